@@ -47,6 +47,11 @@
 unsigned int TextoutLongOperation::time_at_last_pass_ = 0;
 int TextoutLongOperation::next_character_countdown_  = 0;
 
+// The most time we'll make up for in one pass. Time spent waiting for a click
+// or running other bytecode between textouts shouldn't make a burst of text
+// appear all at once.
+const int MAX_CATCH_UP_TIME = 50;
+
 // -----------------------------------------------------------------------
 // TextoutLongOperation
 // -----------------------------------------------------------------------
@@ -205,15 +210,26 @@ bool TextoutLongOperation::operator()(RLMachine& machine) {
     int time_since_last_pass = current_time - time_at_last_pass_;
     time_at_last_pass_ = current_time;
 
-    next_character_countdown_ -= time_since_last_pass;
-    if (next_character_countdown_ <= 0) {
+    next_character_countdown_ = std::max(
+        next_character_countdown_ - time_since_last_pass, -MAX_CATCH_UP_TIME);
+
+    // Display every character that has come due since the last pass, so the
+    // reveal keeps up with the message speed no matter how often we're
+    // called. The glyphs all land in the text window's surface, which gets
+    // uploaded once when the next frame is drawn.
+    int message_speed = machine.system().text().messageSpeed();
+    while (next_character_countdown_ <= 0) {
+      next_character_countdown_ += message_speed;
+
       bool paused = false;
-      next_character_countdown_ = machine.system().text().messageSpeed();
-      return displayOneMoreCharacter(machine, paused);
-    } else {
-      // Let's sleep a bit and then try again.
-      return false;
+      if (displayOneMoreCharacter(machine, paused))
+        return true;
+      if (paused)
+        return false;
     }
+
+    // Let's sleep a bit and then try again.
+    return false;
   }
 }
 
@@ -70,7 +70,8 @@ class TextoutLongOperation : public LongOperation {
   // How long it's been since the last time we've added time to |total_time_|.
   static unsigned int time_at_last_pass_;
 
-  // A countdown in milliseconds until we display the next character.
+  // A countdown in milliseconds until we display the next character. When
+  // it's negative, we owe the screen that much time's worth of characters.
   static int next_character_countdown_;
 };
 
@@ -177,7 +177,7 @@ class Op_CallWithString : public RLOp_Void_1< StrConstant_T > {
       : setter(s) {
   }
 
-  void operator()(RLMachine& machine, std::string incoming) {
+  void operator()(RLMachine& machine, const std::string& incoming) {
     (getSystemObjImpl::getSystemObj<OBJTYPE>(machine).*setter)(incoming);
   }
 
@@ -306,7 +306,7 @@ class Op_ReturnIntValueWithString : public RLOp_Store_1<StrConstant_T> {
       : getter_(g) {
   }
 
-  int operator()(RLMachine& machine, string one) {
+  int operator()(RLMachine& machine, const string& one) {
     return (getSystemObjImpl::getSystemObj<OBJTYPE>(machine).*getter_)(one);
   }
 
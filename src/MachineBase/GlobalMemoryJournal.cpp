@@ -0,0 +1,295 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2013 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+// -----------------------------------------------------------------------
+
+#include "MachineBase/GlobalMemoryJournal.hpp"
+
+#include <boost/crc.hpp>
+#include <boost/cstdint.hpp>
+#include <string>
+
+#include "MachineBase/Memory.hpp"
+
+using boost::uint32_t;
+
+namespace {
+
+const char JOURNAL_MAGIC[8] = { 'R', 'L', 'V', 'M', 'G', 'J', 'N', 0 };
+
+// Record types. Never renumber these; old journals must stay readable.
+enum RecordType {
+  RECORD_INT_G = 1,
+  RECORD_INT_Z = 2,
+  RECORD_STR_M = 3,
+  RECORD_NAME = 4,
+  RECORD_KIDOKU = 5,
+  RECORD_SYSTEM_GLOBALS = 6
+};
+
+// Kidoku indices past this are certainly corrupt; don't allocate for them.
+const int MAX_KIDOKU = 1 << 20;
+
+void AppendUint32(uint32_t value, std::string* out) {
+  for (int i = 0; i < 4; ++i)
+    out->push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+}
+
+void AppendString(const std::string& value, std::string* out) {
+  AppendUint32(value.size(), out);
+  out->append(value);
+}
+
+uint32_t Checksum(const char* data, size_t size) {
+  boost::crc_32_type crc;
+  crc.process_bytes(data, size);
+  return crc.checksum();
+}
+
+// Frames |payload| with its length and checksum and appends it to |out|.
+void AppendRecord(const std::string& payload, std::string* out) {
+  AppendUint32(payload.size(), out);
+  out->append(payload);
+  AppendUint32(Checksum(payload.data(), payload.size()), out);
+}
+
+void AppendIntRecord(RecordType type, int index, int value, std::string* out) {
+  std::string payload(1, static_cast<char>(type));
+  AppendUint32(index, &payload);
+  AppendUint32(value, &payload);
+  AppendRecord(payload, out);
+}
+
+void AppendStringRecord(RecordType type, int index, const std::string& value,
+                        std::string* out) {
+  std::string payload(1, static_cast<char>(type));
+  AppendUint32(index, &payload);
+  AppendString(value, &payload);
+  AppendRecord(payload, out);
+}
+
+// Bounds checked reading of little endian values out of a journal.
+class Reader {
+ public:
+  Reader(const std::string& data, size_t position)
+      : data_(data), position_(position) {}
+
+  size_t position() const { return position_; }
+  size_t remaining() const { return data_.size() - position_; }
+
+  bool readUint32(uint32_t* value) {
+    if (remaining() < 4)
+      return false;
+    *value = 0;
+    for (int i = 0; i < 4; ++i) {
+      *value |= static_cast<uint32_t>(
+          static_cast<unsigned char>(data_[position_ + i])) << (8 * i);
+    }
+    position_ += 4;
+    return true;
+  }
+
+  bool readInt(int* value) {
+    uint32_t raw;
+    if (!readUint32(&raw))
+      return false;
+    *value = static_cast<int>(raw);
+    return true;
+  }
+
+  bool readString(std::string* value) {
+    uint32_t size;
+    if (!readUint32(&size) || remaining() < size)
+      return false;
+    value->assign(data_, position_, size);
+    position_ += size;
+    return true;
+  }
+
+  bool readBytes(size_t size, std::string* value) {
+    if (remaining() < size)
+      return false;
+    value->assign(data_, position_, size);
+    position_ += size;
+    return true;
+  }
+
+ private:
+  const std::string& data_;
+  size_t position_;
+};
+
+// Applies one record's payload. Returns false if it doesn't make sense.
+bool ApplyPayload(const std::string& payload, GlobalMemory* memory,
+                  std::string* system_globals) {
+  if (payload.empty())
+    return false;
+
+  Reader reader(payload, 1);
+  int index, value;
+  std::string str;
+  switch (payload[0]) {
+    case RECORD_INT_G:
+    case RECORD_INT_Z:
+      if (!reader.readInt(&index) || !reader.readInt(&value) ||
+          index < 0 || index >= SIZE_OF_MEM_BANK)
+        return false;
+      if (payload[0] == RECORD_INT_G)
+        memory->intG[index] = value;
+      else
+        memory->intZ[index] = value;
+      return true;
+    case RECORD_STR_M:
+      if (!reader.readInt(&index) || !reader.readString(&str) ||
+          index < 0 || index >= SIZE_OF_MEM_BANK)
+        return false;
+      memory->strM[index] = str;
+      return true;
+    case RECORD_NAME:
+      if (!reader.readInt(&index) || !reader.readString(&str) ||
+          index < 0 || index >= SIZE_OF_NAME_BANK)
+        return false;
+      memory->global_names[index] = str;
+      return true;
+    case RECORD_KIDOKU: {
+      if (!reader.readInt(&index) || !reader.readInt(&value) ||
+          value < 0 || value >= MAX_KIDOKU)
+        return false;
+      boost::dynamic_bitset<>& bitset = memory->kidoku_data[index];
+      if (bitset.size() <= static_cast<size_t>(value))
+        bitset.resize(value + 1, false);
+      bitset[value] = true;
+      return true;
+    }
+    case RECORD_SYSTEM_GLOBALS:
+      if (!reader.readString(&str))
+        return false;
+      *system_globals = str;
+      return true;
+    default:
+      return false;
+  }
+}
+
+}  // namespace
+
+// -----------------------------------------------------------------------
+// GlobalMemoryJournal
+// -----------------------------------------------------------------------
+const size_t GlobalMemoryJournal::HEADER_SIZE = sizeof(JOURNAL_MAGIC) + 8;
+
+GlobalMemoryJournal::GlobalMemoryJournal()
+    : generation_(0), journal_size_(0) {
+}
+
+GlobalMemoryJournal::~GlobalMemoryJournal() {}
+
+bool GlobalMemoryJournal::hasChanges() const {
+  return !int_g_.empty() || !int_z_.empty() || !str_m_.empty() ||
+      !names_.empty() || !kidoku_.empty();
+}
+
+void GlobalMemoryJournal::clearChanges() {
+  int_g_.clear();
+  int_z_.clear();
+  str_m_.clear();
+  names_.clear();
+  kidoku_.clear();
+}
+
+void GlobalMemoryJournal::writeChangeRecords(const GlobalMemory& memory,
+                                             std::string* out) const {
+  for (int index : int_g_)
+    AppendIntRecord(RECORD_INT_G, index, memory.intG[index], out);
+  for (int index : int_z_)
+    AppendIntRecord(RECORD_INT_Z, index, memory.intZ[index], out);
+  for (int index : str_m_)
+    AppendStringRecord(RECORD_STR_M, index, memory.strM[index], out);
+  for (int index : names_)
+    AppendStringRecord(RECORD_NAME, index, memory.global_names[index], out);
+  // Kidoku bits are only ever set, so the mark itself is the new value.
+  for (const std::pair<int, int>& kidoku : kidoku_)
+    AppendIntRecord(RECORD_KIDOKU, kidoku.first, kidoku.second, out);
+}
+
+// static
+void GlobalMemoryJournal::WriteSystemGlobalsRecord(const std::string& globals,
+                                                   std::string* out) {
+  std::string payload(1, static_cast<char>(RECORD_SYSTEM_GLOBALS));
+  AppendString(globals, &payload);
+  AppendRecord(payload, out);
+}
+
+// static
+std::string GlobalMemoryJournal::Header(int version, unsigned int generation) {
+  std::string header(JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC));
+  AppendUint32(version, &header);
+  AppendUint32(generation, &header);
+  return header;
+}
+
+// static
+bool GlobalMemoryJournal::ReadHeader(const std::string& data, int* version,
+                                     unsigned int* generation) {
+  Reader reader(data, 0);
+  std::string magic;
+  uint32_t raw_generation;
+  if (!reader.readBytes(sizeof(JOURNAL_MAGIC), &magic) ||
+      magic != std::string(JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC)) ||
+      !reader.readInt(version) || !reader.readUint32(&raw_generation))
+    return false;
+
+  *generation = raw_generation;
+  return true;
+}
+
+// static
+size_t GlobalMemoryJournal::ApplyRecords(const std::string& data,
+                                         GlobalMemory* memory,
+                                         std::string* system_globals) {
+  Reader reader(data, HEADER_SIZE);
+  size_t intact = HEADER_SIZE;
+  while (reader.remaining()) {
+    std::string payload;
+    uint32_t size, checksum;
+    if (!reader.readUint32(&size) || !reader.readBytes(size, &payload) ||
+        !reader.readUint32(&checksum) ||
+        checksum != Checksum(payload.data(), payload.size()) ||
+        !ApplyPayload(payload, memory, system_globals))
+      break;
+
+    intact = reader.position();
+  }
+
+  return intact;
+}
+
+void GlobalMemoryJournal::setFileState(unsigned int generation,
+                                       size_t journal_size,
+                                       const std::string& system_globals) {
+  generation_ = generation;
+  journal_size_ = journal_size;
+  system_globals_ = system_globals;
+}
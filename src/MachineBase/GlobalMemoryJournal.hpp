@@ -0,0 +1,156 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2013 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+// -----------------------------------------------------------------------
+
+#ifndef SRC_MACHINEBASE_GLOBALMEMORYJOURNAL_HPP_
+#define SRC_MACHINEBASE_GLOBALMEMORYJOURNAL_HPP_
+
+#include <boost/shared_ptr.hpp>
+#include <atomic>
+#include <cstddef>
+#include <set>
+#include <string>
+#include <utility>
+
+struct GlobalMemory;
+
+// Global memory is persisted as a full snapshot (the "base") followed by an
+// append-only journal of the entries that changed since. This class tracks
+// those changes between flushes and encodes and decodes the journal.
+//
+// The journal starts with a header naming the generation of the base it
+// applies to, followed by checksummed records. Every record holds the new
+// absolute value of one entry, so replaying a journal is idempotent. A torn
+// record at the end (from a crash mid-append) ends the replay.
+class GlobalMemoryJournal {
+ public:
+  GlobalMemoryJournal();
+  ~GlobalMemoryJournal();
+
+  // Change tracking. Memory calls these whenever it writes global memory.
+  void markIntG(int index) { int_g_.insert(index); }
+  void markIntZ(int index) { int_z_.insert(index); }
+  void markStrM(int index) { str_m_.insert(index); }
+  void markName(int index) { names_.insert(index); }
+  void markKidoku(int scenario, int kidoku) {
+    kidoku_.insert(std::make_pair(scenario, kidoku));
+  }
+
+  // Whether anything was marked since the last clearChanges().
+  bool hasChanges() const;
+  void clearChanges();
+
+  // Appends a record for every marked entry to |out|, taking the values from
+  // |memory|.
+  void writeChangeRecords(const GlobalMemory& memory, std::string* out) const;
+
+  // Appends a record that replaces the serialized system globals (the
+  // settings that are saved next to global memory) with |globals|.
+  static void WriteSystemGlobalsRecord(const std::string& globals,
+                                       std::string* out);
+
+  // The header of a journal holding changes on top of base |generation|.
+  static std::string Header(int version, unsigned int generation);
+  static const size_t HEADER_SIZE;
+
+  // Parses a journal header. Returns false if |data| doesn't start with one.
+  static bool ReadHeader(const std::string& data, int* version,
+                         unsigned int* generation);
+
+  // Replays the records in |data| after the header onto |memory|. The
+  // payload of the last system globals record is put in |system_globals|.
+  // Returns the size of the intact prefix of |data|; anything after it is
+  // damaged.
+  static size_t ApplyRecords(const std::string& data, GlobalMemory* memory,
+                             std::string* system_globals);
+
+  // The state of the files on disk, kept up to date by the Serialization
+  // functions.
+
+  // The generation of the last base snapshot written or read.
+  unsigned int generation() const { return generation_; }
+
+  // Size of the journal file that follows that base, or 0 if there isn't a
+  // usable one, in which case the next flush must write a new base.
+  size_t journalSize() const { return journal_size_; }
+
+  // The system globals as of the last flush.
+  const std::string& systemGlobals() const { return system_globals_; }
+
+  void setFileState(unsigned int generation, size_t journal_size,
+                    const std::string& system_globals);
+
+  // A new base queued for writing. Until the writer reports that it's on
+  // disk, the file state above keeps describing the old base, and saves keep
+  // appending to the old journal.
+  struct PendingBase {
+    enum State {
+      WRITING,
+      // The new base and the empty journal that follows it are on disk.
+      WRITTEN,
+      // The new base is on disk, but the journal still belongs to the old
+      // one.
+      JOURNAL_FAILED,
+      // Nothing changed on disk.
+      FAILED
+    };
+
+    PendingBase(unsigned int in_generation, size_t in_journal_size)
+        : generation(in_generation), journal_size(in_journal_size),
+          state(WRITING) {
+    }
+
+    const unsigned int generation;
+
+    // The size of the new base's journal, once it's written.
+    size_t journal_size;
+
+    // Set on the file writer's thread.
+    std::atomic<State> state;
+  };
+
+  // The base being written, or NULL.
+  const boost::shared_ptr<PendingBase>& pendingBase() const {
+    return pending_base_;
+  }
+  void setPendingBase(const boost::shared_ptr<PendingBase>& pending_base) {
+    pending_base_ = pending_base;
+  }
+
+ private:
+  std::set<int> int_g_;
+  std::set<int> int_z_;
+  std::set<int> str_m_;
+  std::set<int> names_;
+  std::set<std::pair<int, int> > kidoku_;
+
+  unsigned int generation_;
+  size_t journal_size_;
+  std::string system_globals_;
+  boost::shared_ptr<PendingBase> pending_base_;
+};  // class GlobalMemoryJournal
+
+#endif  // SRC_MACHINEBASE_GLOBALMEMORYJOURNAL_HPP_
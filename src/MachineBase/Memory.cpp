@@ -168,13 +168,11 @@ void Memory::setStringValue(int type, int number, const std::string& value) {
     break;
   case STRM_LOCATION:
     global_->strM[number] = value;
+    global_->journal.markStrM(number);
     break;
   case STRS_LOCATION: {
     // Possibly record the orriginal value for a piece of local memory.
-    std::map<int, std::string>::iterator it = local_.original_strS.find(number);
-    if (it == local_.original_strS.end()) {
-      local_.original_strS.insert(std::make_pair(number, local_.strS[number]));
-    }
+    local_.original_strS.recordOriginal(number, local_.strS[number]);
     local_.strS[number] = value;
     break;
   }
@@ -194,6 +192,7 @@ void Memory::checkNameIndex(int index, const std::string& name) const {
 void Memory::setName(int index, const std::string& name) {
   checkNameIndex(index, "Memory::set_name");
   global_->global_names[index] = name;
+  global_->journal.markName(index);
 }
 
 const std::string& Memory::getName(int index) const {
@@ -227,17 +226,20 @@ void Memory::recordKidoku(int scenario, int kidoku) {
   if (bitset.size() <= static_cast<size_t>(kidoku))
     bitset.resize(kidoku + 1, false);
 
-  bitset[kidoku] = true;
+  if (!bitset[kidoku]) {
+    bitset[kidoku] = true;
+    global_->journal.markKidoku(scenario, kidoku);
+  }
 }
 
 void Memory::takeSavepointSnapshot() {
-  local_.original_intA.clear();
-  local_.original_intB.clear();
-  local_.original_intC.clear();
-  local_.original_intD.clear();
-  local_.original_intE.clear();
-  local_.original_intF.clear();
-  local_.original_strS.clear();
+  local_.original_intA.mark();
+  local_.original_intB.mark();
+  local_.original_intC.mark();
+  local_.original_intD.mark();
+  local_.original_intE.mark();
+  local_.original_intF.mark();
+  local_.original_strS.mark();
 }
 
 // static
@@ -36,6 +36,8 @@
 #include <string>
 #include <vector>
 
+#include "MachineBase/GlobalMemoryJournal.hpp"
+#include "Utilities/SavepointShadow.hpp"
 #include "libReallive/intmemref.h"
 
 const int NUMBER_OF_INT_LOCATIONS = 8;
@@ -67,6 +69,10 @@ struct GlobalMemory {
   // represents a specific kidoku bit.
   std::map<int, boost::dynamic_bitset<> > kidoku_data;
 
+  // Which of the above have changed since they were last written to disk.
+  // Not serialized; see SerializationGlobal.cpp.
+  GlobalMemoryJournal journal;
+
   // boost::serialization
   template<class Archive>
   void serialize(Archive & ar, unsigned int version) {
@@ -107,32 +113,32 @@ struct LocalMemory {
   std::string strS[SIZE_OF_MEM_BANK];
 
   // When one of our values is changed, we put the original value in here. Why?
-  // So that we can save the state of string memory at the time of the last
-  // Savepoint(). Instead of doing some sort of copying entire memory banks
-  // whenever we hit a Savepoint() call, only reconstruct the original memory
-  // when we save.
-  std::map<int, int> original_intA;
-  std::map<int, int> original_intB;
-  std::map<int, int> original_intC;
-  std::map<int, int> original_intD;
-  std::map<int, int> original_intE;
-  std::map<int, int> original_intF;
-  std::map<int, std::string> original_strS;
+  // So that we can save the state of memory at the time of the last
+  // Savepoint(). Instead of copying entire memory banks whenever we hit a
+  // Savepoint() call (which some games do on every line of text), only
+  // reconstruct the original memory when we save.
+  SavepointShadow<int, int> original_intA;
+  SavepointShadow<int, int> original_intB;
+  SavepointShadow<int, int> original_intC;
+  SavepointShadow<int, int> original_intD;
+  SavepointShadow<int, int> original_intE;
+  SavepointShadow<int, int> original_intF;
+  SavepointShadow<int, std::string> original_strS;
 
   std::string local_names[SIZE_OF_NAME_BANK];
 
   // Combines an array with a log of original values and writes the de-modified
   // array to |ar|.
   template<class Archive, typename T>
-  void saveArrayRevertingChanges(Archive& ar,
-                                 const T (&a)[SIZE_OF_MEM_BANK],
-                                 const std::map<int, T>& original) const {
+  void saveArrayRevertingChanges(
+      Archive& ar,
+      const T (&a)[SIZE_OF_MEM_BANK],
+      const SavepointShadow<int, T>& original) const {
     T merged[SIZE_OF_MEM_BANK];
     std::copy(a, a + SIZE_OF_MEM_BANK, merged);
-    for (typename std::map<int, T>::const_iterator it = original.begin();
-         it != original.end(); ++it) {
-      merged[it->first] = it->second;
-    }
+    original.forEachOriginal([&](int index, const T& value) {
+      merged[index] = value;
+    });
     ar & merged;
   }
 
@@ -247,9 +253,9 @@ class Memory {
   LocalMemory& local() { return local_; }
   const LocalMemory& local() const { return local_; }
 
-  // Commit changes in local memory. Unlike the code in src/Systems/ which
-  // copies current values to shadow values, Memory clears a list of changes
-  // that have been made since.
+  // Commit changes in local memory. This only starts a new generation of the
+  // original value logs in LocalMemory, so it doesn't depend on how much
+  // changed since the last savepoint.
   void takeSavepointSnapshot();
 
   // Converts a RealLive letter index (A-Z, AA-ZZ) to its numeric
@@ -286,7 +292,7 @@ class Memory {
   int* int_var[NUMBER_OF_INT_LOCATIONS];
 
   // Change records for original.
-  std::map<int, int>* original_int_var[NUMBER_OF_INT_LOCATIONS];
+  SavepointShadow<int, int>* original_int_var[NUMBER_OF_INT_LOCATIONS];
 };  // end of class Memory
 
 // Implementation of getting an integer out of an array. Global because we need
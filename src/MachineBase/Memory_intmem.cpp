@@ -51,6 +51,8 @@
 
 using namespace std;
 using libReallive::IntMemRef;
+using libReallive::INTG_LOCATION;
+using libReallive::INTZ_LOCATION;
 
 namespace {
 
@@ -63,14 +65,18 @@ void throwIllegalIndex(const IntMemRef& ref,
 }
 
 void saveOriginalValue(int* bank,
-                       std::map<int, int>* original_bank,
+                       SavepointShadow<int, int>* original_bank,
                        int location) {
-  if (bank && original_bank) {
-    std::map<int, int>::iterator it = original_bank->find(location);
-    if (it == original_bank->end()) {
-      original_bank->insert(std::make_pair(location, bank[location]));
-    }
-  }
+  if (bank && original_bank)
+    original_bank->recordOriginal(location, bank[location]);
+}
+
+// Notes a write to |element| of |bank| if it is one of the global banks.
+void markGlobalWrite(GlobalMemory* global, int bank, int element) {
+  if (bank == INTG_LOCATION)
+    global->journal.markIntG(element);
+  else if (bank == INTZ_LOCATION)
+    global->journal.markIntZ(element);
 }
 
 }  // namespace
@@ -113,7 +119,7 @@ void Memory::setIntValue(const IntMemRef& ref, int value) {
   int location = ref.location();
 
   int* bank = NULL;
-  std::map<int, int>* original_bank = NULL;
+  SavepointShadow<int, int>* original_bank = NULL;
   if (index == 8) {
     bank = machine_.currentIntLBank();
   } else if (index < 0 || index > NUMBER_OF_INT_LOCATIONS) {
@@ -128,6 +134,7 @@ void Memory::setIntValue(const IntMemRef& ref, int value) {
     if ((unsigned int)(location) >= 2000)
       throwIllegalIndex(ref, "RLMachine::setIntValue()");
     saveOriginalValue(bank, original_bank, location);
+    markGlobalWrite(global_.get(), index, location);
     bank[location] = value;
   } else {
     // Ab[]..G4b[], Z8b[] などを書く
@@ -139,6 +146,7 @@ void Memory::setIntValue(const IntMemRef& ref, int value) {
       throwIllegalIndex(ref, "RLMachine::setIntValue()");
 
     saveOriginalValue(bank, original_bank, location / eltsize);
+    markGlobalWrite(global_.get(), index, location / eltsize);
     bank[location / eltsize] =
       (bank[location / eltsize] & ~(eltmask << shift))
       | (value & eltmask) << shift;
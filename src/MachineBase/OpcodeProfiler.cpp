@@ -0,0 +1,226 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2013 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+// -----------------------------------------------------------------------
+
+#include "MachineBase/OpcodeProfiler.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "MachineBase/RLModule.hpp"
+#include "MachineBase/RLOperation.hpp"
+#include "libReallive/bytecode.h"
+
+using libReallive::CommandElement;
+using std::endl;
+using std::left;
+using std::right;
+using std::setw;
+
+namespace {
+
+// Collects LongOperations that weren't pushed by an opcode.
+const OpcodeProfiler::OpcodeKey kNoOpcode(-1, -1, -1, -1);
+
+// How many lines operator<< prints.
+const size_t kLinesToPrint = 50;
+
+double milliseconds(OpcodeProfiler::Clock::duration duration) {
+  return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+template<typename Iterator>
+bool totalTimeGreater(Iterator lhs, Iterator rhs) {
+  return lhs->second.total_time() > rhs->second.total_time();
+}
+
+// Returns the entries in |storage| by descending total time.
+template<typename Storage>
+std::vector<typename Storage::const_iterator> sortByTotalTime(
+    const Storage& storage) {
+  typedef typename Storage::const_iterator Iterator;
+  std::vector<Iterator> sorted;
+  for (Iterator it = storage.begin(); it != storage.end(); ++it)
+    sorted.push_back(it);
+  std::stable_sort(sorted.begin(), sorted.end(), totalTimeGreater<Iterator>);
+  return sorted;
+}
+
+void printRow(std::ostream& os, int name_width, const std::string& name,
+              const OpcodeProfiler::Entry& entry) {
+  os << setw(name_width) << left << name << right
+     << setw(10) << entry.count
+     << setw(14) << milliseconds(entry.dispatch_time)
+     << setw(14) << milliseconds(entry.long_operation_time) << endl;
+}
+
+void printHeader(std::ostream& os, int name_width, const std::string& name) {
+  os << setw(name_width) << left << name << right
+     << setw(10) << "Count"
+     << setw(14) << "Dispatch ms"
+     << setw(14) << "LongOp ms" << endl;
+  os << std::string(name_width + 38, '-') << endl;
+}
+
+}  // namespace
+
+// -----------------------------------------------------------------------
+// OpcodeProfiler::Entry
+// -----------------------------------------------------------------------
+OpcodeProfiler::Entry::Entry()
+    : count(0),
+      dispatch_time(Clock::duration::zero()),
+      long_operation_time(Clock::duration::zero()) {
+}
+
+// -----------------------------------------------------------------------
+// OpcodeProfiler
+// -----------------------------------------------------------------------
+OpcodeProfiler::OpcodeProfiler() {}
+
+OpcodeProfiler::~OpcodeProfiler() {}
+
+void OpcodeProfiler::beginDispatch(RLModule& module, const CommandElement& f,
+                                   int scenario, int line) {
+  Entry& opcode = opcodes_[OpcodeKey(f.modtype(), f.module(), f.opcode(),
+                                     f.overload())];
+  if (opcode.name.empty()) {
+    RLOperation* op = module.findOperation(f);
+    std::ostringstream oss;
+    oss << module.moduleName() << "."
+        << (op && op->name() ? op->name() : "???") << " (" << f.modtype()
+        << ":" << f.module() << ":" << f.opcode() << ", " << f.overload()
+        << ")";
+    opcode.name = oss.str();
+  }
+
+  Entry& line_entry = lines_[LineKey(scenario, line)];
+  opcode.count++;
+  line_entry.count++;
+
+  Running running;
+  running.attribution = Attribution(&opcode, &line_entry);
+  running.long_operation = NULL;
+  running.start = Clock::now();
+  running_.push_back(running);
+}
+
+void OpcodeProfiler::endDispatch() {
+  const Running& running = running_.back();
+  Clock::duration elapsed = Clock::now() - running.start;
+  running.attribution.opcode->dispatch_time += elapsed;
+  running.attribution.line->dispatch_time += elapsed;
+  running_.pop_back();
+}
+
+void OpcodeProfiler::attributeLongOperation(
+    const LongOperation* long_operation, int scenario, int line) {
+  Attribution attribution;
+  if (!running_.empty()) {
+    attribution = running_.back().attribution;
+  } else {
+    Entry& opcode = opcodes_[kNoOpcode];
+    opcode.name = "(no opcode)";
+    attribution = Attribution(&opcode, &lines_[LineKey(scenario, line)]);
+  }
+
+  // A LongOperation that is dropped without finishing leaves its entry
+  // behind; it is overwritten if the address is reused.
+  long_operations_[long_operation] = attribution;
+}
+
+void OpcodeProfiler::beginLongOperation(
+    const LongOperation* long_operation) {
+  Running running;
+  std::map<const LongOperation*, Attribution>::const_iterator it =
+      long_operations_.find(long_operation);
+  if (it != long_operations_.end()) {
+    running.attribution = it->second;
+  } else {
+    // Pushed without going through RLMachine::pushLongOperation().
+    Entry& opcode = opcodes_[kNoOpcode];
+    opcode.name = "(no opcode)";
+    running.attribution = Attribution(&opcode, NULL);
+  }
+  running.long_operation = long_operation;
+  running.start = Clock::now();
+  running_.push_back(running);
+}
+
+void OpcodeProfiler::endLongOperation(bool finished) {
+  const Running& running = running_.back();
+  Clock::duration elapsed = Clock::now() - running.start;
+  running.attribution.opcode->long_operation_time += elapsed;
+  if (running.attribution.line)
+    running.attribution.line->long_operation_time += elapsed;
+
+  if (finished)
+    long_operations_.erase(running.long_operation);
+  running_.pop_back();
+}
+
+std::ostream& operator<<(std::ostream& os, const OpcodeProfiler& profiler) {
+  if (profiler.opcodes().empty()) {
+    os << "No opcodes profiled!" << endl;
+    return os;
+  }
+
+  std::ios::fmtflags flags = os.flags();
+  std::streamsize precision = os.precision();
+  os << std::fixed << std::setprecision(3);
+
+  std::vector<OpcodeProfiler::OpcodeStorage::const_iterator> opcodes =
+      sortByTotalTime(profiler.opcodes());
+  int name_width = 6;
+  for (auto const& opcode : opcodes)
+    name_width = std::max(name_width, int(opcode->second.name.size()) + 2);
+
+  printHeader(os, name_width, "Opcode");
+  for (auto const& opcode : opcodes)
+    printRow(os, name_width, opcode->second.name, opcode->second);
+
+  std::vector<OpcodeProfiler::LineStorage::const_iterator> lines =
+      sortByTotalTime(profiler.lines());
+  if (lines.size() > kLinesToPrint)
+    lines.resize(kLinesToPrint);
+
+  os << endl;
+  printHeader(os, 16, "Line");
+  for (auto const& line : lines) {
+    std::ostringstream name;
+    name << "SEEN" << std::setw(4) << std::setfill('0') << line->first.first
+         << ":" << line->first.second;
+    printRow(os, 16, name.str(), line->second);
+  }
+
+  os.flags(flags);
+  os.precision(precision);
+  return os;
+}
@@ -0,0 +1,142 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2013 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+// -----------------------------------------------------------------------
+
+#ifndef SRC_MACHINEBASE_OPCODEPROFILER_HPP_
+#define SRC_MACHINEBASE_OPCODEPROFILER_HPP_
+
+#include <chrono>
+#include <iosfwd>
+#include <map>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "libReallive/bytecode_fwd.h"
+
+class LongOperation;
+class RLModule;
+
+// An optional component to an RLMachine that records how often each opcode
+// runs and how much wall time it costs, both in the RLOperation itself and in
+// any LongOperation it pushes. The same numbers are also kept per SEEN line,
+// so the expensive parts of a scenario can be found without an external
+// profiler.
+//
+// LongOperations are charged to whatever was running when they were pushed:
+// the opcode being dispatched, the LongOperation being run (for nested ones),
+// or, for textout and other pushes from outside the interpreter, a "(no
+// opcode)" entry and the current line.
+class OpcodeProfiler {
+ public:
+  typedef std::chrono::steady_clock Clock;
+
+  struct Entry {
+    Entry();
+
+    // "Module.opcodeName (type:module:opcode, overload)". Unused for lines.
+    std::string name;
+
+    // Number of times the opcode was dispatched (or, for lines, the number of
+    // opcodes dispatched from that line).
+    long count;
+
+    // Time spent in RLOperation::dispatchFunction().
+    Clock::duration dispatch_time;
+
+    // Time spent running LongOperations charged to this entry.
+    Clock::duration long_operation_time;
+
+    Clock::duration total_time() const {
+      return dispatch_time + long_operation_time;
+    }
+  };
+
+  // (module type, module, opcode, overload)
+  typedef std::tuple<int, int, int, int> OpcodeKey;
+  typedef std::map<OpcodeKey, Entry> OpcodeStorage;
+
+  // (scenario, line)
+  typedef std::pair<int, int> LineKey;
+  typedef std::map<LineKey, Entry> LineStorage;
+
+  OpcodeProfiler();
+  ~OpcodeProfiler();
+
+  // Brackets the dispatch of |f| by |module|, issued from |line| of
+  // |scenario|. Calls may nest; every beginDispatch() must be matched by an
+  // endDispatch(), even when the operation throws.
+  void beginDispatch(RLModule& module, const libReallive::CommandElement& f,
+                     int scenario, int line);
+  void endDispatch();
+
+  // Charges |long_operation| to whatever is currently running. Called when it
+  // is pushed onto the stack; |scenario| and |line| are used when nothing is.
+  void attributeLongOperation(const LongOperation* long_operation,
+                              int scenario, int line);
+
+  // Brackets one call to |long_operation|. |finished| is whether it returned
+  // true and is about to be popped.
+  void beginLongOperation(const LongOperation* long_operation);
+  void endLongOperation(bool finished);
+
+  const OpcodeStorage& opcodes() const { return opcodes_; }
+  const LineStorage& lines() const { return lines_; }
+
+ private:
+  // Where the time of a dispatch or a LongOperation is charged.
+  struct Attribution {
+    Attribution() : opcode(NULL), line(NULL) {}
+    Attribution(Entry* in_opcode, Entry* in_line)
+        : opcode(in_opcode), line(in_line) {}
+
+    Entry* opcode;
+    Entry* line;
+  };
+
+  // Something that is currently running.
+  struct Running {
+    Attribution attribution;
+    const LongOperation* long_operation;
+    Clock::time_point start;
+  };
+
+  OpcodeStorage opcodes_;
+  LineStorage lines_;
+
+  // The dispatches and LongOperations currently running, innermost last.
+  std::vector<Running> running_;
+
+  // Who each LongOperation on the stack is charged to.
+  std::map<const LongOperation*, Attribution> long_operations_;
+};
+
+// Pretty prints the opcodes by total time, followed by the most expensive
+// lines.
+std::ostream& operator<<(std::ostream& os, const OpcodeProfiler& profiler);
+
+#endif  // SRC_MACHINEBASE_OPCODEPROFILER_HPP_
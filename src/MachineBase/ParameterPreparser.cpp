@@ -0,0 +1,170 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2013 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+// -----------------------------------------------------------------------
+
+#include "MachineBase/ParameterPreparser.hpp"
+
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <utility>
+
+#include "MachineBase/RLMachine.hpp"
+#include "MachineBase/RLOperation.hpp"
+#include "libReallive/bytecode.h"
+#include "libReallive/scenario.h"
+
+using libReallive::CommandElement;
+using libReallive::ExpressionPiecesVector;
+using libReallive::Scenario;
+
+namespace {
+
+// How many commands the worker parses between handing results back. Small
+// enough that the start of a scene is ready quickly.
+const size_t BATCH_SIZE = 64;
+
+}  // namespace
+
+// -----------------------------------------------------------------------
+// ParameterPreparser
+// -----------------------------------------------------------------------
+ParameterPreparser::ParameterPreparser(RLMachine& machine)
+    : machine_(machine), busy_(false), quit_(false), has_results_(false) {
+}
+
+ParameterPreparser::~ParameterPreparser() {
+  {
+    boost::unique_lock<boost::mutex> lock(mutex_);
+    quit_ = true;
+  }
+  work_available_.notify_all();
+  if (thread_)
+    thread_->join();
+}
+
+void ParameterPreparser::queueScenario(const Scenario* scenario) {
+  if (!queued_scenarios_.insert(scenario->sceneNumber()).second)
+    return;
+
+  {
+    boost::unique_lock<boost::mutex> lock(mutex_);
+    scenarios_.push_back(scenario);
+
+    if (!thread_) {
+      thread_.reset(new boost::thread(
+          std::bind(&ParameterPreparser::threadMain, this)));
+    }
+  }
+  work_available_.notify_one();
+}
+
+void ParameterPreparser::flush() {
+  boost::unique_lock<boost::mutex> lock(mutex_);
+  while (!scenarios_.empty() || busy_)
+    work_done_.wait(lock);
+}
+
+void ParameterPreparser::installResults() {
+  std::vector<Result> results;
+  {
+    boost::unique_lock<boost::mutex> lock(mutex_);
+    results.swap(results_);
+    has_results_.store(false, std::memory_order_release);
+  }
+
+  for (Result& result : results) {
+    // The command may have run, and parsed its own parameters, while these
+    // were in flight.
+    if (!result.element->areParametersParsed())
+      result.element->setParsedParameters(result.parameters);
+  }
+}
+
+bool ParameterPreparser::parseScenario(const Scenario& scenario) {
+  std::vector<Result> parsed;
+  for (Scenario::const_iterator it = scenario.begin(); it != scenario.end();
+       ++it) {
+    // Whether the parameters are already parsed is left to installResults():
+    // the interpreter may be filling them in right now.
+    const CommandElement* element = dynamic_cast<const CommandElement*>(&*it);
+    if (!element)
+      continue;
+
+    RLOperation* operation = machine_.findOperation(*element);
+    if (!operation)
+      continue;
+
+    Result result;
+    result.element = element;
+    try {
+      operation->parseParameters(element->getUnparsedParameters(),
+                                 result.parameters);
+    } catch (std::exception&) {
+      // Leave it to the interpreter, which will report the error when (and
+      // if) the command runs.
+      continue;
+    }
+    parsed.push_back(std::move(result));
+
+    if (parsed.size() == BATCH_SIZE && !publishResults(parsed))
+      return false;
+  }
+
+  return publishResults(parsed);
+}
+
+bool ParameterPreparser::publishResults(std::vector<Result>& parsed) {
+  boost::unique_lock<boost::mutex> lock(mutex_);
+  std::move(parsed.begin(), parsed.end(), std::back_inserter(results_));
+  parsed.clear();
+  if (!results_.empty())
+    has_results_.store(true, std::memory_order_release);
+  return !quit_;
+}
+
+void ParameterPreparser::threadMain() {
+  boost::unique_lock<boost::mutex> lock(mutex_);
+  while (true) {
+    while (scenarios_.empty() && !quit_)
+      work_available_.wait(lock);
+    if (quit_)
+      return;
+
+    const Scenario* scenario = scenarios_.front();
+    scenarios_.pop_front();
+    busy_ = true;
+    lock.unlock();
+
+    bool keep_going = parseScenario(*scenario);
+
+    lock.lock();
+    busy_ = false;
+    work_done_.notify_all();
+    if (!keep_going)
+      return;
+  }
+}
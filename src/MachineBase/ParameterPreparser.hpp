@@ -0,0 +1,128 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2013 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+// -----------------------------------------------------------------------
+
+#ifndef SRC_MACHINEBASE_PARAMETERPREPARSER_HPP_
+#define SRC_MACHINEBASE_PARAMETERPREPARSER_HPP_
+
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include <atomic>
+#include <deque>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "libReallive/expression.h"
+
+class RLMachine;
+class RLOperation;
+
+namespace libReallive {
+class CommandElement;
+class Scenario;
+}  // namespace libReallive
+
+// Parses the parameters of a scenario's commands on a background thread, so
+// that the first time through a scene doesn't pay for the expression parser
+// on every command.
+//
+// Queueing a scenario only records it; the worker thread walks its elements,
+// looks up their operations in |machine| and copies out the strings to parse.
+// It only reads the bytecode, which doesn't change once loaded, and never
+// reads or writes parsed parameters: those are handed back to their
+// CommandElements by installParsedParameters(), on the thread that runs the
+// bytecode. A command that executes before its parameters come back just
+// parses them itself, as it always has.
+//
+// |machine| must outlive the preparser and mustn't have modules attached
+// after it's created.
+class ParameterPreparser {
+ public:
+  explicit ParameterPreparser(RLMachine& machine);
+
+  // Stops the worker, throwing away anything not installed yet.
+  ~ParameterPreparser();
+
+  // Queues every command in |scenario| whose operation the machine knows.
+  // Each scenario is only queued once.
+  void queueScenario(const libReallive::Scenario* scenario);
+
+  // Gives every command parsed so far its parameters. Cheap when there's
+  // nothing new.
+  void installParsedParameters() {
+    if (has_results_.load(std::memory_order_acquire))
+      installResults();
+  }
+
+  // Blocks until everything queued so far has been parsed.
+  void flush();
+
+ private:
+  struct Result {
+    const libReallive::CommandElement* element;
+    libReallive::ExpressionPiecesVector parameters;
+  };
+
+  void installResults();
+
+  // Parses the parameters of every known command in |scenario|, handing them
+  // back in batches. Called on the worker thread without |mutex_| held.
+  // Returns false if the preparser is shutting down.
+  bool parseScenario(const libReallive::Scenario& scenario);
+
+  // Adds |parsed| to |results_| and empties it. Returns false if the
+  // preparser is shutting down.
+  bool publishResults(std::vector<Result>& parsed);
+
+  void threadMain();
+
+  RLMachine& machine_;
+
+  // Scenes already queued. Only used by the interpreter's thread.
+  std::set<int> queued_scenarios_;
+
+  boost::mutex mutex_;
+  boost::condition_variable work_available_;
+  boost::condition_variable work_done_;
+
+  // Guarded by |mutex_|.
+  std::deque<const libReallive::Scenario*> scenarios_;
+  std::vector<Result> results_;
+  bool busy_;
+  bool quit_;
+
+  // Whether |results_| has anything in it, so the interpreter can check
+  // without taking the lock.
+  std::atomic<bool> has_results_;
+
+  // Started with the first queued scenario.
+  boost::scoped_ptr<boost::thread> thread_;
+};  // class ParameterPreparser
+
+#endif  // SRC_MACHINEBASE_PARAMETERPREPARSER_HPP_
@@ -27,6 +27,8 @@
 
 #include <boost/archive/text_iarchive.hpp>
 #include <boost/archive/text_oarchive.hpp>
+#include "portable_binary_archive/portable_binary_iarchive.hpp"
+#include "portable_binary_archive/portable_binary_oarchive.hpp"
 #include <boost/serialization/vector.hpp>
 
 #include "MachineBase/RLMachine.hpp"
@@ -48,6 +50,8 @@
 #include "MachineBase/LongOperation.hpp"
 #include "MachineBase/Memory.hpp"
 #include "MachineBase/OpcodeLog.hpp"
+#include "MachineBase/OpcodeProfiler.hpp"
+#include "MachineBase/ParameterPreparser.hpp"
 #include "MachineBase/RLModule.hpp"
 #include "MachineBase/RLOperation.hpp"
 #include "MachineBase/RealLiveDLL.hpp"
@@ -119,8 +123,12 @@ RLMachine::RLMachine(System& in_system, Archive& in_archive)
       mark_savepoints_(true),
       delay_stack_modifications_(false),
       replaying_graphics_stack_(false) {
-  // Search in the Gameexe for #SEEN_START and place us there
   Gameexe& gameexe = in_system.gameexe();
+  savepoint_message_key_ = gameexe.key("SAVEPOINT_MESSAGE");
+  savepoint_selcom_key_ = gameexe.key("SAVEPOINT_SELCOM");
+  savepoint_seentop_key_ = gameexe.key("SAVEPOINT_SEENTOP");
+
+  // Search in the Gameexe for #SEEN_START and place us there
   libReallive::Scenario* scenario = NULL;
   if (gameexe.exists("SEEN_START")) {
     int first_seen = gameexe("SEEN_START").to_int();
@@ -162,6 +170,9 @@ RLMachine::RLMachine(System& in_system, Archive& in_archive)
 RLMachine::~RLMachine() {
   if (undefined_log_)
     cerr << *undefined_log_;
+
+  if (profiler_)
+    cerr << *profiler_;
 }
 
 void RLMachine::attachModule(RLModule* module) {
@@ -213,7 +224,7 @@ void RLMachine::markSavepoint() {
 }
 
 bool RLMachine::savepointDecide(AttributeFunction func,
-                                const std::string& gameexe_key) const {
+                                const GameexeKey& gameexe_key) const {
   if (!mark_savepoints_)
     return false;
 
@@ -243,16 +254,15 @@ void RLMachine::setMarkSavepoints(const int in) {
 }
 
 bool RLMachine::shouldSetMessageSavepoint() const {
-  return
-      savepointDecide(&Scenario::savepointMessage, "SAVEPOINT_MESSAGE");
+  return savepointDecide(&Scenario::savepointMessage, savepoint_message_key_);
 }
 
 bool RLMachine::shouldSetSelcomSavepoint() const {
-  return savepointDecide(&Scenario::savepointSelcom, "SAVEPOINT_SELCOM");
+  return savepointDecide(&Scenario::savepointSelcom, savepoint_selcom_key_);
 }
 
 bool RLMachine::shouldSetSeentopSavepoint() const {
-  return savepointDecide(&Scenario::savepointSeentop, "SAVEPOINT_SEENTOP");
+  return savepointDecide(&Scenario::savepointSeentop, savepoint_seentop_key_);
 }
 
 void RLMachine::executeNextInstruction() {
@@ -263,7 +273,19 @@ void RLMachine::executeNextInstruction() {
     try {
       if (call_stack_.back().frame_type == StackFrame::TYPE_LONGOP) {
         delay_stack_modifications_ = true;
-        bool ret_val = (*call_stack_.back().long_op)(*this);
+        bool ret_val;
+        if (profiler_) {
+          profiler_->beginLongOperation(call_stack_.back().long_op.get());
+          try {
+            ret_val = (*call_stack_.back().long_op)(*this);
+          } catch(...) {
+            profiler_->endLongOperation(false);
+            throw;
+          }
+          profiler_->endLongOperation(ret_val);
+        } else {
+          ret_val = (*call_stack_.back().long_op)(*this);
+        }
         delay_stack_modifications_ = false;
 
         if (ret_val)
@@ -347,15 +369,38 @@ void RLMachine::advanceInstructionPointer() {
 }
 
 void RLMachine::executeCommand(const CommandElement& f) {
+  if (preparser_)
+    preparser_->installParsedParameters();
+
   ModuleMap::iterator it = modules_.find(packModuleNumber(f.modtype(),
                                                           f.module()));
   if (it != modules_.end()) {
-    it->second->dispatchFunction(*this, f);
+    if (profiler_) {
+      profiler_->beginDispatch(*it->second, f, sceneNumber(), line_);
+      try {
+        it->second->dispatchFunction(*this, f);
+      } catch(...) {
+        profiler_->endDispatch();
+        throw;
+      }
+      profiler_->endDispatch();
+    } else {
+      it->second->dispatchFunction(*this, f);
+    }
   } else {
     throw rlvm::UnimplementedOpcode(*this, f);
   }
 }
 
+RLOperation* RLMachine::findOperation(const CommandElement& f) {
+  ModuleMap::iterator it = modules_.find(packModuleNumber(f.modtype(),
+                                                          f.module()));
+  if (it != modules_.end())
+    return it->second->findOperation(f);
+
+  return NULL;
+}
+
 void RLMachine::jump(int scenario_num, int entrypoint) {
   // Check to make sure it's a valid scenario
   libReallive::Scenario* scenario = archive_.scenario(scenario_num);
@@ -366,6 +411,9 @@ void RLMachine::jump(int scenario_num, int entrypoint) {
     throw rlvm::Exception(oss.str());
   }
 
+  if (preparser_)
+    preparser_->queueScenario(scenario);
+
   if (call_stack_.back().frame_type == StackFrame::TYPE_LONGOP) {
     // TODO: For some reason this is slow; REALLY slow, so for now I'm trying
     // to optimize the common case (no long operations on the back of the
@@ -394,6 +442,9 @@ void RLMachine::farcall(int scenario_num, int entrypoint) {
     throw rlvm::Exception(oss.str());
   }
 
+  if (preparser_)
+    preparser_->queueScenario(scenario);
+
   libReallive::Scenario::const_iterator it =
       scenario->findEntrypoint(entrypoint);
 
@@ -451,6 +502,9 @@ void RLMachine::pushStringValueUp(int index, const std::string& val) {
 }
 
 void RLMachine::pushLongOperation(LongOperation* long_operation) {
+  if (profiler_)
+    profiler_->attributeLongOperation(long_operation, sceneNumber(), line_);
+
   pushStackFrame(StackFrame(call_stack_.back().scenario, call_stack_.back().ip,
                             long_operation));
 }
@@ -656,6 +710,22 @@ void RLMachine::recordUndefinedOpcodeCounts() {
   undefined_log_.reset(new OpcodeLog);
 }
 
+void RLMachine::profileOpcodes() {
+  profiler_.reset(new OpcodeProfiler);
+}
+
+void RLMachine::preparseParameters() {
+  if (preparser_)
+    return;
+
+  preparser_.reset(new ParameterPreparser(*this));
+  for (std::vector<StackFrame>::const_iterator it = call_stack_.begin();
+       it != call_stack_.end(); ++it) {
+    if (it->scenario)
+      preparser_->queueScenario(it->scenario);
+  }
+}
+
 void RLMachine::halt() {
   halted_ = true;
 }
@@ -705,11 +775,15 @@ void RLMachine::load(Archive & ar, unsigned int version) {
 
 // -----------------------------------------------------------------------
 
-// Explicit instantiations for text archives (since we hide the
+// Explicit instantiations for text and binary archives (since we hide the
 // implementation)
 
 template void RLMachine::save<boost::archive::text_oarchive>(
     boost::archive::text_oarchive & ar, unsigned int version) const;
+template void RLMachine::save<portable_binary_oarchive>(
+    portable_binary_oarchive & ar, unsigned int version) const;
 
 template void RLMachine::load<boost::archive::text_iarchive>(
     boost::archive::text_iarchive & ar, unsigned int version);
+template void RLMachine::load<portable_binary_iarchive>(
+    portable_binary_iarchive & ar, unsigned int version);
@@ -34,6 +34,7 @@
 #include <boost/shared_ptr.hpp>
 
 #include "libReallive/bytecode_fwd.h"
+#include "libReallive/gameexe.h"
 #include "libReallive/scenario.h"
 
 #include <functional>
@@ -43,12 +44,16 @@
 namespace  libReallive {
 class Archive;
 class IntMemRef;
+class Scenario;
 };
 
 class LongOperation;
 class Memory;
 class OpcodeLog;
+class OpcodeProfiler;
+class ParameterPreparser;
 class RLModule;
+class RLOperation;
 class RealLiveDLL;
 class System;
 struct StackFrame;
@@ -100,7 +105,7 @@ class RLMachine {
   //   return. On any other value, we fall through to...
   // - Check a Gameexe key, which has the final say.
   bool savepointDecide(AttributeFunction func,
-                       const std::string& gameexe_key) const;
+                       const GameexeKey& gameexe_key) const;
 
   // Whether the DisableAutoSavepoints override is on. This is
   // triggered purely from bytecode.
@@ -225,6 +230,10 @@ class RLMachine {
   int getProbableEncodingType() const;
 
   void executeCommand(const libReallive::CommandElement& f);
+
+  // Returns the operation that executeCommand() would run for |f|, or NULL if
+  // no attached module implements it.
+  RLOperation* findOperation(const libReallive::CommandElement& f);
   void executeExpression(const libReallive::ExpressionElement& e);
   void performTextout(const libReallive::TextoutElement& e);
   void performTextout(const std::string& cp932str);
@@ -296,6 +305,19 @@ class RLMachine {
   // results to stderr on machine destruction.
   void recordUndefinedOpcodeCounts();
 
+  // Starts recording the number of calls and the wall time spent in each
+  // opcode, in the LongOperations it pushes, and on each SEEN line. Will print
+  // the results to stderr on machine destruction.
+  void profileOpcodes();
+
+  // The profile started by profileOpcodes(), or NULL.
+  const OpcodeProfiler* opcodeProfiler() const { return profiler_.get(); }
+
+  // Starts parsing the parameters of every command in each scenario we enter
+  // on a background thread, instead of when each command first runs. Call
+  // after all modules are attached.
+  void preparseParameters();
+
   // ---------------------------------------------------------------------
 
   // Force the machine to halt. This should terminate the execution of
@@ -387,9 +409,21 @@ class RLMachine {
   // undefined opcodes.
   boost::scoped_ptr<OpcodeLog> undefined_log_;
 
+  // (Optional) Where the time goes, per opcode and per line.
+  boost::scoped_ptr<OpcodeProfiler> profiler_;
+
+  // (Optional) Parses parameters ahead of execution.
+  boost::scoped_ptr<ParameterPreparser> preparser_;
+
   // Override defaults
   bool mark_savepoints_;
 
+  // The Gameexe keys consulted by savepointDecide() on every textout,
+  // selection and scenario entry.
+  GameexeKey savepoint_message_key_;
+  GameexeKey savepoint_selcom_key_;
+  GameexeKey savepoint_seentop_key_;
+
   // Whether the stack was modified during the running of a
   // LongOperation. Used to signal that any stack mutating functions should be
   // be placed in |delay_modifications_| for execution later.
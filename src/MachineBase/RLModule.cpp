@@ -120,6 +120,15 @@ RLModule::PropertyList::iterator RLModule::findProperty(int property) const {
                  [&](Property& p) { return p.first == property; });
 }
 
+RLOperation* RLModule::findOperation(const CommandElement& f) {
+  OpcodeMap::iterator it =
+      stored_operations.find(packOpcodeNumber(f.opcode(), f.overload()));
+  if (it != stored_operations.end())
+    return it->second;
+
+  return NULL;
+}
+
 void RLModule::dispatchFunction(RLMachine& machine, const CommandElement& f) {
   OpcodeMap::iterator it =
       stored_operations.find(packOpcodeNumber(f.opcode(), f.overload()));
@@ -119,6 +119,9 @@ class RLModule : public boost::noncopyable {
   void dispatchFunction(RLMachine& machine,
                         const libReallive::CommandElement& f);
 
+  // Returns the RLOperation that implements |f| in this module, or NULL.
+  RLOperation* findOperation(const libReallive::CommandElement& f);
+
   OpcodeMap::iterator begin() { return stored_operations.begin(); }
   OpcodeMap::iterator end() { return stored_operations.end(); }
 
@@ -174,43 +174,14 @@ StrConstant_T::type StrConstant_T::getData(
     RLMachine& machine,
     const std::vector<std::unique_ptr<libReallive::ExpressionPiece>>& p,
     unsigned int& position) {
-  // When I was trying to get P_BRIDE running in rlvm, I noticed that when
-  // loading a game, I would often crash with invalid iterators in the LRUCache
-  // library, in SDLGraphicsSystem where I cached recently used images. After
-  // adding some verification methods to it, it was obvious that it's internal
-  // state was entirely screwed up. There were duplicates in the std::list<>
-  // (it's a precondition that its elements are unique), there were entries in
-  // the std::list<> that didn't exist in the corresponding std::map<>; the
-  // data structure was a complete mess. I verified the datastructure before
-  // and after each operation...and found that it would almost always be
-  // corrupted in the check that happened at the beginning of each
-  // function. Printing out the c_str() pointers showed there was no change
-  // between the consistent data structure and the corrupted one; the
-  // underlying pointers were the same.
-  //
-  // Setting a few watch points, the internal c_str() buffers were being
-  // overwritten by a memcpy in libstdc++ which was called by boost::serialize
-  // during the loading of the RLMachine's local memory.  But that makes
-  // sense. Think about what happens when we execute the following kepago:
-  //
-  //   strS[0] = 'SOMEFILE'
-  //   grpOpenBg(0, strS[0])
-  //
-  // We are assigning a value into the RLMachine's string memory. We are then
-  // passing a copy-on-write string, backed by one memory buffer that contains
-  // 'SOMEFILE' around. LRUCache and string memory now point to the same char*
-  // buffer.
-  //
-  // boost::serialization appears to ignore the COW semantics of std::string
-  // and just writes into it during a serialization::load() no matter how many
-  // people hold references to the inner buffer. Now we have one screwed up
-  // LRUCache data structure, and probably screwed up other places.
-  //
-  // So to fix this, we break the COW semantics here by forcing a copy. I'd
-  // prefer to do this in RLMachine or Memory, but I can't because they return
-  // references.
-  string tmp = p[position++]->getStringValue(machine);
-  return string(tmp.data(), tmp.size());
+  // This used to return a deep copy of the string to break copy-on-write
+  // sharing between string memory and anything an operation stored the
+  // string in (boost::serialization would write through the shared buffer
+  // when loading a game, corrupting SDLGraphicsSystem's LRUCache.) C++11
+  // strings can't share buffers, so we hand out a reference to the string
+  // memory or the constant in the bytecode and let operations copy only
+  // what they keep.
+  return p[position++]->getStringValue(machine);
 }
 
 void StrConstant_T::parseParameters(
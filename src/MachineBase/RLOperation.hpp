@@ -30,6 +30,7 @@
 
 #include <utility>
 #include <string>
+#include <type_traits>
 #include <vector>
 
 #include "libReallive/bytecode_fwd.h"
@@ -185,9 +186,13 @@ struct IntConstant_T {
 // subclass, and should not be used directly. It should only be used
 // as a template parameter to one of those classes, or of another type
 // definition struct.
+//
+// The output is a reference to the string in memory or in the parsed
+// bytecode; it is only valid for the duration of the operation's
+// operator(). Operations that keep the string (or modify it) must copy it.
 struct StrConstant_T {
   // The output type of this type struct
-  typedef std::string type;
+  typedef const std::string& type;
 
   // Convert the incoming parameter objects into the resulting type
   static type getData(RLMachine& machine,
@@ -205,6 +210,15 @@ struct StrConstant_T {
   };
 };
 
+// The value type that a type struct's output is held in when it has to
+// outlive the parameters it was read from, such as in the vector built by
+// Argc_T<> or the tuple built by Complex_T<>. Only differs from A::type for
+// type structs that output references, like StrConstant_T.
+template<typename A>
+struct OwnedType {
+  typedef typename std::decay<typename A::type>::type type;
+};
+
 struct empty_struct { };
 
 // Defines a null type for the Special parameter.
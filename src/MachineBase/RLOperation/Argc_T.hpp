@@ -36,7 +36,7 @@
 template<typename CON>
 struct Argc_T {
   // The output type of this type struct
-  typedef typename std::vector<typename CON::type> type;
+  typedef typename std::vector<typename OwnedType<CON>::type> type;
 
   // Convert the incoming parameter objects into the resulting type.
   // Passes each parameter down to
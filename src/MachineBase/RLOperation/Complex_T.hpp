@@ -38,7 +38,8 @@
 template<typename A, typename B>
 struct Complex2_T {
   // The output type of this type struct
-  typedef std::tuple<typename A::type, typename B::type> type;
+  typedef std::tuple<typename OwnedType<A>::type,
+                     typename OwnedType<B>::type> type;
 
   // Convert the incoming parameter objects into the resulting type.
   static type getData(RLMachine& machine,
@@ -77,8 +78,8 @@ struct Complex2_T {
 template<typename A, typename B, typename C>
 struct Complex3_T {
   // The output type of this type struct
-  typedef std::tuple<typename A::type, typename B::type,
-                     typename C::type> type;
+  typedef std::tuple<typename OwnedType<A>::type, typename OwnedType<B>::type,
+                     typename OwnedType<C>::type> type;
 
   // Convert the incoming parameter objects into the resulting type.
   static type getData(RLMachine& machine,
@@ -119,8 +120,9 @@ struct Complex3_T {
 template<typename A, typename B, typename C, typename D>
 struct Complex4_T {
   // The output type of this type struct
-  typedef std::tuple<typename A::type, typename B::type,
-                     typename C::type, typename D::type> type;
+  typedef std::tuple<typename OwnedType<A>::type, typename OwnedType<B>::type,
+                     typename OwnedType<C>::type,
+                     typename OwnedType<D>::type> type;
 
   // Convert the incoming parameter objects into the resulting type.
   static type getData(RLMachine& machine,
@@ -165,10 +167,10 @@ template<typename A, typename B, typename C, typename D, typename E,
          typename F, typename G>
 struct Complex7_T {
   // The output type of this type struct
-  typedef std::tuple<typename A::type, typename B::type,
-                     typename C::type, typename D::type,
-                     typename E::type, typename F::type,
-                     typename G::type> type;
+  typedef std::tuple<typename OwnedType<A>::type, typename OwnedType<B>::type,
+                     typename OwnedType<C>::type, typename OwnedType<D>::type,
+                     typename OwnedType<E>::type, typename OwnedType<F>::type,
+                     typename OwnedType<G>::type> type;
 
   // Convert the incoming parameter objects into the resulting type.
   static type getData(RLMachine& machine,
@@ -219,10 +221,11 @@ template<typename A, typename B, typename C, typename D, typename E,
          typename F, typename G, typename H>
 struct Complex8_T {
   // The output type of this type struct
-  typedef std::tuple<typename A::type, typename B::type,
-                     typename C::type, typename D::type,
-                     typename E::type, typename F::type,
-                     typename G::type, typename H::type> type;
+  typedef std::tuple<typename OwnedType<A>::type, typename OwnedType<B>::type,
+                     typename OwnedType<C>::type, typename OwnedType<D>::type,
+                     typename OwnedType<E>::type, typename OwnedType<F>::type,
+                     typename OwnedType<G>::type,
+                     typename OwnedType<H>::type> type;
 
   // Convert the incoming parameter objects into the resulting type.
   static type getData(RLMachine& machine,
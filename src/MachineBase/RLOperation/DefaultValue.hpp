@@ -64,7 +64,7 @@ struct DefaultIntValue_T {
 // Typestruct that will return an empty string if there isn't a value.
 struct DefaultStrValue_T {
   // The output type of this type struct
-  typedef std::string type;
+  typedef StrConstant_T::type type;
 
   // Convert the incoming parameter objects into the resulting type
   static type getData(RLMachine& machine,
@@ -73,7 +73,8 @@ struct DefaultStrValue_T {
     if (position < p.size()) {
       return StrConstant_T::getData(machine, p, position);
     } else {
-      return std::string();
+      static const std::string empty;
+      return empty;
     }
   }
 
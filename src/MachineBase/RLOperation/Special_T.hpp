@@ -59,15 +59,15 @@ struct Special_T {
     // 0 = A, 1 = B
     int type;
 
-    typename A::type first;
-    typename B::type second;
-    typename C::type third;
-    typename D::type fourth;
-    typename E::type fifth;
-    typename F::type sixth;
-    typename G::type seventh;
-    typename H::type eighth;
-    typename I::type ninth;
+    typename OwnedType<A>::type first;
+    typename OwnedType<B>::type second;
+    typename OwnedType<C>::type third;
+    typename OwnedType<D>::type fourth;
+    typename OwnedType<E>::type fifth;
+    typename OwnedType<F>::type sixth;
+    typename OwnedType<G>::type seventh;
+    typename OwnedType<H>::type eighth;
+    typename OwnedType<I>::type ninth;
   };
 
   // Export our internal struct as our external type
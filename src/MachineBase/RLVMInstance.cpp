@@ -36,11 +36,14 @@
 #include "Modules/Modules.hpp"
 #include "Modules/Module_Sys_Save.hpp"
 #include "Platforms/gcn/GCNPlatform.hpp"
+#include "Systems/Base/EventSystem.hpp"
 #include "Systems/Base/GraphicsSystem.hpp"
+#include "Systems/Base/MemoryReport.hpp"
 #include "Systems/Base/SystemError.hpp"
 #include "Systems/SDL/SDLSystem.hpp"
 #include "Utilities/Exception.hpp"
 #include "Utilities/File.hpp"
+#include "Utilities/FrameTimings.hpp"
 #include "Utilities/findFontFile.h"
 #include "Utilities/gettext.h"
 #include "Utilities/StringUtilities.hpp"
@@ -79,8 +82,13 @@ RLVMInstance::RLVMInstance()
       memory_(false),
       undefined_opcodes_(false),
       count_undefined_copcodes_(false),
+      profile_opcodes_(false),
       load_save_(-1),
-      dump_seen_(-1) {
+      dump_seen_(-1),
+      sound_cache_mb_(-1),
+      preparse_parameters_(false),
+      frame_timings_(false),
+      memory_log_seconds_(0) {
   srand(time(NULL));
 }
 
@@ -118,6 +126,9 @@ void RLVMInstance::Run(const boost::filesystem::path& gamerootPath) {
       gameexe("__GAMEFONT") = custom_font_;
     }
 
+    if (sound_cache_mb_ != -1)
+      gameexe("__SOUND_CACHE_MB") = sound_cache_mb_;
+
     libReallive::Archive arc(seenPath.string(), gameexe("REGNAME"));
     if (dump_seen_ != -1) {
       libReallive::Scenario* scenario = arc.scenario(dump_seen_);
@@ -152,6 +163,12 @@ void RLVMInstance::Run(const boost::filesystem::path& gamerootPath) {
     if (count_undefined_copcodes_)
       rlmachine.recordUndefinedOpcodeCounts();
 
+    if (profile_opcodes_)
+      rlmachine.profileOpcodes();
+
+    if (preparse_parameters_)
+      rlmachine.preparseParameters();
+
     Serialization::loadGlobalMemory(rlmachine);
 
     // Now to preform a quick integrity check. If the user opened the Japanese
@@ -164,6 +181,11 @@ void RLVMInstance::Run(const boost::filesystem::path& gamerootPath) {
     if (load_save_ != -1)
       Sys_load()(rlmachine, load_save_);
 
+    if (frame_timings_)
+      FrameTimings::Shared().enable(trace_file_);
+
+    unsigned int last_memory_log = sdlSystem.event().getTicks();
+
     while (!rlmachine.halted()) {
       if (g_background) {
         // do nothing when sent to background
@@ -180,11 +202,25 @@ void RLVMInstance::Run(const boost::filesystem::path& gamerootPath) {
       // etc.
       sdlSystem.run(rlmachine);
 
+      if (memory_log_seconds_ > 0) {
+        unsigned int now = sdlSystem.event().getTicks();
+        if (now - last_memory_log >= memory_log_seconds_ * 1000u) {
+          MemoryReport report;
+          sdlSystem.reportMemoryUsage(rlmachine, report);
+          cerr << "Memory: " << report.summary() << endl;
+          last_memory_log = now;
+        }
+      }
+
       // Run the rlmachine through another instruction
+      ScopedTimer timer("executeNextInstruction");
       rlmachine.executeNextInstruction();
     }
 
+    FrameTimings::Shared().finish();
+
     Serialization::saveGlobalMemory(rlmachine);
+    Serialization::waitForPendingSaves();
   } catch (rlvm::UserPresentableError& e) {
     ReportFatalError(e.message_text(), e.informative_text());
   } catch (rlvm::Exception& e) {
@@ -47,8 +47,17 @@ class RLVMInstance {
   void set_memory() { memory_ = true; }
   void set_undefined_opcodes() { undefined_opcodes_ = true; }
   void set_count_undefined() { count_undefined_copcodes_ = true; }
+  void set_profile_opcodes() { profile_opcodes_ = true; }
   void set_load_save(int in) { load_save_ = in; }
   void set_custom_font(const std::string& font) { custom_font_ = font; }
+  void set_sound_cache_mb(int in) { sound_cache_mb_ = in; }
+  void set_preparse_parameters() { preparse_parameters_ = true; }
+  void set_frame_timings() { frame_timings_ = true; }
+  void set_trace_file(const boost::filesystem::path& path) {
+    frame_timings_ = true;
+    trace_file_ = path;
+  }
+  void set_memory_log_seconds(int in) { memory_log_seconds_ = in; }
 
   void set_dump_seen(int in) { dump_seen_ = in; }
 
@@ -100,11 +109,31 @@ class RLVMInstance {
   // used on exit.
   bool count_undefined_copcodes_;
 
+  // Whether we should print out where time was spent, per opcode and per
+  // line, on exit.
+  bool profile_opcodes_;
+
   // Loads the specified save file as soon as emulation starts if not -1.
   int load_save_;
 
   // Dumps psuedokepago of the current seen to stdout and exit if not -1.
   int dump_seen_;
+
+  // Ceiling on decoded sound effects kept in memory, in megabytes, if not -1.
+  int sound_cache_mb_;
+
+  // Whether command parameters are parsed on a background thread when a
+  // scenario is entered.
+  bool preparse_parameters_;
+
+  // Whether we time each part of a frame and print percentiles on exit.
+  bool frame_timings_;
+
+  // Where to write those timings as a Chrome trace, if anywhere.
+  boost::filesystem::path trace_file_;
+
+  // How often to print a line of per subsystem memory use, or 0 for never.
+  int memory_log_seconds_;
 };
 
 #endif  // SRC_MACHINEBASE_RLVMINSTANCE_hpp_
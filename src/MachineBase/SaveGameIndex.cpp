@@ -0,0 +1,135 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2013 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+// -----------------------------------------------------------------------
+
+#include "MachineBase/SaveGameIndex.hpp"
+
+#include "portable_binary_archive/portable_binary_iarchive.hpp"
+#include "portable_binary_archive/portable_binary_oarchive.hpp"
+#include <boost/date_time/posix_time/time_serialize.hpp>
+#include <boost/filesystem/fstream.hpp>
+#include <boost/filesystem/operations.hpp>
+#include <boost/serialization/map.hpp>
+#include <exception>
+#include <iostream>
+
+using namespace std;
+namespace fs = boost::filesystem;
+
+namespace {
+
+// Bumped whenever Entry changes; an index with any other version is thrown
+// away and rebuilt from the save games.
+const int CURRENT_INDEX_VERSION = 1;
+
+}  // namespace
+
+// -----------------------------------------------------------------------
+// SaveGameIndex
+// -----------------------------------------------------------------------
+SaveGameIndex::SaveGameIndex(const boost::filesystem::path& index_file)
+    : index_file_(index_file) {
+  fs::ifstream file(index_file_, ios::binary);
+  if (!file)
+    return;
+
+  try {
+    portable_binary_iarchive ia(file);
+    int version;
+    ia >> version;
+    if (version == CURRENT_INDEX_VERSION)
+      ia >> entries_;
+  } catch (std::exception& e) {
+    // The index is only a cache; start over from the save games.
+    cerr << "Ignoring unreadable save game index " << index_file_ << ": "
+         << e.what() << endl;
+    entries_.clear();
+  }
+}
+
+SaveGameIndex::~SaveGameIndex() {}
+
+bool SaveGameIndex::lookup(int slot, const boost::filesystem::path& save_file,
+                           SaveGameHeader* header) const {
+  std::map<int, Entry>::const_iterator it = entries_.find(slot);
+  if (it == entries_.end())
+    return false;
+
+  boost::system::error_code ec;
+  std::time_t modification_time = fs::last_write_time(save_file, ec);
+  if (ec || modification_time != it->second.modification_time)
+    return false;
+  boost::uintmax_t size = fs::file_size(save_file, ec);
+  if (ec || size != it->second.size)
+    return false;
+
+  *header = it->second.header;
+  return true;
+}
+
+void SaveGameIndex::update(int slot, const boost::filesystem::path& save_file,
+                           const SaveGameHeader& header) {
+  boost::system::error_code ec;
+  Entry entry;
+  entry.header = header;
+  entry.modification_time = fs::last_write_time(save_file, ec);
+  if (!ec)
+    entry.size = fs::file_size(save_file, ec);
+  if (ec) {
+    entries_.erase(slot);
+    return;
+  }
+
+  entries_[slot] = entry;
+  write();
+}
+
+void SaveGameIndex::remove(int slot) {
+  if (entries_.erase(slot))
+    write();
+}
+
+void SaveGameIndex::write() const {
+  fs::path tmp_file = index_file_;
+  tmp_file += ".tmp";
+
+  try {
+    {
+      fs::ofstream file(tmp_file, ios::binary);
+      if (!file)
+        return;
+
+      portable_binary_oarchive oa(file);
+      oa << CURRENT_INDEX_VERSION << entries_;
+    }
+
+    fs::rename(tmp_file, index_file_);
+  } catch (std::exception& e) {
+    // Failing to write the index only costs us speed later.
+    cerr << "Could not write save game index " << index_file_ << ": "
+         << e.what() << endl;
+  }
+}
@@ -0,0 +1,90 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2013 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+// -----------------------------------------------------------------------
+
+#ifndef SRC_MACHINEBASE_SAVEGAMEINDEX_HPP_
+#define SRC_MACHINEBASE_SAVEGAMEINDEX_HPP_
+
+#include <boost/cstdint.hpp>
+#include <boost/filesystem/path.hpp>
+#include <ctime>
+#include <map>
+
+#include "MachineBase/SaveGameHeader.hpp"
+
+// Caches the headers of every save game in a directory in a single file, so
+// that the SaveDate family of functions and the save/load menus don't have to
+// open and decompress each save game just to show its title and date.
+//
+// Each entry remembers the size and modification time of the save game it
+// was taken from; an entry whose save game has changed since is ignored.
+class SaveGameIndex {
+ public:
+  // Loads the index stored in |index_file|, if there is one. A missing,
+  // unreadable or out of date index file is treated as empty.
+  explicit SaveGameIndex(const boost::filesystem::path& index_file);
+  ~SaveGameIndex();
+
+  const boost::filesystem::path& indexFile() const { return index_file_; }
+
+  // Fetches the cached header for |slot|, whose save game lives at
+  // |save_file|. Returns false if the slot isn't in the index or the save
+  // game has been written since it was indexed.
+  bool lookup(int slot, const boost::filesystem::path& save_file,
+              SaveGameHeader* header) const;
+
+  // Records that the save game at |save_file| in |slot| has |header|, and
+  // writes the index back to disk.
+  void update(int slot, const boost::filesystem::path& save_file,
+              const SaveGameHeader& header);
+
+  // Drops whatever is cached for |slot|, and writes the index back to disk.
+  void remove(int slot);
+
+ private:
+  struct Entry {
+    SaveGameHeader header;
+
+    // The save game this entry was taken from, as it was on disk then.
+    std::time_t modification_time;
+    boost::uintmax_t size;
+
+    template<class Archive>
+    void serialize(Archive& ar, unsigned int version) {
+      ar & header & modification_time & size;
+    }
+  };
+
+  // Writes |entries_| to |index_file_|, replacing the previous index
+  // atomically so a crash can't leave half an index behind.
+  void write() const;
+
+  boost::filesystem::path index_file_;
+
+  std::map<int, Entry> entries_;
+};
+
+#endif  // SRC_MACHINEBASE_SAVEGAMEINDEX_HPP_
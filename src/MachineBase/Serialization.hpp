@@ -45,6 +45,8 @@ namespace Serialization {
 //          here; this is a likely location for errors
 extern RLMachine* g_current_machine;
 
+// Queues writing the global memory file in the background, like
+// saveGameForSlot().
 void saveGlobalMemory(RLMachine& machine);
 void saveGlobalMemoryTo(std::ostream& oss, RLMachine& machine);
 
@@ -53,9 +55,18 @@ void loadGlobalMemoryFrom(std::istream& iss, RLMachine& machine);
 
 boost::filesystem::path buildSaveGameFilename(RLMachine& machine, int slot);
 
+// Snapshots the game and queues it to be written to |slot| in the
+// background. The slot's file is only replaced once the new save is
+// completely on disk.
 void saveGameForSlot(RLMachine& machine, int slot);
 void saveGameTo(std::ostream& oss, RLMachine& machine);
 
+// Blocks until every save game and global memory file queued by
+// saveGameForSlot() and saveGlobalMemory() has been written. Everything here
+// that reads those files calls it first; code that looks at the save
+// directory directly must too.
+void waitForPendingSaves();
+
 SaveGameHeader loadHeaderForSlot(RLMachine& machine, int slot);
 SaveGameHeader loadHeaderFrom(std::istream& iss);
 
@@ -39,12 +39,17 @@
 #include <boost/filesystem/operations.hpp>
 #include <boost/iostreams/filtering_stream.hpp>
 #include <boost/iostreams/filter/zlib.hpp>
+#include <exception>
 #include <fstream>
+#include <functional>
+#include <iterator>
 #include <sstream>
 #include <iostream>
 
+#include "Utilities/AsyncFileWriter.hpp"
 #include "Utilities/Exception.hpp"
 #include "Utilities/dynamic_bitset_serialize.hpp"
+#include "MachineBase/GlobalMemoryJournal.hpp"
 #include "MachineBase/RLMachine.hpp"
 #include "MachineBase/Memory.hpp"
 #include "Systems/Base/System.hpp"
@@ -67,20 +72,220 @@ namespace Serialization {
 //   bug in its implementation of vectors of primitive types which made
 //   archives not-backwards (or forwards) compatible. Thankfully, the save
 //   games themselves don't use that feature.
-const int CURRENT_GLOBAL_VERSION = 3;
+// - Was changed to 4 when global memory started being journaled. The base
+//   file now records its generation right after the version.
+const int CURRENT_GLOBAL_VERSION = 4;
+
+namespace {
+
+typedef GlobalMemoryJournal::PendingBase PendingBase;
+
+// Once the journal grows past this, the next save writes a fresh base file
+// and starts the journal over.
+const size_t MAX_JOURNAL_SIZE = 256 * 1024;
+
+fs::path buildGlobalJournalFilename(RLMachine& machine) {
+  return machine.system().gameSaveDirectory() / "global.journal";
+}
+
+// Writes the settings kept next to global memory into |oa|.
+template<class Archive>
+void writeSystemGlobals(Archive& oa, RLMachine& machine) {
+  System& sys = machine.system();
+  oa << const_cast<const SystemGlobals&>(sys.globals())
+     << const_cast<const GraphicsSystemGlobals&>(sys.graphics().globals())
+     << const_cast<const EventSystemGlobals&>(sys.event().globals())
+     << const_cast<const TextSystemGlobals&>(sys.text().globals())
+     << const_cast<const SoundSystemGlobals&>(sys.sound().globals());
+}
+
+template<class Archive>
+void readSystemGlobals(Archive& ia, RLMachine& machine) {
+  System& sys = machine.system();
+  ia >> sys.globals()
+     >> sys.graphics().globals()
+     >> sys.event().globals()
+     >> sys.text().globals()
+     >> sys.sound().globals();
+
+  // Restore options which may have System specific implementations. (This
+  // will probably expand as more of RealLive is implemented).
+  sys.sound().restoreFromGlobals();
+}
+
+// The settings serialized on their own. They change rarely and as a whole,
+// so the journal stores them as one blob, and only when it differs from the
+// last one written.
+std::string serializeSystemGlobals(RLMachine& machine) {
+  ostringstream oss(ios::binary);
+  {
+    text_oarchive oa(oss);
+    writeSystemGlobals(oa, machine);
+  }
+  return oss.str();
+}
+
+void applySystemGlobals(const std::string& globals, RLMachine& machine) {
+  istringstream iss(globals, ios::binary);
+  text_iarchive ia(iss);
+  readSystemGlobals(ia, machine);
+}
+
+// Writes the uncompressed global memory archive.
+void writeGlobalMemory(std::ostream& oss, RLMachine& machine,
+                       unsigned int generation) {
+  text_oarchive oa(oss);
+  oa << CURRENT_GLOBAL_VERSION << generation
+     << const_cast<const GlobalMemory&>(machine.memory().global());
+  writeSystemGlobals(oa, machine);
+}
+
+// Replays the journal that follows the base file just loaded. A journal that
+// belongs to a different base, or is damaged, is left for the next save to
+// replace.
+void replayGlobalJournal(RLMachine& machine) {
+  GlobalMemory& global = machine.memory().global();
+  GlobalMemoryJournal& journal = global.journal;
+
+  fs::ifstream file(buildGlobalJournalFilename(machine), ios::binary);
+  if (!file)
+    return;
+  std::string data((istreambuf_iterator<char>(file)),
+                   istreambuf_iterator<char>());
+
+  int version;
+  unsigned int generation;
+  if (!GlobalMemoryJournal::ReadHeader(data, &version, &generation) ||
+      version != CURRENT_GLOBAL_VERSION || generation != journal.generation())
+    return;
+
+  std::string system_globals = journal.systemGlobals();
+  size_t intact = GlobalMemoryJournal::ApplyRecords(data, &global,
+                                                    &system_globals);
+  journal.clearChanges();
+
+  try {
+    if (system_globals != journal.systemGlobals())
+      applySystemGlobals(system_globals, machine);
+  } catch (std::exception& e) {
+    cerr << "WARNING: Ignoring unreadable settings in global journal: "
+         << e.what() << endl;
+    system_globals = serializeSystemGlobals(machine);
+    intact = 0;
+  }
+
+  if (intact != data.size()) {
+    cerr << "WARNING: Global journal is damaged after byte " << intact
+         << "; rewriting global memory on the next save." << endl;
+    intact = 0;
+  }
+  journal.setFileState(generation, intact, system_globals);
+}
+
+// Called on the file writer's thread once a new base has been written, or
+// has failed to be. The journal is only started over for the new base when
+// the base made it to disk. Saves queued since then append to the journal
+// after this, so their records land on whichever base is current.
+void finishBaseWrite(const boost::shared_ptr<PendingBase>& pending,
+                     const fs::path& journal_path, bool succeeded) {
+  if (!succeeded) {
+    pending->state = PendingBase::FAILED;
+    return;
+  }
+
+  try {
+    AsyncFileWriter::ReplaceNow(
+        journal_path,
+        GlobalMemoryJournal::Header(CURRENT_GLOBAL_VERSION,
+                                    pending->generation));
+    pending->state = PendingBase::WRITTEN;
+  } catch (std::exception& e) {
+    cerr << "--- WARNING: ERROR DURING SAVING FILE: " << e.what() << " ---"
+         << endl;
+    pending->state = PendingBase::JOURNAL_FAILED;
+  }
+}
+
+// Catches up with the base queued by an earlier save, if it's done.
+void updatePendingBase(GlobalMemoryJournal& journal) {
+  boost::shared_ptr<PendingBase> pending = journal.pendingBase();
+  if (!pending)
+    return;
+
+  switch (pending->state) {
+    case PendingBase::WRITING:
+      return;
+    case PendingBase::WRITTEN:
+      journal.setFileState(pending->generation, pending->journal_size,
+                           journal.systemGlobals());
+      break;
+    case PendingBase::JOURNAL_FAILED:
+      // Nothing in the journal applies to the new base, so write another.
+      journal.setFileState(pending->generation, 0, journal.systemGlobals());
+      break;
+    case PendingBase::FAILED:
+      // The old base is still on disk, and its journal has every change.
+      break;
+  }
+  journal.setPendingBase(boost::shared_ptr<PendingBase>());
+}
+
+}  // namespace
 
 fs::path buildGlobalMemoryFilename(RLMachine& machine) {
   return machine.system().gameSaveDirectory() / "global.sav.gz";
 }
 
 void saveGlobalMemory(RLMachine& machine) {
-  fs::path home = buildGlobalMemoryFilename(machine);
-  fs::ofstream file(home, ios::binary);
-  if (!file) {
-    throw rlvm::Exception(_("Could not open global memory file."));
+  GlobalMemory& global = machine.memory().global();
+  GlobalMemoryJournal& journal = global.journal;
+  std::string system_globals = serializeSystemGlobals(machine);
+  updatePendingBase(journal);
+  boost::shared_ptr<PendingBase> pending = journal.pendingBase();
+
+  // Append what changed since the last save. Until a new base is known to be
+  // on disk, this goes to the old base's journal, so that one keeps every
+  // change in case the new base never makes it.
+  if (journal.journalSize() != 0 || pending) {
+    std::string records;
+    journal.writeChangeRecords(global, &records);
+    if (system_globals != journal.systemGlobals())
+      GlobalMemoryJournal::WriteSystemGlobalsRecord(system_globals, &records);
+
+    if (!records.empty()) {
+      size_t journal_size = journal.journalSize();
+      if (journal_size != 0)
+        journal_size += records.size();
+      journal.setFileState(journal.generation(), journal_size,
+                           system_globals);
+      if (pending)
+        pending->journal_size += records.size();
+
+      AsyncFileWriter::Shared().append(buildGlobalJournalFilename(machine),
+                                       records);
+    }
+  }
+
+  if (!pending && (journal.journalSize() == 0 ||
+                   journal.journalSize() > MAX_JOURNAL_SIZE)) {
+    // Write a new base. Its journal is started by finishBaseWrite() once the
+    // base is on disk; until then the old base and journal stay current.
+    pending.reset(new PendingBase(journal.generation() + 1,
+                                  GlobalMemoryJournal::HEADER_SIZE));
+    ostringstream data(ios::binary);
+    writeGlobalMemory(data, machine, pending->generation);
+    AsyncFileWriter::Shared().write(
+        buildGlobalMemoryFilename(machine), std::string(), data.str(),
+        std::bind(&finishBaseWrite, pending,
+                  buildGlobalJournalFilename(machine),
+                  std::placeholders::_1));
+
+    journal.setPendingBase(pending);
+    journal.setFileState(journal.generation(), journal.journalSize(),
+                         system_globals);
   }
 
-  saveGlobalMemoryTo(file, machine);
+  journal.clearChanges();
 }
 
 void saveGlobalMemoryTo(std::ostream& oss, RLMachine& machine) {
@@ -89,19 +294,12 @@ void saveGlobalMemoryTo(std::ostream& oss, RLMachine& machine) {
   filtered_output.push(zlib_compressor());
   filtered_output.push(oss);
 
-  text_oarchive oa(filtered_output);
-  System& sys = machine.system();
-
-  oa << CURRENT_GLOBAL_VERSION
-     << const_cast<const GlobalMemory&>(machine.memory().global())
-     << const_cast<const SystemGlobals&>(sys.globals())
-     << const_cast<const GraphicsSystemGlobals&>(sys.graphics().globals())
-     << const_cast<const EventSystemGlobals&>(sys.event().globals())
-     << const_cast<const TextSystemGlobals&>(sys.text().globals())
-     << const_cast<const SoundSystemGlobals&>(sys.sound().globals());
+  writeGlobalMemory(filtered_output, machine,
+                    machine.memory().global().journal.generation());
 }
 
 void loadGlobalMemory(RLMachine& machine) {
+  waitForPendingSaves();
   fs::path home = buildGlobalMemoryFilename(machine);
   fs::ifstream file(home, ios::binary);
 
@@ -127,7 +325,10 @@ void loadGlobalMemory(RLMachine& machine) {
 
       cerr << "WARNING: Unable to read saved global memory file. Moving "
            << save_dir << " to " << dest_save_dir << endl;
+      return;
     }
+
+    replayGlobalJournal(machine);
   }
 }
 
@@ -138,12 +339,16 @@ void loadGlobalMemoryFrom(std::istream& iss, RLMachine& machine) {
   filtered_input.push(iss);
 
   text_iarchive ia(filtered_input);
-  System& sys = machine.system();
   int version;
   ia >> version;
 
+  unsigned int generation = 0;
+  if (version >= 4)
+    ia >> generation;
+
   // Load global memory.
-  ia >> machine.memory().global();
+  GlobalMemory& global = machine.memory().global();
+  ia >> global;
 
   // When Karmic Koala came out, support for all boost earlier than 1.36 was
   // dropped. For years, I had used boost 1.35 on Ubuntu. It turns out that
@@ -157,17 +362,14 @@ void loadGlobalMemoryFrom(std::istream& iss, RLMachine& machine) {
   // headers which was unsuccessful, I'm just saying to hell with the user's
   // settings. Most people don't change these values and save games and global
   // memory still work (per above.)
-  if (version == CURRENT_GLOBAL_VERSION) {
-    ia >> sys.globals()
-       >> sys.graphics().globals()
-       >> sys.event().globals()
-       >> sys.text().globals()
-       >> sys.sound().globals();
-
-    // Restore options which may have System specific implementations. (This
-    // will probably expand as more of RealLive is implemented).
-    sys.sound().restoreFromGlobals();
-  }
+  if (version >= 3)
+    readSystemGlobals(ia, machine);
+
+  // Nothing is known about a journal yet, so the next save writes a new base
+  // unless loadGlobalMemory() finds one that matches.
+  global.journal.clearChanges();
+  global.journal.setFileState(generation, 0, serializeSystemGlobals(machine));
+  global.journal.setPendingBase(boost::shared_ptr<PendingBase>());
 }
 
 }  // namespace Serialization
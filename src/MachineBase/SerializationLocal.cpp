@@ -28,6 +28,8 @@
 // include headers that implement a archive in simple text format
 #include <boost/archive/text_oarchive.hpp>
 #include <boost/archive/text_iarchive.hpp>
+#include "portable_binary_archive/portable_binary_iarchive.hpp"
+#include "portable_binary_archive/portable_binary_oarchive.hpp"
 #include <boost/serialization/split_free.hpp>
 #include <boost/serialization/vector.hpp>
 #include <boost/serialization/export.hpp>
@@ -37,6 +39,8 @@
 #include <boost/filesystem/fstream.hpp>
 #include <boost/iostreams/filtering_stream.hpp>
 #include <boost/iostreams/filter/zlib.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <algorithm>
 #include <fstream>
 #include <sstream>
 #include <iostream>
@@ -47,6 +51,7 @@
 #include "MachineBase/Memory.hpp"
 #include "MachineBase/RLMachine.hpp"
 #include "MachineBase/SaveGameHeader.hpp"
+#include "MachineBase/SaveGameIndex.hpp"
 #include "MachineBase/Serialization.hpp"
 #include "MachineBase/StackFrame.hpp"
 #include "Systems/Base/AnmGraphicsObjectData.hpp"
@@ -59,6 +64,7 @@
 #include "Systems/Base/SoundSystem.hpp"
 #include "Systems/Base/System.hpp"
 #include "Systems/Base/TextSystem.hpp"
+#include "Utilities/AsyncFileWriter.hpp"
 #include "Utilities/Exception.hpp"
 #include "Utilities/algoplus.hpp"
 #include "Utilities/gettext.h"
@@ -74,12 +80,24 @@ namespace Serialization {
 
 RLMachine* g_current_machine = NULL;
 
-const int CURRENT_LOCAL_VERSION = 2;
+// Version 2 saves are zlib compressed text archives. Version 3 saves are
+// portable binary archives, which read the same on 32 and 64 bit builds; see
+// saveGameTo() for the layout.
+const int CURRENT_LOCAL_VERSION = 3;
 
 }  // namespace Serialization
 
 namespace {
 
+using Serialization::CURRENT_LOCAL_VERSION;
+
+// Starts every binary save game. Older saves begin directly with a zlib
+// stream, whose first byte is never 'R'.
+const char SAVE_MAGIC[8] = { 'R', 'L', 'V', 'M', 'S', 'A', 'V', 0 };
+
+// The name of the header cache in the save game directory.
+const char SAVE_INDEX_FILENAME[] = "saveindex.dat";
+
 template<typename TYPE>
 void checkInFileOpened(TYPE& file, const fs::path& home) {
   if (!file) {
@@ -88,38 +106,141 @@ void checkInFileOpened(TYPE& file, const fs::path& home) {
   }
 }
 
+// Reads a save game in either format. The header is read immediately; the
+// compressed remainder is only touched once something asks for it.
+class SaveGameReader {
+ public:
+  explicit SaveGameReader(std::istream& iss)
+      : iss_(iss), binary_(iss.peek() == SAVE_MAGIC[0]) {
+    if (binary_) {
+      char magic[sizeof(SAVE_MAGIC)];
+      iss_.read(magic, sizeof(magic));
+      if (!iss_ || !std::equal(magic, magic + sizeof(magic), SAVE_MAGIC))
+        throw rlvm::Exception("Corrupt save game file");
+
+      portable_binary_iarchive ia(iss_);
+      ia >> version_ >> header_;
+      if (version_ > CURRENT_LOCAL_VERSION)
+        throw rlvm::Exception("Save game is from a newer version of rlvm");
+    } else {
+      openPayload();
+      *text_archive_ >> version_ >> header_;
+    }
+  }
+
+  const SaveGameHeader& header() const { return header_; }
+
+  template<typename T>
+  SaveGameReader& operator>>(T& t) {
+    if (!text_archive_ && !binary_archive_)
+      openPayload();
+
+    if (binary_archive_)
+      *binary_archive_ >> t;
+    else
+      *text_archive_ >> t;
+    return *this;
+  }
+
+ private:
+  void openPayload() {
+    filtered_input_.push(boost::iostreams::zlib_decompressor());
+    filtered_input_.push(iss_);
+    if (binary_)
+      binary_archive_.reset(new portable_binary_iarchive(filtered_input_));
+    else
+      text_archive_.reset(new text_iarchive(filtered_input_));
+  }
+
+  std::istream& iss_;
+  bool binary_;
+  int version_;
+  SaveGameHeader header_;
+
+  boost::iostreams::filtering_stream<boost::iostreams::input> filtered_input_;
+  boost::scoped_ptr<portable_binary_iarchive> binary_archive_;
+  boost::scoped_ptr<text_iarchive> text_archive_;
+};
+
+// Writes the uncompressed start of a save game in the current format. The
+// header goes in its own archive so that it can be read without inflating the
+// rest of the file.
+void writeSaveGameHeader(std::ostream& oss, const SaveGameHeader& header) {
+  oss.write(SAVE_MAGIC, sizeof(SAVE_MAGIC));
+  portable_binary_oarchive oa(oss);
+  oa << CURRENT_LOCAL_VERSION << header;
+}
+
+// Writes the body of a save game, which goes after the header through zlib.
+void writeSaveGameBody(std::ostream& oss, RLMachine& machine) {
+  portable_binary_oarchive oa(oss);
+  oa << const_cast<const LocalMemory&>(machine.memory().local())
+     << const_cast<const RLMachine&>(machine)
+     << const_cast<const System&>(machine.system())
+     << const_cast<const GraphicsSystem&>(machine.system().graphics())
+     << const_cast<const TextSystem&>(machine.system().text())
+     << const_cast<const SoundSystem&>(machine.system().sound());
+}
+
+// Returns the header cache for the current game's save directory.
+SaveGameIndex& saveGameIndex(RLMachine& machine) {
+  static boost::scoped_ptr<SaveGameIndex> index;
+
+  fs::path index_file =
+      machine.system().gameSaveDirectory() / SAVE_INDEX_FILENAME;
+  if (!index || index->indexFile() != index_file)
+    index.reset(new SaveGameIndex(index_file));
+  return *index;
+}
+
 }  // namespace
 
 namespace Serialization {
 
 void saveGameForSlot(RLMachine& machine, int slot) {
   fs::path path = buildSaveGameFilename(machine, slot);
-  fs::ofstream file(path, ios::binary);
-  checkInFileOpened(file, path);
+  const SaveGameHeader header(machine.system().graphics().windowSubtitle());
+
+  // Only the snapshot of the game state happens here; compressing it and
+  // writing it to disk is left to the writer thread.
+  ostringstream header_data(ios::binary);
+  ostringstream body_data(ios::binary);
+
+  g_current_machine = &machine;
+
+  try {
+    writeSaveGameHeader(header_data, header);
+    writeSaveGameBody(body_data, machine);
+  }
+  catch(std::exception& e) {
+    cerr << "--- WARNING: ERROR DURING SAVING FILE: " << e.what() << " ---"
+         << endl;
+
+    g_current_machine = NULL;
+    throw e;
+  }
+
+  g_current_machine = NULL;
+
+  // The cached header is stale as soon as the new save lands.
+  saveGameIndex(machine).remove(slot);
 
-  saveGameTo(file, machine);
+  AsyncFileWriter::Shared().write(path, header_data.str(), body_data.str());
 }
 
 void saveGameTo(std::ostream& oss, RLMachine& machine) {
-  using namespace boost::iostreams;
-  filtering_stream<output> filtered_output;
-  filtered_output.push(zlib_compressor());
-  filtered_output.push(oss);
-
   const SaveGameHeader header(machine.system().graphics().windowSubtitle());
 
   g_current_machine = &machine;
 
   try {
-    text_oarchive oa(filtered_output);
-    oa << CURRENT_LOCAL_VERSION
-       << header
-       << const_cast<const LocalMemory&>(machine.memory().local())
-       << const_cast<const RLMachine&>(machine)
-       << const_cast<const System&>(machine.system())
-       << const_cast<const GraphicsSystem&>(machine.system().graphics())
-       << const_cast<const TextSystem&>(machine.system().text())
-       << const_cast<const SoundSystem&>(machine.system().sound());
+    writeSaveGameHeader(oss, header);
+
+    using namespace boost::iostreams;
+    filtering_stream<output> filtered_output;
+    filtered_output.push(zlib_compressor());
+    filtered_output.push(oss);
+    writeSaveGameBody(filtered_output, machine);
   }
   catch(std::exception& e) {
     cerr << "--- WARNING: ERROR DURING SAVING FILE: " << e.what() << " ---"
@@ -132,6 +253,10 @@ void saveGameTo(std::ostream& oss, RLMachine& machine) {
   g_current_machine = NULL;
 }
 
+void waitForPendingSaves() {
+  AsyncFileWriter::Shared().flush();
+}
+
 fs::path buildSaveGameFilename(RLMachine& machine, int slot) {
   ostringstream oss;
   oss << "save" << setw(3) << setfill('0') << slot << ".sav.gz";
@@ -140,30 +265,31 @@ fs::path buildSaveGameFilename(RLMachine& machine, int slot) {
 }
 
 SaveGameHeader loadHeaderForSlot(RLMachine& machine, int slot) {
+  waitForPendingSaves();
   fs::path path = buildSaveGameFilename(machine, slot);
-  fs::ifstream file(path, ios::binary);
-  checkInFileOpened(file, path);
-
-  return loadHeaderFrom(file);
-}
-
-SaveGameHeader loadHeaderFrom(std::istream& iss) {
-  using namespace boost::iostreams;
-  filtering_stream<input> filtered_input;
-  filtered_input.push(zlib_decompressor());
-  filtered_input.push(iss);
 
-  int version;
+  SaveGameIndex& index = saveGameIndex(machine);
   SaveGameHeader header;
+  if (index.lookup(slot, path, &header))
+    return header;
 
-  // Only load the header
-  text_iarchive ia(filtered_input);
-  ia >> version >> header;
+  {
+    fs::ifstream file(path, ios::binary);
+    checkInFileOpened(file, path);
+    header = loadHeaderFrom(file);
+  }
 
+  index.update(slot, path, header);
   return header;
 }
 
+SaveGameHeader loadHeaderFrom(std::istream& iss) {
+  // Only load the header
+  return SaveGameReader(iss).header();
+}
+
 void loadLocalMemoryForSlot(RLMachine& machine, int slot, Memory& memory) {
+  waitForPendingSaves();
   fs::path path = buildSaveGameFilename(machine, slot);
   fs::ifstream file(path, ios::binary);
   checkInFileOpened(file, path);
@@ -172,22 +298,12 @@ void loadLocalMemoryForSlot(RLMachine& machine, int slot, Memory& memory) {
 }
 
 void loadLocalMemoryFrom(std::istream& iss, Memory& memory) {
-  using namespace boost::iostreams;
-  filtering_stream<input> filtered_input;
-  filtered_input.push(zlib_decompressor());
-  filtered_input.push(iss);
-
-  int version;
-  SaveGameHeader header;
-
-  // Only load the header
-  text_iarchive ia(filtered_input);
-  ia >> version
-     >> header
-     >> memory.local();
+  SaveGameReader reader(iss);
+  reader >> memory.local();
 }
 
 void loadGameForSlot(RLMachine& machine, int slot) {
+  waitForPendingSaves();
   fs::path path = buildSaveGameFilename(machine, slot);
   fs::ifstream file(path, ios::binary);
   checkInFileOpened(file, path);
@@ -196,14 +312,6 @@ void loadGameForSlot(RLMachine& machine, int slot) {
 }
 
 void loadGameFrom(std::istream& iss, RLMachine& machine) {
-  using namespace boost::iostreams;
-  filtering_stream<input> filtered_input;
-  filtered_input.push(zlib_decompressor());
-  filtered_input.push(iss);
-
-  int version;
-  SaveGameHeader header;
-
   g_current_machine = &machine;
 
   try {
@@ -211,18 +319,20 @@ void loadGameFrom(std::istream& iss, RLMachine& machine) {
     // often hold references to objects in the System heiarchy.
     machine.reset();
 
-    text_iarchive ia(filtered_input);
-    ia >> version
-       >> header
-       >> machine.memory().local()
-       >> machine
-       >> machine.system()
-       >> machine.system().graphics()
-       >> machine.system().text()
-       >> machine.system().sound();
+    SaveGameReader reader(iss);
+    reader >> machine.memory().local()
+           >> machine
+           >> machine.system()
+           >> machine.system().graphics()
+           >> machine.system().text()
+           >> machine.system().sound();
 
     machine.system().graphics().replayGraphicsStack(machine);
 
+    // What we just loaded is the state at a savepoint; saving again before
+    // the next one should write it back out, not whatever came before.
+    machine.markSavepoint();
+
     machine.system().graphics().forceRefresh();
   }
   catch(std::exception& e) {
@@ -27,6 +27,8 @@
 
 #include <boost/archive/text_iarchive.hpp>
 #include <boost/archive/text_oarchive.hpp>
+#include "portable_binary_archive/portable_binary_iarchive.hpp"
+#include "portable_binary_archive/portable_binary_oarchive.hpp"
 
 #include "MachineBase/StackFrame.hpp"
 
@@ -117,12 +119,16 @@ void StackFrame::load(Archive & ar, unsigned int version) {
 
 // -----------------------------------------------------------------------
 
-// Explicit instantiations for text archives (since we hide the
+// Explicit instantiations for text and binary archives (since we hide the
 // implementation)
 
 template void StackFrame::save<boost::archive::text_oarchive>(
   boost::archive::text_oarchive & ar, unsigned int version) const;
+template void StackFrame::save<portable_binary_oarchive>(
+  portable_binary_oarchive & ar, unsigned int version) const;
 
 template void StackFrame::load<boost::archive::text_iarchive>(
   boost::archive::text_iarchive & ar, unsigned int version);
+template void StackFrame::load<portable_binary_iarchive>(
+  portable_binary_iarchive & ar, unsigned int version);
 
@@ -59,40 +59,40 @@ struct LongOp_bgmWait : public LongOperation {
 };
 
 struct bgmLoop_0 : public RLOp_Void_1<StrConstant_T> {
-  void operator()(RLMachine& machine, string filename) {
+  void operator()(RLMachine& machine, const string& filename) {
     machine.system().sound().bgmPlay(filename, true);
   }
 };
 
 struct bgmLoop_1 : public RLOp_Void_2<StrConstant_T, IntConstant_T> {
-  void operator()(RLMachine& machine, string filename, int fadein) {
+  void operator()(RLMachine& machine, const string& filename, int fadein) {
     machine.system().sound().bgmPlay(filename, true, fadein);
   }
 };
 
 struct bgmLoop_2 : public RLOp_Void_3<StrConstant_T, IntConstant_T,
                                           IntConstant_T> {
-  void operator()(RLMachine& machine, string filename, int fadein,
+  void operator()(RLMachine& machine, const string& filename, int fadein,
                   int fadeout) {
     machine.system().sound().bgmPlay(filename, true, fadein, fadeout);
   }
 };
 
 struct bgmPlay_0 : public RLOp_Void_1<StrConstant_T> {
-  void operator()(RLMachine& machine, string filename) {
+  void operator()(RLMachine& machine, const string& filename) {
     machine.system().sound().bgmPlay(filename, false);
   }
 };
 
 struct bgmPlay_1 : public RLOp_Void_2<StrConstant_T, IntConstant_T> {
-  void operator()(RLMachine& machine, string filename, int fadein) {
+  void operator()(RLMachine& machine, const string& filename, int fadein) {
     machine.system().sound().bgmPlay(filename, false, fadein);
   }
 };
 
 struct bgmPlay_2 : public RLOp_Void_3<StrConstant_T, IntConstant_T,
                                           IntConstant_T> {
-  void operator()(RLMachine& machine, string filename, int fadein,
+  void operator()(RLMachine& machine, const string& filename, int fadein,
                   int fadeout) {
     machine.system().sound().bgmPlay(filename, false, fadein, fadeout);
   }
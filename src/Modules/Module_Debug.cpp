@@ -52,7 +52,7 @@ struct DebugMessageInt : public RLOp_Void_1< IntConstant_T > {
 };
 
 struct DebugMessageStr : public RLOp_Void_1< StrConstant_T > {
-  void operator()(RLMachine& machine, std::string value) {
+  void operator()(RLMachine& machine, const std::string& value) {
     if (machine.system().gameexe()("MEMORY").exists()) {
       string utfvalue = cp932toUTF8(value, machine.getTextEncoding());
       cerr << "DebugMessage: " << utfvalue << endl;
@@ -31,7 +31,7 @@
 #include "Systems/Base/System.hpp"
 
 struct g00Preload : public RLOp_Void_2< IntConstant_T, StrConstant_T > {
-  void operator()(RLMachine& machine, int slot, string name) {
+  void operator()(RLMachine& machine, int slot, const string& name) {
     machine.system().graphics().PreloadG00(slot, name);
   }
 };
@@ -48,11 +48,13 @@
 #include "MachineBase/RLOperation/Rect_T.hpp"
 #include "MachineBase/RLOperation/Special_T.hpp"
 #include "Systems/Base/Colour.hpp"
+#include "Systems/Base/GraphicsStackAnalysis.hpp"
 #include "Systems/Base/GraphicsStackFrame.hpp"
 #include "Systems/Base/GraphicsSystem.hpp"
 #include "Systems/Base/Surface.hpp"
 #include "Systems/Base/System.hpp"
 #include "Systems/Base/TextSystem.hpp"
+#include "Utilities/Exception.hpp"
 #include "Utilities/Graphics.hpp"
 #include "libReallive/bytecode.h"
 #include "libReallive/gameexe.h"
@@ -99,15 +101,15 @@ void blitDC1toDC0(RLMachine& machine) {
 // Kanon uses the recOpen('?', ...) form for rendering Last Regrets. This isn't
 // documented in the rldev manual, and we must check for that case.
 void loadImageToDC1(RLMachine& machine,
-                    std::string name,
+                    const std::string& fileName,
                     const Rect& srcRect,
                     const Point& dest,
                     int opacity, bool useAlpha) {
   GraphicsSystem& graphics = machine.system().graphics();
 
-  if (name != "?") {
-    if (name == "???")
-      name = graphics.defaultGrpName();
+  if (fileName != "?") {
+    const std::string& name =
+        fileName == "???" ? graphics.defaultGrpName() : fileName;
 
     boost::shared_ptr<Surface> dc0 = graphics.getDC(0);
     boost::shared_ptr<Surface> dc1 = graphics.getDC(1);
@@ -245,7 +247,8 @@ struct load_1 : public RLOp_Void_3<StrConstant_T, IntConstant_T,
   bool use_alpha_;
   explicit load_1(bool in) : use_alpha_(in) {}
 
-  void operator()(RLMachine& machine, string filename, int dc, int opacity) {
+  void operator()(RLMachine& machine, const string& filename, int dc,
+                  int opacity) {
     GraphicsSystem& graphics = machine.system().graphics();
 
     boost::shared_ptr<const Surface> surface(
@@ -273,7 +276,7 @@ struct load_3 : public RLOp_Void_5<
   bool use_alpha_;
   explicit load_3(bool in) : use_alpha_(in) {}
 
-  void operator()(RLMachine& machine, string filename, int dc,
+  void operator()(RLMachine& machine, const string& filename, int dc,
                   Rect srcRect, Point dest, int opacity) {
     GraphicsSystem& graphics = machine.system().graphics();
     boost::shared_ptr<const Surface> surface(
@@ -389,7 +392,7 @@ struct open_1 : public RLOp_Void_3<StrConstant_T, IntConstant_T,
   bool use_alpha_;
   explicit open_1(bool in) : use_alpha_(in) {}
 
-  void operator()(RLMachine& machine, string filename, int effectNum,
+  void operator()(RLMachine& machine, const string& filename, int effectNum,
                   int opacity) {
     Rect src;
     Point dest;
@@ -416,7 +419,7 @@ struct open_0 : public RLOp_Void_2<StrConstant_T, IntConstant_T> {
   open_1 delegate_;
   explicit open_0(bool in) : delegate_(in) {}
 
-  void operator()(RLMachine& machine, string filename, int effectNum) {
+  void operator()(RLMachine& machine, const string& filename, int effectNum) {
     vector<int> selEffect = getSELEffect(machine, effectNum);
     delegate_(machine, filename, effectNum, selEffect[14]);
   }
@@ -428,7 +431,7 @@ struct open_3 : public RLOp_Void_5<
   bool use_alpha_;
   explicit open_3(bool in) : use_alpha_(in) {}
 
-  void operator()(RLMachine& machine, string filename, int effectNum,
+  void operator()(RLMachine& machine, const string& filename, int effectNum,
                   Rect srcRect, Point dest, int opacity) {
     GraphicsSystem& graphics = machine.system().graphics();
 
@@ -456,7 +459,7 @@ struct open_2 : public RLOp_Void_4<
   open_3<SPACE> delegate_;
   explicit open_2(bool in) : delegate_(in) {}
 
-  void operator()(RLMachine& machine, string filename, int effectNum,
+  void operator()(RLMachine& machine, const string& filename, int effectNum,
                   Rect src, Point dest) {
     int opacity = getSELEffect(machine, effectNum).at(14);
     delegate_(machine, filename, effectNum, src, dest, opacity);
@@ -472,7 +475,7 @@ struct open_4 : public RLOp_Void_13<
   bool use_alpha_;
   explicit open_4(bool in) : use_alpha_(in) {}
 
-  void operator()(RLMachine& machine, string fileName,
+  void operator()(RLMachine& machine, const string& fileName,
                   Rect srcRect, Point dest,
                   int time, int style, int direction, int interpolation,
                   int xsize, int ysize, int a, int b, int opacity, int c) {
@@ -494,7 +497,7 @@ struct open_4 : public RLOp_Void_13<
 
 struct openBg_1 : public RLOp_Void_3<StrConstant_T, IntConstant_T,
                                      IntConstant_T > {
-  void operator()(RLMachine& machine, string fileName, int effectNum,
+  void operator()(RLMachine& machine, const string& fileName, int effectNum,
                   int opacity) {
     GraphicsSystem& graphics = machine.system().graphics();
     Rect srcRect;
@@ -517,7 +520,7 @@ struct openBg_1 : public RLOp_Void_3<StrConstant_T, IntConstant_T,
 struct openBg_0 : public RLOp_Void_2< StrConstant_T, IntConstant_T > {
   openBg_1 delegate_;
 
-  void operator()(RLMachine& machine, string filename, int effectNum) {
+  void operator()(RLMachine& machine, const string& filename, int effectNum) {
     vector<int> selEffect = getSELEffect(machine, effectNum);
     delegate_(machine, filename, effectNum, selEffect[14]);
   }
@@ -529,7 +532,7 @@ struct openBg_3 : public RLOp_Void_5<
   bool use_alpha_;
   explicit openBg_3(bool in) : use_alpha_(in) {}
 
-  void operator()(RLMachine& machine, string fileName, int effectNum,
+  void operator()(RLMachine& machine, const string& fileName, int effectNum,
                   Rect srcRect, Point destPt, int opacity) {
     GraphicsSystem& graphics = machine.system().graphics();
     OpenBgPrelude(machine, fileName);
@@ -552,7 +555,7 @@ struct openBg_2
   openBg_3<SPACE> delegate_;
   explicit openBg_2(bool in) : delegate_(in) {}
 
-  void operator()(RLMachine& machine, string fileName, int effectNum,
+  void operator()(RLMachine& machine, const string& fileName, int effectNum,
                   Rect srcRect, Point destPt) {
     vector<int> selEffect = getSELEffect(machine, effectNum);
     delegate_(machine, fileName, effectNum, srcRect, destPt, selEffect[14]);
@@ -568,7 +571,7 @@ struct openBg_4 : public RLOp_Void_13<
   bool use_alpha_;
   explicit openBg_4(bool in) : use_alpha_(in) {}
 
-  void operator()(RLMachine& machine, string fileName,
+  void operator()(RLMachine& machine, const string& fileName,
                   Rect srcRect, Point destPt,
                   int time, int style, int direction, int interpolation,
                   int xsize, int ysize, int a, int b, int opacity, int c) {
@@ -942,8 +945,8 @@ struct multi_str_1
     : public RLOp_Void_4<StrConstant_T, IntConstant_T, IntConstant_T,
                          MultiCommand>,
       public multi_command<SPACE> {
-  void operator()(RLMachine& machine, string filename, int effect, int alpha,
-                  MultiCommand::type commands) {
+  void operator()(RLMachine& machine, const string& filename, int effect,
+                  int alpha, MultiCommand::type commands) {
     load_1(false)(machine, filename, MULTI_TARGET_DC, 255);
     multi_command<SPACE>::handleMultiCommands(machine, commands);
     display_0()(machine, MULTI_TARGET_DC, effect);
@@ -955,7 +958,7 @@ struct multi_str_0
     : public RLOp_Void_3<StrConstant_T, IntConstant_T, MultiCommand> {
   multi_str_1<SPACE> delegate_;
 
-  void operator()(RLMachine& machine, string filename, int effect,
+  void operator()(RLMachine& machine, const string& filename, int effect,
                   MultiCommand::type commands) {
     delegate_(machine, filename, effect, 255, commands);
   }
@@ -1248,8 +1251,150 @@ GrpModule::GrpModule()
 
 // -----------------------------------------------------------------------
 
+namespace {
+
+// Evaluates parameter |index| of a graphics stack command. Everything on the
+// graphics stack was serialized with constant parameters, so this doesn't
+// touch any memory banks.
+const libReallive::ExpressionPiece& StackParameter(
+    const libReallive::CommandElement& command, size_t index,
+    std::unique_ptr<libReallive::ExpressionPiece>* storage) {
+  if (index >= command.param_count())
+    throw rlvm::Exception("Missing parameter in graphics stack command");
+
+  std::string param = command.get_param(index);
+  const char* src = param.c_str();
+  *storage = libReallive::get_data(src);
+  return **storage;
+}
+
+int IntStackParameter(RLMachine& machine,
+                      const libReallive::CommandElement& command,
+                      size_t index) {
+  std::unique_ptr<libReallive::ExpressionPiece> storage;
+  return StackParameter(command, index, &storage).integerValue(machine);
+}
+
+std::string StrStackParameter(RLMachine& machine,
+                              const libReallive::CommandElement& command,
+                              size_t index) {
+  std::unique_ptr<libReallive::ExpressionPiece> storage;
+  return StackParameter(command, index, &storage).getStringValue(machine);
+}
+
+// Works out what replaying |command| will do to the DCs. Only the handful of
+// commands that make up most of a typical graphics stack are understood;
+// everything else (open, display, effects, stretch blits, ...) is treated as
+// something that may read or write any DC.
+GraphicsStackEffect DescribeStackCommand(
+    RLMachine& machine, const libReallive::CommandElement& command) {
+  GraphicsStackEffect effect;
+  if (command.modtype() != 1 || command.module() != 33)
+    return effect;
+
+  try {
+    int opcode = command.opcode();
+    int overload = command.overload();
+    switch (opcode) {
+      case 15: {
+        // allocDC
+        int dc = IntStackParameter(machine, command, 0);
+        if (overload == 0 && dc >= 1) {
+          effect.understood = true;
+          effect.writes.push_back(dc);
+          effect.replaces.push_back(dc);
+          effect.reallocates = true;
+        }
+        break;
+      }
+      case 31:
+      case 201: {
+        // wipe, and the whole DC forms of fill.
+        if (opcode == 201 && overload > 1)
+          break;
+        int dc = IntStackParameter(machine, command, 0);
+        effect.understood = true;
+        effect.writes.push_back(dc);
+        effect.replaces.push_back(dc);
+        // Filling a DC that was never allocated allocates it.
+        if (dc >= 1)
+          effect.resizes.push_back(dc);
+        break;
+      }
+      case 50:
+      case 51:
+      case 70:
+      case 71:
+      case 1050:
+      case 1051: {
+        // The {grp,rec}(Mask)?(Load|Buffer) family.
+        effect.image = StrStackParameter(machine, command, 0);
+        int dc = IntStackParameter(machine, command, 1);
+        effect.understood = true;
+        effect.writes.push_back(dc);
+        if (overload <= 1 && dc >= 2) {
+          // load_1 reallocates the DC at the image's size before blitting.
+          effect.replaces.push_back(dc);
+          effect.reallocates = true;
+        } else if (dc >= 1) {
+          effect.resizes.push_back(dc);
+        }
+        break;
+      }
+      case 73:
+      case 74:
+      case 76:
+      case 1053:
+      case 1054:
+      case 1056:
+        // The open family composites over DC0 and DC1 and runs effects;
+        // don't try to model that, but do prefetch what it loads.
+        effect.image = StrStackParameter(machine, command, 0);
+        break;
+      case 100:
+      case 101:
+      case 1100:
+      case 1101: {
+        // The whole DC forms of {grp,rec}(Mask)?Copy.
+        if (overload > 1)
+          break;
+        int src = IntStackParameter(machine, command, 0);
+        int dst = IntStackParameter(machine, command, 1);
+        effect.understood = true;
+        if (src == dst)
+          break;
+        effect.writes.push_back(dst);
+        effect.reads.push_back(src);
+        if (src >= 1)
+          effect.resizes.push_back(src);
+        if (dst >= 1)
+          effect.resizes.push_back(dst);
+        break;
+      }
+      default:
+        break;
+    }
+  } catch (std::exception&) {
+    effect = GraphicsStackEffect();
+  }
+
+  // '?' and '???' are placeholders that are only resolved during replay.
+  if (!effect.image.empty() && effect.image[0] == '?')
+    effect.image.clear();
+
+  return effect;
+}
+
+}  // namespace
+
 void replayGraphicsStackCommand(RLMachine& machine,
                                 const std::deque<std::string>& stack) {
+  GraphicsSystem& graphics = machine.system().graphics();
+
+  // Parse the whole stack up front so we can see which commands are
+  // overwritten by later ones and which images we're about to need.
+  std::vector<libReallive::CommandElement*> commands;
+  std::string parse_error;
   try {
     for (auto const& command : stack) {
       if (command != "") {
@@ -1260,15 +1405,44 @@ void replayGraphicsStackCommand(RLMachine& machine,
                 command.c_str(), command.c_str() + command.size(), cdata);
         libReallive::CommandElement* command =
             dynamic_cast<libReallive::CommandElement*>(element);
-        if (command) {
-          machine.executeCommand(*command);
-        }
+        if (command)
+          commands.push_back(command);
+      }
+    }
+  } catch (std::exception& e) {
+    parse_error = e.what();
+  }
+
+  std::vector<GraphicsStackEffect> effects;
+  for (libReallive::CommandElement* command : commands)
+    effects.push_back(DescribeStackCommand(machine, *command));
+  std::vector<bool> overwritten = FindOverwrittenStackCommands(effects);
+
+  std::vector<std::string> images;
+  for (size_t i = 0; i < effects.size(); ++i) {
+    if (!overwritten[i] && !effects[i].image.empty())
+      images.push_back(effects[i].image);
+  }
+  graphics.prefetchSurfaces(images);
+
+  try {
+    for (size_t i = 0; i < commands.size(); ++i) {
+      if (overwritten[i]) {
+        // Keep the command on the stack so that it looks exactly like it did
+        // when the game was saved, even though we don't run it.
+        graphics.addGraphicsStackCommand(
+            commands[i]->serializableData(machine));
+      } else {
+        machine.executeCommand(*commands[i]);
       }
     }
   } catch (std::exception& e) {
     cerr << "Error while replaying graphics stack: " << e.what() << endl;
     return;
   }
+
+  if (!parse_error.empty())
+    cerr << "Error while replaying graphics stack: " << parse_error << endl;
 }
 
 // -----------------------------------------------------------------------
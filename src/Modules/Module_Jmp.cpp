@@ -466,7 +466,7 @@ struct rtl_with_1 : public RLOp_Void_Void {
 // one. Used in the Little Busters battle system to return string values that
 // refer to people's faces. (See SEEN8700).
 struct push_string_value_up : public RLOp_Void_2<IntConstant_T, StrConstant_T> {
-  void operator()(RLMachine& machine, int index, std::string val) {
+  void operator()(RLMachine& machine, int index, const std::string& val) {
     machine.pushStringValueUp(index, val);
   }
 };
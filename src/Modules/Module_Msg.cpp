@@ -97,7 +97,7 @@ struct SetFontColour : public RLOp_Void_1< DefaultIntValue_T< 0 > > {
 };
 
 struct doruby_display : public RLOp_Void_1< StrConstant_T > {
-  void operator()(RLMachine& machine, std::string cpStr) {
+  void operator()(RLMachine& machine, const std::string& cpStr) {
     std::string utf8str = cp932toUTF8(cpStr, machine.getTextEncoding());
     machine.system().text().currentPage().displayRubyText(utf8str);
   }
@@ -191,7 +191,7 @@ struct TextOffset : public RLOp_Void_2<IntConstant_T, IntConstant_T> {
 };
 
 struct FaceOpen : public RLOp_Void_2<StrConstant_T, DefaultIntValue_T<0> > {
-  void operator()(RLMachine& machine, string file, int index) {
+  void operator()(RLMachine& machine, const string& file, int index) {
     TextPage& page = machine.system().text().currentPage();
     page.faceOpen(file, index);
   }
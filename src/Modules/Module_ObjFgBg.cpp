@@ -206,7 +206,7 @@ struct objSetRect_0
 
 struct objSetText
     : public RLOp_Void_2<IntConstant_T, DefaultStrValue_T> {
-  void operator()(RLMachine& machine, int buf, string val) {
+  void operator()(RLMachine& machine, int buf, const string& val) {
     GraphicsObject& obj = getGraphicsObject(machine, this, buf);
     std::string utf8str = cp932toUTF8(val, machine.getTextEncoding());
     obj.setTextText(utf8str);
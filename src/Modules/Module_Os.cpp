@@ -47,7 +47,8 @@ namespace {
 // always return true to get over this speed bump.
 struct CheckFile
   : public RLOp_Store_3<StrConstant_T, IntConstant_T, StrConstant_T> {
-  int operator()(RLMachine& machine, string one, int two, string three) {
+  int operator()(RLMachine& machine, const string& one, int two,
+                 const string& three) {
     return 1;
   }
 };
@@ -83,7 +83,7 @@ string rl_itoa_implementation(int number, int length, char fill) {
 // Assigns the string value val to the string variable dest.
 struct strcpy_0 : public RLOp_Void_2< StrReference_T, StrConstant_T > {
   void operator()(RLMachine& machine, StringReferenceIterator dest,
-                  string val) {
+                  const string& val) {
     *dest = val;
   }
 };
@@ -93,8 +93,8 @@ struct strcpy_0 : public RLOp_Void_2< StrReference_T, StrConstant_T > {
 // Assigns the first count characters of val to the string variable dest.
 struct strcpy_1 : public RLOp_Void_3< StrReference_T, StrConstant_T,
                                           IntConstant_T > {
-  void operator()(RLMachine& machine, StringReferenceIterator dest, string val,
-                  int count) {
+  void operator()(RLMachine& machine, StringReferenceIterator dest,
+                  const string& val, int count) {
     *dest = val.substr(0, count);
   }
 };
@@ -123,7 +123,7 @@ struct strclear_1 : public RLOp_Void_2< StrReference_T, StrReference_T > {
 // the string into the memory location of the first.
 struct Str_strcat : public RLOp_Void_2< StrReference_T, StrConstant_T > {
   void operator()(RLMachine& machine, StringReferenceIterator it,
-                  string append) {
+                  const string& append) {
     string s = *it;
     s += append;
     *it = s;
@@ -133,7 +133,7 @@ struct Str_strcat : public RLOp_Void_2< StrReference_T, StrConstant_T > {
 // Implement op<1:Str:00003, 0>, fun strlen(strC). Returns the length
 // of value; Double-byte characters are counted as two bytes.
 struct Str_strlen : public RLOp_Store_1< StrConstant_T > {
-  int operator()(RLMachine& machine, string value) {
+  int operator()(RLMachine& machine, const string& value) {
     return value.size();
   }
 };
@@ -145,7 +145,7 @@ struct Str_strlen : public RLOp_Store_1< StrConstant_T > {
 //
 // TODO(erg): THIS NEEDS TO HANDLE JSX ORDERING, NOT JUST ASCII!
 struct Str_strcmp : public RLOp_Store_2< StrConstant_T, StrConstant_T> {
-  int operator()(RLMachine& machine, string lhs, string rhs) {
+  int operator()(RLMachine& machine, const string& lhs, const string& rhs) {
     return strcmp(lhs.c_str(), rhs.c_str());
   }
 };
@@ -156,7 +156,7 @@ struct Str_strcmp : public RLOp_Store_2< StrConstant_T, StrConstant_T> {
 struct strsub_0 : public RLOp_Void_3<StrReference_T, StrConstant_T,
                                          IntConstant_T> {
   void operator()(RLMachine& machine, StringReferenceIterator dest,
-                  string source, int offset) {
+                  const string& source, int offset) {
     const char* str = source.c_str();
     string output;
 
@@ -189,7 +189,7 @@ struct strsub_0 : public RLOp_Void_3<StrReference_T, StrConstant_T,
 struct strsub_1 : public RLOp_Void_4< StrReference_T, StrConstant_T,
                                           IntConstant_T, IntConstant_T> {
   void operator()(RLMachine& machine, StringReferenceIterator dest,
-                  string source, int offset, int length) {
+                  const string& source, int offset, int length) {
     const char* str = source.c_str();
     string output;
 
@@ -216,7 +216,7 @@ struct strsub_1 : public RLOp_Void_4< StrReference_T, StrConstant_T,
 // Implements op<1:Str:00006, 0>, fun strrsub(str, strC, intC).
 struct strrsub_0 : public strsub_0 {
   void operator()(RLMachine& machine, StringReferenceIterator dest,
-                  string source, int offsetFromBack) {
+                  const string& source, int offsetFromBack) {
     int offset = strcharlen(source.c_str()) - offsetFromBack;
     return strsub_0::operator()(machine, dest, source, offset);
   }
@@ -225,7 +225,7 @@ struct strrsub_0 : public strsub_0 {
 // Implements op<1:Str:00006, 1>, fun strrsub(str, strC, intC, intC).
 struct strrsub_1 : public strsub_1 {
   void operator()(RLMachine& machine, StringReferenceIterator dest,
-                  string source, int offsetFromBack, int length) {
+                  const string& source, int offsetFromBack, int length) {
     if (length > offsetFromBack) {
       throw rlvm::Exception(
           "strrsub: length of substring greater then offset in rsub");
@@ -240,7 +240,7 @@ struct strrsub_1 : public strsub_1 {
 // number of characters (as opposed to bytes) in a string. This
 // function deals with Shift_JIS characters properly.
 struct Str_strcharlen : public RLOp_Store_1< StrConstant_T > {
-  int operator()(RLMachine& machine, string val) {
+  int operator()(RLMachine& machine, const string& val) {
     return strcharlen(val.c_str());
   }
 };
@@ -275,7 +275,7 @@ struct hantozen_0 : public RLOp_Void_1< StrReference_T > {
 //
 // Changes half width characters to their full width equivalents.
 struct hantozen_1 : public RLOp_Void_2< StrConstant_T, StrReference_T > {
-  void operator()(RLMachine& machine, string input,
+  void operator()(RLMachine& machine, const string& input,
                   StringReferenceIterator dest) {
     *dest = hantozen_cp932(input, machine.getTextEncoding());
   }
@@ -294,7 +294,7 @@ struct zentohan_0 : public RLOp_Void_1< StrReference_T > {
 //
 // Changes full width characters to their half width equivalents.
 struct zentohan_1 : public RLOp_Void_2< StrConstant_T, StrReference_T > {
-  void operator()(RLMachine& machine, string input,
+  void operator()(RLMachine& machine, const string& input,
                   StringReferenceIterator dest) {
     *dest = zentohan_cp932(input, machine.getTextEncoding());
   }
@@ -317,10 +317,11 @@ struct Uppercase_0 : public RLOp_Void_1< StrReference_T > {
 // Changes the case of all ASCII characters to UPPERCASE. This function does
 // not affect full-width Shift_JIS characters.
 struct Uppercase_1 : public RLOp_Void_2< StrConstant_T, StrReference_T > {
-  void operator()(RLMachine& machine, string input,
+  void operator()(RLMachine& machine, const string& input,
                   StringReferenceIterator dest) {
-    transform(input.begin(), input.end(), input.begin(), ToUpper);
-    *dest = input;
+    string output = input;
+    transform(output.begin(), output.end(), output.begin(), ToUpper);
+    *dest = output;
   }
 };
 
@@ -341,10 +342,11 @@ struct Lowercase_0 : public RLOp_Void_1< StrReference_T > {
 // Changes the case of all ASCII characters to LOWERCASE. This function does
 // not affect full-width Shift_JIS characters.
 struct Lowercase_1 : public RLOp_Void_2< StrConstant_T, StrReference_T > {
-  void operator()(RLMachine& machine, string input,
+  void operator()(RLMachine& machine, const string& input,
                   StringReferenceIterator dest) {
-    transform(input.begin(), input.end(), input.begin(), ToLower);
-    *dest = input;
+    string output = input;
+    transform(output.begin(), output.end(), output.begin(), ToLower);
+    *dest = output;
   }
 };
 
@@ -458,7 +460,7 @@ struct itoa_1 : public RLOp_Void_3< IntConstant_T, StrReference_T,
 // testing and I failed most of them because lexical_cast has different
 // semantics about consuming *all* of the input string.
 struct Str_atoi : public RLOp_Store_1< StrConstant_T > {
-  int operator()(RLMachine& machine, string word) {
+  int operator()(RLMachine& machine, const string& word) {
     stringstream ss(word);
     int out;
     ss >> out;
@@ -508,7 +510,8 @@ struct Str_digit : public RLOp_Store_3< IntConstant_T, IntReference_T,
 // Returns the offset of the first instance of substring in str, or -1 if
 // substring is not found.
 struct Str_strpos : public RLOp_Store_2< StrConstant_T, StrConstant_T > {
-  int operator()(RLMachine& machine, string str, string substring) {
+  int operator()(RLMachine& machine, const string& str,
+                 const string& substring) {
     size_t pos = str.find(substring);
     if (pos == string::npos)
       return -1;
@@ -523,7 +526,8 @@ struct Str_strpos : public RLOp_Store_2< StrConstant_T, StrConstant_T > {
 // substring appears only once, or not at all, in string, the behaviour is
 // identical with that of strpos.
 struct Str_strlpos : public RLOp_Store_2< StrConstant_T, StrConstant_T > {
-  int operator()(RLMachine& machine, string str, string substring) {
+  int operator()(RLMachine& machine, const string& str,
+                 const string& substring) {
     size_t pos = str.rfind(substring);
     if (pos == string::npos)
       return -1;
@@ -536,7 +540,7 @@ struct Str_strlpos : public RLOp_Store_2< StrConstant_T, StrConstant_T > {
 //
 // Prints a string.
 struct Str_strout : public RLOp_Void_1< StrConstant_T > {
-  void operator()(RLMachine& machine, string value) {
+  void operator()(RLMachine& machine, const string& value) {
     // Assumption: Text is in whatever native encoding for getTextEncoding().
     machine.performTextout(value);
   }
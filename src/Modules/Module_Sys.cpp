@@ -72,7 +72,7 @@ using namespace std;
 namespace {
 
 struct title : public RLOp_Void_1< StrConstant_T > {
-  void operator()(RLMachine& machine, std::string subtitle) {
+  void operator()(RLMachine& machine, const std::string& subtitle) {
     machine.system().graphics().setWindowSubtitle(
       subtitle, machine.getTextEncoding());
   }
@@ -74,6 +74,7 @@ namespace {
 
 struct SaveExists : public RLOp_Store_1< IntConstant_T > {
   int operator()(RLMachine& machine, int slot) {
+    Serialization::waitForPendingSaves();
     fs::path saveFile = Serialization::buildSaveGameFilename(machine, slot);
     return fs::exists(saveFile) ? 1 : 0;
   }
@@ -246,6 +247,7 @@ struct GetSaveFlag : public RLOp_Store_2<IntConstant_T, GetSaveFlagList> {
 // been saved.
 struct LatestSave : public RLOp_Store_Void {
   int operator()(RLMachine& machine) {
+    Serialization::waitForPendingSaves();
     fs::path saveDir = machine.system().gameSaveDirectory();
     int latestSlot = -1;
     time_t latestTime = std::numeric_limits<time_t>::min();
@@ -93,6 +93,11 @@ GCNInfoWindow::GCNInfoWindow(RLMachine& machine, const RlvmInfo& info,
   values.push_back(
       new gcn::Label(transformationName(info.text_transformation)));
 
+  for (auto const& usage : info.memory_usage) {
+    keys.push_back(new gcn::Label(usage.first + ": "));
+    values.push_back(new gcn::Label(usage.second));
+  }
+
   int max_key_space = max_space(keys);
   int max_value_space = max_space(values);
   set_size_and_align(keys, max_key_space, gcn::Graphics::RIGHT);
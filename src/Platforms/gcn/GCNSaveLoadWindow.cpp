@@ -85,6 +85,7 @@ SaveGameListModel::SaveGameListModel(const std::string& no_data,
   int latestSlot = -1;
   time_t latestTime = numeric_limits<time_t>::min();
 
+  Serialization::waitForPendingSaves();
   for (int slot = 0; slot < 100; ++slot) {
     fs::path saveFile = Serialization::buildSaveGameFilename(machine, slot);
 
@@ -92,7 +92,11 @@ int main(int argc, char* argv[]) {
       ("help", "Produce help message")
       ("help-debug", "Print help message for people working on rlvm")
       ("version", "Display version and license information")
-      ("font", po::value<string>(), "Specifies TrueType font to use.");
+      ("font", po::value<string>(), "Specifies TrueType font to use.")
+      ("sound-cache-mb", po::value<int>(),
+       "Megabytes of decoded sound effects to keep in memory")
+      ("preparse",
+       "Parse each scene's commands on a background thread when it's entered");
 
   po::options_description debugOpts("Debugging Options");
   debugOpts.add_options()
@@ -103,7 +107,18 @@ int main(int argc, char* argv[]) {
       ("undefined-opcodes", "Display a message on undefined opcodes")
       ("count-undefined",
        "On exit, present a summary table about how many times each undefined "
-       "opcode was called");
+       "opcode was called")
+      ("profile-opcodes",
+       "On exit (or when F11 is pressed), print the time spent in each opcode "
+       "and on each SEEN line")
+      ("frame-timings",
+       "On exit, print percentiles of how long each part of a frame took")
+      ("trace-file", po::value<string>(),
+       "Record how long each part of a frame took and write it to the given "
+       "file as Chrome trace JSON (implies --frame-timings)")
+      ("memory-log", po::value<int>(),
+       "Every given number of seconds, print a line with the memory held by "
+       "each subsystem (press F10 for the full table)");
 
   // Declare the final option to be game-root
   po::options_description hidden("Hidden");
@@ -208,12 +223,30 @@ int main(int argc, char* argv[]) {
   if (vm.count("count-undefined"))
     instance.set_count_undefined();
 
+  if (vm.count("profile-opcodes"))
+    instance.set_profile_opcodes();
+
+  if (vm.count("frame-timings"))
+    instance.set_frame_timings();
+
+  if (vm.count("trace-file"))
+    instance.set_trace_file(vm["trace-file"].as<string>());
+
+  if (vm.count("memory-log"))
+    instance.set_memory_log_seconds(vm["memory-log"].as<int>());
+
   if (vm.count("load-save"))
     instance.set_load_save(vm["load-save"].as<int>());
 
   if (vm.count("font"))
     instance.set_custom_font(vm["font"].as<string>());
 
+  if (vm.count("sound-cache-mb"))
+    instance.set_sound_cache_mb(vm["sound-cache-mb"].as<int>());
+
+  if (vm.count("preparse"))
+    instance.set_preparse_parameters();
+
   instance.Run(gamerootPath);
 
   return 0;
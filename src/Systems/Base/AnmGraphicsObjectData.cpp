@@ -35,6 +35,8 @@
 
 #include <boost/archive/text_iarchive.hpp>
 #include <boost/archive/text_oarchive.hpp>
+#include "portable_binary_archive/portable_binary_iarchive.hpp"
+#include "portable_binary_archive/portable_binary_oarchive.hpp"
 #include <boost/serialization/export.hpp>
 #include <boost/serialization/scoped_ptr.hpp>
 
@@ -336,8 +338,12 @@ void AnmGraphicsObjectData::save(Archive& ar, unsigned int version) const {
 
 template void AnmGraphicsObjectData::save<boost::archive::text_oarchive>(
   boost::archive::text_oarchive & ar, unsigned int version) const;
+template void AnmGraphicsObjectData::save<portable_binary_oarchive>(
+  portable_binary_oarchive & ar, unsigned int version) const;
 
 template void AnmGraphicsObjectData::load<boost::archive::text_iarchive>(
   boost::archive::text_iarchive & ar, unsigned int version);
+template void AnmGraphicsObjectData::load<portable_binary_iarchive>(
+  portable_binary_iarchive & ar, unsigned int version);
 
 BOOST_CLASS_EXPORT(AnmGraphicsObjectData);
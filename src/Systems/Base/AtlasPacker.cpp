@@ -0,0 +1,127 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2013 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+// -----------------------------------------------------------------------
+
+
+#include "Systems/Base/AtlasPacker.hpp"
+
+AtlasPacker::AtlasPacker(const Size& size)
+    : size_(size), used_area_(0), allocations_(0) {
+  free_rects_.push_back(Rect(Point(0, 0), size));
+}
+
+AtlasPacker::~AtlasPacker() {
+}
+
+bool AtlasPacker::allocate(const Size& size, Rect* out) {
+  int best = -1;
+  int best_leftover = 0;
+  for (size_t i = 0; i < free_rects_.size(); ++i) {
+    const Rect& r = free_rects_[i];
+    if (r.width() < size.width() || r.height() < size.height())
+      continue;
+
+    int leftover = r.width() * r.height() - size.width() * size.height();
+    if (best == -1 || leftover < best_leftover) {
+      best = i;
+      best_leftover = leftover;
+    }
+  }
+
+  if (best == -1)
+    return false;
+
+  Rect free = free_rects_[best];
+  free_rects_.erase(free_rects_.begin() + best);
+
+  // Split the rest of |free| along the axis that leaves the larger piece
+  // whole.
+  int right_width = free.width() - size.width();
+  int bottom_height = free.height() - size.height();
+  Rect right, bottom;
+  if (right_width > bottom_height) {
+    right = Rect::REC(free.x() + size.width(), free.y(),
+                      right_width, free.height());
+    bottom = Rect::REC(free.x(), free.y() + size.height(),
+                       size.width(), bottom_height);
+  } else {
+    right = Rect::REC(free.x() + size.width(), free.y(),
+                      right_width, size.height());
+    bottom = Rect::REC(free.x(), free.y() + size.height(),
+                       free.width(), bottom_height);
+  }
+
+  if (right.width() > 0 && right.height() > 0)
+    free_rects_.push_back(right);
+  if (bottom.width() > 0 && bottom.height() > 0)
+    free_rects_.push_back(bottom);
+
+  *out = Rect(free.origin(), size);
+  used_area_ += size.width() * size.height();
+  allocations_++;
+  return true;
+}
+
+void AtlasPacker::release(const Rect& rect) {
+  used_area_ -= rect.width() * rect.height();
+  allocations_--;
+
+  if (allocations_ == 0) {
+    free_rects_.clear();
+    free_rects_.push_back(Rect(Point(0, 0), size_));
+    used_area_ = 0;
+    return;
+  }
+
+  free_rects_.push_back(rect);
+  mergeFreeRects();
+}
+
+void AtlasPacker::mergeFreeRects() {
+  bool merged = true;
+  while (merged) {
+    merged = false;
+    for (size_t i = 0; i < free_rects_.size() && !merged; ++i) {
+      for (size_t j = 0; j < free_rects_.size() && !merged; ++j) {
+        if (i == j)
+          continue;
+
+        Rect& a = free_rects_[i];
+        const Rect& b = free_rects_[j];
+        if (a.y() == b.y() && a.height() == b.height() && a.x2() == b.x()) {
+          a = Rect::REC(a.x(), a.y(), a.width() + b.width(), a.height());
+          merged = true;
+        } else if (a.x() == b.x() && a.width() == b.width() &&
+                   a.y2() == b.y()) {
+          a = Rect::REC(a.x(), a.y(), a.width(), a.height() + b.height());
+          merged = true;
+        }
+
+        if (merged)
+          free_rects_.erase(free_rects_.begin() + j);
+      }
+    }
+  }
+}
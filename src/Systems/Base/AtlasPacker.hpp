@@ -0,0 +1,66 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2013 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+// -----------------------------------------------------------------------
+
+
+#ifndef SRC_SYSTEMS_BASE_ATLASPACKER_HPP_
+#define SRC_SYSTEMS_BASE_ATLASPACKER_HPP_
+
+#include <vector>
+
+#include "Systems/Base/Rect.hpp"
+
+// Hands out rectangles from a fixed size page and takes them back. Free space
+// is kept as a list of disjoint rectangles: allocating picks the one that
+// leaves the least area over and splits what's left guillotine style, and
+// releasing merges neighbours back together where they line up. When the last
+// rectangle comes back, the whole page is free again.
+class AtlasPacker {
+ public:
+  explicit AtlasPacker(const Size& size);
+  ~AtlasPacker();
+
+  // Finds room for |size|. Returns false if the page has no free rectangle
+  // large enough.
+  bool allocate(const Size& size, Rect* out);
+
+  // Gives back a rectangle returned by allocate().
+  void release(const Rect& rect);
+
+  const Size& size() const { return size_; }
+  int usedArea() const { return used_area_; }
+  int allocations() const { return allocations_; }
+
+ private:
+  // Repeatedly joins pairs of free rectangles that share a whole edge.
+  void mergeFreeRects();
+
+  Size size_;
+  std::vector<Rect> free_rects_;
+  int used_area_;
+  int allocations_;
+};  // class AtlasPacker
+
+#endif  // SRC_SYSTEMS_BASE_ATLASPACKER_HPP_
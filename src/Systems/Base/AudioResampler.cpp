@@ -0,0 +1,276 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2013 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+// -----------------------------------------------------------------------
+
+#include "Systems/Base/AudioResampler.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(RLVM_FIXED_POINT_AUDIO)
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#else
+#if defined(__SSE__)
+#include <xmmintrin.h>
+#endif
+#endif
+
+namespace {
+
+// Past this many phases we approximate the ratio; the resulting pitch error
+// is well under what anyone can hear.
+const int MAX_PHASES = 1024;
+
+// Kaiser window shape parameter; trades main lobe width for stopband depth.
+const double KAISER_BETA = 6.0;
+
+// How much of the narrower Nyquist band the lowpass passes. Leaves room for
+// the transition band of a short filter.
+const double CUTOFF = 0.9;
+
+#if defined(RLVM_FIXED_POINT_AUDIO)
+const int COEF_SHIFT = 14;
+#endif
+
+int gcd(int a, int b) {
+  while (b) {
+    int t = a % b;
+    a = b;
+    b = t;
+  }
+  return a;
+}
+
+// Zeroth order modified Bessel function of the first kind, for the window.
+double besselI0(double x) {
+  double sum = 1.0;
+  double term = 1.0;
+  for (int k = 1; k < 32; ++k) {
+    term *= (x / (2.0 * k)) * (x / (2.0 * k));
+    sum += term;
+    if (term < sum * 1e-12)
+      break;
+  }
+  return sum;
+}
+
+inline int16_t clampSample(int value) {
+  return static_cast<int16_t>(std::max(-32768, std::min(32767, value)));
+}
+
+#if defined(RLVM_FIXED_POINT_AUDIO)
+
+inline ResamplerSample toResamplerSample(int16_t in) { return in; }
+
+inline int16_t dotProduct(const int16_t* x, const int16_t* c) {
+#if defined(__SSE2__)
+  __m128i acc = _mm_madd_epi16(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(x)),
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(c)));
+  acc = _mm_add_epi32(acc, _mm_madd_epi16(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(x + 8)),
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(c + 8))));
+  acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(1, 0, 3, 2)));
+  acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(2, 3, 0, 1)));
+  int sum = _mm_cvtsi128_si32(acc);
+#else
+  int sum = 0;
+  for (int i = 0; i < AudioResampler::TAPS; ++i)
+    sum += x[i] * c[i];
+#endif
+  return clampSample((sum + (1 << (COEF_SHIFT - 1))) >> COEF_SHIFT);
+}
+
+#else
+
+inline ResamplerSample toResamplerSample(int16_t in) { return in; }
+
+inline int16_t dotProduct(const float* x, const float* c) {
+#if defined(__SSE__)
+  __m128 acc = _mm_mul_ps(_mm_loadu_ps(x), _mm_loadu_ps(c));
+  for (int i = 4; i < AudioResampler::TAPS; i += 4)
+    acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(x + i), _mm_loadu_ps(c + i)));
+  acc = _mm_add_ps(acc, _mm_movehl_ps(acc, acc));
+  acc = _mm_add_ss(acc, _mm_shuffle_ps(acc, acc, 1));
+  float sum = _mm_cvtss_f32(acc);
+#else
+  float sum = 0;
+  for (int i = 0; i < AudioResampler::TAPS; ++i)
+    sum += x[i] * c[i];
+#endif
+  return clampSample(static_cast<int>(std::floor(sum + 0.5f)));
+}
+
+#endif
+
+}  // namespace
+
+// -----------------------------------------------------------------------
+// AudioResampler
+// -----------------------------------------------------------------------
+AudioResampler::AudioResampler(int in_rate, int out_rate, int channels)
+    : in_rate_(in_rate),
+      out_rate_(out_rate),
+      channels_(std::min(std::max(channels, 1), 2)),
+      up_(1),
+      down_(1),
+      position_(0),
+      phase_(0) {
+  if (!isPassthrough()) {
+    int divisor = gcd(in_rate_, out_rate_);
+    up_ = out_rate_ / divisor;
+    down_ = in_rate_ / divisor;
+    if (up_ > MAX_PHASES) {
+      down_ = static_cast<int>(
+          double(in_rate_) * MAX_PHASES / out_rate_ + 0.5);
+      up_ = MAX_PHASES;
+    }
+
+    buildFilters();
+  }
+
+  reset();
+}
+
+AudioResampler::~AudioResampler() {
+}
+
+void AudioResampler::process(const int16_t* in, int frames,
+                             std::vector<int16_t>& out) {
+  if (isPassthrough()) {
+    out.insert(out.end(), in, in + frames * channels_);
+    return;
+  }
+
+  for (int c = 0; c < channels_; ++c) {
+    std::vector<ResamplerSample>& history = history_[c];
+    size_t old_size = history.size();
+    history.resize(old_size + frames);
+    for (int i = 0; i < frames; ++i)
+      history[old_size + i] = toResamplerSample(in[i * channels_ + c]);
+  }
+
+  drain(out);
+}
+
+void AudioResampler::flush(std::vector<int16_t>& out) {
+  if (isPassthrough())
+    return;
+
+  // The last input frame is the center of a window when there are TAPS / 2
+  // frames after it.
+  for (int c = 0; c < channels_; ++c)
+    history_[c].resize(history_[c].size() + TAPS / 2, 0);
+  drain(out);
+  reset();
+}
+
+void AudioResampler::reset() {
+  // Prime with enough silence that the first window is centered on the first
+  // input frame.
+  for (int c = 0; c < 2; ++c)
+    history_[c].assign(c < channels_ ? TAPS / 2 - 1 : 0, 0);
+  position_ = 0;
+  phase_ = 0;
+}
+
+// static
+void AudioResampler::resampleBuffer(const int16_t* in, int frames,
+                                    int channels, int in_rate, int out_rate,
+                                    std::vector<int16_t>& out) {
+  AudioResampler resampler(in_rate, out_rate, channels);
+  out.reserve(out.size() +
+              (static_cast<int64_t>(frames) * out_rate / in_rate + 1) *
+              channels);
+  resampler.process(in, frames, out);
+  resampler.flush(out);
+}
+
+void AudioResampler::buildFilters() {
+  filters_.resize(up_ * TAPS);
+
+  // Cut off below whichever Nyquist frequency is lower, measured in cycles
+  // per input sample.
+  double cutoff = CUTOFF * std::min(1.0, double(up_) / down_);
+  double half = TAPS / 2.0;
+  double i0_beta = besselI0(KAISER_BETA);
+
+  std::vector<double> taps(TAPS);
+  for (int phase = 0; phase < up_; ++phase) {
+    double sum = 0;
+    for (int j = 0; j < TAPS; ++j) {
+      // Distance from the output instant to input sample j of the window.
+      double d = (j - half + 1) - double(phase) / up_;
+      double x = M_PI * cutoff * d;
+      double sinc = std::fabs(x) < 1e-9 ? 1.0 : std::sin(x) / x;
+      double r = d / half;
+      double window = r * r < 1.0 ?
+          besselI0(KAISER_BETA * std::sqrt(1.0 - r * r)) / i0_beta : 0.0;
+      taps[j] = sinc * window;
+      sum += taps[j];
+    }
+
+    // Normalize every phase to unity gain at DC so that a constant signal
+    // doesn't pick up a ripple at the phase rate.
+    ResamplerSample* dest = &filters_[phase * TAPS];
+    for (int j = 0; j < TAPS; ++j) {
+#if defined(RLVM_FIXED_POINT_AUDIO)
+      dest[j] = static_cast<int16_t>(
+          std::floor(taps[j] / sum * (1 << COEF_SHIFT) + 0.5));
+#else
+      dest[j] = static_cast<float>(taps[j] / sum);
+#endif
+    }
+  }
+}
+
+void AudioResampler::drain(std::vector<int16_t>& out) {
+  int available = static_cast<int>(history_[0].size());
+  if (position_ + TAPS <= available) {
+    // Reserve for the frames we're about to emit so the loop doesn't
+    // reallocate.
+    int64_t steps = static_cast<int64_t>(available - TAPS - position_) * up_ /
+                    down_ + 1;
+    out.reserve(out.size() + steps * channels_);
+  }
+
+  while (position_ + TAPS <= available) {
+    const ResamplerSample* filter = &filters_[phase_ * TAPS];
+    for (int c = 0; c < channels_; ++c)
+      out.push_back(dotProduct(&history_[c][position_], filter));
+
+    phase_ += down_;
+    position_ += phase_ / up_;
+    phase_ %= up_;
+  }
+
+  // Drop the input we've moved past.
+  int consumed = std::min(position_, available);
+  for (int c = 0; c < channels_; ++c)
+    history_[c].erase(history_[c].begin(), history_[c].begin() + consumed);
+  position_ -= consumed;
+}
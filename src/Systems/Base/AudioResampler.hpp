@@ -0,0 +1,108 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2013 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+// -----------------------------------------------------------------------
+
+#ifndef SRC_SYSTEMS_BASE_AUDIORESAMPLER_HPP_
+#define SRC_SYSTEMS_BASE_AUDIORESAMPLER_HPP_
+
+#include <stdint.h>
+#include <vector>
+
+// Sample and coefficient types for the resampler. Define
+// RLVM_FIXED_POINT_AUDIO on devices without a fast FPU to filter with 16-bit
+// integer coefficients instead of floats.
+#if defined(RLVM_FIXED_POINT_AUDIO)
+typedef int16_t ResamplerSample;
+#else
+typedef float ResamplerSample;
+#endif
+
+// Polyphase windowed sinc sample rate converter for interleaved signed 16-bit
+// audio. Every sound source (BGM streams, sound effects, wav files and voices)
+// goes through one of these to reach the mixer's output rate, instead of
+// through a mix of SDL_mixer's and xclannad's converters.
+//
+// The ratio between the two rates is reduced to L/M, and the prototype lowpass
+// filter is split into L phases of TAPS coefficients each, so each output
+// frame costs one TAPS long dot product per channel.
+class AudioResampler {
+ public:
+  // Taps per phase. A multiple of 8 so the dot products vectorize cleanly.
+  static const int TAPS = 16;
+
+  AudioResampler(int in_rate, int out_rate, int channels);
+  ~AudioResampler();
+
+  int inputRate() const { return in_rate_; }
+  int outputRate() const { return out_rate_; }
+  int channels() const { return channels_; }
+
+  // Whether the rates are equal; process() still works but just copies.
+  bool isPassthrough() const { return in_rate_ == out_rate_; }
+
+  // Feeds |frames| interleaved frames of input and appends every output frame
+  // that can now be computed to |out|. The filter delay is compensated for, so
+  // the first output frame lines up with the first input frame.
+  void process(const int16_t* in, int frames, std::vector<int16_t>& out);
+
+  // Pushes enough silence through the filter to emit the output frames that
+  // correspond to the tail of the input.
+  void flush(std::vector<int16_t>& out);
+
+  // Forgets all buffered input, as when seeking in a stream.
+  void reset();
+
+  // Converts a whole buffer in one go.
+  static void resampleBuffer(const int16_t* in, int frames, int channels,
+                             int in_rate, int out_rate,
+                             std::vector<int16_t>& out);
+
+ private:
+  // Builds the L phase filter bank.
+  void buildFilters();
+
+  // Computes output frames from |history_| until we run out of input.
+  void drain(std::vector<int16_t>& out);
+
+  int in_rate_;
+  int out_rate_;
+  int channels_;
+
+  // Interpolation factor (number of phases) and decimation step.
+  int up_;
+  int down_;
+
+  // |up_| phases of TAPS coefficients each, stored contiguously.
+  std::vector<ResamplerSample> filters_;
+
+  // Deinterleaved input per channel. |position_| is the index of the first
+  // sample of the window for the next output frame, and |phase_| is which
+  // filter to use for it.
+  std::vector<ResamplerSample> history_[2];
+  int position_;
+  int phase_;
+};  // class AudioResampler
+
+#endif  // SRC_SYSTEMS_BASE_AUDIORESAMPLER_HPP_
@@ -26,6 +26,8 @@
 
 #include <boost/archive/text_iarchive.hpp>
 #include <boost/archive/text_oarchive.hpp>
+#include "portable_binary_archive/portable_binary_iarchive.hpp"
+#include "portable_binary_archive/portable_binary_oarchive.hpp"
 #include <boost/serialization/export.hpp>
 
 #include "Systems/Base/ColourFilterObjectData.hpp"
@@ -126,12 +128,18 @@ void ColourFilterObjectData::serialize(Archive& ar, unsigned int version) {
 
 // -----------------------------------------------------------------------
 
-// Explicit instantiations for text archives (since we hide the
+// Explicit instantiations for text and binary archives (since we hide the
 // implementation)
 
 template void ColourFilterObjectData::serialize<boost::archive::text_iarchive>(
   boost::archive::text_iarchive& ar, unsigned int version);
+template void ColourFilterObjectData::serialize<
+  portable_binary_iarchive>(
+    portable_binary_iarchive& ar, unsigned int version);
 template void ColourFilterObjectData::serialize<boost::archive::text_oarchive>(
   boost::archive::text_oarchive& ar, unsigned int version);
+template void ColourFilterObjectData::serialize<
+  portable_binary_oarchive>(
+    portable_binary_oarchive& ar, unsigned int version);
 
 BOOST_CLASS_EXPORT(ColourFilterObjectData);
@@ -0,0 +1,96 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2013 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+// -----------------------------------------------------------------------
+
+#include "Systems/Base/DirtyRegion.hpp"
+
+namespace {
+
+long Area(const Rect& rect) {
+  return static_cast<long>(rect.width()) * rect.height();
+}
+
+// How many pixels outside both |a| and |b| the box around them covers.
+long MergeCost(const Rect& a, const Rect& b) {
+  return Area(a.rectUnion(b)) - Area(a) - Area(b);
+}
+
+}  // namespace
+
+// -----------------------------------------------------------------------
+// DirtyRegion
+// -----------------------------------------------------------------------
+const size_t DirtyRegion::MAX_RECTS;
+
+DirtyRegion::DirtyRegion() {}
+
+DirtyRegion::~DirtyRegion() {}
+
+void DirtyRegion::add(const Rect& rect) {
+  if (rect.width() <= 0 || rect.height() <= 0)
+    return;
+
+  // Swallow every rectangle that's cheaper to upload together with the new
+  // one. The grown rectangle may now reach ones we've already passed, so
+  // start over after each merge.
+  Rect merged = rect;
+  for (size_t i = 0; i < rects_.size(); ) {
+    if (MergeCost(merged, rects_[i]) <= 0) {
+      merged = merged.rectUnion(rects_[i]);
+      rects_.erase(rects_.begin() + i);
+      i = 0;
+    } else {
+      ++i;
+    }
+  }
+  rects_.push_back(merged);
+
+  while (rects_.size() > MAX_RECTS) {
+    size_t best_i = 0, best_j = 1;
+    long best_cost = MergeCost(rects_[0], rects_[1]);
+    for (size_t i = 0; i < rects_.size(); ++i) {
+      for (size_t j = i + 1; j < rects_.size(); ++j) {
+        long cost = MergeCost(rects_[i], rects_[j]);
+        if (cost < best_cost) {
+          best_cost = cost;
+          best_i = i;
+          best_j = j;
+        }
+      }
+    }
+
+    rects_[best_i] = rects_[best_i].rectUnion(rects_[best_j]);
+    rects_.erase(rects_.begin() + best_j);
+  }
+}
+
+long DirtyRegion::area() const {
+  long total = 0;
+  for (std::vector<Rect>::const_iterator it = rects_.begin();
+       it != rects_.end(); ++it) {
+    total += Area(*it);
+  }
+  return total;
+}
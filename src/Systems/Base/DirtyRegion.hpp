@@ -0,0 +1,61 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2013 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+// -----------------------------------------------------------------------
+
+#ifndef SRC_SYSTEMS_BASE_DIRTYREGION_HPP_
+#define SRC_SYSTEMS_BASE_DIRTYREGION_HPP_
+
+#include <vector>
+
+#include "Systems/Base/Rect.hpp"
+
+// The parts of a surface that were written to since its texture was last
+// uploaded. Keeping a few separate rectangles instead of one bounding box
+// means that touching two corners of a large surface doesn't reupload
+// everything in between. Rectangles are merged when the box around them
+// wastes no more than they overlap, and the closest pair is merged when
+// there are more than MAX_RECTS.
+class DirtyRegion {
+ public:
+  static const size_t MAX_RECTS = 8;
+
+  DirtyRegion();
+  ~DirtyRegion();
+
+  void add(const Rect& rect);
+  void clear() { rects_.clear(); }
+
+  bool empty() const { return rects_.empty(); }
+  const std::vector<Rect>& rects() const { return rects_; }
+
+  // The number of pixels covered. Rectangles never overlap by much, so this
+  // is what an upload of the region costs.
+  long area() const;
+
+ private:
+  std::vector<Rect> rects_;
+};  // class DirtyRegion
+
+#endif  // SRC_SYSTEMS_BASE_DIRTYREGION_HPP_
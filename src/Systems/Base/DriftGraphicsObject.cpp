@@ -26,6 +26,8 @@
 
 #include <boost/archive/text_iarchive.hpp>
 #include <boost/archive/text_oarchive.hpp>
+#include "portable_binary_archive/portable_binary_iarchive.hpp"
+#include "portable_binary_archive/portable_binary_oarchive.hpp"
 #include <boost/serialization/scoped_ptr.hpp>
 #include <boost/serialization/export.hpp>
 
@@ -239,11 +241,15 @@ BOOST_CLASS_EXPORT(DriftGraphicsObject);
 
 // -----------------------------------------------------------------------
 
-// Explicit instantiations for text archives (since we hide the
+// Explicit instantiations for text and binary archives (since we hide the
 // implementation)
 
 template void DriftGraphicsObject::save<boost::archive::text_oarchive>(
   boost::archive::text_oarchive & ar, unsigned int version) const;
+template void DriftGraphicsObject::save<portable_binary_oarchive>(
+  portable_binary_oarchive & ar, unsigned int version) const;
 
 template void DriftGraphicsObject::load<boost::archive::text_iarchive>(
   boost::archive::text_iarchive & ar, unsigned int version);
+template void DriftGraphicsObject::load<portable_binary_iarchive>(
+  portable_binary_iarchive & ar, unsigned int version);
@@ -31,6 +31,8 @@
 
 #include <boost/archive/text_oarchive.hpp>
 #include <boost/archive/text_iarchive.hpp>
+#include "portable_binary_archive/portable_binary_iarchive.hpp"
+#include "portable_binary_archive/portable_binary_oarchive.hpp"
 #include <boost/serialization/scoped_ptr.hpp>
 
 #include "Systems/Base/GanGraphicsObjectData.hpp"
@@ -356,14 +358,18 @@ void GanGraphicsObjectData::save(Archive& ar, unsigned int version) const {
 
 // -----------------------------------------------------------------------
 
-// Explicit instantiations for text archives (since we hide the
+// Explicit instantiations for text and binary archives (since we hide the
 // implementation)
 
 template void GanGraphicsObjectData::save<boost::archive::text_oarchive>(
   boost::archive::text_oarchive & ar, unsigned int version) const;
+template void GanGraphicsObjectData::save<portable_binary_oarchive>(
+  portable_binary_oarchive & ar, unsigned int version) const;
 
 template void GanGraphicsObjectData::load<boost::archive::text_iarchive>(
   boost::archive::text_iarchive & ar, unsigned int version);
+template void GanGraphicsObjectData::load<portable_binary_iarchive>(
+  portable_binary_iarchive & ar, unsigned int version);
 
 // -----------------------------------------------------------------------
 
@@ -27,6 +27,8 @@
 
 #include <boost/archive/text_iarchive.hpp>
 #include <boost/archive/text_oarchive.hpp>
+#include "portable_binary_archive/portable_binary_iarchive.hpp"
+#include "portable_binary_archive/portable_binary_oarchive.hpp"
 
 // -----------------------------------------------------------------------
 
@@ -40,6 +42,7 @@
 
 #include "Systems/Base/GraphicsObjectData.hpp"
 #include "Systems/Base/ObjectMutator.hpp"
+#include "Systems/Base/ParentGraphicsObjectData.hpp"
 #include "Utilities/Exception.hpp"
 
 using namespace std;
@@ -815,6 +818,15 @@ void GraphicsObject::EndObjectMutatorMatching(
   }
 }
 
+size_t GraphicsObject::memoryUsage() const {
+  size_t bytes = sizeof(GraphicsObject) +
+                 object_mutators_.capacity() * sizeof(ObjectMutator*) +
+                 object_mutators_.size() * sizeof(ObjectMutator);
+  if (!isCleared())
+    bytes += sizeof(Impl) / impl_.use_count();
+  return bytes;
+}
+
 void GraphicsObject::makeImplUnique() {
   if (!impl_.unique()) {
     impl_.reset(new Impl(*impl_));
@@ -873,6 +885,28 @@ void GraphicsObject::execute(RLMachine& machine) {
   }
 }
 
+bool GraphicsObject::changesOnExecute() {
+  if (!object_mutators_.empty())
+    return true;
+  if (!object_data_)
+    return false;
+  if (object_data_->currentlyPlaying())
+    return true;
+
+  if (object_data_->isParentLayer()) {
+    LazyArray<GraphicsObject>& children =
+        static_cast<ParentGraphicsObjectData&>(*object_data_).objects();
+    AllocatedLazyArrayIterator<GraphicsObject> it = children.allocated_begin();
+    AllocatedLazyArrayIterator<GraphicsObject> end = children.allocated_end();
+    for (; it != end; ++it) {
+      if (it->changesOnExecute())
+        return true;
+    }
+  }
+
+  return false;
+}
+
 template<class Archive>
 void GraphicsObject::serialize(Archive& ar, unsigned int version) {
   ar & impl_ & object_data_;
@@ -882,9 +916,13 @@ void GraphicsObject::serialize(Archive& ar, unsigned int version) {
 
 template void GraphicsObject::serialize<boost::archive::text_oarchive>(
   boost::archive::text_oarchive & ar, unsigned int version);
+template void GraphicsObject::serialize<portable_binary_oarchive>(
+  portable_binary_oarchive & ar, unsigned int version);
 
 template void GraphicsObject::serialize<boost::archive::text_iarchive>(
   boost::archive::text_iarchive & ar, unsigned int version);
+template void GraphicsObject::serialize<portable_binary_iarchive>(
+  portable_binary_iarchive & ar, unsigned int version);
 
 // -----------------------------------------------------------------------
 // GraphicsObject::Impl
@@ -1079,14 +1117,18 @@ void GraphicsObject::Impl::serialize(Archive& ar, unsigned int version) {
 
 // -----------------------------------------------------------------------
 
-// Explicit instantiations for text archives (since we hide the
+// Explicit instantiations for text and binary archives (since we hide the
 // implementation)
 
 template void GraphicsObject::Impl::serialize<boost::archive::text_oarchive>(
   boost::archive::text_oarchive & ar, unsigned int version);
+template void GraphicsObject::Impl::serialize<portable_binary_oarchive>(
+  portable_binary_oarchive & ar, unsigned int version);
 
 template void GraphicsObject::Impl::serialize<boost::archive::text_iarchive>(
   boost::archive::text_iarchive & ar, unsigned int version);
+template void GraphicsObject::Impl::serialize<portable_binary_iarchive>(
+  portable_binary_iarchive & ar, unsigned int version);
 
 // -----------------------------------------------------------------------
 // GraphicsObject::Impl::TextProperties
@@ -1100,16 +1142,22 @@ void GraphicsObject::Impl::TextProperties::serialize(
 
 // -----------------------------------------------------------------------
 
-// Explicit instantiations for text archives (since we hide the
+// Explicit instantiations for text and binary archives (since we hide the
 // implementation)
 
 template void GraphicsObject::Impl::TextProperties::serialize
 <boost::archive::text_oarchive>(
   boost::archive::text_oarchive & ar, unsigned int version);
+template void GraphicsObject::Impl::TextProperties::serialize
+<portable_binary_oarchive>(
+  portable_binary_oarchive & ar, unsigned int version);
 
 template void GraphicsObject::Impl::TextProperties::serialize
 <boost::archive::text_iarchive>(
   boost::archive::text_iarchive & ar, unsigned int version);
+template void GraphicsObject::Impl::TextProperties::serialize
+<portable_binary_iarchive>(
+  portable_binary_iarchive & ar, unsigned int version);
 
 // -----------------------------------------------------------------------
 // GraphicsObject::Impl::DirftProperties
@@ -1128,10 +1176,16 @@ void GraphicsObject::Impl::DriftProperties::serialize(
 template void GraphicsObject::Impl::DriftProperties::serialize
 <boost::archive::text_oarchive>(
   boost::archive::text_oarchive & ar, unsigned int version);
+template void GraphicsObject::Impl::DriftProperties::serialize
+<portable_binary_oarchive>(
+  portable_binary_oarchive & ar, unsigned int version);
 
 template void GraphicsObject::Impl::DriftProperties::serialize
 <boost::archive::text_iarchive>(
   boost::archive::text_iarchive & ar, unsigned int version);
+template void GraphicsObject::Impl::DriftProperties::serialize
+<portable_binary_iarchive>(
+  portable_binary_iarchive & ar, unsigned int version);
 
 // -----------------------------------------------------------------------
 // GraphicsObject::Impl::DigitProperties
@@ -1147,10 +1201,16 @@ void GraphicsObject::Impl::DigitProperties::serialize(
 template void GraphicsObject::Impl::DigitProperties::serialize
 <boost::archive::text_oarchive>(
   boost::archive::text_oarchive & ar, unsigned int version);
+template void GraphicsObject::Impl::DigitProperties::serialize
+<portable_binary_oarchive>(
+  portable_binary_oarchive & ar, unsigned int version);
 
 template void GraphicsObject::Impl::DigitProperties::serialize
 <boost::archive::text_iarchive>(
   boost::archive::text_iarchive & ar, unsigned int version);
+template void GraphicsObject::Impl::DigitProperties::serialize
+<portable_binary_iarchive>(
+  portable_binary_iarchive & ar, unsigned int version);
 
 // -----------------------------------------------------------------------
 // GraphicsObject::Impl::ButtonProperties
@@ -1170,8 +1230,14 @@ void GraphicsObject::Impl::ButtonProperties::serialize(
 template void GraphicsObject::Impl::ButtonProperties::serialize
 <boost::archive::text_oarchive>(
   boost::archive::text_oarchive & ar, unsigned int version);
+template void GraphicsObject::Impl::ButtonProperties::serialize
+<portable_binary_oarchive>(
+  portable_binary_oarchive & ar, unsigned int version);
 
 template void GraphicsObject::Impl::ButtonProperties::serialize
 <boost::archive::text_iarchive>(
   boost::archive::text_iarchive & ar, unsigned int version);
+template void GraphicsObject::Impl::ButtonProperties::serialize
+<portable_binary_iarchive>(
+  portable_binary_iarchive & ar, unsigned int version);
 
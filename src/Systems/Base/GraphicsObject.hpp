@@ -206,6 +206,10 @@ class GraphicsObject {
   // to force a redraw, or something.
   void execute(RLMachine& machine);
 
+  // Whether execute() may change this object: it has running mutators, or
+  // its data (or a child's, for parent objects) is playing an animation.
+  bool changesOnExecute();
+
   // Text Object accessors
   void setTextText(const std::string& utf8str);
   const std::string& textText() const;
@@ -292,6 +296,11 @@ class GraphicsObject {
   // Whether we have the default shared data. Only used in unit testing.
   bool isCleared() const { return impl_ == s_empty_impl; }
 
+  // Approximate bytes held by this object, for memory reports. The shared
+  // copy-on-write data is split evenly between the objects sharing it, and
+  // the surfaces in objectData() are counted by the surfaces themselves.
+  size_t memoryUsage() const;
+
  private:
   // Makes the ineternal copy for our copy-on-write semantics. This function
   // checks to see if our Impl object has only one reference to it. If it
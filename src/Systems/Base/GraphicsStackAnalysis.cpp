@@ -0,0 +1,77 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2013 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+// -----------------------------------------------------------------------
+
+#include "Systems/Base/GraphicsStackAnalysis.hpp"
+
+#include <set>
+
+std::vector<bool> FindOverwrittenStackCommands(
+    const std::vector<GraphicsStackEffect>& effects) {
+  std::vector<bool> overwritten(effects.size(), false);
+
+  // Walking backwards, the DCs whose current contents (or size) will be
+  // thrown away before anyone looks at them.
+  std::set<int> dead_contents;
+  std::set<int> dead_sizes;
+
+  for (int i = static_cast<int>(effects.size()) - 1; i >= 0; --i) {
+    const GraphicsStackEffect& effect = effects[i];
+    if (!effect.understood) {
+      dead_contents.clear();
+      dead_sizes.clear();
+      continue;
+    }
+
+    bool skippable = true;
+    for (int dc : effect.writes) {
+      if (!dead_contents.count(dc))
+        skippable = false;
+    }
+    for (int dc : effect.resizes) {
+      if (!dead_sizes.count(dc))
+        skippable = false;
+    }
+
+    if (skippable) {
+      overwritten[i] = true;
+      continue;
+    }
+
+    // A command reads its inputs before writing its output, so going
+    // backwards we apply the writes first.
+    for (int dc : effect.replaces) {
+      dead_contents.insert(dc);
+      if (effect.reallocates)
+        dead_sizes.insert(dc);
+    }
+    for (int dc : effect.reads) {
+      dead_contents.erase(dc);
+      dead_sizes.erase(dc);
+    }
+  }
+
+  return overwritten;
+}
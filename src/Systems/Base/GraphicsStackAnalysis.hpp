@@ -0,0 +1,69 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2013 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+// -----------------------------------------------------------------------
+
+#ifndef SRC_SYSTEMS_BASE_GRAPHICSSTACKANALYSIS_HPP_
+#define SRC_SYSTEMS_BASE_GRAPHICSSTACKANALYSIS_HPP_
+
+#include <string>
+#include <vector>
+
+// What replaying one command on the graphics stack does to the DCs, as far as
+// its opcode and (already constant) arguments tell us.
+struct GraphicsStackEffect {
+  GraphicsStackEffect() : understood(false), reallocates(false) {}
+
+  // False for commands we don't model. They're always replayed, and since
+  // they may read anything, nothing before them is ever skipped either.
+  bool understood;
+
+  // Every DC this command changes.
+  std::vector<int> writes;
+
+  // The DCs in |writes| whose old contents are thrown away entirely.
+  std::vector<int> replaces;
+
+  // Whether the DCs in |replaces| are also reallocated at a new size.
+  bool reallocates;
+
+  // DCs whose contents this command reads.
+  std::vector<int> reads;
+
+  // DCs this command may make larger.
+  std::vector<int> resizes;
+
+  // The image file this command loads, if any. Filled in even for commands
+  // that aren't |understood|, since they still benefit from prefetching.
+  std::string image;
+};
+
+// Returns, for each command, whether replaying it can be skipped because
+// every DC it writes to is replaced by a later command before anything reads
+// it. Commands that only touch a DC's size are kept unless a later command
+// reallocates that DC.
+std::vector<bool> FindOverwrittenStackCommands(
+    const std::vector<GraphicsStackEffect>& effects);
+
+#endif  // SRC_SYSTEMS_BASE_GRAPHICSSTACKANALYSIS_HPP_
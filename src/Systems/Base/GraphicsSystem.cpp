@@ -32,6 +32,8 @@
 #include <boost/algorithm/string.hpp>
 #include <boost/archive/text_iarchive.hpp>
 #include <boost/archive/text_oarchive.hpp>
+#include "portable_binary_archive/portable_binary_iarchive.hpp"
+#include "portable_binary_archive/portable_binary_oarchive.hpp"
 #include <boost/lexical_cast.hpp>
 #include <boost/serialization/deque.hpp>
 #include <boost/serialization/scoped_ptr.hpp>
@@ -60,6 +62,7 @@
 #include "Systems/Base/GraphicsStackFrame.hpp"
 #include "Systems/Base/HIKRenderer.hpp"
 #include "Systems/Base/HIKScript.hpp"
+#include "Systems/Base/MemoryReport.hpp"
 #include "Systems/Base/MouseCursor.hpp"
 #include "Systems/Base/ObjectMutator.hpp"
 #include "Systems/Base/ObjectSettings.hpp"
@@ -68,7 +71,9 @@
 #include "Systems/Base/SystemError.hpp"
 #include "Systems/Base/TextSystem.hpp"
 #include "Utilities/Exception.hpp"
+#include "Utilities/FrameTimings.hpp"
 #include "Utilities/LazyArray.hpp"
+#include "Utilities/SavepointShadow.hpp"
 #include "libReallive/gameexe.h"
 #include "libReallive/expression.h"
 
@@ -181,17 +186,32 @@ GraphicsSystemGlobals::GraphicsSystemGlobals(Gameexe& gameexe)
 struct GraphicsSystem::GraphicsObjectImpl {
   GraphicsObjectImpl(int objects_in_layer);
 
+  // Copies object |obj_number| in |layer| into the savepoint originals, unless
+  // it has already changed since the last savepoint. Call before changing it.
+  void recordOriginalObject(int layer, int obj_number);
+
+  // recordOriginalObject() for every allocated object in both layers.
+  void recordOriginalObjects();
+
+  // Copies |graphics_stack|, unless it has already changed since the last
+  // savepoint. Call before changing it.
+  void recordOriginalGraphicsStack();
+
+  // Rebuilds |layer| as it was at the last savepoint into |out|.
+  void savepointObjects(int layer, LazyArray<GraphicsObject>* out);
+
   // Foreground objects
   LazyArray<GraphicsObject> foreground_objects;
 
   // Background objects
   LazyArray<GraphicsObject> background_objects;
 
-  // Foreground objects (at the time of the last save)
-  LazyArray<GraphicsObject> saved_foreground_objects;
-
-  // Background objects (at the time of the last save)
-  LazyArray<GraphicsObject> saved_background_objects;
+  // Objects as they were at the last savepoint, for the slots that have
+  // changed since. An empty pointer means the slot wasn't allocated.
+  typedef SavepointShadow<int, boost::shared_ptr<GraphicsObject> >
+      ObjectShadow;
+  ObjectShadow original_foreground_objects;
+  ObjectShadow original_background_objects;
 
   // Whether we restore |old_graphics_stack| using the old method instead of
   // replaying the new graphics stack format.
@@ -201,8 +221,10 @@ struct GraphicsSystem::GraphicsObjectImpl {
   // current moment.
   std::deque<std::string> graphics_stack;
 
-  // Commands to rebuild the graphics stack (at the time of the last savepoint)
-  std::deque<std::string> saved_graphics_stack;
+  // Commands to rebuild the graphics stack (at the time of the last
+  // savepoint), if |graphics_stack| has changed since.
+  std::deque<std::string> original_graphics_stack;
+  bool graphics_stack_changed;
 
   // Old style graphics stack implementation.
   std::vector<GraphicsStackFrame> old_graphics_stack;
@@ -213,9 +235,61 @@ struct GraphicsSystem::GraphicsObjectImpl {
 GraphicsSystem::GraphicsObjectImpl::GraphicsObjectImpl(int size)
     : foreground_objects(size),
       background_objects(size),
-      saved_foreground_objects(size),
-      saved_background_objects(size),
-      use_old_graphics_stack(false) {
+      use_old_graphics_stack(false),
+      graphics_stack_changed(false) {
+}
+
+void GraphicsSystem::GraphicsObjectImpl::recordOriginalObject(int layer,
+                                                              int obj_number) {
+  LazyArray<GraphicsObject>& objects =
+      layer == OBJ_BG ? background_objects : foreground_objects;
+  ObjectShadow& originals =
+      layer == OBJ_BG ? original_background_objects :
+      original_foreground_objects;
+  if (obj_number < 0 || obj_number >= objects.size() ||
+      originals.hasOriginal(obj_number))
+    return;
+
+  boost::shared_ptr<GraphicsObject> original;
+  if (objects.exists(obj_number))
+    original.reset(new GraphicsObject(objects[obj_number]));
+  originals.recordOriginal(obj_number, original);
+}
+
+void GraphicsSystem::GraphicsObjectImpl::recordOriginalObjects() {
+  for (int layer = OBJ_FG; layer <= OBJ_BG; ++layer) {
+    LazyArray<GraphicsObject>& objects =
+        layer == OBJ_BG ? background_objects : foreground_objects;
+    AllocatedLazyArrayIterator<GraphicsObject> it = objects.allocated_begin();
+    AllocatedLazyArrayIterator<GraphicsObject> end = objects.allocated_end();
+    for (; it != end; ++it)
+      recordOriginalObject(layer, it.pos());
+  }
+}
+
+void GraphicsSystem::GraphicsObjectImpl::recordOriginalGraphicsStack() {
+  if (!graphics_stack_changed) {
+    original_graphics_stack = graphics_stack;
+    graphics_stack_changed = true;
+  }
+}
+
+void GraphicsSystem::GraphicsObjectImpl::savepointObjects(
+    int layer, LazyArray<GraphicsObject>* out) {
+  LazyArray<GraphicsObject>& objects =
+      layer == OBJ_BG ? background_objects : foreground_objects;
+  const ObjectShadow& originals =
+      layer == OBJ_BG ? original_background_objects :
+      original_foreground_objects;
+
+  objects.copyTo(*out);
+  originals.forEachOriginal(
+      [&](int obj_number, const boost::shared_ptr<GraphicsObject>& original) {
+        if (original)
+          (*out)[obj_number] = *original;
+        else
+          out->deleteAt(obj_number);
+      });
 }
 
 // -----------------------------------------------------------------------
@@ -237,6 +311,7 @@ GraphicsSystem::GraphicsSystem(System& system, Gameexe& gameexe)
     use_custom_mouse_cursor_(gameexe("MOUSE_CURSOR").exists()),
     show_cursor_from_bytecode_(true),
     cursor_(gameexe("MOUSE_CURSOR").to_int(0)),
+    cursor_name_key_(gameexe.key("MOUSE_CURSOR", cursor_, "NAME")),
     system_(system),
     preloaded_hik_scripts_(32),
     preloaded_g00_(256),
@@ -349,19 +424,21 @@ int GraphicsSystem::CurrentShakingFrameTime() const {
 
 int GraphicsSystem::useCustomCursor() {
   return use_custom_mouse_cursor_ &&
-      system().gameexe()("MOUSE_CURSOR", cursor_, "NAME").to_string("") != "";
+      system().gameexe()(cursor_name_key_).to_string("") != "";
 }
 
 // -----------------------------------------------------------------------
 
 void GraphicsSystem::setCursor(int cursor) {
   cursor_ = cursor;
+  cursor_name_key_ = system().gameexe().key("MOUSE_CURSOR", cursor_, "NAME");
   mouse_cursor_.reset();
 }
 
 // -----------------------------------------------------------------------
 
 void GraphicsSystem::addGraphicsStackCommand(const std::string& command) {
+  graphics_object_impl_->recordOriginalGraphicsStack();
   graphics_object_impl_->graphics_stack.push_back(command);
 
   // RealLive only allows 127 commands to be on the stack so game programmers
@@ -386,12 +463,14 @@ int GraphicsSystem::stackSize() const {
 // -----------------------------------------------------------------------
 
 void GraphicsSystem::clearStack() {
+  graphics_object_impl_->recordOriginalGraphicsStack();
   graphics_object_impl_->graphics_stack.clear();
 }
 
 // -----------------------------------------------------------------------
 
 void GraphicsSystem::stackPop(int items) {
+  graphics_object_impl_->recordOriginalGraphicsStack();
   for (int i = 0; i < items; ++i) {
     if (graphics_object_impl_->graphics_stack.size()) {
       graphics_object_impl_->graphics_stack.pop_back();
@@ -410,6 +489,7 @@ void GraphicsSystem::replayGraphicsStack(RLMachine& machine) {
     replayDepricatedGraphicsStackVector(machine, stack_to_replay);
     graphics_object_impl_->use_old_graphics_stack = false;
   } else {
+    graphics_object_impl_->recordOriginalGraphicsStack();
     std::deque<std::string> stack_to_replay;
     stack_to_replay.swap(graphics_object_impl_->graphics_stack);
 
@@ -526,6 +606,8 @@ boost::shared_ptr<Surface> GraphicsSystem::renderToSurface() {
 }
 
 void GraphicsSystem::drawFrame(std::ostream* tree) {
+  ScopedTimer timer("drawFrame");
+
   switch (background_type_) {
     case BACKGROUND_DC0: {
       // Display DC0
@@ -559,10 +641,18 @@ void GraphicsSystem::drawFrame(std::ostream* tree) {
 
 void GraphicsSystem::executeGraphicsSystem(RLMachine& machine) {
   // Check to see if any of the graphics objects are reporting that
-  // they want to force a redraw
-  for_each(foregroundObjects().allocated_begin(),
-           foregroundObjects().allocated_end(),
-           [&](GraphicsObject& obj) { obj.execute(machine); });
+  // they want to force a redraw. Mutators and animations change objects
+  // without going through getObject(), so keep the savepoint's copy of an
+  // object before they touch it.
+  AllocatedLazyArrayIterator<GraphicsObject> it =
+      foregroundObjects().allocated_begin();
+  AllocatedLazyArrayIterator<GraphicsObject> end =
+      foregroundObjects().allocated_end();
+  for (; it != end; ++it) {
+    if (it->changesOnExecute())
+      graphics_object_impl_->recordOriginalObject(OBJ_FG, it.pos());
+    it->execute(machine);
+  }
 
   if (mouse_cursor_)
     mouse_cursor_->execute(system());
@@ -591,6 +681,11 @@ void GraphicsSystem::reset() {
   clearAllObjects();
   clearAllDCs();
 
+  // Nothing from before the reset should be saved.
+  graphics_object_impl_->original_foreground_objects.clear();
+  graphics_object_impl_->original_background_objects.clear();
+  graphics_object_impl_->graphics_stack_changed = false;
+
   preloaded_hik_scripts_.clear();
   preloaded_g00_.clear();
   hik_renderer_.reset();
@@ -599,6 +694,7 @@ void GraphicsSystem::reset() {
   // Reset the cursor
   show_cursor_from_bytecode_ = true;
   cursor_ = system().gameexe()("MOUSE_CURSOR").to_int(0);
+  cursor_name_key_ = system().gameexe().key("MOUSE_CURSOR", cursor_, "NAME");
   mouse_cursor_.reset();
 
   default_grp_name_ = "";
@@ -728,10 +824,55 @@ boost::shared_ptr<const Surface> GraphicsSystem::getSurfaceNamed(
 
 // -----------------------------------------------------------------------
 
+void GraphicsSystem::prefetchSurfaces(
+    const std::vector<std::string>& short_filenames) {
+  // Loading more than the cache holds would only evict the first images we
+  // loaded before anyone got to use them.
+  vector<std::string> to_load;
+  for (vector<std::string>::const_iterator it = short_filenames.begin();
+       it != short_filenames.end() && to_load.size() < image_cache_.max_size();
+       ++it) {
+    if (it->empty() || GetPreloadedG00(*it) || image_cache_.exists(*it) ||
+        std::find(to_load.begin(), to_load.end(), *it) != to_load.end())
+      continue;
+    to_load.push_back(*it);
+  }
+
+  if (to_load.empty())
+    return;
+
+  vector<boost::shared_ptr<const Surface> > surfaces =
+      loadSurfacesFromFiles(to_load);
+  for (size_t i = 0; i < to_load.size() && i < surfaces.size(); ++i) {
+    if (surfaces[i])
+      image_cache_.insert(to_load[i], surfaces[i]);
+  }
+}
+
+// -----------------------------------------------------------------------
+
+std::vector<boost::shared_ptr<const Surface> >
+GraphicsSystem::loadSurfacesFromFiles(
+    const std::vector<std::string>& short_filenames) {
+  vector<boost::shared_ptr<const Surface> > surfaces;
+  for (vector<std::string>::const_iterator it = short_filenames.begin();
+       it != short_filenames.end(); ++it) {
+    try {
+      surfaces.push_back(loadSurfaceFromFile(*it));
+    } catch (std::exception&) {
+      surfaces.push_back(boost::shared_ptr<const Surface>());
+    }
+  }
+  return surfaces;
+}
+
+// -----------------------------------------------------------------------
+
 /// @todo The looping constructs here totally defeat the purpose of
 ///       LazyArray, and make it a bit worse.
 void GraphicsSystem::clearAndPromoteObjects() {
   typedef LazyArray<GraphicsObject>::full_iterator FullIterator;
+  graphics_object_impl_->recordOriginalObjects();
 
   FullIterator bg = graphics_object_impl_->background_objects.full_begin();
   FullIterator bg_end = graphics_object_impl_->background_objects.full_end();
@@ -755,6 +896,8 @@ GraphicsObject& GraphicsSystem::getObject(int layer, int obj_number) {
   if (layer < 0 || layer > 1)
     throw rlvm::Exception("Invalid layer number");
 
+  // Callers may change the object through the returned reference.
+  graphics_object_impl_->recordOriginalObject(layer, obj_number);
   if (layer == OBJ_BG)
     return graphics_object_impl_->background_objects[obj_number];
   else
@@ -767,6 +910,7 @@ void GraphicsSystem::setObject(int layer, int obj_number, GraphicsObject& obj) {
   if (layer < 0 || layer > 1)
     throw rlvm::Exception("Invalid layer number");
 
+  graphics_object_impl_->recordOriginalObject(layer, obj_number);
   if (layer == OBJ_BG)
     graphics_object_impl_->background_objects[obj_number] = obj;
   else
@@ -776,6 +920,8 @@ void GraphicsSystem::setObject(int layer, int obj_number, GraphicsObject& obj) {
 // -----------------------------------------------------------------------
 
 void GraphicsSystem::clearObject(int obj_number) {
+  graphics_object_impl_->recordOriginalObject(OBJ_FG, obj_number);
+  graphics_object_impl_->recordOriginalObject(OBJ_BG, obj_number);
   graphics_object_impl_->foreground_objects.deleteAt(obj_number);
   graphics_object_impl_->background_objects.deleteAt(obj_number);
 }
@@ -783,6 +929,7 @@ void GraphicsSystem::clearObject(int obj_number) {
 // -----------------------------------------------------------------------
 
 void GraphicsSystem::clearAllObjects() {
+  graphics_object_impl_->recordOriginalObjects();
   graphics_object_impl_->foreground_objects.clear();
   graphics_object_impl_->background_objects.clear();
 }
@@ -790,6 +937,7 @@ void GraphicsSystem::clearAllObjects() {
 // -----------------------------------------------------------------------
 
 void GraphicsSystem::resetAllObjectsProperties() {
+  graphics_object_impl_->recordOriginalObjects();
   AllocatedLazyArrayIterator<GraphicsObject> it =
     graphics_object_impl_->foreground_objects.allocated_begin();
   AllocatedLazyArrayIterator<GraphicsObject> end =
@@ -842,10 +990,9 @@ bool GraphicsSystem::animationsPlaying() const {
 // -----------------------------------------------------------------------
 
 void GraphicsSystem::takeSavepointSnapshot() {
-  foregroundObjects().copyTo(graphics_object_impl_->saved_foreground_objects);
-  backgroundObjects().copyTo(graphics_object_impl_->saved_background_objects);
-  graphics_object_impl_->saved_graphics_stack =
-      graphics_object_impl_->graphics_stack;
+  graphics_object_impl_->original_foreground_objects.mark();
+  graphics_object_impl_->original_background_objects.mark();
+  graphics_object_impl_->graphics_stack_changed = false;
 }
 
 // -----------------------------------------------------------------------
@@ -859,6 +1006,50 @@ void GraphicsSystem::clearAllDCs() {
 
 // -----------------------------------------------------------------------
 
+void GraphicsSystem::reportMemoryUsage(MemoryReport& report) {
+  size_t cache_bytes = 0;
+  const std::vector<std::string> keys = image_cache_.get_all_keys();
+  for (const std::string& key : keys) {
+    boost::shared_ptr<const Surface> surface = image_cache_.fetch(key, false);
+    if (surface)
+      cache_bytes += surface->size().width() * surface->size().height() * 4;
+  }
+  report.add("Image cache", cache_bytes, keys.size());
+
+  size_t object_bytes = 0;
+  size_t object_count = 0;
+  LazyArray<GraphicsObject>* layers[] = {
+    &graphics_object_impl_->foreground_objects,
+    &graphics_object_impl_->background_objects
+  };
+  for (LazyArray<GraphicsObject>* layer : layers) {
+    AllocatedLazyArrayIterator<GraphicsObject> it = layer->allocated_begin();
+    AllocatedLazyArrayIterator<GraphicsObject> end = layer->allocated_end();
+    for (; it != end; ++it) {
+      object_bytes += it->memoryUsage();
+      object_count++;
+    }
+  }
+  report.add("Graphics objects", object_bytes, object_count);
+
+  size_t original_bytes = 0;
+  size_t original_count = 0;
+  auto count_original =
+      [&](const boost::shared_ptr<GraphicsObject>& object) {
+    if (object) {
+      original_bytes += object->memoryUsage();
+      original_count++;
+    }
+  };
+  graphics_object_impl_->original_foreground_objects.forEachStoredValue(
+      count_original);
+  graphics_object_impl_->original_background_objects.forEachStoredValue(
+      count_original);
+  report.add("Savepoint objects", original_bytes, original_count);
+}
+
+// -----------------------------------------------------------------------
+
 void GraphicsSystem::renderObjects(std::ostream* tree) {
   // The tuple is order, layer, depth, objid, GraphicsObject. Tuples are easy
   // to sort.
@@ -965,13 +1156,26 @@ GraphicsObjectData* GraphicsSystem::buildObjOfFile(
 
 template<class Archive>
 void GraphicsSystem::save(Archive& ar, unsigned int version) const {
+  // Rebuild the state at the last savepoint from the current state and the
+  // originals of whatever changed since.
+  const std::deque<std::string>& saved_graphics_stack =
+      graphics_object_impl_->graphics_stack_changed ?
+      graphics_object_impl_->original_graphics_stack :
+      graphics_object_impl_->graphics_stack;
+
+  int size = graphics_object_impl_->foreground_objects.size();
+  LazyArray<GraphicsObject> saved_background_objects(size);
+  graphics_object_impl_->savepointObjects(OBJ_BG, &saved_background_objects);
+  LazyArray<GraphicsObject> saved_foreground_objects(size);
+  graphics_object_impl_->savepointObjects(OBJ_FG, &saved_foreground_objects);
+
   ar
     & subtitle_
     & default_grp_name_
     & default_bgr_name_
-    & graphics_object_impl_->saved_graphics_stack
-    & graphics_object_impl_->saved_background_objects
-    & graphics_object_impl_->saved_foreground_objects;
+    & saved_graphics_stack
+    & saved_background_objects
+    & saved_foreground_objects;
 }
 
 // -----------------------------------------------------------------------
@@ -1001,5 +1205,9 @@ void GraphicsSystem::load(Archive& ar, unsigned int version) {
 
 template void GraphicsSystem::load<boost::archive::text_iarchive>(
   boost::archive::text_iarchive & ar, unsigned int version);
+template void GraphicsSystem::load<portable_binary_iarchive>(
+  portable_binary_iarchive & ar, unsigned int version);
 template void GraphicsSystem::save<boost::archive::text_oarchive>(
   boost::archive::text_oarchive & ar, unsigned int version) const;
+template void GraphicsSystem::save<portable_binary_oarchive>(
+  portable_binary_oarchive & ar, unsigned int version) const;
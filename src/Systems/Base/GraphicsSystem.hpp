@@ -47,6 +47,7 @@
 #include "Systems/Base/ToneCurve.hpp"
 
 #include "Utilities/LazyArray.hpp"
+#include "libReallive/gameexe.h"
 #include "lru_cache.hpp"
 
 #ifdef ANDROID
@@ -56,12 +57,12 @@
 #endif
 
 class ColourFilter;
-class Gameexe;
 class GraphicsObject;
 class GraphicsObjectData;
 class GraphicsStackFrame;
 class HIKRenderer;
 class HIKScript;
+class MemoryReport;
 class MouseCursor;
 class Renderable;
 class RGBAColour;
@@ -367,6 +368,13 @@ class GraphicsSystem : public EventListener {
   boost::shared_ptr<const Surface> getSurfaceNamed(
       const std::string& short_filename);
 
+  // Warms the image cache with |short_filenames| so that the following
+  // getSurfaceNamed() calls don't touch the disk. Images which are already
+  // cached are skipped, and at most as many images as the cache holds are
+  // loaded. Images that fail to load are silently left out; the error is
+  // reported when the image is actually asked for.
+  void prefetchSurfaces(const std::vector<std::string>& short_filenames);
+
   virtual boost::shared_ptr<Surface> getHaikei() = 0;
 
   virtual boost::shared_ptr<Surface> getDC(int dc) = 0;
@@ -403,6 +411,10 @@ class GraphicsSystem : public EventListener {
   // overridden with #OBJECT_MAX.
   int objectLayerSize();
 
+  // Direct access to the object layers. Changes made through these aren't
+  // tracked for the savepoint snapshot, so they're only for transient state;
+  // anything that should be saved goes through getObject(). (Mutators and
+  // animations run by executeGraphicsSystem() are tracked there.)
   LazyArray<GraphicsObject>& backgroundObjects();
   LazyArray<GraphicsObject>& foregroundObjects();
 
@@ -413,14 +425,18 @@ class GraphicsSystem : public EventListener {
   // instead of the current state of the graphics, since RealLive is a savepoint
   // based system.
   //
-  // (This operation isn't exceptionally expensive; internally GraphicsObject
-  // has multiple copy-on-write data structs to make this and object promotion a
-  // relativly cheap operation.)
+  // This doesn't copy anything. Objects and the graphics stack are copied the
+  // first time they change after a savepoint, and save() puts those copies
+  // back over the current state.
   void takeSavepointSnapshot();
 
   // Sets DC0 to black and frees up DCs 1 through 16.
   void clearAllDCs();
 
+  // Adds the image cache, graphics objects and the savepoint copies of
+  // graphics objects to |report|. Subclasses add their surfaces.
+  virtual void reportMemoryUsage(MemoryReport& report);
+
   // Implementation of MouseMotionListener:
   virtual void mouseMotion(const Point& new_location);
 
@@ -477,6 +493,12 @@ class GraphicsSystem : public EventListener {
   virtual boost::shared_ptr<const Surface> loadSurfaceFromFile(
       const std::string& short_filename) = 0;
 
+  // Loads a batch of images for prefetchSurfaces(). The returned vector is
+  // parallel to |short_filenames|, with an empty pointer for every image that
+  // couldn't be loaded. The default implementation loads them one by one.
+  virtual std::vector<boost::shared_ptr<const Surface> > loadSurfacesFromFiles(
+      const std::vector<std::string>& short_filenames);
+
   // Default grp name (used in grp* and rec* functions where filename
   // is '???')
   std::string default_grp_name_;
@@ -548,6 +570,10 @@ class GraphicsSystem : public EventListener {
   // Current cursor id. Initially set to \#MOUSE_CURSOR if the key exists.
   int cursor_;
 
+  // \#MOUSE_CURSOR.<cursor_>.NAME, which useCustomCursor() checks every
+  // frame.
+  GameexeKey cursor_name_key_;
+
   // Location of the cursor's hotspot
   Point cursor_pos_;
 
@@ -57,13 +57,9 @@
 
 #include "Systems/Base/KOEPACVoiceArchive.hpp"
 
-#include <algorithm>
 #include <cstring>
-#include <fstream>
 #include <sstream>
-#include <vector>
 #include <boost/filesystem/path.hpp>
-#include <boost/filesystem/fstream.hpp>
 #include <boost/scoped_array.hpp>
 
 #include "Utilities/Exception.hpp"
@@ -71,7 +67,6 @@
 
 using namespace std;
 using boost::scoped_array;
-using std::ifstream;
 using std::ostringstream;
 namespace fs = boost::filesystem;
 
@@ -281,11 +276,10 @@ KOEPACVoiceArchive::~KOEPACVoiceArchive() {
 // -----------------------------------------------------------------------
 
 boost::shared_ptr<VoiceSample> KOEPACVoiceArchive::findSample(int sample_num) {
-  std::vector<Entry>::const_iterator it =
-      std::lower_bound(entries_.begin(), entries_.end(), sample_num);
-  if (it != entries_.end()) {
+  Entry entry(0, 0, 0);
+  if (findEntry(sample_num, &entry)) {
     return boost::shared_ptr<VoiceSample>(
-        new KOEPACVoiceSample(file_, it->offset, it->length, rate_));
+        new KOEPACVoiceSample(file_, entry.offset, entry.length, rate_));
   }
 
   throw rlvm::Exception("Couldn't find sample in KOEPACVoiceArchive");
@@ -293,40 +287,30 @@ boost::shared_ptr<VoiceSample> KOEPACVoiceArchive::findSample(int sample_num) {
 
 // -----------------------------------------------------------------------
 
+VoiceArchive::Entry KOEPACVoiceArchive::readEntry(const char* record) const {
+  int koe_num = read_little_endian_short(record);
+  int length  = read_little_endian_short(record + 2);
+  int offset = read_little_endian_int(record + 4);
+  return Entry(koe_num, length, offset);
+}
+
+// -----------------------------------------------------------------------
+
 void KOEPACVoiceArchive::readTable(boost::filesystem::path file) {
-  fs::ifstream ifs(file, ifstream::in | ifstream::binary);
-  if (!ifs) {
-    ostringstream oss;
-    oss << "Could not open file \"" << file << "\".";
-    throw rlvm::Exception(oss.str());
-  }
+  mapFile(file);
 
   // Copied from koedec.cc
-  char head[0x20];
-  ifs.read(head, 0x20);
-  if (strncmp(head, "KOEPAC", 7) != 0) {
+  const char* head = data();
+  if (mappedSize() < 0x20 || strncmp(head, "KOEPAC", 7) != 0) {
     ostringstream oss;
     oss << file << " does not appear to be in KOEPAC format";
     throw rlvm::Exception(oss.str());
   }
 
-  int table_len = read_little_endian_int(head + 0x10);
-  entries_.reserve(table_len);
-
   rate_ = read_little_endian_int(head + 0x18);
   if (rate_ == 0) {
     rate_ = 22050;
   }
 
-  char* buf = new char[table_len * 8];
-  ifs.read(buf, table_len * 8);
-  for (int i = 0; i < table_len; i++) {
-    int koe_num = read_little_endian_short(buf + i * 8);
-    int length  = read_little_endian_short(buf + i * 8 + 2);
-    int offset = read_little_endian_int(buf + i * 8 + 4);
-    entries_.push_back(Entry(koe_num, length, offset));
-  }
-  sort(entries_.begin(), entries_.end());
-
-  delete [] buf;
+  setTable(0x20, read_little_endian_int(head + 0x10), 8);
 }
@@ -28,7 +28,6 @@
 #define SRC_SYSTEMS_BASE_KOEPACVOICEARCHIVE_HPP_
 
 #include <boost/filesystem/path.hpp>
-#include <vector>
 
 #include "Systems/Base/VoiceArchive.hpp"
 
@@ -42,6 +41,10 @@ class KOEPACVoiceArchive : public VoiceArchive {
 
   virtual boost::shared_ptr<VoiceSample> findSample(int sample_num);
 
+ protected:
+  // KOEPAC tables store (koe_num, length) as shorts followed by an int offset.
+  virtual Entry readEntry(const char* record) const;
+
  private:
   void readTable(boost::filesystem::path file);
 
@@ -50,9 +53,6 @@ class KOEPACVoiceArchive : public VoiceArchive {
 
   // The rate of the samples in this file.
   int rate_;
-
-  // A list of samples in this archive
-  std::vector<Entry> entries_;
 };  // class KOEPACVoiceArchive
 
 #endif  // SRC_SYSTEMS_BASE_KOEPACVOICEARCHIVE_HPP_
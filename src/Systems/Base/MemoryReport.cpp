@@ -0,0 +1,97 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2013 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+// -----------------------------------------------------------------------
+
+#include "Systems/Base/MemoryReport.hpp"
+
+#include <iomanip>
+#include <ostream>
+#include <sstream>
+
+// -----------------------------------------------------------------------
+// MemoryReport
+// -----------------------------------------------------------------------
+MemoryReport::MemoryReport() {}
+
+MemoryReport::~MemoryReport() {}
+
+void MemoryReport::add(const std::string& name, size_t bytes, size_t items) {
+  Line line = { name, bytes, items };
+  lines_.push_back(line);
+}
+
+size_t MemoryReport::bytes(const std::string& name) const {
+  for (const Line& line : lines_) {
+    if (line.name == name)
+      return line.bytes;
+  }
+  return 0;
+}
+
+std::string MemoryReport::summary() const {
+  std::ostringstream oss;
+  for (size_t i = 0; i < lines_.size(); ++i) {
+    if (i)
+      oss << ", ";
+    oss << lines_[i].name << " " << formatBytes(lines_[i].bytes);
+  }
+  return oss.str();
+}
+
+// -----------------------------------------------------------------------
+
+std::string formatBytes(size_t bytes) {
+  static const char* const units[] = { "B", "KB", "MB", "GB" };
+
+  std::ostringstream oss;
+  if (bytes < 1024) {
+    oss << bytes << " B";
+  } else {
+    double value = bytes;
+    int unit = 0;
+    while (value >= 1024 && unit < 3) {
+      value /= 1024;
+      unit++;
+    }
+    oss << std::fixed << std::setprecision(1) << value << " " << units[unit];
+  }
+  return oss.str();
+}
+
+std::ostream& operator<<(std::ostream& os, const MemoryReport& report) {
+  size_t name_width = 4;
+  for (const MemoryReport::Line& line : report.lines())
+    name_width = std::max(name_width, line.name.size());
+
+  os << std::left << std::setw(name_width) << "Name" << std::right
+     << std::setw(12) << "Bytes" << std::setw(10) << "Items" << std::endl;
+  os << std::string(name_width + 22, '-') << std::endl;
+  for (const MemoryReport::Line& line : report.lines()) {
+    os << std::left << std::setw(name_width) << line.name << std::right
+       << std::setw(12) << formatBytes(line.bytes)
+       << std::setw(10) << line.items << std::endl;
+  }
+  return os;
+}
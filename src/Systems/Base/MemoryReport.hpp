@@ -0,0 +1,74 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2013 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+// -----------------------------------------------------------------------
+
+#ifndef SRC_SYSTEMS_BASE_MEMORYREPORT_HPP_
+#define SRC_SYSTEMS_BASE_MEMORYREPORT_HPP_
+
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+// A snapshot of how many bytes each part of rlvm is holding on to. Filled in
+// by System::reportMemoryUsage(), which asks the archive and every subsystem
+// to add their lines.
+//
+// The numbers are live byte counts of the data each part owns, not of every
+// allocation it made, and some lines overlap: cached images are also counted
+// under surfaces.
+class MemoryReport {
+ public:
+  struct Line {
+    std::string name;
+    size_t bytes;
+
+    // How many things make up |bytes| (surfaces, pages, objects...).
+    size_t items;
+  };
+
+  MemoryReport();
+  ~MemoryReport();
+
+  void add(const std::string& name, size_t bytes, size_t items);
+
+  const std::vector<Line>& lines() const { return lines_; }
+
+  // The bytes on the line called |name|, or 0 if there is none.
+  size_t bytes(const std::string& name) const;
+
+  // Every line on one line of text, for periodic logging.
+  std::string summary() const;
+
+ private:
+  std::vector<Line> lines_;
+};
+
+// Formats |bytes| as "512 B", "12.5 KB", "3.2 MB"...
+std::string formatBytes(size_t bytes);
+
+// Pretty prints a MemoryReport as a table.
+std::ostream& operator<<(std::ostream& os, const MemoryReport& report);
+
+#endif  // SRC_SYSTEMS_BASE_MEMORYREPORT_HPP_
@@ -74,18 +74,18 @@ char* NWKVoiceSample::decode(int* size) {
 NWKVoiceArchive::NWKVoiceArchive(fs::path file, int file_no)
     : VoiceArchive(file_no),
       file_(file) {
-  readVisualArtsTable(file, 12, entries_);
+  mapFile(file);
+  readVisualArtsTable(12);
 }
 
 NWKVoiceArchive::~NWKVoiceArchive() {
 }
 
 boost::shared_ptr<VoiceSample> NWKVoiceArchive::findSample(int sample_num) {
-  std::vector<Entry>::const_iterator it =
-      std::lower_bound(entries_.begin(), entries_.end(), sample_num);
-  if (it != entries_.end()) {
+  Entry entry(0, 0, 0);
+  if (findEntry(sample_num, &entry)) {
     return boost::shared_ptr<VoiceSample>(
-        new NWKVoiceSample(file_, it->offset, it->length));
+        new NWKVoiceSample(file_, entry.offset, entry.length));
   }
 
   throw rlvm::Exception("Couldn't find sample in NWKVoiceArchive");
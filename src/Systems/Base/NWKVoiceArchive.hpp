@@ -27,7 +27,6 @@
 #ifndef SRC_SYSTEMS_BASE_NWKVOICEARCHIVE_HPP_
 #define SRC_SYSTEMS_BASE_NWKVOICEARCHIVE_HPP_
 
-#include <vector>
 #include <boost/filesystem/path.hpp>
 
 #include "Systems/Base/VoiceArchive.hpp"
@@ -42,12 +41,8 @@ class NWKVoiceArchive : public VoiceArchive {
   virtual boost::shared_ptr<VoiceSample> findSample(int sample_num);
 
  private:
-  void readTable(boost::filesystem::path file);
-
   // The file to read from
   boost::filesystem::path file_;
-
-  std::vector<Entry> entries_;
 };
 
 #endif
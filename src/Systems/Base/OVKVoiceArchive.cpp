@@ -77,7 +77,8 @@ namespace fs = boost::filesystem;
 OVKVoiceArchive::OVKVoiceArchive(fs::path file, int file_no)
     : VoiceArchive(file_no),
       file_(file) {
-  readVisualArtsTable(file, 16, entries_);
+  mapFile(file);
+  readVisualArtsTable(16);
 }
 
 // -----------------------------------------------------------------------
@@ -88,11 +89,10 @@ OVKVoiceArchive::~OVKVoiceArchive() {
 // -----------------------------------------------------------------------
 
 boost::shared_ptr<VoiceSample> OVKVoiceArchive::findSample(int sample_num) {
-  std::vector<Entry>::const_iterator it =
-      std::lower_bound(entries_.begin(), entries_.end(), sample_num);
-  if (it != entries_.end()) {
+  Entry entry(0, 0, 0);
+  if (findEntry(sample_num, &entry)) {
     return boost::shared_ptr<VoiceSample>(
-        new OVKVoiceSample(file_, it->offset, it->length));
+        new OVKVoiceSample(file_, entry.offset, entry.length));
   }
 
   throw rlvm::Exception("Couldn't find sample in OVKVoiceArchive");
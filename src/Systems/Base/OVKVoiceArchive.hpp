@@ -27,7 +27,6 @@
 #ifndef SRC_SYSTEMS_BASE_OVKVOICEARCHIVE_HPP_
 #define SRC_SYSTEMS_BASE_OVKVOICEARCHIVE_HPP_
 
-#include <vector>
 #include <boost/filesystem/path.hpp>
 
 #include "Systems/Base/VoiceArchive.hpp"
@@ -45,9 +44,6 @@ class OVKVoiceArchive : public VoiceArchive {
  private:
   // The file to read from
   boost::filesystem::path file_;
-
-  // A list of samples in this archive
-  std::vector<Entry> entries_;
 };  // class OVKVoiceArchive
 
 #endif  // SRC_SYSTEMS_BASE_OVKVOICEARCHIVE_HPP_
@@ -26,6 +26,8 @@
 
 #include <boost/archive/text_iarchive.hpp>
 #include <boost/archive/text_oarchive.hpp>
+#include "portable_binary_archive/portable_binary_iarchive.hpp"
+#include "portable_binary_archive/portable_binary_oarchive.hpp"
 #include <boost/serialization/export.hpp>
 
 #include "Systems/Base/ParentGraphicsObjectData.hpp"
@@ -125,15 +127,21 @@ void ParentGraphicsObjectData::serialize(Archive& ar, unsigned int version) {
 
 // -----------------------------------------------------------------------
 
-// Explicit instantiations for text archives (since we hide the
+// Explicit instantiations for text and binary archives (since we hide the
 // implementation)
 
 template void ParentGraphicsObjectData::serialize<
   boost::archive::text_iarchive>(
       boost::archive::text_iarchive& ar, unsigned int version);
+template void ParentGraphicsObjectData::serialize<
+  portable_binary_iarchive>(
+      portable_binary_iarchive& ar, unsigned int version);
 template void ParentGraphicsObjectData::serialize<
   boost::archive::text_oarchive>(
       boost::archive::text_oarchive& ar, unsigned int version);
+template void ParentGraphicsObjectData::serialize<
+  portable_binary_oarchive>(
+      portable_binary_oarchive& ar, unsigned int version);
 
 BOOST_CLASS_EXPORT(ParentGraphicsObjectData);
 
@@ -0,0 +1,234 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2013 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+// -----------------------------------------------------------------------
+
+#include "Systems/Base/PixelKernels.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "Utilities/WorkerPool.hpp"
+
+namespace {
+
+// Below this many pixels, waking up the pool costs more than it saves.
+const int PARALLEL_PIXELS = 128 * 1024;
+
+// Calls |band| with ranges of rows that together cover [0, height).
+void ForEachBand(const PixelRect& rect,
+                 const std::function<void(int, int)>& band) {
+  WorkerPool& pool = WorkerPool::Shared();
+  int pixels = rect.width * rect.height;
+  int bands = 1;
+  if (pixels >= PARALLEL_PIXELS && pool.threadCount() > 0) {
+    bands = std::min(pool.threadCount() + 1, pixels / (PARALLEL_PIXELS / 2));
+    bands = std::min(bands, rect.height);
+  }
+
+  if (bands <= 1) {
+    band(0, rect.height);
+    return;
+  }
+
+  pool.parallelFor(bands, [&](int i) {
+      band(rect.height * i / bands, rect.height * (i + 1) / bands);
+    });
+}
+
+// Applies |fn| to every pixel of |dst|, one row span at a time.
+void ForEachRow(const PixelRect& dst,
+                const std::function<void(uint32_t*, int)>& fn) {
+  ForEachBand(dst, [&](int begin, int end) {
+      for (int y = begin; y < end; ++y)
+        fn(dst.row(y), dst.width);
+    });
+}
+
+inline uint32_t BlendPixel(uint32_t s, uint32_t d, const PixelLayout& layout,
+                           uint32_t rgb_mask) {
+  uint32_t a = (s >> layout.a_shift) & 0xff;
+  if (a == 0)
+    return d;
+  if (a == 255)
+    return (s & rgb_mask) | (d & ~rgb_mask);
+
+  // d + (s - d) * a / 256, rearranged so nothing goes negative.
+  uint32_t out = d & ~rgb_mask;
+  const int shifts[3] = { layout.r_shift, layout.g_shift, layout.b_shift };
+  for (int i = 0; i < 3; ++i) {
+    uint32_t sc = (s >> shifts[i]) & 0xff;
+    uint32_t dc = (d >> shifts[i]) & 0xff;
+    out |= ((sc * a + dc * (256 - a)) >> 8) << shifts[i];
+  }
+  return out;
+}
+
+}  // namespace
+
+// -----------------------------------------------------------------------
+
+void FillPixels(const PixelRect& dst, uint32_t pixel) {
+  ForEachRow(dst, [pixel](uint32_t* row, int width) {
+      int x = 0;
+#if defined(__SSE2__)
+      __m128i value = _mm_set1_epi32(pixel);
+      for (; x + 4 <= width; x += 4)
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(row + x), value);
+#endif
+      for (; x < width; ++x)
+        row[x] = pixel;
+    });
+}
+
+// -----------------------------------------------------------------------
+
+void CopyPixels(const PixelRect& src, const PixelRect& dst) {
+  ForEachBand(dst, [&](int begin, int end) {
+      for (int y = begin; y < end; ++y)
+        memmove(dst.row(y), src.row(y), dst.width * 4);
+    });
+}
+
+// -----------------------------------------------------------------------
+
+void AlphaBlendPixels(const PixelRect& src, const PixelRect& dst,
+                      const PixelLayout& layout) {
+  const uint32_t rgb_mask = layout.rgbMask();
+  ForEachBand(dst, [&](int begin, int end) {
+      for (int y = begin; y < end; ++y) {
+        const uint32_t* s = src.row(y);
+        uint32_t* d = dst.row(y);
+        int x = 0;
+#if defined(__SSE2__)
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i mask = _mm_set1_epi32(rgb_mask);
+        const __m128i all_255 = _mm_set1_epi32(255);
+        const __m128i c256 = _mm_set1_epi16(256);
+        const __m128i a_shift = _mm_cvtsi32_si128(layout.a_shift);
+        for (; x + 4 <= dst.width; x += 4) {
+          __m128i sp = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + x));
+          __m128i dp = _mm_loadu_si128(reinterpret_cast<__m128i*>(d + x));
+
+          // Spread each pixel's alpha over all four of its bytes.
+          __m128i a = _mm_and_si128(_mm_srl_epi32(sp, a_shift), all_255);
+          __m128i opaque = _mm_cmpeq_epi32(a, all_255);
+          a = _mm_or_si128(a, _mm_slli_epi32(a, 8));
+          a = _mm_or_si128(a, _mm_slli_epi32(a, 16));
+
+          // (s * a + d * (256 - a)) >> 8 never exceeds 16 bits.
+          __m128i lo_a = _mm_unpacklo_epi8(a, zero);
+          __m128i hi_a = _mm_unpackhi_epi8(a, zero);
+          __m128i lo = _mm_add_epi16(
+              _mm_mullo_epi16(_mm_unpacklo_epi8(sp, zero), lo_a),
+              _mm_mullo_epi16(_mm_unpacklo_epi8(dp, zero),
+                              _mm_sub_epi16(c256, lo_a)));
+          __m128i hi = _mm_add_epi16(
+              _mm_mullo_epi16(_mm_unpackhi_epi8(sp, zero), hi_a),
+              _mm_mullo_epi16(_mm_unpackhi_epi8(dp, zero),
+                              _mm_sub_epi16(c256, hi_a)));
+          __m128i blended = _mm_packus_epi16(_mm_srli_epi16(lo, 8),
+                                             _mm_srli_epi16(hi, 8));
+
+          // Opaque pixels are copied rather than blended.
+          blended = _mm_or_si128(_mm_and_si128(opaque, sp),
+                                 _mm_andnot_si128(opaque, blended));
+
+          __m128i out = _mm_or_si128(_mm_and_si128(mask, blended),
+                                     _mm_andnot_si128(mask, dp));
+          _mm_storeu_si128(reinterpret_cast<__m128i*>(d + x), out);
+        }
+#endif
+        for (; x < dst.width; ++x)
+          d[x] = BlendPixel(s[x], d[x], layout, rgb_mask);
+      }
+    });
+}
+
+// -----------------------------------------------------------------------
+
+void InvertPixels(const PixelRect& dst, const PixelLayout& layout) {
+  const uint32_t rgb_mask = layout.rgbMask();
+  ForEachRow(dst, [rgb_mask](uint32_t* row, int width) {
+      int x = 0;
+#if defined(__SSE2__)
+      __m128i mask = _mm_set1_epi32(rgb_mask);
+      for (; x + 4 <= width; x += 4) {
+        __m128i* p = reinterpret_cast<__m128i*>(row + x);
+        _mm_storeu_si128(p, _mm_xor_si128(_mm_loadu_si128(p), mask));
+      }
+#endif
+      for (; x < width; ++x)
+        row[x] ^= rgb_mask;
+    });
+}
+
+// -----------------------------------------------------------------------
+
+void MonoPixels(const PixelRect& dst, const PixelLayout& layout) {
+  // 0.3 R + 0.59 G + 0.11 B in 16.16 fixed point. The rounding term makes
+  // this agree with the old floating point version on every input.
+  uint32_t r_weight[256], g_weight[256], b_weight[256];
+  for (int i = 0; i < 256; ++i) {
+    r_weight[i] = 19661 * i;
+    g_weight[i] = 38666 * i;
+    b_weight[i] = 7209 * i + 61;
+  }
+
+  const uint32_t rgb_mask = layout.rgbMask();
+  ForEachRow(dst, [&](uint32_t* row, int width) {
+      for (int x = 0; x < width; ++x) {
+        uint32_t p = row[x];
+        uint32_t grey = (r_weight[(p >> layout.r_shift) & 0xff] +
+                         g_weight[(p >> layout.g_shift) & 0xff] +
+                         b_weight[(p >> layout.b_shift) & 0xff]) >> 16;
+        if (grey > 255)
+          grey = 255;
+        row[x] = (p & ~rgb_mask) | (grey << layout.r_shift) |
+                 (grey << layout.g_shift) | (grey << layout.b_shift);
+      }
+    });
+}
+
+// -----------------------------------------------------------------------
+
+void MapPixelChannels(const PixelRect& dst, const PixelLayout& layout,
+                      const ChannelMap& r, const ChannelMap& g,
+                      const ChannelMap& b) {
+  const uint32_t rgb_mask = layout.rgbMask();
+  ForEachRow(dst, [&](uint32_t* row, int width) {
+      for (int x = 0; x < width; ++x) {
+        uint32_t p = row[x];
+        row[x] = (p & ~rgb_mask) |
+                 (uint32_t(r[(p >> layout.r_shift) & 0xff]) << layout.r_shift) |
+                 (uint32_t(g[(p >> layout.g_shift) & 0xff]) << layout.g_shift) |
+                 (uint32_t(b[(p >> layout.b_shift) & 0xff]) << layout.b_shift);
+      }
+    });
+}
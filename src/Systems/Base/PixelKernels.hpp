@@ -0,0 +1,92 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2013 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+// -----------------------------------------------------------------------
+
+#ifndef SRC_SYSTEMS_BASE_PIXELKERNELS_HPP_
+#define SRC_SYSTEMS_BASE_PIXELKERNELS_HPP_
+
+#include <stdint.h>
+#include <boost/array.hpp>
+
+// Tight loops over 32-bit pixels for the DC operations of the Grp module.
+// These work on raw memory so they don't depend on SDL. Rectangles big
+// enough to be worth it are split into bands of rows that run on
+// WorkerPool::Shared(). The inner loops use SSE2 where it's available.
+
+// A rectangle of 32-bit pixels somewhere in memory. |pitch| is in bytes.
+struct PixelRect {
+  PixelRect(void* pixels, int pitch, int width, int height)
+      : pixels(static_cast<uint8_t*>(pixels)), pitch(pitch), width(width),
+        height(height) {}
+
+  uint32_t* row(int y) const {
+    return reinterpret_cast<uint32_t*>(pixels + pitch * y);
+  }
+
+  uint8_t* pixels;
+  int pitch;
+  int width;
+  int height;
+};
+
+// Where each channel lives in a pixel, as a bit shift.
+struct PixelLayout {
+  PixelLayout(int r_shift, int g_shift, int b_shift, int a_shift)
+      : r_shift(r_shift), g_shift(g_shift), b_shift(b_shift),
+        a_shift(a_shift) {}
+
+  uint32_t rgbMask() const {
+    return (0xffu << r_shift) | (0xffu << g_shift) | (0xffu << b_shift);
+  }
+
+  int r_shift;
+  int g_shift;
+  int b_shift;
+  int a_shift;
+};
+
+typedef boost::array<uint8_t, 256> ChannelMap;
+
+// Sets every pixel in |dst| to |pixel|.
+void FillPixels(const PixelRect& dst, uint32_t pixel);
+
+// Copies |src| over |dst|, which must be the same size and layout and must
+// not overlap.
+void CopyPixels(const PixelRect& src, const PixelRect& dst);
+
+// Blends |src| onto |dst| with |src|'s alpha channel, the way SDL blits one
+// RGBA surface onto another: fully opaque pixels are copied, and the alpha
+// channel of |dst| is left alone.
+void AlphaBlendPixels(const PixelRect& src, const PixelRect& dst,
+                      const PixelLayout& layout);
+
+// The colour transforms. All of them leave alpha alone.
+void InvertPixels(const PixelRect& dst, const PixelLayout& layout);
+void MonoPixels(const PixelRect& dst, const PixelLayout& layout);
+void MapPixelChannels(const PixelRect& dst, const PixelLayout& layout,
+                      const ChannelMap& r, const ChannelMap& g,
+                      const ChannelMap& b);
+
+#endif  // SRC_SYSTEMS_BASE_PIXELKERNELS_HPP_
@@ -0,0 +1,75 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2013 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+// -----------------------------------------------------------------------
+
+
+#include "Systems/Base/QuadBatch.hpp"
+
+QuadBatch::QuadBatch(const Submitter& submitter)
+    : submitter_(submitter), texture_(0), mode_(BLEND_ALPHA),
+      submitted_texture_(0) {
+  vertices_.reserve(MAX_QUADS * 4);
+}
+
+QuadBatch::~QuadBatch() {
+}
+
+void QuadBatch::addQuad(unsigned int texture, BlendMode mode,
+                        const Vertex quad[4]) {
+  if (!vertices_.empty()) {
+    if (texture != texture_ || mode != mode_) {
+      stats_.state_changes++;
+      flush();
+    } else if (pendingQuads() == MAX_QUADS) {
+      flush();
+    }
+  }
+
+  texture_ = texture;
+  mode_ = mode;
+  vertices_.insert(vertices_.end(), quad, quad + 4);
+}
+
+void QuadBatch::flush() {
+  if (vertices_.empty())
+    return;
+
+  int quads = pendingQuads();
+  stats_.draw_calls++;
+  stats_.quads += quads;
+  if (texture_ != submitted_texture_) {
+    stats_.texture_binds++;
+    submitted_texture_ = texture_;
+  }
+
+  // Drop the batch even if the submitter throws, so we don't send it twice.
+  try {
+    submitter_(texture_, mode_, &vertices_[0], quads);
+  } catch (...) {
+    vertices_.clear();
+    throw;
+  }
+  vertices_.clear();
+}
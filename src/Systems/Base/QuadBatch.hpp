@@ -0,0 +1,110 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2013 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+// -----------------------------------------------------------------------
+
+
+#ifndef SRC_SYSTEMS_BASE_QUADBATCH_HPP_
+#define SRC_SYSTEMS_BASE_QUADBATCH_HPP_
+
+#include <stdint.h>
+#include <functional>
+#include <vector>
+
+// Collects textured quads and hands them to a submit function in as few
+// batches as the texture and blend state allow. Consecutive quads that use
+// the same texture and blend mode become one draw call instead of one each.
+//
+// This class knows nothing about OpenGL so it can be tested without a
+// context; Texture supplies the submit function that actually draws.
+class QuadBatch {
+ public:
+  enum BlendMode {
+    // Overwrite the destination.
+    BLEND_REPLACE,
+    // Normal alpha blending.
+    BLEND_ALPHA,
+    // Add the source, scaled by its alpha, to the destination.
+    BLEND_ADDITIVE,
+    // The subtractive colour mask fallback.
+    BLEND_SATURATE
+  };
+
+  struct Vertex {
+    float x, y;
+    float u, v;
+    uint8_t r, g, b, a;
+  };
+
+  // Called with |quads| * 4 vertices, in top left, top right, bottom right,
+  // bottom left order for each quad.
+  typedef std::function<void(unsigned int texture, BlendMode mode,
+                             const Vertex* vertices, int quads)> Submitter;
+
+  struct Stats {
+    Stats() : draw_calls(0), quads(0), texture_binds(0), state_changes(0) {}
+
+    unsigned long draw_calls;
+    unsigned long quads;
+
+    // Draw calls that used a different texture than the one before.
+    unsigned long texture_binds;
+
+    // Flushes forced because the texture or blend mode changed.
+    unsigned long state_changes;
+  };
+
+  // Most quads we hold before flushing, which keeps indices in 16 bits.
+  static const int MAX_QUADS = 4096;
+
+  explicit QuadBatch(const Submitter& submitter);
+  ~QuadBatch();
+
+  // Queues one quad, flushing first if it can't join the pending batch.
+  void addQuad(unsigned int texture, BlendMode mode, const Vertex quad[4]);
+
+  // Submits everything pending. Anything that touches GL state outside of
+  // this class (reading the framebuffer, uploading to a texture that may be
+  // pending, swapping buffers) has to call this first.
+  void flush();
+
+  int pendingQuads() const { return vertices_.size() / 4; }
+
+  const Stats& stats() const { return stats_; }
+  void resetStats() { stats_ = Stats(); }
+
+ private:
+  Submitter submitter_;
+
+  unsigned int texture_;
+  BlendMode mode_;
+
+  // The texture of the last batch we submitted.
+  unsigned int submitted_texture_;
+  std::vector<Vertex> vertices_;
+
+  Stats stats_;
+};  // class QuadBatch
+
+#endif  // SRC_SYSTEMS_BASE_QUADBATCH_HPP_
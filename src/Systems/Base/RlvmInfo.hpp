@@ -29,6 +29,8 @@
 #define SRC_SYSTEMS_BASE_RLVMINFO_HPP_
 
 #include <string>
+#include <utility>
+#include <vector>
 
 /**
  * Data struct used to pass data to display on the Interpreter menu.
@@ -43,6 +45,9 @@ struct RlvmInfo {
 
   bool rlbabel_loaded;
   int text_transformation;
+
+  // Each line of the MemoryReport, as a name and a formatted byte count.
+  std::vector<std::pair<std::string, std::string> > memory_usage;
 };
 
 #endif  // SRC_SYSTEMS_BASE_RLVMINFO_HPP_
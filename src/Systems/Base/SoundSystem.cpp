@@ -27,6 +27,8 @@
 
 #include <boost/archive/text_iarchive.hpp>
 #include <boost/archive/text_oarchive.hpp>
+#include "portable_binary_archive/portable_binary_iarchive.hpp"
+#include "portable_binary_archive/portable_binary_oarchive.hpp"
 
 #include "Systems/Base/SoundSystem.hpp"
 
@@ -40,6 +42,7 @@
 
 #include "MachineBase/Serialization.hpp"
 #include "Systems/Base/EventSystem.hpp"
+#include "Systems/Base/MemoryReport.hpp"
 #include "Systems/Base/System.hpp"
 #include "libReallive/gameexe.h"
 
@@ -427,6 +430,11 @@ void SoundSystem::reset() {
   // empty
 }
 
+void SoundSystem::reportMemoryUsage(MemoryReport& report) {
+  report.add("Voice archives", voice_cache_.mappedBytes(),
+             voice_cache_.mappedArchives());
+}
+
 // static
 void SoundSystem::checkChannel(int channel, const char* function_name) {
   if (channel < 0 || channel > NUM_TOTAL_CHANNELS) {
@@ -471,12 +479,16 @@ void SoundSystem::save(Archive& ar, unsigned int version) const {
 
 // -----------------------------------------------------------------------
 
-// Explicit instantiations for text archives (since we hide the
+// Explicit instantiations for text and binary archives (since we hide the
 // implementation)
 
 template void SoundSystem::save<boost::archive::text_oarchive>(
   boost::archive::text_oarchive & ar, unsigned int version) const;
+template void SoundSystem::save<portable_binary_oarchive>(
+  portable_binary_oarchive & ar, unsigned int version) const;
 
 template void SoundSystem::load<boost::archive::text_iarchive>(
   boost::archive::text_iarchive & ar, unsigned int version);
+template void SoundSystem::load<portable_binary_iarchive>(
+  portable_binary_iarchive & ar, unsigned int version);
 
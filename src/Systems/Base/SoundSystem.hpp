@@ -39,6 +39,7 @@
 #include "Systems/Base/VoiceCache.hpp"
 
 class Gameexe;
+class MemoryReport;
 class System;
 
 const int NUM_BASE_CHANNELS = 16;
@@ -362,6 +363,10 @@ class SoundSystem {
 
   virtual void reset();
 
+  // Adds the mapped voice archives to |report|. Subclasses add their decoded
+  // sample caches.
+  virtual void reportMemoryUsage(MemoryReport& report);
+
   System& system() { return system_; }
 
   System& system_;
@@ -45,6 +45,7 @@
 #include "Modules/Module_Sys.hpp"
 #include "Systems/Base/EventSystem.hpp"
 #include "Systems/Base/GraphicsSystem.hpp"
+#include "Systems/Base/MemoryReport.hpp"
 #include "Systems/Base/Platform.hpp"
 #include "Systems/Base/RlvmInfo.hpp"
 #include "Systems/Base/SoundSystem.hpp"
@@ -52,6 +53,7 @@
 #include "Systems/Base/TextSystem.hpp"
 #include "Utilities/Exception.hpp"
 #include "Utilities/StringUtilities.hpp"
+#include "libReallive/archive.h"
 #include "libReallive/gameexe.h"
 
 #ifdef ANDROID
@@ -314,6 +316,13 @@ void System::showSystemInfo(RLMachine& machine) {
     info.rlbabel_loaded = machine.dllLoaded("rlBabel");
     info.text_transformation = machine.getTextEncoding();
 
+    MemoryReport report;
+    reportMemoryUsage(machine, report);
+    for (const MemoryReport::Line& line : report.lines()) {
+      info.memory_usage.push_back(
+          std::make_pair(line.name, formatBytes(line.bytes)));
+    }
+
     platform_->showSystemInfo(machine, info);
   }
 }
@@ -389,6 +398,17 @@ void System::dumpRenderTree(RLMachine& machine) {
   graphics().refresh(&tree);
 }
 
+void System::reportMemoryUsage(RLMachine& machine, MemoryReport& report) {
+  libReallive::Archive& archive = machine.archive();
+  report.add("SEEN.TXT mapping", archive.mappedBytes(), 1);
+  report.add("Parsed scenarios", archive.parsedScenarioBytes(),
+             archive.parsedScenarioCount());
+
+  graphics().reportMemoryUsage(report);
+  text().reportMemoryUsage(report);
+  sound().reportMemoryUsage(report);
+}
+
 boost::filesystem::path System::getHomeDirectory() {
 #ifdef ANDROID
   return fs::path(g_root_path);
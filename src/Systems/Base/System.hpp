@@ -43,6 +43,7 @@ class SoundSystem;
 class RLMachine;
 class Gameexe;
 class GameexeInterpretObject;
+class MemoryReport;
 class Platform;
 
 // Syscom Constants
@@ -257,6 +258,10 @@ class System {
   // Renders the screen and dumps a textual representation of the screen.
   void dumpRenderTree(RLMachine& machine);
 
+  // Fills |report| with the live memory of the SEEN.TXT archive and every
+  // subsystem.
+  void reportMemoryUsage(RLMachine& machine, MemoryReport& report);
+
   bool forceWait() { return force_wait_; }
   void setForceWait(bool in) { force_wait_ = in; }
 
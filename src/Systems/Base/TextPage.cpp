@@ -52,6 +52,9 @@ class TextPageElement {
   virtual bool isTextElement() { return false; }
   virtual void replayElement(TextPage& ts, bool is_active_page) = 0;
   virtual TextPageElement* clone() const = 0;
+
+  // Approximate bytes held by this element, for memory reports.
+  virtual size_t memoryUsage() const = 0;
 };
 
 inline TextPageElement* new_clone(const TextPageElement& in) {
@@ -73,25 +76,64 @@ class TextTextPageElement : public TextPageElement {
     return new TextTextPageElement(*this);
   }
 
+  virtual size_t memoryUsage() const {
+    return sizeof(*this) + list_of_chars_to_print_.capacity() +
+        layout_.capacity() * sizeof(TextWindow::PlacedGlyph);
+  }
+
  private:
   // A list of UTF-8 characters to print.
   string list_of_chars_to_print_;
+
+  // The glyphs the last replay drew, and the window state before and after
+  // it. Replaying from the same starting state just redraws them, which skips
+  // measuring, kinsoku and line breaking for every character.
+  bool layout_valid_;
+  TextWindow::LayoutState layout_before_;
+  TextWindow::LayoutState layout_after_;
+  std::vector<TextWindow::PlacedGlyph> layout_;
 };
 
-TextTextPageElement::TextTextPageElement() {
+TextTextPageElement::TextTextPageElement() : layout_valid_(false) {
 }
 
 void TextTextPageElement::replayElement(TextPage& page, bool is_active_page) {
   // Sometimes there are empty TextTextPageElements. I hypothesize these happen
   // because of empty strings which just set the speaker's name.
-  if (list_of_chars_to_print_.size()) {
+  if (list_of_chars_to_print_.empty())
+    return;
+
+  boost::shared_ptr<TextWindow> window =
+      page.system_->text().textWindow(page.window_num_);
+  TextWindow::LayoutState before = window->layoutState();
+  if (layout_valid_ && before == layout_before_) {
+    window->drawPlacedGlyphs(layout_);
+    window->setLayoutState(layout_after_);
+    return;
+  }
+
+  layout_valid_ = false;
+  layout_.clear();
+  window->setGlyphRecorder(&layout_);
+  try {
     printTextToFunction(bind(&TextPage::CharacterImpl, ref(page), _1, _2),
                         list_of_chars_to_print_, "");
+  } catch (...) {
+    window->setGlyphRecorder(NULL);
+    throw;
   }
+  window->setGlyphRecorder(NULL);
+
+  // A window whose character() doesn't go through TextWindow::character()
+  // records nothing; keep replaying those the slow way.
+  layout_before_ = before;
+  layout_after_ = window->layoutState();
+  layout_valid_ = !layout_.empty();
 }
 
 void TextTextPageElement::append(const string& c) {
   list_of_chars_to_print_.append(c);
+  layout_valid_ = false;
 }
 
 // -----------------------------------------------------------------------
@@ -111,6 +153,9 @@ class ActionElement : public TextPageElement {
     return new ActionElement(*this);
   }
 
+  // Doesn't include whatever |action_| keeps on the heap.
+  virtual size_t memoryUsage() const { return sizeof(*this); }
+
  private:
   std::function<void(TextPage&, bool)> action_;
 };
@@ -255,6 +300,14 @@ bool TextPage::isFull() const {
   return system_->text().textWindow( window_num_)->isFull();
 }
 
+size_t TextPage::memoryUsage() const {
+  size_t bytes = sizeof(TextPage) +
+                 elements_to_replay_.capacity() * sizeof(TextPageElement*);
+  for (const TextPageElement& element : elements_to_replay_)
+    bytes += element.memoryUsage();
+  return bytes;
+}
+
 void TextPage::addAction(
     const std::function<void(TextPage&, bool)>& action) {
   action(*this, true);
@@ -120,6 +120,10 @@ class TextPage {
   // to implement implicit pauses when a page is full.
   bool isFull() const;
 
+  // Approximate bytes held by this page and the elements it replays, for
+  // memory reports.
+  size_t memoryUsage() const;
+
   // Queries to see if there has been an invocation of
   // markRubyBegin(), but not the closing displayRubyText().
   bool inRubyGloss() const { return in_ruby_gloss_; }
@@ -27,6 +27,8 @@
 
 #include <boost/archive/text_iarchive.hpp>
 #include <boost/archive/text_oarchive.hpp>
+#include "portable_binary_archive/portable_binary_iarchive.hpp"
+#include "portable_binary_archive/portable_binary_oarchive.hpp"
 
 #include "Systems/Base/TextSystem.hpp"
 
@@ -44,6 +46,7 @@
 #include "MachineBase/RLMachine.hpp"
 #include "MachineBase/Serialization.hpp"
 #include "Systems/Base/GraphicsSystem.hpp"
+#include "Systems/Base/MemoryReport.hpp"
 #include "Systems/Base/Surface.hpp"
 #include "Systems/Base/System.hpp"
 #include "Systems/Base/TextKeyCursor.hpp"
@@ -62,6 +65,19 @@ using std::vector;
 
 const unsigned int MAX_PAGE_HISTORY = 100;
 
+// Default ceiling on |text_surface_cache_|. Object text is usually a handful
+// of short strings, so this holds a few hundred of them.
+const int DEFAULT_TEXT_CACHE_MB = 8;
+
+// Reads __TEXT_CACHE_MB as a byte count. Multiplies in size_t so large
+// settings don't overflow, and treats a negative setting as the default.
+static size_t textCacheBytes(Gameexe& gexe) {
+  int megabytes = gexe("__TEXT_CACHE_MB").to_int(DEFAULT_TEXT_CACHE_MB);
+  if (megabytes < 0)
+    megabytes = DEFAULT_TEXT_CACHE_MB;
+  return static_cast<size_t>(megabytes) * 1024 * 1024;
+}
+
 const int FULLWIDTH_NUMBER_SIGN = 0xFF03;
 const int FULLWIDTH_A = 0xFF21;
 const int FULLWIDTH_B = 0xFF22;
@@ -115,7 +131,8 @@ TextSystem::TextSystem(System& system, Gameexe& gexe)
       skip_mode_(false),
       kidoku_read_(false),
       in_selection_mode_(false),
-      system_(system) {
+      system_(system),
+      text_surface_cache_(textCacheBytes(gexe)) {
   GameexeInterpretObject ctrl_use(gexe("CTRL_USE"));
   if (ctrl_use.exists())
     ctrl_key_skip_ = ctrl_use;
@@ -496,10 +513,48 @@ bool parseInteger(std::string::const_iterator& begin,
   return true;
 }
 
+bool TextSystem::RenderTextKey::operator<(const RenderTextKey& rhs) const {
+  if (size != rhs.size) return size < rhs.size;
+  if (xspace != rhs.xspace) return xspace < rhs.xspace;
+  if (yspace != rhs.yspace) return yspace < rhs.yspace;
+  if (max_chars_in_line != rhs.max_chars_in_line)
+    return max_chars_in_line < rhs.max_chars_in_line;
+  if (colour != rhs.colour) return colour < rhs.colour;
+  if (shadow_colour != rhs.shadow_colour)
+    return shadow_colour < rhs.shadow_colour;
+  return utf8str < rhs.utf8str;
+}
+
 boost::shared_ptr<Surface> TextSystem::renderText(
     const std::string& utf8str, int size, int xspace, int yspace,
     const RGBColour& colour, RGBColour* shadow_colour,
     int max_chars_in_line) {
+  RenderTextKey key;
+  key.utf8str = utf8str;
+  key.size = size;
+  key.xspace = xspace;
+  key.yspace = yspace;
+  key.max_chars_in_line = max_chars_in_line;
+  key.colour = (colour.r() << 16) | (colour.g() << 8) | colour.b();
+  key.shadow_colour = shadow_colour ?
+      ((shadow_colour->r() << 16) | (shadow_colour->g() << 8) |
+       shadow_colour->b()) : -1;
+
+  boost::shared_ptr<Surface> surface = text_surface_cache_.fetch(key);
+  if (!surface) {
+    surface = renderTextUncached(utf8str, size, xspace, yspace, colour,
+                                 shadow_colour, max_chars_in_line);
+    Size s = surface->size();
+    text_surface_cache_.insert(key, surface, s.width() * s.height() * 4);
+  }
+
+  return surface;
+}
+
+boost::shared_ptr<Surface> TextSystem::renderTextUncached(
+    const std::string& utf8str, int size, int xspace, int yspace,
+    const RGBColour& colour, RGBColour* shadow_colour,
+    int max_chars_in_line) {
   const int line_max_width =
       (max_chars_in_line > 0) ? (size + xspace) * max_chars_in_line :
       INT_MAX;
@@ -770,6 +825,25 @@ void TextSystem::reset() {
   skip_mode_ = false;
 }
 
+void TextSystem::reportMemoryUsage(MemoryReport& report) {
+  size_t page_bytes = 0;
+  size_t page_count = 0;
+  auto count_pageset = [&](const PageSet& set) {
+    for (PageSet::const_iterator it = set.begin(); it != set.end(); ++it) {
+      page_bytes += it->second->memoryUsage();
+      page_count++;
+    }
+  };
+  if (current_pageset_)
+    count_pageset(*current_pageset_);
+  for (const PageSet& set : previous_page_sets_)
+    count_pageset(set);
+  report.add("Text pages", page_bytes, page_count);
+
+  report.add("Text surface cache", text_surface_cache_.current_bytes(),
+             text_surface_cache_.size());
+}
+
 void TextSystem::setKidokuRead(const int in) {
   bool value_changed = kidoku_read_ != in;
 
@@ -813,14 +887,18 @@ void TextSystem::save(Archive& ar, unsigned int version) const {
 
 // -----------------------------------------------------------------------
 
-// Explicit instantiations for text archives (since we hide the
+// Explicit instantiations for text and binary archives (since we hide the
 // implementation)
 
 template void TextSystem::save<boost::archive::text_oarchive>(
   boost::archive::text_oarchive & ar, unsigned int version) const;
+template void TextSystem::save<portable_binary_oarchive>(
+  portable_binary_oarchive & ar, unsigned int version) const;
 
 template void TextSystem::load<boost::archive::text_iarchive>(
   boost::archive::text_iarchive & ar, unsigned int version);
+template void TextSystem::load<portable_binary_iarchive>(
+  portable_binary_iarchive & ar, unsigned int version);
 
 // -----------------------------------------------------------------------
 
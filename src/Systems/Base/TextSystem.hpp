@@ -31,6 +31,7 @@
 #include "Systems/Base/EventListener.hpp"
 
 #include "MachineBase/LongOperation.hpp"
+#include "Utilities/SizedLRUCache.hpp"
 
 #include <boost/ptr_container/ptr_list.hpp>
 #include <boost/ptr_container/ptr_map.hpp>
@@ -44,6 +45,7 @@
 
 class Gameexe;
 class Memory;
+class MemoryReport;
 class Point;
 class RGBColour;
 class RLMachine;
@@ -220,11 +222,38 @@ class TextSystem : public EventListener {
   // Returns a surface with |utf8str| rendered with the other specified
   // properties. Will search |utf8str| for object text syntax and will change
   // various properties based on that syntax.
+  //
+  // Surfaces are shared through |text_surface_cache_| between every caller
+  // asking for the same text, so callers must not draw onto them.
   boost::shared_ptr<Surface> renderText(
       const std::string& utf8str, int size, int xspace,
       int yspace, const RGBColour& colour, RGBColour* shadow_colour,
       int max_chars_in_line);
 
+  // Everything that goes into a renderText() surface.
+  struct RenderTextKey {
+    bool operator<(const RenderTextKey& rhs) const;
+
+    std::string utf8str;
+    int size, xspace, yspace, max_chars_in_line;
+    int colour;
+
+    // -1 when there's no shadow; otherwise the packed RGB value.
+    int shadow_colour;
+  };
+  typedef SizedLRUCache<RenderTextKey, boost::shared_ptr<Surface> >
+      TextSurfaceCache;
+
+  void setTextSurfaceCacheBytes(size_t bytes) {
+    text_surface_cache_.set_max_bytes(bytes);
+  }
+  size_t textSurfaceCacheBytes() const {
+    return text_surface_cache_.current_bytes();
+  }
+  const TextSurfaceCache::Stats& textSurfaceCacheStats() const {
+    return text_surface_cache_.stats();
+  }
+
   // Renders a glyph onto destination. Returns the size of the glyph blitted.
   virtual Size renderGlyphOnto(
       const std::string& current,
@@ -242,6 +271,9 @@ class TextSystem : public EventListener {
   // Resets non-configuration values (so we can load games).
   virtual void reset();
 
+  // Adds the backlog pages and the text surface cache to |report|.
+  virtual void reportMemoryUsage(MemoryReport& report);
+
   bool kidokuRead() const { return kidoku_read_; }
   void setKidokuRead(const int in);
 
@@ -337,9 +369,19 @@ class TextSystem : public EventListener {
   // manageable constant number.
   void expireOldPages();
 
+  // Does the actual work of renderText() on a cache miss.
+  boost::shared_ptr<Surface> renderTextUncached(
+      const std::string& utf8str, int size, int xspace,
+      int yspace, const RGBColour& colour, RGBColour* shadow_colour,
+      int max_chars_in_line);
+
   // Our parent system object.
   System& system_;
 
+  // Rendered object text, name plates and selection buttons. Sized from the
+  // internal __TEXT_CACHE_MB key.
+  TextSurfaceCache text_surface_cache_;
+
   // This state can change after the last savepoint marker. These are the
   // values that should be saved to disk.
   int savepoint_active_window_;
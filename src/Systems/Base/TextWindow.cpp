@@ -92,7 +92,7 @@ TextWindow::TextWindow(System& system, int window_num)
       text_insertion_point_y_(0),
       ruby_begin_point_(-1), current_line_number_(0),
       current_indentation_in_pixels_(0), last_token_was_name_(false),
-      use_indentation_(0), colour_(),
+      glyph_recorder_(NULL), use_indentation_(0), colour_(),
       filter_(0), is_visible_(0), in_selection_mode_(0),
       system_(system),
       text_system_(system.text()) {
@@ -544,8 +544,10 @@ bool TextWindow::character(const std::string& current,
 
     // If the width of this glyph plus the spacing will put us over the
     // edge of the window, then line increment.
+    bool broke_line = false;
     if (mustLineBreak(cur_codepoint, rest)) {
       hardBrake();
+      broke_line = true;
 
       if (isFull())
         return false;
@@ -557,6 +559,16 @@ bool TextWindow::character(const std::string& current,
         text_insertion_point_x_, text_insertion_point_y_,
         textSurface());
 
+    if (glyph_recorder_) {
+      PlacedGlyph glyph;
+      glyph.text = current;
+      glyph.position = Point(text_insertion_point_x_, text_insertion_point_y_);
+      glyph.font_size = fontSizeInPixels();
+      glyph.colour = font_colour_;
+      glyph.starts_line = broke_line;
+      glyph_recorder_->push_back(glyph);
+    }
+
     // Move the insertion point forward one character
     text_insertion_point_x_ += font_size_in_pixels_ + x_spacing_;
 
@@ -658,6 +670,81 @@ void TextWindow::markRubyBegin() {
   ruby_begin_point_ = text_insertion_point_x_;
 }
 
+TextWindow::LayoutState::LayoutState()
+    : insertion_point_x(0), insertion_point_y(0), line_number(0),
+      indentation(0), ruby_begin_point(-1), font_size(0),
+      last_token_was_name(false), default_font_size(0), ruby_size(0),
+      x_window_size_in_chars(0), y_window_size_in_chars(0), x_spacing(0),
+      y_spacing(0), name_mod(0) {
+}
+
+bool TextWindow::LayoutState::operator==(const LayoutState& rhs) const {
+  return insertion_point_x == rhs.insertion_point_x &&
+      insertion_point_y == rhs.insertion_point_y &&
+      line_number == rhs.line_number &&
+      indentation == rhs.indentation &&
+      ruby_begin_point == rhs.ruby_begin_point &&
+      font_size == rhs.font_size &&
+      colour == rhs.colour &&
+      last_token_was_name == rhs.last_token_was_name &&
+      default_font_size == rhs.default_font_size &&
+      ruby_size == rhs.ruby_size &&
+      x_window_size_in_chars == rhs.x_window_size_in_chars &&
+      y_window_size_in_chars == rhs.y_window_size_in_chars &&
+      x_spacing == rhs.x_spacing &&
+      y_spacing == rhs.y_spacing &&
+      name_mod == rhs.name_mod;
+}
+
+TextWindow::LayoutState TextWindow::layoutState() const {
+  LayoutState state;
+  state.insertion_point_x = text_insertion_point_x_;
+  state.insertion_point_y = text_insertion_point_y_;
+  state.line_number = current_line_number_;
+  state.indentation = current_indentation_in_pixels_;
+  state.ruby_begin_point = ruby_begin_point_;
+  state.font_size = font_size_in_pixels_;
+  state.colour = font_colour_;
+  state.last_token_was_name = last_token_was_name_;
+  state.default_font_size = default_font_size_in_pixels_;
+  state.ruby_size = ruby_size_;
+  state.x_window_size_in_chars = x_window_size_in_chars_;
+  state.y_window_size_in_chars = y_window_size_in_chars_;
+  state.x_spacing = x_spacing_;
+  state.y_spacing = y_spacing_;
+  state.name_mod = name_mod_;
+  return state;
+}
+
+void TextWindow::setLayoutState(const LayoutState& state) {
+  // The geometry fields are only there for comparison; the script owns them.
+  text_insertion_point_x_ = state.insertion_point_x;
+  text_insertion_point_y_ = state.insertion_point_y;
+  current_line_number_ = state.line_number;
+  current_indentation_in_pixels_ = state.indentation;
+  ruby_begin_point_ = state.ruby_begin_point;
+  font_size_in_pixels_ = state.font_size;
+  font_colour_ = state.colour;
+  last_token_was_name_ = state.last_token_was_name;
+}
+
+void TextWindow::drawPlacedGlyphs(const std::vector<PlacedGlyph>& glyphs) {
+  if (glyphs.empty())
+    return;
+
+  setVisible(true);
+
+  boost::shared_ptr<Surface> surface = textSurface();
+  RGBColour shadow = RGBAColour::Black().rgb();
+  for (std::vector<PlacedGlyph>::const_iterator it = glyphs.begin();
+       it != glyphs.end(); ++it) {
+    text_system_.renderGlyphOnto(it->text, it->font_size, it->colour, &shadow,
+                                 it->position.x(), it->position.y(), surface);
+  }
+
+  system_.graphics().markScreenAsDirty(GUT_TEXTSYS);
+}
+
 void TextWindow::setRGBAF(const vector<int>& attr) {
   colour_ = RGBAColour(attr.at(0), attr.at(1), attr.at(2), attr.at(3));
   setFilter(attr.at(4));
@@ -242,6 +242,55 @@ class TextWindow {
   virtual void markRubyBegin();
   virtual void displayRubyText(const std::string& utf8str) = 0;
 
+  // ------------------------------------------------- [ Layout replay ]
+  // One glyph drawn by character(), with everything needed to draw it again
+  // without measuring or line breaking.
+  struct PlacedGlyph {
+    PlacedGlyph() : font_size(0), starts_line(false) {}
+
+    std::string text;
+    Point position;
+    int font_size;
+    RGBColour colour;
+
+    // Whether character() broke the line right before this glyph.
+    bool starts_line;
+  };
+
+  // Everything character() reads or writes. A run of glyphs recorded from one
+  // LayoutState can be drawn again whenever the window is back in that state.
+  struct LayoutState {
+    LayoutState();
+    bool operator==(const LayoutState& rhs) const;
+
+    int insertion_point_x, insertion_point_y;
+    int line_number;
+    int indentation;
+    int ruby_begin_point;
+    int font_size;
+    RGBColour colour;
+    bool last_token_was_name;
+
+    // Window geometry, which can be changed by the script.
+    int default_font_size;
+    int ruby_size;
+    int x_window_size_in_chars, y_window_size_in_chars;
+    int x_spacing, y_spacing;
+    int name_mod;
+  };
+
+  LayoutState layoutState() const;
+  void setLayoutState(const LayoutState& state);
+
+  // While |glyphs| is non-NULL, character() appends every glyph it draws.
+  void setGlyphRecorder(std::vector<PlacedGlyph>* glyphs) {
+    glyph_recorder_ = glyphs;
+  }
+
+  // Draws a run recorded by character() at the recorded positions. Doesn't
+  // touch the layout state; pair it with setLayoutState().
+  virtual void drawPlacedGlyphs(const std::vector<PlacedGlyph>& glyphs);
+
 
   // Text Windows are responsible for presenting the questions from
   // select() and select_s() calls. (select_w() is not done here.)
@@ -305,6 +354,9 @@ class TextWindow {
   // for quotes.
   bool last_token_was_name_;
 
+  // Where character() records the glyphs it draws, if anywhere.
+  std::vector<PlacedGlyph>* glyph_recorder_;
+
   // The default font size.
   int default_font_size_in_pixels_;
 
@@ -26,12 +26,12 @@
 
 #include "Systems/Base/VoiceArchive.hpp"
 
+#include <algorithm>
 #include <cstring>
-#include <fstream>
 #include <sstream>
-#include <boost/filesystem/fstream.hpp>
 
 #include "Utilities/Exception.hpp"
+#include "libReallive/filemap.h"
 #include "xclannad/endian.hpp"
 
 namespace fs = boost::filesystem;
@@ -80,36 +80,117 @@ const char* VoiceSample::MakeWavHeader(int rate, int ch, int bps, int size) {
 // VoiceArchive
 // -----------------------------------------------------------------------
 VoiceArchive::VoiceArchive(int file_no)
-    : file_no_(file_no) {
+    : file_no_(file_no),
+      table_offset_(0),
+      table_count_(0),
+      record_size_(0),
+      table_prepared_(false) {
 }
 
 VoiceArchive::~VoiceArchive() {
 }
 
-void VoiceArchive::readVisualArtsTable(boost::filesystem::path file,
-                                       int entry_length,
-                                       std::vector<Entry>& entries) {
-  fs::ifstream ifs(file, fs::ifstream::in | fs::ifstream::binary);
-  if (!ifs) {
+size_t VoiceArchive::mappedSize() const {
+  return mapping_ ? mapping_->size() : 0;
+}
+
+void VoiceArchive::mapFile(const boost::filesystem::path& file) {
+  try {
+    mapping_.reset(new libReallive::Mapping(file.string(), libReallive::Read));
+  } catch (libReallive::Error& e) {
     std::ostringstream oss;
     oss << "Could not open file \"" << file << "\".";
     throw rlvm::Exception(oss.str());
   }
+}
+
+const char* VoiceArchive::data() const {
+  return mapping_->get();
+}
+
+void VoiceArchive::setTable(size_t offset, int count, int record_size) {
+  if (count < 0 ||
+      offset + static_cast<size_t>(count) * record_size > mappedSize()) {
+    std::ostringstream oss;
+    oss << "Voice archive " << file_no_ << " has a truncated entry table.";
+    throw rlvm::Exception(oss.str());
+  }
+
+  table_offset_ = offset;
+  table_count_ = count;
+  record_size_ = record_size;
+  table_prepared_ = false;
+  sorted_entries_.clear();
+}
+
+void VoiceArchive::readVisualArtsTable(int entry_length) {
+  if (mappedSize() < 4) {
+    std::ostringstream oss;
+    oss << "Voice archive " << file_no_ << " is too small to have a table.";
+    throw rlvm::Exception(oss.str());
+  }
 
   // Copied from koedec.
-  char head[0x20];
-  ifs.read(head, 4);
-  int table_len = read_little_endian_int(head);
-  entries.reserve(table_len);
-
-  for (int i = 0; i < table_len; ++i) {
-    ifs.read(head, entry_length);
-    int length = read_little_endian_int(head);
-    int offset = read_little_endian_int(head+4);
-    int koe_num = read_little_endian_int(head+8);
-    entries.push_back(Entry(koe_num, length, offset));
+  setTable(4, read_little_endian_int(data()), entry_length);
+}
+
+VoiceArchive::Entry VoiceArchive::readEntry(const char* record) const {
+  int length = read_little_endian_int(record);
+  int offset = read_little_endian_int(record+4);
+  int koe_num = read_little_endian_int(record+8);
+  return Entry(koe_num, length, offset);
+}
+
+bool VoiceArchive::findEntry(int koe_num, Entry* out) {
+  if (!table_prepared_)
+    prepareTable();
+
+  if (!sorted_entries_.empty()) {
+    std::vector<Entry>::const_iterator it = std::lower_bound(
+        sorted_entries_.begin(), sorted_entries_.end(), koe_num);
+    if (it == sorted_entries_.end() || it->koe_num != koe_num)
+      return false;
+    *out = *it;
+    return true;
+  }
+
+  const char* table = data() + table_offset_;
+  int low = 0;
+  int high = table_count_;
+  while (low < high) {
+    int mid = low + (high - low) / 2;
+    if (readEntry(table + mid * record_size_).koe_num < koe_num)
+      low = mid + 1;
+    else
+      high = mid;
+  }
+
+  if (low == table_count_)
+    return false;
+
+  Entry entry = readEntry(table + low * record_size_);
+  if (entry.koe_num != koe_num)
+    return false;
+  *out = entry;
+  return true;
+}
+
+void VoiceArchive::prepareTable() {
+  table_prepared_ = true;
+
+  // Every archive we've seen stores its table in order, so this is normally a
+  // single pass over the mapped records with no allocation.
+  const char* table = data() + table_offset_;
+  for (int i = 1; i < table_count_; ++i) {
+    if (readEntry(table + i * record_size_).koe_num <
+        readEntry(table + (i - 1) * record_size_).koe_num) {
+      sorted_entries_.reserve(table_count_);
+      for (int j = 0; j < table_count_; ++j)
+        sorted_entries_.push_back(readEntry(table + j * record_size_));
+      std::sort(sorted_entries_.begin(), sorted_entries_.end());
+      return;
+    }
   }
-  sort(entries.begin(), entries.end());
 }
 
 VoiceArchive::Entry::Entry(int ikoe_num, int ilength, int ioffset)
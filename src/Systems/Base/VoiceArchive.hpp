@@ -27,11 +27,17 @@
 #ifndef SRC_SYSTEMS_BASE_VOICEARCHIVE_HPP_
 #define SRC_SYSTEMS_BASE_VOICEARCHIVE_HPP_
 
+#include <cstddef>
 #include <vector>
 #include <boost/enable_shared_from_this.hpp>
 #include <boost/filesystem/path.hpp>
+#include <boost/scoped_ptr.hpp>
 #include <boost/shared_ptr.hpp>
 
+namespace libReallive {
+class Mapping;
+}
+
 class VoiceArchive;
 
 const int WAV_HEADER_SIZE = 0x2c;
@@ -57,6 +63,10 @@ class VoiceArchive : public boost::enable_shared_from_this<VoiceArchive> {
 
   int fileNumber() const { return file_no_; }
 
+  // The number of bytes of the archive that we have mapped into memory. This
+  // is what VoiceCache uses to decide how many archives to keep open.
+  size_t mappedSize() const;
+
   virtual boost::shared_ptr<VoiceSample> findSample(int sample_num) = 0;
 
  protected:
@@ -77,14 +87,51 @@ class VoiceArchive : public boost::enable_shared_from_this<VoiceArchive> {
     }
   };
 
-  // Reads and parses' VisualArt's simple audio table format into a
-  // vector<Entry>.
-  void readVisualArtsTable(boost::filesystem::path file,
-                           int entry_length,
-                           std::vector<Entry>& entries);
+  // Memory maps |file|. Must be called by subclasses before they try to read
+  // their table.
+  void mapFile(const boost::filesystem::path& file);
+
+  // Raw access to the mapped archive.
+  const char* data() const;
+
+  // Points the entry table at |count| records of |record_size| bytes each,
+  // starting |offset| bytes into the mapped file. Nothing is parsed until the
+  // first call to findEntry().
+  void setTable(size_t offset, int count, int record_size);
+
+  // Points the entry table at VisualArt's simple audio table format: a count
+  // followed by records of |entry_length| bytes.
+  void readVisualArtsTable(int entry_length);
+
+  // Decodes a single table record. The default implementation reads
+  // VisualArt's (length, offset, koe_num) triple of little endian ints.
+  virtual Entry readEntry(const char* record) const;
+
+  // Looks up |koe_num| in the table, binary searching the mapped records in
+  // place. Returns false if there's no such sample.
+  bool findEntry(int koe_num, Entry* out);
 
  private:
+  // Checks whether the on disk table is already sorted by koe_num; if it
+  // isn't, we fall back to building a sorted copy in |sorted_entries_|.
+  void prepareTable();
+
   int file_no_;
+
+  // Our view of the archive on disk.
+  boost::scoped_ptr<libReallive::Mapping> mapping_;
+
+  // Location of the entry table in |mapping_|.
+  size_t table_offset_;
+  int table_count_;
+  int record_size_;
+
+  // Whether prepareTable() has run.
+  bool table_prepared_;
+
+  // Sorted copy of the table; only filled in when the archive's table isn't
+  // sorted on disk.
+  std::vector<Entry> sorted_entries_;
 };  // end of class VoiceArchive
 
 #endif  // SRC_SYSTEMS_BASE_VOICEARCHIVE_HPP_
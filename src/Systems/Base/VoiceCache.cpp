@@ -43,6 +43,10 @@
 
 const int ID_RADIX = 100000;
 
+// Mapped archives only cost address space until their pages are touched, but
+// we still don't want to hold every archive in a game open on a 32-bit device.
+const size_t DEFAULT_MAX_MAPPED_BYTES = 128 * 1024 * 1024;
+
 using boost::iends_with;
 using std::string;
 
@@ -50,7 +54,8 @@ namespace fs = boost::filesystem;
 
 VoiceCache::VoiceCache(SoundSystem& sound_system)
     : sound_system_(sound_system),
-      file_cache_(7) {
+      file_cache_(DEFAULT_MAX_MAPPED_BYTES),
+      archive_opens_(0) {
 }
 
 VoiceCache::~VoiceCache() {
@@ -67,7 +72,8 @@ boost::shared_ptr<VoiceSample> VoiceCache::find(int id) {
     archive = findArchive(file_no);
     if (archive) {
       // Cache for later use.
-      file_cache_.insert(file_no, archive);
+      archive_opens_++;
+      file_cache_.insert(file_no, archive, archive->mappedSize());
       return archive->findSample(index);
     } else {
       // There aren't any archives with |file_no|. Look for an individual file
@@ -27,24 +27,37 @@
 #ifndef SRC_SYSTEMS_BASE_VOICECACHE_HPP_
 #define SRC_SYSTEMS_BASE_VOICECACHE_HPP_
 
-#include "lru_cache.hpp"
-
+#include <cstddef>
 #include <boost/shared_ptr.hpp>
 
+#include "Utilities/SizedLRUCache.hpp"
+
 class SoundSystem;
 class VoiceArchive;
 class VoiceSample;
 
-/**
- *
- */
+// Finds voice samples by their koe id, keeping recently used voice archives
+// memory mapped. The number of open archives is bounded by the total number of
+// bytes mapped, since archive sizes vary wildly between games and characters.
 class VoiceCache {
  public:
+  typedef SizedLRUCache<int, boost::shared_ptr<VoiceArchive> > ArchiveCache;
+
   explicit VoiceCache(SoundSystem& sound_system);
   ~VoiceCache();
 
   boost::shared_ptr<VoiceSample> find(int id);
 
+  // Sets the ceiling on bytes of voice archives kept mapped.
+  void setMaxMappedBytes(size_t bytes) { file_cache_.set_max_bytes(bytes); }
+  size_t mappedBytes() const { return file_cache_.current_bytes(); }
+  size_t mappedArchives() const { return file_cache_.size(); }
+
+  // How many times we had to open and map an archive from disk. A miss in
+  // |cacheStats()| that doesn't lead to an open means the sample was loose.
+  int archiveOpens() const { return archive_opens_; }
+  const ArchiveCache::Stats& cacheStats() const { return file_cache_.stats(); }
+
  private:
   // Searches for a file archive of voices.
   boost::shared_ptr<VoiceArchive> findArchive(int file_no) const;
@@ -56,7 +69,9 @@ class VoiceCache {
   SoundSystem& sound_system_;
 
   // A mapping between a file id number and the underlying file object.
-  LRUCache<int, boost::shared_ptr<VoiceArchive> > file_cache_;
+  ArchiveCache file_cache_;
+
+  int archive_opens_;
 };  // class VoiceCache
 
 #endif  // SRC_SYSTEMS_BASE_VOICECACHE_HPP_
@@ -28,11 +28,14 @@
 #include "Systems/SDL/SDLEventSystem.hpp"
 
 #include <functional>
+#include <iostream>
 #include <SDL/SDL.h>
 
+#include "MachineBase/OpcodeProfiler.hpp"
 #include "MachineBase/RLMachine.hpp"
 #include "Systems/Base/EventListener.hpp"
 #include "Systems/Base/GraphicsSystem.hpp"
+#include "Systems/Base/MemoryReport.hpp"
 #include "Systems/SDL/SDLSystem.hpp"
 
 #include "log.h"
@@ -225,6 +228,17 @@ void SDLEventSystem::handleKeyUp(RLMachine& machine, SDL_Event& event) {
     machine.system().showSystemInfo(machine);
     break;
   }
+  case SDLK_F10: {
+    MemoryReport report;
+    machine.system().reportMemoryUsage(machine, report);
+    std::cerr << report;
+    break;
+  }
+  case SDLK_F11: {
+    if (machine.opcodeProfiler())
+      std::cerr << *machine.opcodeProfiler();
+    break;
+  }
   case SDLK_F12: {
     machine.system().dumpRenderTree(machine);
     break;
@@ -0,0 +1,177 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2013 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+// -----------------------------------------------------------------------
+
+#include "Systems/SDL/SDLGlyphCache.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+#include "Systems/Base/Colour.hpp"
+#include "Systems/SDL/SDLSurface.hpp"
+#include "Systems/SDL/SDLUtils.hpp"
+
+using std::cerr;
+using std::endl;
+
+namespace {
+
+// Atlases are at most this many pixels on a side. For the 25 point font most
+// games use, that holds a little under 900 glyphs in 4MB.
+const int MAX_ATLAS_DIMENSION = 1024;
+
+int packColour(const RGBColour& colour) {
+  return (colour.r() << 16) | (colour.g() << 8) | colour.b();
+}
+
+}  // namespace
+
+// -----------------------------------------------------------------------
+// SDLGlyphCache::Atlas
+// -----------------------------------------------------------------------
+Point SDLGlyphCache::Atlas::cellOrigin(int cell) const {
+  return Point((cell % columns) * cell_size.width(),
+               (cell / columns) * cell_size.height());
+}
+
+// -----------------------------------------------------------------------
+// SDLGlyphCache
+// -----------------------------------------------------------------------
+SDLGlyphCache::SDLGlyphCache() {
+}
+
+SDLGlyphCache::~SDLGlyphCache() {
+}
+
+Size SDLGlyphCache::drawGlyph(TTF_Font* font, int font_size,
+                              const std::string& text,
+                              const RGBColour& colour,
+                              SDLSurface& destination,
+                              const Point& insertion) {
+  Key key(text, font_size, packColour(colour));
+  Atlas& atlas = atlasFor(font, font_size);
+
+  EntryMap::iterator it = entries_.find(key);
+  if (it != entries_.end()) {
+    stats_.hits++;
+    Entry& entry = it->second;
+    atlas.lru.splice(atlas.lru.begin(), atlas.lru, entry.lru);
+    destination.blitFROMSurface(
+        atlas.surface.get(),
+        Rect(atlas.cellOrigin(entry.cell), entry.size),
+        Rect(insertion, entry.size), 255);
+    return entry.size;
+  }
+
+  stats_.misses++;
+  SDL_Color sdl_colour;
+  RGBColourToSDLColor(colour, &sdl_colour);
+  boost::shared_ptr<SDL_Surface> glyph(
+      TTF_RenderUTF8_Blended(font, text.c_str(), sdl_colour),
+      SDL_FreeSurface);
+  if (glyph == NULL) {
+    // Bug during Kyou's path. The string is printed "". Regression in parser?
+    cerr << "WARNING. TTF_RenderUTF8_Blended didn't render the character \""
+         << text << "\". Hopefully continuing..." << endl;
+    return Size(0, 0);
+  }
+
+  Size size(glyph->w, glyph->h);
+  if (size.width() > atlas.cell_size.width() ||
+      size.height() > atlas.cell_size.height()) {
+    stats_.uncacheable++;
+    destination.blitFROMSurface(glyph.get(), Rect(Point(0, 0), size),
+                                Rect(insertion, size), 255);
+    return size;
+  }
+
+  // Copy the glyph into its cell verbatim, alpha channel included, instead of
+  // blending it over whatever the previous occupant left there.
+  int cell = allocateCell(atlas);
+  Point origin = atlas.cellOrigin(cell);
+  SDL_SetAlpha(glyph.get(), 0, SDL_ALPHA_OPAQUE);
+  SDL_Rect src_rect = { 0, 0, Uint16(size.width()), Uint16(size.height()) };
+  SDL_Rect dest_rect = { Sint16(origin.x()), Sint16(origin.y()), 0, 0 };
+  if (SDL_BlitSurface(glyph.get(), &src_rect, atlas.surface.get(), &dest_rect))
+    reportSDLError("SDL_BlitSurface", "SDLGlyphCache::drawGlyph()");
+
+  atlas.lru.push_front(key);
+  Entry entry;
+  entry.cell = cell;
+  entry.size = size;
+  entry.lru = atlas.lru.begin();
+  entries_.insert(std::make_pair(key, entry));
+
+  destination.blitFROMSurface(atlas.surface.get(), Rect(origin, size),
+                              Rect(insertion, size), 255);
+  return size;
+}
+
+void SDLGlyphCache::clear() {
+  entries_.clear();
+  atlases_.clear();
+}
+
+SDLGlyphCache::Atlas& SDLGlyphCache::atlasFor(TTF_Font* font, int font_size) {
+  AtlasMap::iterator it = atlases_.find(font_size);
+  if (it != atlases_.end())
+    return it->second;
+
+  // Full width characters render about |font_size| wide; leave room for
+  // italics and wide punctuation. Anything wider skips the cache.
+  Size cell_size(font_size + font_size / 2 + 2,
+                 std::max(TTF_FontHeight(font), font_size) + 2);
+  int columns = std::max(1, MAX_ATLAS_DIMENSION / cell_size.width());
+  int rows = std::max(1, MAX_ATLAS_DIMENSION / cell_size.height());
+
+  Atlas& atlas = atlases_[font_size];
+  atlas.cell_size = cell_size;
+  atlas.columns = columns;
+  atlas.surface.reset(
+      buildNewSurface(Size(columns * cell_size.width(),
+                           rows * cell_size.height())),
+      SDL_FreeSurface);
+
+  // Hand out cells from the top left first.
+  for (int cell = columns * rows - 1; cell >= 0; --cell)
+    atlas.free_cells.push_back(cell);
+
+  return atlas;
+}
+
+int SDLGlyphCache::allocateCell(Atlas& atlas) {
+  if (!atlas.free_cells.empty()) {
+    int cell = atlas.free_cells.back();
+    atlas.free_cells.pop_back();
+    return cell;
+  }
+
+  EntryMap::iterator victim = entries_.find(atlas.lru.back());
+  int cell = victim->second.cell;
+  atlas.lru.pop_back();
+  entries_.erase(victim);
+  stats_.evictions++;
+  return cell;
+}
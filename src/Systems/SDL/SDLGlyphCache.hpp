@@ -0,0 +1,133 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2013 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+// -----------------------------------------------------------------------
+
+#ifndef SRC_SYSTEMS_SDL_SDLGLYPHCACHE_HPP_
+#define SRC_SYSTEMS_SDL_SDLGLYPHCACHE_HPP_
+
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+#include <SDL/SDL_ttf.h>
+
+#include "Systems/Base/Rect.hpp"
+
+class RGBColour;
+class SDLSurface;
+
+// Cache of rendered glyphs for SDLTextSystem, so that drawing a character
+// we've drawn before is a blit instead of a trip through FreeType and an
+// SDL_Surface allocation.
+//
+// Each font size gets one atlas surface split into a grid of cells sized for
+// that font. A glyph is keyed on its UTF-8 text, font size and colour (so a
+// character and its shadow are two entries) and occupies one cell; when the
+// atlas is full, the least recently drawn glyph gives up its cell. Glyphs too
+// big for a cell are rendered every time, as before.
+class SDLGlyphCache {
+ public:
+  struct Stats {
+    Stats() : hits(0), misses(0), evictions(0), uncacheable(0) {}
+
+    unsigned long hits;
+    unsigned long misses;
+    unsigned long evictions;
+    unsigned long uncacheable;
+  };
+
+  SDLGlyphCache();
+  ~SDLGlyphCache();
+
+  // Draws |text| rendered with |font| in |colour| onto |destination| with its
+  // top left corner at |insertion|. Returns the size of the glyph, or an empty
+  // size if SDL_ttf couldn't render it.
+  Size drawGlyph(TTF_Font* font, int font_size, const std::string& text,
+                 const RGBColour& colour, SDLSurface& destination,
+                 const Point& insertion);
+
+  // Drops every cached glyph and atlas.
+  void clear();
+
+  const Stats& stats() const { return stats_; }
+
+ private:
+  struct Key {
+    Key(const std::string& in_text, int in_size, int in_colour)
+        : text(in_text), size(in_size), colour(in_colour) {}
+
+    bool operator<(const Key& rhs) const {
+      if (size != rhs.size)
+        return size < rhs.size;
+      if (colour != rhs.colour)
+        return colour < rhs.colour;
+      return text < rhs.text;
+    }
+
+    std::string text;
+    int size;
+    int colour;
+  };
+
+  typedef std::list<Key> LRUList;
+
+  struct Entry {
+    int cell;
+    Size size;
+    LRUList::iterator lru;
+  };
+
+  typedef std::map<Key, Entry> EntryMap;
+
+  // All the glyphs for one font size.
+  struct Atlas {
+    boost::shared_ptr<SDL_Surface> surface;
+    Size cell_size;
+    int columns;
+    std::vector<int> free_cells;
+
+    // Most recently drawn glyph first.
+    LRUList lru;
+
+    Point cellOrigin(int cell) const;
+  };
+
+  typedef std::map<int, Atlas> AtlasMap;
+
+  // Returns the atlas for |font_size|, building it on first use.
+  Atlas& atlasFor(TTF_Font* font, int font_size);
+
+  // Finds a cell for a new glyph, evicting the least recently used one if
+  // needed.
+  int allocateCell(Atlas& atlas);
+
+  EntryMap entries_;
+  AtlasMap atlases_;
+  Stats stats_;
+};  // class SDLGlyphCache
+
+#endif  // SRC_SYSTEMS_SDL_SDLGLYPHCACHE_HPP_
@@ -63,6 +63,7 @@
 #include "Systems/Base/Colour.hpp"
 #include "Systems/Base/EventSystem.hpp"
 #include "Systems/Base/GraphicsObject.hpp"
+#include "Systems/Base/MemoryReport.hpp"
 #include "Systems/Base/MouseCursor.hpp"
 #include "Systems/Base/Renderable.hpp"
 #include "Systems/Base/System.hpp"
@@ -79,9 +80,11 @@
 #endif
 #include "Systems/SDL/Texture.hpp"
 #include "Utilities/Exception.hpp"
+#include "Utilities/FrameTimings.hpp"
 #include "Utilities/Graphics.hpp"
 #include "Utilities/LazyArray.hpp"
 #include "Utilities/StringUtilities.hpp"
+#include "Utilities/WorkerPool.hpp"
 #include "libReallive/gameexe.h"
 #include "xclannad/file.h"
 
@@ -102,6 +105,9 @@ void SDLGraphicsSystem::setCursor(int cursor) {
 }
 
 void SDLGraphicsSystem::beginFrame() {
+  // Anything queued outside of a frame goes out before we move the origin.
+  Texture::ScreenBatch().flush();
+
   glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
   glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
   DebugShowGLErrors();
@@ -137,11 +143,17 @@ void SDLGraphicsSystem::markScreenAsDirty(GraphicsUpdateType type) {
 }
 
 void SDLGraphicsSystem::endFrame() {
+  // The final renderers (guichan) draw with raw GL, so the scene has to be
+  // on the screen before they run.
+  QuadBatch& batch = Texture::ScreenBatch();
+  batch.flush();
+
   FinalRenderers::iterator it = renderer_begin();
   FinalRenderers::iterator end = renderer_end();
   for (; it != end; ++it) {
     (*it)->render(NULL);
   }
+  batch.flush();
 
 #ifndef ANDROID
   if (screenUpdateMode() == SCREENUPDATEMODE_MANUAL) {
@@ -160,6 +172,13 @@ void SDLGraphicsSystem::endFrame() {
   }
 
   drawCursor();
+  batch.flush();
+
+  last_frame_batch_stats_ = batch.stats();
+  batch.resetStats();
+
+  last_frame_upload_stats_ = Texture::GetUploadStats();
+  Texture::ResetUploadStats();
 
   // Swap the buffers
 #ifndef ANDROID
@@ -179,63 +198,26 @@ void SDLGraphicsSystem::redrawLastFrame() {
   // DrawManual() mode.
   if (screen_contents_texture_valid_) {
     // Redraw the screen
-    glBindTexture(GL_TEXTURE_2D, screen_contents_texture_);
-#if 0
-    glBegin(GL_QUADS); {
-      int dx1 = 0;
-      int dx2 = screenSize().width();
-      int dy1 = 0;
-      int dy2 = screenSize().height();
-
-      float x_cord = dx2 / float(screen_tex_width_);
-      float y_cord = dy2 / float(screen_tex_height_);
-
-      glColor4ub(255, 255, 255, 255);
-      glTexCoord2f(0, y_cord);
-      glVertex2i(dx1, dy1);
-      glTexCoord2f(x_cord, y_cord);
-      glVertex2i(dx2, dy1);
-      glTexCoord2f(x_cord, 0);
-      glVertex2i(dx2, dy2);
-      glTexCoord2f(0, 0);
-      glVertex2i(dx1, dy2);
-    }
-    glEnd();
-#else
-      int dx1 = 0;
-      int dx2 = screenSize().width();
-      int dy1 = 0;
-      int dy2 = screenSize().height();
-
-      float x_cord = dx2 / float(screen_tex_width_);
-      float y_cord = dy2 / float(screen_tex_height_);
-
-      glColor4ub(255, 255, 255, 255);
-    GLfloat vtx1[] = {
-      dx1, dy1, 0,
-      dx2, dy1, 0,
-      dx2, dy2, 0,
-      dx1, dy2, 0
-    };
-    GLfloat tex1[] = {
-      0,y_cord,
-      x_cord,y_cord,
-      x_cord,0,
-      0,0
+    int dx1 = 0;
+    int dx2 = screenSize().width();
+    int dy1 = 0;
+    int dy2 = screenSize().height();
+
+    float x_cord = dx2 / float(screen_tex_width_);
+    float y_cord = dy2 / float(screen_tex_height_);
+
+    // The copy of the back buffer is upside down.
+    QuadBatch::Vertex quad[4] = {
+      { float(dx1), float(dy1), 0, y_cord, 255, 255, 255, 255 },
+      { float(dx2), float(dy1), x_cord, y_cord, 255, 255, 255, 255 },
+      { float(dx2), float(dy2), x_cord, 0, 255, 255, 255, 255 },
+      { float(dx1), float(dy2), 0, 0, 255, 255, 255, 255 }
     };
-
-    glEnableClientState(GL_VERTEX_ARRAY);
-    glEnableClientState(GL_TEXTURE_COORD_ARRAY);
-
-    glVertexPointer(3, GL_FLOAT, 0, vtx1);
-    glTexCoordPointer(2, GL_FLOAT, 0, tex1);
-    glDrawArrays(GL_TRIANGLE_FAN,0,4);
-
-    glDisableClientState(GL_VERTEX_ARRAY);
-    glDisableClientState(GL_TEXTURE_COORD_ARRAY);
-#endif
+    QuadBatch& batch = Texture::ScreenBatch();
+    batch.addQuad(screen_contents_texture_, QuadBatch::BLEND_REPLACE, quad);
 
     drawCursor();
+    batch.flush();
 
 #ifndef ANDROID
     glFlush();
@@ -486,6 +468,11 @@ void SDLGraphicsSystem::Observe(NotificationType type,
 #ifndef ANDROID
   Shaders::Reset();
 #endif
+  Texture::ResetUploadBuffers();
+
+  // The context is going away. Surfaces drop their textures on the same
+  // notification, and pages die once the last of them is gone.
+  texture_atlas_.clear();
 }
 
 void SDLGraphicsSystem::setWindowSubtitle(const std::string& cp932str,
@@ -633,15 +620,26 @@ static SDLSurface::GrpRect xclannadRegionToGrpRect(
   return rect;
 }
 
-boost::shared_ptr<const Surface> SDLGraphicsSystem::loadSurfaceFromFile(
-    const std::string& short_filename) {
-  boost::filesystem::path filename =
-      system().findFile(short_filename, IMAGE_FILETYPES);
-  if (filename.empty()) {
-    ostringstream oss;
-    oss << "Could not find image file \"" << short_filename << "\".";
-    throw rlvm::Exception(oss.str());
-  }
+struct SDLGraphicsSystem::DecodedImage {
+  DecodedImage() : width(0), height(0), mask(NO_MASK), read(false) {}
+
+  int width;
+  int height;
+
+  // RGBA data in the raw G00 byte order; see the Default*mask defines.
+  std::vector<char> pixels;
+  MaskType mask;
+
+  // Whether the converter managed to read the pixel data at all.
+  bool read;
+
+  vector<SDLSurface::GrpRect> region_table;
+};
+
+// static
+void SDLGraphicsSystem::decodeImageFile(const boost::filesystem::path& filename,
+                                        DecodedImage* image) {
+  ScopedTimer timer("decodeImage");
 
   // Glue code to allow my stuff to work with Jagarl's loader
   FILE* file = fopen(filename.string().c_str(), "rb");
@@ -662,10 +660,13 @@ boost::shared_ptr<const Surface> SDLGraphicsSystem::loadSurfaceFromFile(
   if (conv == 0) {
     throw SystemError("Failure in GRPCONV.");
   }
-  // do not free until SDL_FreeSurface() is called on the surface using it
-  char* mem = (char*)malloc(conv->Width() * conv->Height() * 4 + 1024);
-  SDL_Surface* s = 0;
-  if (conv->Read(mem)) {
+
+  image->width = conv->Width();
+  image->height = conv->Height();
+  image->pixels.resize(conv->Width() * conv->Height() * 4 + 1024);
+  char* mem = &image->pixels[0];
+  image->read = conv->Read(mem);
+  if (image->read) {
     MaskType is_mask = conv->IsMask() ? ALPHA_MASK : NO_MASK;
     if (is_mask == ALPHA_MASK) {
       int len = conv->Width()*conv->Height();
@@ -679,28 +680,36 @@ boost::shared_ptr<const Surface> SDLGraphicsSystem::loadSurfaceFromFile(
         is_mask = NO_MASK;
       }
     }
-
-    s = newSurfaceFromRGBAData(conv->Width(), conv->Height(), mem, is_mask);
+    image->mask = is_mask;
   }
-  free(mem);
 
   // Grab the Type-2 information out of the converter or create one
   // default region if none exist
-  vector<SDLSurface::GrpRect> region_table;
   if (conv->region_table.size()) {
     transform(conv->region_table.begin(), conv->region_table.end(),
-              back_inserter(region_table),
+              back_inserter(image->region_table),
               xclannadRegionToGrpRect);
   } else {
     SDLSurface::GrpRect rect;
     rect.rect = Rect(Point(0, 0), Size(conv->Width(), conv->Height()));
     rect.originX = 0;
     rect.originY = 0;
-    region_table.push_back(rect);
+    image->region_table.push_back(rect);
+  }
+}
+
+boost::shared_ptr<const Surface> SDLGraphicsSystem::surfaceFromDecodedImage(
+    const std::string& short_filename, DecodedImage* image) {
+  SDL_Surface* s = 0;
+  if (image->read) {
+    s = newSurfaceFromRGBAData(image->width, image->height, &image->pixels[0],
+                               image->mask);
   }
+  // The surface holds a converted copy, so the raw data can go now.
+  std::vector<char>().swap(image->pixels);
 
   boost::shared_ptr<Surface> surface_to_ret(
-      new SDLSurface(this, s, region_table));
+      new SDLSurface(this, s, image->region_table));
   // handle tone curve effect loading
   if(short_filename.find("?") != short_filename.npos) {
     string effect_no_str = short_filename.substr(short_filename.find("?") + 1);
@@ -711,12 +720,72 @@ boost::shared_ptr<const Surface> SDLGraphicsSystem::loadSurfaceFromFile(
       oss << "Tone curve index " << effect_no << " is invalid.";
       throw rlvm::Exception(oss.str());
     }
-    surface_to_ret.get()->toneCurve(globals().tone_curves.getEffect(effect_no / 10 - 1), Rect(Point(0, 0), Size(conv->Width(), conv->Height())));
+    surface_to_ret.get()->toneCurve(globals().tone_curves.getEffect(effect_no / 10 - 1), Rect(Point(0, 0), Size(image->width, image->height)));
   }
 
   return surface_to_ret;
 }
 
+boost::filesystem::path SDLGraphicsSystem::findImageFile(
+    const std::string& short_filename) {
+  boost::filesystem::path filename =
+      system().findFile(short_filename, IMAGE_FILETYPES);
+  if (filename.empty()) {
+    ostringstream oss;
+    oss << "Could not find image file \"" << short_filename << "\".";
+    throw rlvm::Exception(oss.str());
+  }
+  return filename;
+}
+
+boost::shared_ptr<const Surface> SDLGraphicsSystem::loadSurfaceFromFile(
+    const std::string& short_filename) {
+  DecodedImage image;
+  decodeImageFile(findImageFile(short_filename), &image);
+  return surfaceFromDecodedImage(short_filename, &image);
+}
+
+std::vector<boost::shared_ptr<const Surface> >
+SDLGraphicsSystem::loadSurfacesFromFiles(
+    const std::vector<std::string>& short_filenames) {
+  // Path lookup and surface construction both touch shared state (the file
+  // index and the NotificationService), so only the reading and decoding of
+  // each file is spread over the worker pool.
+  int count = short_filenames.size();
+  vector<boost::filesystem::path> paths(count);
+  for (int i = 0; i < count; ++i) {
+    try {
+      paths[i] = findImageFile(short_filenames[i]);
+    } catch (std::exception&) {
+    }
+  }
+
+  vector<DecodedImage> images(count);
+  vector<char> decoded(count, false);
+  WorkerPool::Shared().parallelFor(count, [&](int i) {
+    if (paths[i].empty())
+      return;
+    try {
+      decodeImageFile(paths[i], &images[i]);
+      decoded[i] = true;
+    } catch (std::exception&) {
+    }
+  });
+
+  vector<boost::shared_ptr<const Surface> > surfaces(count);
+  for (int i = 0; i < count; ++i) {
+    if (!decoded[i])
+      continue;
+    try {
+      surfaces[i] = surfaceFromDecodedImage(short_filenames[i], &images[i]);
+    } catch (std::exception&) {
+    }
+  }
+  return surfaces;
+}
+
+// -----------------------------------------------------------------------
+
 boost::shared_ptr<Surface> SDLGraphicsSystem::getHaikei() {
   if (haikei_->rawSurface() == NULL) {
     haikei_->allocate(screenSize(), true);
@@ -749,3 +818,11 @@ void SDLGraphicsSystem::reset() {
 
   GraphicsSystem::reset();
 }
+
+// -----------------------------------------------------------------------
+
+void SDLGraphicsSystem::reportMemoryUsage(MemoryReport& report) {
+  report.add("Surfaces", SDLSurface::liveSurfaceBytes(),
+             SDLSurface::liveSurfaceCount());
+  GraphicsSystem::reportMemoryUsage(report);
+}
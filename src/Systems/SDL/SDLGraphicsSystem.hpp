@@ -30,11 +30,15 @@
 
 #include <set>
 #include <string>
+#include <vector>
 
 #include <boost/shared_ptr.hpp>
 #include "base/notification_observer.h"
 #include "base/notification_registrar.h"
 #include "Systems/Base/GraphicsSystem.hpp"
+#include "Systems/Base/QuadBatch.hpp"
+#include "Systems/SDL/Texture.hpp"
+#include "Systems/SDL/TextureAtlas.hpp"
 
 #ifndef ANDROID
 #include <SDL/SDL_opengl.h>
@@ -82,6 +86,20 @@ class SDLGraphicsSystem : public GraphicsSystem,
   void redrawLastFrame();
   void drawCursor();
 
+  // Draw calls, texture binds and quads submitted during the last complete
+  // frame.
+  const QuadBatch::Stats& lastFrameBatchStats() const {
+    return last_frame_batch_stats_;
+  }
+
+  // Texture reuploads done during the last complete frame.
+  const Texture::UploadStats& lastFrameUploadStats() const {
+    return last_frame_upload_stats_;
+  }
+
+  // Where SDLSurfaces put their textures when they're small enough.
+  TextureAtlas& textureAtlas() { return texture_atlas_; }
+
   virtual boost::shared_ptr<Surface> endFrameToSurface();
 
   virtual void executeGraphicsSystem(RLMachine& machine);
@@ -92,6 +110,8 @@ class SDLGraphicsSystem : public GraphicsSystem,
 
   virtual boost::shared_ptr<const Surface> loadSurfaceFromFile(
       const std::string& short_filename);
+  virtual std::vector<boost::shared_ptr<const Surface> > loadSurfacesFromFiles(
+      const std::vector<std::string>& short_filenames);
 
   virtual boost::shared_ptr<Surface> getHaikei();
   virtual boost::shared_ptr<Surface> getDC(int dc);
@@ -110,7 +130,29 @@ class SDLGraphicsSystem : public GraphicsSystem,
   // game.
   virtual void reset();
 
+  virtual void reportMemoryUsage(MemoryReport& report);
+
  private:
+  // Pixel data and region table read out of an image file. Decoding into one
+  // of these touches nothing but the file, so it's safe off the main thread.
+  struct DecodedImage;
+
+  // Reads and decodes |filename|.
+  //
+  // @exception Error Throws when the file can't be opened or decoded.
+  static void decodeImageFile(const boost::filesystem::path& filename,
+                              DecodedImage* image);
+
+  // Turns a decoded image into a surface, applying the tone curve named in
+  // |short_filename|, if any. Must run on the main thread.
+  boost::shared_ptr<const Surface> surfaceFromDecodedImage(
+      const std::string& short_filename, DecodedImage* image);
+
+  // Resolves |short_filename| to a path on disk.
+  //
+  // @exception Error Throws when no image by that name exists.
+  boost::filesystem::path findImageFile(const std::string& short_filename);
+
   void setupVideo();
 
   // Makes sure that a passed in dc number is valid.
@@ -175,6 +217,11 @@ class SDLGraphicsSystem : public GraphicsSystem,
   int screen_tex_width_;
   int screen_tex_height_;
 
+  QuadBatch::Stats last_frame_batch_stats_;
+  Texture::UploadStats last_frame_upload_stats_;
+
+  TextureAtlas texture_atlas_;
+
   NotificationRegistrar registrar_;
 };
 
@@ -30,6 +30,9 @@
 #include <SDL/SDL_mixer.h>
 #include <boost/algorithm/string.hpp>
 #include <boost/filesystem/operations.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <algorithm>
+#include <cstring>
 #include <functional>
 #include <iostream>
 #include <map>
@@ -37,6 +40,7 @@
 #include <string>
 #include <vector>
 
+#include "Systems/Base/AudioResampler.hpp"
 #include "Systems/Base/System.hpp"
 #include "Systems/SDL/SDLAudioLocker.hpp"
 #include "Utilities/Exception.hpp"
@@ -50,9 +54,130 @@ const int STOP_NOW = -2;
 
 const int DEFAULT_FADE_MS = 10;
 
+namespace {
+
+// Source frames pulled from the decoder per refill.
+const int RESAMPLE_CHUNK_FRAMES = 4096;
+
+// Presents any decoder as signed 16-bit stereo at the mixer's rate, so that
+// WAVFILE::MakeConverter() only ever has to change the sample format. The
+// xclannad converter only downsamples, by linear interpolation, and passes
+// upsampled data through at the wrong rate.
+class ResamplingWAVFILE : public WAVFILE {
+ public:
+  explicit ResamplingWAVFILE(WAVFILE* original)
+      : original_(original),
+        in_channels_(original->wavinfo.Channels),
+        in_bytes_(original->wavinfo.DataBits / 8),
+        resampler_(original->wavinfo.SamplingRate, freq, 2),
+        read_pos_(0),
+        eof_(false) {
+    wavinfo.SamplingRate = freq;
+    wavinfo.Channels = 2;
+    wavinfo.DataBits = 16;
+  }
+
+  virtual ~ResamplingWAVFILE() {}
+
+  virtual int Read(char* buf, int blksize, int blklen) {
+    int wanted = blksize * blklen;
+    while (bufferedBytes() < wanted && refill()) {}
+
+    int copied = std::min(wanted, bufferedBytes()) / blksize * blksize;
+    if (copied == 0 && eof_)
+      return -1;
+
+    memcpy(buf, &output_[read_pos_], copied);
+    read_pos_ += copied / sizeof(int16_t);
+    return copied / blksize;
+  }
+
+  virtual void Seek(int count) {
+    original_->Seek(count);
+    resampler_.reset();
+    output_.clear();
+    read_pos_ = 0;
+    eof_ = false;
+  }
+
+  // Wraps |original| if it isn't already at the mixer's rate.
+  static WAVFILE* Wrap(WAVFILE* original) {
+    if (int(original->wavinfo.SamplingRate) == freq ||
+        original->wavinfo.Channels < 1 || original->wavinfo.Channels > 2 ||
+        (original->wavinfo.DataBits != 8 && original->wavinfo.DataBits != 16))
+      return original;
+    return new ResamplingWAVFILE(original);
+  }
+
+ private:
+  int bufferedBytes() const {
+    return (output_.size() - read_pos_) * sizeof(int16_t);
+  }
+
+  // Decodes and resamples another chunk of the source. Returns false once
+  // the source is exhausted and the resampler's tail has been drained.
+  bool refill() {
+    if (eof_)
+      return false;
+
+    // Compact what the mixer has already consumed.
+    output_.erase(output_.begin(), output_.begin() + read_pos_);
+    read_pos_ = 0;
+
+    int frame_bytes = in_channels_ * in_bytes_;
+    raw_.resize(RESAMPLE_CHUNK_FRAMES * frame_bytes);
+    int frames = original_->Read(&raw_[0], frame_bytes,
+                                 RESAMPLE_CHUNK_FRAMES);
+    if (frames <= 0) {
+      resampler_.flush(output_);
+      eof_ = true;
+      return true;
+    }
+
+    // Widen to 16-bit stereo. 8-bit data is signed, as in MakeConverter().
+    stereo_.resize(frames * 2);
+    for (int i = 0; i < frames; ++i) {
+      for (int c = 0; c < 2; ++c) {
+        int ch = std::min(c, in_channels_ - 1);
+        const char* sample = &raw_[(i * in_channels_ + ch) * in_bytes_];
+        int16_t value;
+        if (in_bytes_ == 1)
+          value = static_cast<int16_t>(static_cast<signed char>(*sample) << 8);
+        else
+          memcpy(&value, sample, sizeof(value));
+        stereo_[i * 2 + c] = value;
+      }
+    }
+
+    resampler_.process(&stereo_[0], frames, output_);
+    return true;
+  }
+
+  boost::scoped_ptr<WAVFILE> original_;
+  int in_channels_;
+  int in_bytes_;
+  AudioResampler resampler_;
+
+  std::vector<char> raw_;
+  std::vector<int16_t> stereo_;
+
+  // Resampled frames not yet handed to the mixer, starting at |read_pos_|.
+  std::vector<int16_t> output_;
+  size_t read_pos_;
+
+  bool eof_;
+};
+
+}  // namespace
+
 boost::shared_ptr<SDLMusic> SDLMusic::s_currently_playing;
+int SDLMusic::s_play_generation = 0;
+boost::shared_ptr<SDLMusic> SDLMusic::s_mixing;
+int SDLMusic::s_mixing_generation = 0;
 bool SDLMusic::s_bgm_enabled = true;
 int SDLMusic::s_computed_bgm_vol = 128;
+SPSCQueue<SDLMusic::MixerCommand, 64> SDLMusic::s_commands;
+SPSCQueue<SDLMusic::MixerEvent, 128> SDLMusic::s_events;
 
 // -----------------------------------------------------------------------
 // SDLMusic
@@ -61,8 +186,12 @@ int SDLMusic::s_computed_bgm_vol = 128;
 SDLMusic::SDLMusic(const SoundSystem::DSTrack& track, WAVFILE* wav)
     : file_(wav),
       track_(track),
+      looping_(false),
+      fading_(false),
+      paused_(false),
       fadetime_total_(0),
       fade_in_ms_(0),
+      loop_point_(STOP_AT_END),
       music_paused_(false) {
   // Advance the audio stream to the starting point
   if (track.from > 0)
@@ -70,21 +199,17 @@ SDLMusic::SDLMusic(const SoundSystem::DSTrack& track, WAVFILE* wav)
 }
 
 SDLMusic::~SDLMusic() {
-  SDLAudioLocker locker;
+  // The mixer hands back every reference it holds through |s_events|, so the
+  // last one is always dropped on the game thread and we don't need to lock.
   delete file_;
-
-  if (s_currently_playing.get() == this)
-    s_currently_playing.reset();
 }
 
 bool SDLMusic::isLooping() const {
-  SDLAudioLocker locker;
-  return loop_point_ != STOP_AT_END;
+  return looping_;
 }
 
 bool SDLMusic::isFading() const {
-  SDLAudioLocker locker;
-  return fadetime_total_ > 0;
+  return fading_;
 }
 
 void SDLMusic::play(bool loop) {
@@ -92,51 +217,62 @@ void SDLMusic::play(bool loop) {
 }
 
 void SDLMusic::stop() {
-  SDLAudioLocker locker;
   if (s_currently_playing.get() == this)
     s_currently_playing.reset();
+
+  MixerCommand command;
+  command.type = MixerCommand::STOP;
+  command.music = shared_from_this();
+  PostCommand(command);
 }
 
 void SDLMusic::fadeIn(bool loop, int fade_in_ms) {
-  SDLAudioLocker locker;
-
-  if (loop)
-    loop_point_ = track_.loop;
-  else
-    loop_point_ = STOP_AT_END;
-
-  fade_count_ = 0;
-  fade_in_ms_ = fade_in_ms;
+  looping_ = loop;
   s_currently_playing = shared_from_this();
+
+  MixerCommand command;
+  command.type = MixerCommand::PLAY;
+  command.music = s_currently_playing;
+  command.value = fade_in_ms;
+  command.loop_point = loop ? track_.loop : STOP_AT_END;
+  command.generation = ++s_play_generation;
+  PostCommand(command);
 }
 
 void SDLMusic::fadeOut(int fade_out_ms) {
-  SDLAudioLocker locker;
-  fade_count_ = 0;
-  if (fade_out_ms <= 0)
-    fade_out_ms = DEFAULT_FADE_MS;
-  fadetime_total_ = fade_out_ms;
+  fading_ = true;
+
+  MixerCommand command;
+  command.type = MixerCommand::FADE_OUT;
+  command.music = shared_from_this();
+  command.value = fade_out_ms <= 0 ? DEFAULT_FADE_MS : fade_out_ms;
+  PostCommand(command);
 }
 
 void SDLMusic::pause() {
-  SDLAudioLocker locker;
-  music_paused_ = true;
+  paused_ = true;
+
+  MixerCommand command;
+  command.type = MixerCommand::PAUSE;
+  command.music = shared_from_this();
+  PostCommand(command);
 }
 
 void SDLMusic::unpause() {
-  SDLAudioLocker locker;
-  music_paused_ = false;
+  paused_ = false;
+
+  MixerCommand command;
+  command.type = MixerCommand::UNPAUSE;
+  command.music = shared_from_this();
+  PostCommand(command);
 }
 
 std::string SDLMusic::name() const {
-  SDLAudioLocker locker;
   return track_.name;
 }
 
 int SDLMusic::bgmStatus() const {
-  SDLAudioLocker locker;
-
-  if (music_paused_)
+  if (paused_)
     return 0;
   else if (isFading())
     return 2;
@@ -144,13 +280,145 @@ int SDLMusic::bgmStatus() const {
     return 1;
 }
 
+// static
+boost::shared_ptr<SDLMusic> SDLMusic::CurrnetlyPlaying() {
+  ProcessMixerEvents();
+  return s_currently_playing;
+}
+
+// static
+bool SDLMusic::IsCurrentlyPlaying() {
+  ProcessMixerEvents();
+  return s_currently_playing.get();
+}
+
+// static
+void SDLMusic::SetBgmEnabled(const int in) {
+  MixerCommand command;
+  command.type = MixerCommand::SET_ENABLED;
+  command.value = in;
+  PostCommand(command);
+}
+
+// static
+void SDLMusic::SetComputedBgmVolume(const int in) {
+  MixerCommand command;
+  command.type = MixerCommand::SET_VOLUME;
+  command.value = in / 2;
+  PostCommand(command);
+}
+
+// static
+void SDLMusic::PostCommand(const MixerCommand& command) {
+  ProcessMixerEvents();
+
+  while (!s_commands.push(command)) {
+    // The mixer hasn't run in a while (the device may be paused or closed).
+    // It can't be in the callback while we hold the lock, so it's safe to
+    // stand in for it.
+    {
+      SDLAudioLocker locker;
+      ApplyCommands();
+    }
+    ProcessMixerEvents();
+  }
+}
+
+// static
+void SDLMusic::ProcessMixerEvents() {
+  MixerEvent event;
+  while (s_events.pop(&event)) {
+    if (event.finished && event.generation == s_play_generation &&
+        s_currently_playing == event.music) {
+      s_currently_playing.reset();
+    }
+  }
+}
+
+// static
+void SDLMusic::ApplyCommands() {
+  MixerCommand command;
+  while (s_events.freeSlots() >= 2 && s_commands.pop(&command)) {
+    ApplyCommand(command);
+
+    // Hand our reference back rather than dropping it here, where it could be
+    // the last one.
+    if (command.music) {
+      MixerEvent event;
+      event.music = command.music;
+      command.music.reset();
+      s_events.push(event);
+    }
+  }
+}
+
+// static
+void SDLMusic::ApplyCommand(const MixerCommand& command) {
+  SDLMusic* music = command.music.get();
+  switch (command.type) {
+    case MixerCommand::PLAY:
+      if (s_mixing != command.music)
+        RetireMixing(false);
+      s_mixing = command.music;
+      s_mixing_generation = command.generation;
+      music->loop_point_ = command.loop_point;
+      music->fade_count_ = 0;
+      music->fade_in_ms_ = command.value;
+      break;
+    case MixerCommand::STOP:
+      if (s_mixing == command.music)
+        RetireMixing(false);
+      break;
+    case MixerCommand::FADE_OUT:
+      music->fade_count_ = 0;
+      music->fadetime_total_ = command.value;
+      break;
+    case MixerCommand::PAUSE:
+      music->music_paused_ = true;
+      break;
+    case MixerCommand::UNPAUSE:
+      music->music_paused_ = false;
+      break;
+    case MixerCommand::SET_ENABLED:
+      s_bgm_enabled = command.value;
+      break;
+    case MixerCommand::SET_VOLUME:
+      s_computed_bgm_vol = command.value;
+      break;
+  }
+}
+
+// static
+bool SDLMusic::RetireMixing(bool finished) {
+  if (!s_mixing)
+    return true;
+  if (s_events.freeSlots() == 0)
+    return false;
+
+  MixerEvent event;
+  event.music = s_mixing;
+  event.finished = finished;
+  event.generation = s_mixing_generation;
+  s_mixing.reset();
+  s_events.push(event);
+  return true;
+}
+
 // static
 void SDLMusic::MixMusic(void *udata, Uint8 *stream, int len) {
   // Inside an SDL_LockAudio() section set up by SDL_Mixer! Don't lock here!
-  SDLMusic* music = s_currently_playing.get();
+  ApplyCommands();
+
+  // A track that ended while the event ring was full is still waiting to be
+  // handed back.
+  if (s_mixing && s_mixing->loop_point_ == STOP_NOW)
+    RetireMixing(true);
+
+  SDLMusic* music = s_mixing.get();
 
   int count;
-  if (!s_bgm_enabled || !music || music->music_paused_) {
+  if (!s_bgm_enabled || !music || music->music_paused_ ||
+      music->loop_point_ == STOP_NOW) {
     memset(stream, 0, len);
     return;
   }
@@ -159,8 +427,8 @@ void SDLMusic::MixMusic(void *udata, Uint8 *stream, int len) {
   if (count != len/4) {
     memset(stream+count*4, 0, len-count*4);
     if (music->loop_point_ == STOP_AT_END) {
+      // Handed back once we're done with |music| below.
       music->loop_point_ = STOP_NOW;
-      s_currently_playing.reset();
     } else {
       music->file_->Seek(music->loop_point_);
       music->file_->Read( (char*)(stream+count*4), 4, len/4-count);
@@ -181,8 +449,8 @@ void SDLMusic::MixMusic(void *udata, Uint8 *stream, int len) {
     int count_total = music->fadetime_total_*(WAVFILE::freq/1000);
     if (music->fade_count_ > count_total) {
       music->loop_point_ = STOP_NOW;
-      s_currently_playing.reset();
       memset(stream, 0, len);
+      RetireMixing(true);
       return;
     }
 
@@ -196,11 +464,15 @@ void SDLMusic::MixMusic(void *udata, Uint8 *stream, int len) {
     memset(stream, 0, len);
     SDL_MixAudio(stream, (Uint8*)stream_dup, len, cur_vol);
   }
+
+  if (music->loop_point_ == STOP_NOW)
+    RetireMixing(true);
 }
 
 template<typename TYPE>
 WAVFILE* buildMusicImplementation(FILE* file, int size) {
-  return WAVFILE::MakeConverter(new TYPE(file, size));
+  return WAVFILE::MakeConverter(
+      ResamplingWAVFILE::Wrap(new TYPE(file, size)));
 }
 
 boost::shared_ptr<SDLMusic> SDLMusic::CreateMusic(
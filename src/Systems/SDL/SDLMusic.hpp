@@ -31,6 +31,7 @@
 #include <string>
 
 #include "Systems/Base/SoundSystem.hpp"
+#include "Utilities/SPSCQueue.hpp"
 
 #include <boost/enable_shared_from_this.hpp>
 #include <boost/noncopyable.hpp>
@@ -56,6 +57,16 @@
 //
 // So instead of taking just jagarl's nwatowav.cc, I'm also stealing
 // wavfile.{cc,h}, and some binding code.
+//
+// Playback of a single BGM track through Mix_HookMusic().
+//
+// The game thread never touches the state MixMusic() reads. Every play, stop,
+// fade, pause and volume change is posted to the mixer through a lock-free
+// command ring and applied at the start of the next callback, and the mixer
+// hands back the references it is done with (and notices that a track ended)
+// through a second ring, so SDLMusic objects are always destroyed on the game
+// thread. The accessors below answer from the game thread's own copy of the
+// state, which is why none of them take the audio lock.
 class SDLMusic : public boost::noncopyable,
                  public boost::enable_shared_from_this<SDLMusic> {
  public:
@@ -87,22 +98,49 @@ class SDLMusic : public boost::noncopyable,
 
   // Returns the currently playing SDLMusic object. Returns NULL if no
   // music is currently playing.
-  static boost::shared_ptr<SDLMusic> CurrnetlyPlaying() {
-    return s_currently_playing;
-  }
+  static boost::shared_ptr<SDLMusic> CurrnetlyPlaying();
 
   // Whether music is currently playing.
-  static bool IsCurrentlyPlaying() { return s_currently_playing.get(); }
+  static bool IsCurrentlyPlaying();
 
   // Whether we should output music.
-  static void SetBgmEnabled(const int in) { s_bgm_enabled = in; }
+  static void SetBgmEnabled(const int in);
 
   // What volume we should play this at normally.
-  static void SetComputedBgmVolume(const int in) {
-    s_computed_bgm_vol = in / 2;
-  }
+  static void SetComputedBgmVolume(const int in);
 
  private:
+  // A request from the game thread to the mixer.
+  struct MixerCommand {
+    enum Type {
+      PLAY,
+      STOP,
+      FADE_OUT,
+      PAUSE,
+      UNPAUSE,
+      SET_ENABLED,
+      SET_VOLUME
+    };
+
+    MixerCommand() : type(STOP), value(0), loop_point(0), generation(0) {}
+
+    Type type;
+    boost::shared_ptr<SDLMusic> music;
+    int value;
+    int loop_point;
+    int generation;
+  };
+
+  // A reference the mixer is done with. If |finished| is set, the track that
+  // was started as play number |generation| has run out or faded away.
+  struct MixerEvent {
+    MixerEvent() : finished(false), generation(0) {}
+
+    boost::shared_ptr<SDLMusic> music;
+    bool finished;
+    int generation;
+  };
+
   // Builds an SDLMusic object.
   SDLMusic(const SoundSystem::DSTrack& track, WAVFILE* wav);
 
@@ -112,6 +150,23 @@ class SDLMusic : public boost::noncopyable,
   // the static method WavChunk::callback in music2/music.cc.
   static void MixMusic(void *udata, Uint8 *stream, int len);
 
+  // Game thread: queues |command| for the mixer. If the ring is full because
+  // the mixer isn't running, applies the commands itself under the audio lock.
+  static void PostCommand(const MixerCommand& command);
+
+  // Game thread: releases the references handed back by the mixer and forgets
+  // about tracks that have finished.
+  static void ProcessMixerEvents();
+
+  // Mixer: applies queued commands, as long as there's room to hand back
+  // whatever references they release.
+  static void ApplyCommands();
+  static void ApplyCommand(const MixerCommand& command);
+
+  // Mixer: stops mixing the current track and hands it back to the game
+  // thread. Returns false if there's no room in the event ring yet.
+  static bool RetireMixing(bool finished);
+
   // Strongly coupled because of access to SDLMusic::MixMusic.
   friend class SDLSoundSystem;
 
@@ -121,6 +176,13 @@ class SDLMusic : public boost::noncopyable,
   // The underlying track information
   const SoundSystem::DSTrack& track_;
 
+  // The game thread's view of this track, for the accessors.
+  bool looping_;
+  bool fading_;
+  bool paused_;
+
+  // Everything below is only touched by the mixer.
+
   // No idea.
   int fade_count_;
 
@@ -136,14 +198,30 @@ class SDLMusic : public boost::noncopyable,
   // Whether the music is currently paused.
   bool music_paused_;
 
-  // The currently playing track.
+  // The track the game thread last started, until the mixer reports that it
+  // finished or it's stopped.
   static boost::shared_ptr<SDLMusic> s_currently_playing;
 
-  // Whether we should even be playing music.
+  // Incremented on every play so a stale "finished" event for an earlier play
+  // of the same track is ignored.
+  static int s_play_generation;
+
+  // The track the mixer is playing and the play it belongs to. Mixer only.
+  static boost::shared_ptr<SDLMusic> s_mixing;
+  static int s_mixing_generation;
+
+  // Whether we should even be playing music. Mixer only.
   static bool s_bgm_enabled;
 
-  // The volume we should play music at as a [0,128] range.
+  // The volume we should play music at as a [0,128] range. Mixer only.
   static int s_computed_bgm_vol;
+
+  // Game thread -> mixer.
+  static SPSCQueue<MixerCommand, 64> s_commands;
+
+  // Mixer -> game thread. Each command releases at most two references, so
+  // this is twice the size of |s_commands|.
+  static SPSCQueue<MixerEvent, 128> s_events;
 };
 
 // -----------------------------------------------------------------------
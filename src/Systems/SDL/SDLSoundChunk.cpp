@@ -29,11 +29,73 @@
 
 #include <SDL/SDL_mixer.h>
 #include <boost/algorithm/string.hpp>
+#include <algorithm>
+#include <cstring>
+#include <vector>
 
+#include "Systems/Base/AudioResampler.hpp"
 #include "Systems/Base/SoundSystem.hpp"
+#include "Systems/Base/VoiceArchive.hpp"
 #include "Systems/SDL/SDLAudioLocker.hpp"
+#include "Utilities/File.hpp"
+#include "xclannad/endian.hpp"
 #include "xclannad/wavfile.h"
 
+namespace {
+
+// Reads the format out of the canonical 44 byte header that NWAFILE::ReadAll()
+// and the voice decoders write, and that most plain .wav files have. Returns
+// false for anything with extra chunks or a non-PCM format.
+bool parseCanonicalWavHeader(const char* data, int size, int* rate,
+                             int* channels, int* bits, int* data_len) {
+  if (size < WAV_HEADER_SIZE ||
+      memcmp(data, "RIFF", 4) != 0 ||
+      memcmp(data + 0x08, "WAVEfmt ", 8) != 0 ||
+      read_little_endian_int(data + 0x10) != 16 ||
+      read_little_endian_short(data + 0x14) != 1 ||
+      memcmp(data + 0x24, "data", 4) != 0)
+    return false;
+
+  *channels = read_little_endian_short(data + 0x16);
+  *rate = read_little_endian_int(data + 0x18);
+  *bits = read_little_endian_short(data + 0x22);
+  *data_len = std::min(read_little_endian_int(data + 0x28),
+                       size - WAV_HEADER_SIZE);
+  return *data_len >= 0;
+}
+
+// Loads a WAV image from memory, converting it to the mixer's sample rate with
+// our resampler first. SDL_mixer would otherwise do the rate conversion with
+// SDL_ConvertAudio(), which only handles power of two ratios and aliases
+// badly. Anything we don't understand is passed to SDL_mixer untouched.
+Mix_Chunk* loadResampledWav(const char* data, int size) {
+  int rate, channels, bits, data_len;
+  if (!parseCanonicalWavHeader(data, size, &rate, &channels, &bits,
+                               &data_len) ||
+      bits != 16 || channels < 1 || channels > 2 || rate <= 0 ||
+      rate == WAVFILE::freq) {
+    return Mix_LoadWAV_RW(SDL_RWFromConstMem(data, size), 1);
+  }
+
+  std::vector<int16_t> samples;
+  AudioResampler::resampleBuffer(
+      reinterpret_cast<const int16_t*>(data + WAV_HEADER_SIZE),
+      data_len / (2 * channels), channels, rate, WAVFILE::freq, samples);
+
+  int out_len = samples.size() * sizeof(int16_t);
+  std::vector<char> wav(WAV_HEADER_SIZE + out_len);
+  memcpy(&wav[0], VoiceSample::MakeWavHeader(WAVFILE::freq, channels, 2,
+                                             wav.size()),
+         WAV_HEADER_SIZE);
+  if (out_len)
+    memcpy(&wav[WAV_HEADER_SIZE], &samples[0], out_len);
+
+  // Mix_LoadWAV_RW() copies the samples into the chunk.
+  return Mix_LoadWAV_RW(SDL_RWFromConstMem(&wav[0], wav.size()), 1);
+}
+
+}  // namespace
+
 SDLSoundChunk::PlayingTable SDLSoundChunk::s_playing_table;
 
 SDLSoundChunk::SDLSoundChunk(const boost::filesystem::path& path)
@@ -41,7 +103,7 @@ SDLSoundChunk::SDLSoundChunk(const boost::filesystem::path& path)
 }
 
 SDLSoundChunk::SDLSoundChunk(char* data, int length)
-    : sample_(Mix_LoadWAV_RW(SDL_RWFromMem(data, length+0x2c), 1)),
+    : sample_(loadResampledWav(data, length + WAV_HEADER_SIZE)),
       data_(data) {
 }
 
@@ -50,6 +112,10 @@ SDLSoundChunk::~SDLSoundChunk() {
   data_.reset();
 }
 
+size_t SDLSoundChunk::byteSize() const {
+  return sample_ ? sample_->alen : 0;
+}
+
 Mix_Chunk* SDLSoundChunk::loadSample(const boost::filesystem::path& path) {
   if (boost::iequals(path.extension().string(), ".nwa")) {
     // Hack to load NWA sounds into a MixChunk. I was resisted doing this
@@ -62,10 +128,17 @@ Mix_Chunk* SDLSoundChunk::loadSample(const boost::filesystem::path& path) {
     char* data = NWAFILE::ReadAll(f, size);
     fclose(f);
 
-    Mix_Chunk* chunk = Mix_LoadWAV_RW(SDL_RWFromMem(data, size), 1);
+    Mix_Chunk* chunk = loadResampledWav(data, size);
     delete [] data;
 
     return chunk;
+  } else if (boost::iequals(path.extension().string(), ".wav")) {
+    boost::scoped_array<char> data;
+    int size = 0;
+    if (!loadFileData(path, data, size))
+      return NULL;
+
+    return loadResampledWav(data.get(), size);
   } else {
     return Mix_LoadWAV(path.native().c_str());
   }
@@ -51,6 +51,9 @@ class SDLSoundChunk : public boost::enable_shared_from_this<SDLSoundChunk> {
 
   ~SDLSoundChunk();
 
+  // The size of the decoded samples, for SDLSoundSystem's cache accounting.
+  size_t byteSize() const;
+
   // Plays the chunk on the given channel. Wraps Mix_PlayChannel. Pass -1 to
   // |loops| for infinite loops.
   //
@@ -34,16 +34,31 @@
 #include <sstream>
 #include <string>
 
+#include "Systems/Base/MemoryReport.hpp"
 #include "Systems/Base/System.hpp"
 #include "Systems/Base/SystemError.hpp"
 #include "Systems/Base/VoiceArchive.hpp"
 #include "Systems/SDL/SDLMusic.hpp"
 #include "Systems/SDL/SDLSoundChunk.hpp"
 #include "Utilities/Exception.hpp"
+#include "libReallive/gameexe.h"
 
 using namespace std;
 namespace fs = boost::filesystem;
 
+// Default ceiling on decoded sound effects and wavPlay() files. Override with
+// --sound-cache-mb.
+const int DEFAULT_SOUND_CACHE_MB = 32;
+
+// Reads __SOUND_CACHE_MB as a byte count. Multiplies in size_t so large
+// settings don't overflow, and treats a negative setting as the default.
+static size_t soundCacheBytes(Gameexe& gameexe) {
+  int megabytes = gameexe("__SOUND_CACHE_MB").to_int(DEFAULT_SOUND_CACHE_MB);
+  if (megabytes < 0)
+    megabytes = DEFAULT_SOUND_CACHE_MB;
+  return static_cast<size_t>(megabytes) * 1024 * 1024;
+}
+
 // -----------------------------------------------------------------------
 // RealLive Sound Qualities table
 // -----------------------------------------------------------------------
@@ -69,8 +84,8 @@ static RealLiveSoundQualities s_real_live_sound_qualities[] = {
 // SDLSoundSystem (private)
 // -----------------------------------------------------------------------
 SDLSoundSystem::SDLSoundChunkPtr SDLSoundSystem::getSoundChunk(
-    const std::string& file_name, SoundChunkCache& cache) {
-  SDLSoundChunkPtr sample = cache.fetch(file_name);
+    const std::string& file_name) {
+  SDLSoundChunkPtr sample = chunk_cache_.fetch(file_name);
   if (sample == NULL) {
     fs::path file_path = system_.findFile(file_name, SOUND_FILETYPES);
     if (file_path.empty()) {
@@ -80,12 +95,44 @@ SDLSoundSystem::SDLSoundChunkPtr SDLSoundSystem::getSoundChunk(
     }
 
     sample.reset(new SDLSoundChunk(file_path));
-    cache.insert(file_name, sample);
+    chunk_cache_.insert(file_name, sample, sample->byteSize());
   }
 
   return sample;
 }
 
+void SDLSoundSystem::preloadSoundEffects() {
+  for (SeTable::const_iterator it = seTable().begin();
+       it != seTable().end(); ++it) {
+    if (chunk_cache_.current_bytes() >= chunk_cache_.max_bytes())
+      break;
+    size_t free_bytes = chunk_cache_.max_bytes() - chunk_cache_.current_bytes();
+
+    const string& file_name = it->second.first;
+    if (file_name == "" || chunk_cache_.exists(file_name))
+      continue;
+
+    fs::path file_path = system_.findFile(file_name, SOUND_FILETYPES);
+    if (file_path.empty())
+      continue;
+
+    // A decoded sample is at least about as big as its file (compressed
+    // formats only grow, and a WAV just loses its header), so skip files that
+    // can't fit without paying to decode them. A smaller effect later in the
+    // table may still fit.
+    boost::system::error_code ec;
+    uintmax_t file_size = fs::file_size(file_path, ec);
+    if (ec || file_size > free_bytes)
+      continue;
+
+    SDLSoundChunkPtr sample(new SDLSoundChunk(file_path));
+    if (sample->byteSize() > free_bytes)
+      continue;
+
+    chunk_cache_.insert(file_name, sample, sample->byteSize());
+  }
+}
+
 SDLSoundSystem::SDLSoundChunkPtr SDLSoundSystem::buildKoeChunk(
     char* data, int length) {
   return SDLSoundChunkPtr(new SDLSoundChunk(data, length));
@@ -94,7 +141,7 @@ SDLSoundSystem::SDLSoundChunkPtr SDLSoundSystem::buildKoeChunk(
 void SDLSoundSystem::wavPlayImpl(const std::string& wav_file,
                                  const int channel, bool loop) {
   if (pcmEnabled()) {
-    SDLSoundChunkPtr sample = getSoundChunk(wav_file, wav_cache_);
+    SDLSoundChunkPtr sample = getSoundChunk(wav_file);
     setChannelVolumeImpl(channel);
     int loop_num = loop ? -1 : 0;
     sample->playChunkOn(channel, loop_num);
@@ -132,7 +179,8 @@ boost::shared_ptr<SDLMusic> SDLSoundSystem::LoadMusic(
 // SDLSoundSystem
 // -----------------------------------------------------------------------
 SDLSoundSystem::SDLSoundSystem(System& system)
-  : SoundSystem(system), se_cache_(5), wav_cache_(5) {
+  : SoundSystem(system),
+    chunk_cache_(soundCacheBytes(system.gameexe())) {
   SDL_InitSubSystem(SDL_INIT_AUDIO);
 
   /* We're going to be requesting certain things from our audio
@@ -164,6 +212,9 @@ SDLSoundSystem::SDLSoundSystem(System& system)
   Mix_ChannelFinished(&SDLSoundChunk::SoundChunkFinishedPlayback);
 
   setMusicHook(NULL);
+
+  // Needs WAVFILE::freq to be set so the chunks are resampled correctly.
+  preloadSoundEffects();
 }
 
 SDLSoundSystem::~SDLSoundSystem() {
@@ -229,7 +280,7 @@ void SDLSoundSystem::wavPlay(const std::string& wav_file, bool loop,
   checkChannel(channel, "SDLSoundSystem::wav_play");
 
   if (pcmEnabled()) {
-    SDLSoundChunkPtr sample = getSoundChunk(wav_file, wav_cache_);
+    SDLSoundChunkPtr sample = getSoundChunk(wav_file);
     setChannelVolumeImpl(channel);
 
     int loop_num = loop ? -1 : 0;
@@ -283,7 +334,7 @@ void SDLSoundSystem::playSe(const int se_num) {
       return;
     }
 
-    SDLSoundChunkPtr sample = getSoundChunk(file_name, wav_cache_);
+    SDLSoundChunkPtr sample = getSoundChunk(file_name);
 
     // SE chunks have no volume other than the modifier.
     Mix_Volume(channel, realLiveVolumeToSDLMixerVolume(seVolumeMod()));
@@ -408,6 +459,12 @@ void SDLSoundSystem::reset() {
   SoundSystem::reset();
 }
 
+void SDLSoundSystem::reportMemoryUsage(MemoryReport& report) {
+  SoundSystem::reportMemoryUsage(report);
+  report.add("Sound chunk cache", chunk_cache_.current_bytes(),
+             chunk_cache_.size());
+}
+
 void SDLSoundSystem::setMusicHook(
   void (*mix_func)(void *udata, Uint8 *stream, int len)) {
   if (!mix_func)
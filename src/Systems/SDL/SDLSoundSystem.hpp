@@ -29,7 +29,7 @@
 #define SRC_SYSTEMS_SDL_SDLSOUNDSYSTEM_HPP_
 
 #include "Systems/Base/SoundSystem.hpp"
-#include "lru_cache.hpp"
+#include "Utilities/SizedLRUCache.hpp"
 
 #include <string>
 #include <boost/shared_ptr.hpp>
@@ -41,6 +41,9 @@ class SDLMusic;
 
 class SDLSoundSystem : public SoundSystem {
  public:
+  typedef boost::shared_ptr<SDLSoundChunk> SDLSoundChunkPtr;
+  typedef SizedLRUCache<std::string, SDLSoundChunkPtr> SoundChunkCache;
+
   explicit SDLSoundSystem(System& system);
   ~SDLSoundSystem();
 
@@ -82,22 +85,31 @@ class SDLSoundSystem : public SoundSystem {
 
   virtual void reset();
 
+  virtual void reportMemoryUsage(MemoryReport& report);
+
   // Wrapper around SDL_mixer's hook function. We do this because we need to
   // have our own default music mixing function which is set at startup.
   void setMusicHook(void (*mix_func)(void *udata, Uint8 *stream, int len));
 
+  // Changes how many bytes of decoded samples we keep around.
+  void setChunkCacheBytes(size_t bytes) { chunk_cache_.set_max_bytes(bytes); }
+  size_t chunkCacheBytes() const { return chunk_cache_.current_bytes(); }
+  const SoundChunkCache::Stats& chunkCacheStats() const {
+    return chunk_cache_.stats();
+  }
+
  private:
-  typedef boost::shared_ptr<SDLSoundChunk> SDLSoundChunkPtr;
   typedef boost::shared_ptr<SDLMusic> SDLMusicPtr;
-  typedef LRUCache<std::string, SDLSoundChunkPtr> SoundChunkCache;
 
   virtual void koePlayImpl(int id);
 
-  // Retrieves a sound chunk from the passed in cache (or loads it if
-  // it's not in the cache and then stuffs it into the cache.)
-  SDLSoundChunkPtr getSoundChunk(
-    const std::string& file_name,
-    SoundChunkCache& cache);
+  // Retrieves a sound chunk from |chunk_cache_| (or loads it if it's not in
+  // the cache and then stuffs it into the cache.)
+  SDLSoundChunkPtr getSoundChunk(const std::string& file_name);
+
+  // Decodes the files in the \#SE table into |chunk_cache_| until it is full,
+  // so the first click on each menu item doesn't hit the disk.
+  void preloadSoundEffects();
 
   // Builds a SoundChunk from a piece of memory. This is used for playing
   // voice. These chunks are not put in a SoundChunkCache since there's no
@@ -120,8 +132,9 @@ class SDLSoundSystem : public SoundSystem {
   // found.
   boost::shared_ptr<SDLMusic> LoadMusic(const std::string& bgm_name);
 
-  SoundChunkCache se_cache_;
-  SoundChunkCache wav_cache_;
+  // Decoded sound effects and wavPlay() files, keyed on file name and bounded
+  // by the size of their samples.
+  SoundChunkCache chunk_cache_;
 
   // The music to play next as soon as the current track finishes.
   SDLMusicPtr queued_music_;
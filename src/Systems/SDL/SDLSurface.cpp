@@ -28,6 +28,7 @@
 #include "Systems/SDL/SDLSurface.hpp"
 
 #include <SDL/SDL.h>
+#include <atomic>
 #include <iostream>
 #include <sstream>
 #include <vector>
@@ -36,10 +37,13 @@
 #include "Systems/Base/Colour.hpp"
 #include "Systems/Base/GraphicsObject.hpp"
 #include "Systems/Base/GraphicsObjectData.hpp"
+#include "Systems/Base/PixelKernels.hpp"
 #include "Systems/Base/SystemError.hpp"
 #include "Systems/SDL/SDLGraphicsSystem.hpp"
 #include "Systems/SDL/SDLUtils.hpp"
 #include "Systems/SDL/Texture.hpp"
+#include "Systems/SDL/TextureAtlas.hpp"
+#include "Utilities/FrameTimings.hpp"
 #include "Utilities/Graphics.hpp"
 #include "pygame/alphablit.h"
 
@@ -48,11 +52,74 @@ using boost::ptr_vector;
 
 namespace {
 
-// An interface to TransformSurface that maps one color to another.
+// Every SDL_Surface currently owned by an SDLSurface, for memory reports.
+// Surfaces are built on the prefetch threads too, so these are atomic.
+std::atomic<size_t> g_live_surface_count(0);
+std::atomic<size_t> g_live_surface_bytes(0);
+
+void trackSurface(SDL_Surface* surface) {
+  g_live_surface_count++;
+  g_live_surface_bytes += surface->pitch * surface->h;
+}
+
+void untrackSurface(SDL_Surface* surface) {
+  g_live_surface_count--;
+  g_live_surface_bytes -= surface->pitch * surface->h;
+}
+
+// Whether the pixel kernels understand |surface|.
+bool IsKernelSurface(SDL_Surface* surface) {
+  return surface->format->BytesPerPixel == 4;
+}
+
+bool SameLayout(SDL_Surface* a, SDL_Surface* b) {
+  return a->format->Rmask == b->format->Rmask &&
+         a->format->Gmask == b->format->Gmask &&
+         a->format->Bmask == b->format->Bmask &&
+         a->format->Amask == b->format->Amask;
+}
+
+PixelLayout LayoutOf(SDL_Surface* surface) {
+  return PixelLayout(surface->format->Rshift, surface->format->Gshift,
+                     surface->format->Bshift, surface->format->Ashift);
+}
+
+// The pixels of |area|, which must be inside |surface|.
+PixelRect PixelsIn(SDL_Surface* surface, const Rect& area) {
+  return PixelRect(static_cast<char*>(surface->pixels) +
+                       surface->pitch * area.y() + 4 * area.x(),
+                   surface->pitch, area.width(), area.height());
+}
+
+// Clips a blit of |src| to |dst| to the bounds of both surfaces the way
+// SDL_BlitSurface() does. Returns false if nothing is left.
+bool ClipBlit(const Rect& src_bounds, const Rect& dst_bounds,
+              Rect& src, Rect& dst) {
+  Rect clipped = src.intersection(src_bounds);
+  if (clipped.width() <= 0 || clipped.height() <= 0)
+    return false;
+  dst = Rect(dst.origin() + (clipped.origin() - src.origin()),
+             clipped.size());
+  src = clipped;
+
+  clipped = dst.intersection(dst_bounds);
+  if (clipped.width() <= 0 || clipped.height() <= 0)
+    return false;
+  src = Rect(src.origin() + (clipped.origin() - dst.origin()),
+             clipped.size());
+  dst = clipped;
+  return true;
+}
+
+// An interface to TransformSurface that maps one color to another. 32-bit
+// surfaces go through apply(), which hands the whole area to a pixel kernel;
+// anything else is mapped one pixel at a time.
 class ColourTransformer {
  public:
   virtual ~ColourTransformer() {}
   virtual SDL_Color operator()(const SDL_Color& colour) const = 0;
+  virtual void apply(const PixelRect& pixels,
+                     const PixelLayout& layout) const = 0;
 };
 
 class ToneCurveColourTransformer : public ColourTransformer{
@@ -68,6 +135,11 @@ class ToneCurveColourTransformer : public ColourTransformer{
     return out;
   }
 
+  virtual void apply(const PixelRect& pixels,
+                     const PixelLayout& layout) const {
+    MapPixelChannels(pixels, layout, colormap[0], colormap[1], colormap[2]);
+  }
+
  private:
 	ToneCurveRGBMap colormap;
 };
@@ -83,6 +155,11 @@ class InvertColourTransformer : public ColourTransformer {
     };
     return out;
   }
+
+  virtual void apply(const PixelRect& pixels,
+                     const PixelLayout& layout) const {
+    InvertPixels(pixels, layout);
+  }
 };
 
 class MonoColourTransformer : public ColourTransformer {
@@ -98,11 +175,23 @@ class MonoColourTransformer : public ColourTransformer {
     };
     return out;
   }
+
+  virtual void apply(const PixelRect& pixels,
+                     const PixelLayout& layout) const {
+    MonoPixels(pixels, layout);
+  }
 };
 
 class ApplyColourTransformer : public ColourTransformer {
  public:
   explicit ApplyColourTransformer(const RGBColour& colour) : colour_(colour) {
+    // Each output channel only depends on the same input channel, so work
+    // out all 256 answers up front.
+    for (int i = 0; i < 256; ++i) {
+      maps_[0][i] = compose(colour_.r(), i);
+      maps_[1][i] = compose(colour_.g(), i);
+      maps_[2][i] = compose(colour_.b(), i);
+    }
   }
 
   int compose(int in_colour, int surface_colour) const {
@@ -128,14 +217,33 @@ class ApplyColourTransformer : public ColourTransformer {
     return out;
   }
 
+  virtual void apply(const PixelRect& pixels,
+                     const PixelLayout& layout) const {
+    MapPixelChannels(pixels, layout, maps_[0], maps_[1], maps_[2]);
+  }
+
  private:
   RGBColour colour_;
+  ChannelMap maps_[3];
 };
 
 // Applies a |transformer| to every pixel in |area| in the surface |surface|.
 void TransformSurface(SDLSurface* our_surface, const Rect& area,
                       const ColourTransformer& transformer) {
   SDL_Surface* surface = our_surface->rawSurface();
+  if (IsKernelSurface(surface)) {
+    Rect clipped = area.intersection(our_surface->rect());
+    if (clipped.width() <= 0 || clipped.height() <= 0)
+      return;
+
+    SDL_LockSurface(surface);
+    transformer.apply(PixelsIn(surface, clipped), LayoutOf(surface));
+    SDL_UnlockSurface(surface);
+
+    our_surface->markWrittenTo(clipped);
+    return;
+  }
+
   SDL_Color colour;
   Uint32 col = 0;
 
@@ -219,17 +327,31 @@ SDLSurface::TextureRecord::TextureRecord(
     x_(x), y_(y), w_(w), h_(h), bytes_per_pixel_(bytes_per_pixel),
     byte_order_(byte_order), byte_type_(byte_type) {}
 
+SDLSurface::TextureRecord::TextureRecord(
+  SDL_Surface* surface,
+  int x, int y, int w, int h, unsigned int bytes_per_pixel,
+  int byte_order, int byte_type,
+  const boost::shared_ptr<AtlasPage>& page, const Rect& slot)
+  : texture(new Texture(surface, x, y, w, h, bytes_per_pixel, byte_order,
+                        byte_type, page, slot)),
+    x_(x), y_(y), w_(w), h_(h), bytes_per_pixel_(bytes_per_pixel),
+    byte_order_(byte_order), byte_type_(byte_type) {}
+
 // -----------------------------------------------------------------------
 
 void SDLSurface::TextureRecord::reupload(SDL_Surface* surface,
-                                         const Rect& dirty) {
+                                         const DirtyRegion& dirty) {
   if (texture) {
-    Rect i = Rect::REC(x_, y_, w_, h_).intersection(dirty);
-    if (!i.isEmpty()) {
-      texture->reupload(surface,
-                        i.x() - x_, i.y() - y_,
-                        i.x(), i.y(), i.width(), i.height(),
-                        bytes_per_pixel_, byte_order_, byte_type_);
+    Rect piece = Rect::REC(x_, y_, w_, h_);
+    for (std::vector<Rect>::const_iterator it = dirty.rects().begin();
+         it != dirty.rects().end(); ++it) {
+      Rect i = piece.intersection(*it);
+      if (i.width() > 0 && i.height() > 0) {
+        texture->reupload(surface,
+                          i.x() - x_, i.y() - y_,
+                          i.x(), i.y(), i.width(), i.height(),
+                          bytes_per_pixel_, byte_order_, byte_type_);
+      }
     }
   } else {
     texture.reset(new Texture(surface, x_, y_, w_, h_, bytes_per_pixel_,
@@ -258,6 +380,7 @@ SDLSurface::SDLSurface(SDLGraphicsSystem* system)
 SDLSurface::SDLSurface(SDLGraphicsSystem* system, SDL_Surface* surf)
   : surface_(surf), texture_is_valid_(false), is_dc0_(false),
     graphics_system_(system), is_mask_(false) {
+  trackSurface(surf);
   buildRegionTable(Size(surf->w, surf->h));
   registerForNotification(system);
 }
@@ -270,6 +393,7 @@ SDLSurface::SDLSurface(SDLGraphicsSystem* system, SDL_Surface* surf,
   : surface_(surf), region_table_(region_table),
     texture_is_valid_(false), is_dc0_(false), graphics_system_(system),
     is_mask_(false) {
+  trackSurface(surf);
   registerForNotification(system);
 }
 
@@ -285,6 +409,20 @@ SDLSurface::SDLSurface(SDLGraphicsSystem* system, const Size& size)
 
 // -----------------------------------------------------------------------
 
+// static
+size_t SDLSurface::liveSurfaceCount() {
+  return g_live_surface_count;
+}
+
+// -----------------------------------------------------------------------
+
+// static
+size_t SDLSurface::liveSurfaceBytes() {
+  return g_live_surface_bytes;
+}
+
+// -----------------------------------------------------------------------
+
 void SDLSurface::EnsureUploaded() const {
   // TODO(erg): Style fix this entire file and make this implementation:
   uploadTextureIfNeeded();
@@ -342,6 +480,7 @@ void SDLSurface::allocate(const Size& size) {
   deallocate();
 
   surface_ = buildNewSurface(size);
+  trackSurface(surface_);
 
   fill(RGBAColour::Black());
 }
@@ -358,6 +497,7 @@ void SDLSurface::allocate(const Size& size, bool is_dc0) {
 void SDLSurface::deallocate() {
   textures_.clear();
   if (surface_) {
+    untrackSurface(surface_);
     SDL_FreeSurface(surface_);
     surface_ = NULL;
   }
@@ -408,9 +548,31 @@ void SDLSurface::blitToSurface(Surface& dest_surface,
         reportSDLError("SDL_SetAlpha", "SDLGraphicsSystem::blitSurfaceToDC()");
     }
 
-    if (SDL_BlitSurface(surface_, &src_rect, sdl_dest_surface.surface(),
-                       &dest_rect))
+    SDL_Surface* dest = sdl_dest_surface.surface();
+    if (surface_ != dest && IsKernelSurface(surface_) &&
+        IsKernelSurface(dest) && SameLayout(surface_, dest) &&
+        surface_->format->Amask && !(surface_->flags & SDL_SRCCOLORKEY)) {
+      // Same as the SDL_BlitSurface() below, but split over the worker
+      // pool. SDL ignores |alpha| when the source has an alpha channel, so
+      // we do too.
+      Rect clipped_src = src, clipped_dst = dst;
+      if (ClipBlit(rect(), sdl_dest_surface.rect(), clipped_src,
+                   clipped_dst)) {
+        SDL_LockSurface(surface_);
+        SDL_LockSurface(dest);
+        if (use_src_alpha) {
+          AlphaBlendPixels(PixelsIn(surface_, clipped_src),
+                           PixelsIn(dest, clipped_dst), LayoutOf(dest));
+        } else {
+          CopyPixels(PixelsIn(surface_, clipped_src),
+                     PixelsIn(dest, clipped_dst));
+        }
+        SDL_UnlockSurface(dest);
+        SDL_UnlockSurface(surface_);
+      }
+    } else if (SDL_BlitSurface(surface_, &src_rect, dest, &dest_rect)) {
       reportSDLError("SDL_BlitSurface", "SDLGraphicsSystem::blitSurfaceToDC()");
+    }
   }
   sdl_dest_surface.markWrittenTo(dst);
 }
@@ -503,12 +665,33 @@ static void determineProperties(
 
 void SDLSurface::uploadTextureIfNeeded() const {
   if (!texture_is_valid_) {
+    ScopedTimer timer("uploadTexture");
+
     if (textures_.size() == 0) {
       GLenum bytes_per_pixel;
       GLint byte_order, byte_type;
       determineProperties(surface_, is_mask_, bytes_per_pixel, byte_order,
                           byte_type);
 
+      // Small images share a page of the graphics system's atlas, so that
+      // drawing a screen full of buttons doesn't bind a texture per button.
+      boost::shared_ptr<AtlasPage> page;
+      Rect slot;
+      if (graphics_system_ && !is_dc0_ && bytes_per_pixel == 4) {
+        TextureAtlas& atlas = graphics_system_->textureAtlas();
+        if (atlas.canHold(size()))
+          page = atlas.allocate(size(), &slot);
+      }
+
+      if (page) {
+        textures_.push_back(TextureRecord(
+            surface_, 0, 0, surface_->w, surface_->h, bytes_per_pixel,
+            byte_order, byte_type, page, slot));
+        dirty_region_.clear();
+        texture_is_valid_ = true;
+        return;
+      }
+
       // ---------------------------------------------------------------------
 
       // Figure out the optimal way of splitting up the image.
@@ -535,11 +718,11 @@ void SDLSurface::uploadTextureIfNeeded() const {
     } else {
       // Reupload the textures without reallocating them.
       for_each(textures_.begin(), textures_.end(), [&](TextureRecord& record) {
-          record.reupload(surface_, dirty_rectangle_);
+          record.reupload(surface_, dirty_region_);
         });
     }
 
-    dirty_rectangle_ = Rect();
+    dirty_region_.clear();
     texture_is_valid_ = true;
   }
 }
@@ -610,11 +793,20 @@ void SDLSurface::fill(const RGBAColour& colour, const Rect& area) {
   // Fill the entire surface with the incoming colour
   Uint32 sdl_colour = MapRGBA(surface_->format, colour);
 
-  SDL_Rect rect;
-  RectToSDLRect(area, &rect);
+  if (IsKernelSurface(surface_)) {
+    Rect clipped = area.intersection(rect());
+    if (clipped.width() > 0 && clipped.height() > 0) {
+      SDL_LockSurface(surface_);
+      FillPixels(PixelsIn(surface_, clipped), sdl_colour);
+      SDL_UnlockSurface(surface_);
+    }
+  } else {
+    SDL_Rect rect;
+    RectToSDLRect(area, &rect);
 
-  if (SDL_FillRect(surface_, &rect, sdl_colour))
-    reportSDLError("SDL_FillRect", "SDLGraphicsSystem::wipe()");
+    if (SDL_FillRect(surface_, &rect, sdl_colour))
+      reportSDLError("SDL_FillRect", "SDLGraphicsSystem::wipe()");
+  }
 
   // If we are the main screen, then we want to update the screen
   markWrittenTo(area);
@@ -788,7 +980,7 @@ void SDLSurface::markWrittenTo(const Rect& written_rect) {
   }
 
   // Mark that the texture needs reuploading
-  dirty_rectangle_ = dirty_rectangle_.rectUnion(written_rect);
+  dirty_region_.add(written_rect.intersection(rect()));
   texture_is_valid_ = false;
 }
 
@@ -803,7 +995,8 @@ void SDLSurface::Observe(NotificationType type,
     }
     textures_.clear();
 
-    dirty_rectangle_ = rect();
+    dirty_region_.clear();
+    dirty_region_.add(rect());
   }
 
   texture_is_valid_ = false;
@@ -35,10 +35,12 @@
 
 #include "base/notification_observer.h"
 #include "base/notification_registrar.h"
+#include "Systems/Base/DirtyRegion.hpp"
 #include "Systems/Base/Surface.hpp"
 #include "Systems/Base/ToneCurve.hpp"
 
 struct SDL_Surface;
+class AtlasPage;
 class Texture;
 class GraphicsSystem;
 class SDLGraphicsSystem;
@@ -75,6 +77,11 @@ class SDLSurface : public Surface,
   SDLSurface(SDLGraphicsSystem* system, const Size& size);
   ~SDLSurface();
 
+  // The number of SDL_Surfaces owned by SDLSurface objects right now, and
+  // the bytes of pixel data they hold. Used for memory reports.
+  static size_t liveSurfaceCount();
+  static size_t liveSurfaceBytes();
+
   virtual void EnsureUploaded() const;
 
   void registerForNotification(GraphicsSystem* system);
@@ -173,9 +180,15 @@ class SDLSurface : public Surface,
                   int x, int y, int w, int h, unsigned int bytes_per_pixel,
                   int byte_order, int byte_type);
 
-    // Reuploads this current piece of surface from the supplied
-    // surface without allocating a new texture.
-    void reupload(SDL_Surface* surface, const Rect& dirty);
+    // Builds the texture in |slot| of a shared atlas |page|.
+    TextureRecord(SDL_Surface* surface,
+                  int x, int y, int w, int h, unsigned int bytes_per_pixel,
+                  int byte_order, int byte_type,
+                  const boost::shared_ptr<AtlasPage>& page, const Rect& slot);
+
+    // Reuploads the parts of this piece of surface that are in |dirty|
+    // from the supplied surface without allocating a new texture.
+    void reupload(SDL_Surface* surface, const DirtyRegion& dirty);
 
     // Clears |texture|. Called before a switch between windowed and
     // fullscreen mode, so that we aren't holding stale references.
@@ -211,8 +224,8 @@ class SDLSurface : public Surface,
   mutable bool texture_is_valid_;
 
   // When a chunk of the surface is invalidated, we only want to upload the
-  // smallest possible area, but for simplicity, we only keep one dirty area.
-  mutable Rect dirty_rectangle_;
+  // smallest possible area, so we keep every separately written area.
+  mutable DirtyRegion dirty_region_;
 
   // Whether this surface is DC0 and needs special treatment.
   bool is_dc0_;
@@ -38,6 +38,7 @@
 #include "Systems/SDL/SDLGraphicsSystem.hpp"
 #include "Systems/SDL/SDLSoundSystem.hpp"
 #include "Systems/SDL/SDLTextSystem.hpp"
+#include "Utilities/FrameTimings.hpp"
 #include "libReallive/defs.h"
 #include "libReallive/gameexe.h"
 
@@ -91,12 +92,25 @@ SDLSystem::~SDLSystem() {
 extern bool global_texture_reload;
 
 void SDLSystem::run(RLMachine& machine) {
+  ScopedTimer frame_timer("frame");
+
   // Give the event handler a chance to run.
-  event_system_->executeEventSystem(machine);
-  text_system_->executeTextSystem();
-  sound_system_->executeSoundSystem();
-  if (!global_texture_reload)
+  {
+    ScopedTimer timer("executeEventSystem");
+    event_system_->executeEventSystem(machine);
+  }
+  {
+    ScopedTimer timer("executeTextSystem");
+    text_system_->executeTextSystem();
+  }
+  {
+    ScopedTimer timer("executeSoundSystem");
+    sound_system_->executeSoundSystem();
+  }
+  if (!global_texture_reload) {
+    ScopedTimer timer("executeGraphicsSystem");
     graphics_system_->executeGraphicsSystem(machine);
+  }
 
   if (platform())
     platform()->run(machine);
@@ -120,6 +134,7 @@ void SDLSystem::run(RLMachine& machine) {
     sleep_time = max_time;
 
   if (!forceFastForward() && sleep_time) {
+    ScopedTimer timer("wait");
     event_system_->wait(sleep_time);
     setForceWait(false);
   }
@@ -85,45 +85,15 @@ Size SDLTextSystem::renderGlyphOnto(
   SDLSurface* sdl_surface = static_cast<SDLSurface*>(destination.get());
 
   boost::shared_ptr<TTF_Font> font = getFontOfSize(font_size);
-
-  // TODO: Glyphs go in a cache?
-  SDL_Color sdl_colour;
-  RGBColourToSDLColor(font_colour, &sdl_colour);
-  boost::shared_ptr<SDL_Surface> character(
-      TTF_RenderUTF8_Blended(font.get(), current.c_str(), sdl_colour),
-      SDL_FreeSurface);
-
-  if (character == NULL) {
-    // Bug during Kyou's path. The string is printed "". Regression in parser?
-    cerr << "WARNING. TTF_RenderUTF8_Blended didn't render the character \""
-         << current << "\". Hopefully continuing..." << endl;
-    return Size(0, 0);
-  }
-
-  boost::shared_ptr<SDL_Surface> shadow;
-  if (shadow_colour && sdl_system_.text().fontShadow()) {
-    SDL_Color sdl_shadow_colour;
-    RGBColourToSDLColor(*shadow_colour, &sdl_shadow_colour);
-
-    shadow.reset(
-        TTF_RenderUTF8_Blended(font.get(), current.c_str(), sdl_shadow_colour),
-        SDL_FreeSurface);
-  }
-
   Point insertion(insertion_point_x, insertion_point_y);
 
-  if (shadow) {
-    Size offset(shadow->w, shadow->h);
-    sdl_surface->blitFROMSurface(
-        shadow.get(), Rect(Point(0, 0), offset),
-        Rect(insertion + Point(2, 2), offset),
-        255);
+  if (shadow_colour && sdl_system_.text().fontShadow()) {
+    glyph_cache_.drawGlyph(font.get(), font_size, current, *shadow_colour,
+                           *sdl_surface, insertion + Point(2, 2));
   }
 
-  Size size(character->w, character->h);
-  sdl_surface->blitFROMSurface(
-      character.get(), Rect(Point(0, 0), size), Rect(insertion, size), 255);
-  return size;
+  return glyph_cache_.drawGlyph(font.get(), font_size, current, font_colour,
+                                *sdl_surface, insertion);
 }
 
 int SDLTextSystem::charWidth(int size, uint16_t codepoint) {
@@ -35,6 +35,7 @@
 #include <SDL/SDL_ttf.h>
 
 #include "Systems/Base/TextSystem.hpp"
+#include "Systems/SDL/SDLGlyphCache.hpp"
 
 class Point;
 class RLMachine;
@@ -62,11 +63,16 @@ class SDLTextSystem : public TextSystem {
   // Returns (and caches) a SDL_ttf font object for a font of |size|.
   boost::shared_ptr<TTF_Font> getFontOfSize(int size);
 
+  const SDLGlyphCache& glyphCache() const { return glyph_cache_; }
+
  private:
   // Font storage.
   typedef std::map< int , boost::shared_ptr<TTF_Font> > FontSizeMap;
   FontSizeMap map_;
 
+  // Previously rendered characters, so most text output is just a blit.
+  SDLGlyphCache glyph_cache_;
+
   SDLSystem& sdl_system_;
 };
 
@@ -53,6 +53,7 @@
 #include "Systems/SDL/Shaders.hpp"
 #endif
 #include "Systems/SDL/Texture.hpp"
+#include "Systems/SDL/TextureAtlas.hpp"
 
 #include "pygame/alphablit.h"
 
@@ -68,6 +69,16 @@ unsigned int Texture::s_screen_height = 0;
 unsigned int Texture::s_upload_buffer_size = 0;
 boost::scoped_array<char> Texture::s_upload_buffer;
 
+Texture::UploadStats Texture::s_upload_stats;
+
+#ifndef ANDROID
+// Reuploads cycle through a few pixel buffer objects, so that filling one
+// never has to wait for the card to finish reading the last.
+static const int PIXEL_BUFFER_COUNT = 3;
+static GLuint s_pixel_buffers[PIXEL_BUFFER_COUNT] = { 0, 0, 0 };
+static int s_next_pixel_buffer = 0;
+#endif
+
 // -----------------------------------------------------------------------
 
 void Texture::SetScreenSize(const Size& s) {
@@ -79,6 +90,68 @@ int Texture::ScreenHeight() {
   return s_screen_height;
 }
 
+// Draws one batch of quads with client side vertex arrays, which works on
+// both desktop GL and GLES.
+static void SubmitQuads(unsigned int texture, QuadBatch::BlendMode mode,
+                        const QuadBatch::Vertex* vertices, int quads) {
+  // Two triangles per quad; the indices never change, so build them once.
+  static std::vector<GLushort> indices;
+  if (indices.empty()) {
+    indices.reserve(QuadBatch::MAX_QUADS * 6);
+    for (int i = 0; i < QuadBatch::MAX_QUADS; ++i) {
+      GLushort base = i * 4;
+      indices.push_back(base);
+      indices.push_back(base + 1);
+      indices.push_back(base + 2);
+      indices.push_back(base);
+      indices.push_back(base + 2);
+      indices.push_back(base + 3);
+    }
+  }
+
+  glEnable(GL_TEXTURE_2D);
+  glBindTexture(GL_TEXTURE_2D, texture);
+
+  switch (mode) {
+    case QuadBatch::BLEND_REPLACE:
+      glBlendFunc(GL_ONE, GL_ZERO);
+      break;
+    case QuadBatch::BLEND_ALPHA:
+      glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+      break;
+    case QuadBatch::BLEND_ADDITIVE:
+      glBlendFunc(GL_SRC_ALPHA, GL_ONE);
+      break;
+    case QuadBatch::BLEND_SATURATE:
+      glBlendFunc(GL_SRC_ALPHA_SATURATE, GL_ONE_MINUS_SRC_ALPHA);
+      break;
+  }
+
+  glEnableClientState(GL_VERTEX_ARRAY);
+  glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+  glEnableClientState(GL_COLOR_ARRAY);
+
+  const GLsizei stride = sizeof(QuadBatch::Vertex);
+  glVertexPointer(2, GL_FLOAT, stride, &vertices->x);
+  glTexCoordPointer(2, GL_FLOAT, stride, &vertices->u);
+  glColorPointer(4, GL_UNSIGNED_BYTE, stride, &vertices->r);
+  glDrawElements(GL_TRIANGLES, quads * 6, GL_UNSIGNED_SHORT, &indices[0]);
+
+  glDisableClientState(GL_VERTEX_ARRAY);
+  glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+  glDisableClientState(GL_COLOR_ARRAY);
+
+  // Leave things how the unbatched code expects them.
+  glColor4ub(255, 255, 255, 255);
+  glBlendFunc(GL_ONE, GL_ZERO);
+  DebugShowGLErrors();
+}
+
+QuadBatch& Texture::ScreenBatch() {
+  static QuadBatch batch(&SubmitQuads);
+  return batch;
+}
+
 GLenum get_texture_format(GLint bpp)
 {
     switch (bpp) {
@@ -102,7 +175,9 @@ Texture::Texture(SDL_Surface* surface, int x, int y, int w, int h,
     texture_width_(SafeSize(logical_width_)),
     texture_height_(SafeSize(logical_height_)),
     back_texture_id_(0),
-    is_upside_down_(false) {
+    is_upside_down_(false),
+    atlas_x_(0),
+    atlas_y_(0) {
   surface = SDL_DisplayFormatAlpha(surface);
   glEnable(GL_TEXTURE_2D);
   glGenTextures(1, &texture_id_);
@@ -169,7 +244,9 @@ Texture::Texture(render_to_texture, int width, int height)
     total_width_(width), total_height_(height),
     texture_width_(0), texture_height_(0), texture_id_(0),
     back_texture_id_(0),
-    is_upside_down_(true) {
+    is_upside_down_(true),
+    atlas_x_(0),
+    atlas_y_(0) {
   glEnable(GL_TEXTURE_2D);
   glGenTextures(1, &texture_id_);
   glBindTexture(GL_TEXTURE_2D, texture_id_);
@@ -188,6 +265,8 @@ Texture::Texture(render_to_texture, int width, int height)
                0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
   DebugShowGLErrors();
 
+  // We're copying the screen, so everything queued has to be on it first.
+  ScreenBatch().flush();
   glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, 0, logical_width_,
                       logical_height_);
   DebugShowGLErrors();
@@ -195,7 +274,34 @@ Texture::Texture(render_to_texture, int width, int height)
 
 // -----------------------------------------------------------------------
 
+Texture::Texture(SDL_Surface* surface, int x, int y, int w, int h,
+                 unsigned int bytes_per_pixel, int byte_order, int byte_type,
+                 const boost::shared_ptr<AtlasPage>& page, const Rect& slot)
+  : x_offset_(x), y_offset_(y), logical_width_(w), logical_height_(h),
+    total_width_(surface->w), total_height_(surface->h),
+    texture_width_(page->size()), texture_height_(page->size()),
+    texture_id_(page->textureId()),
+    back_texture_id_(0),
+    is_upside_down_(false),
+    atlas_page_(page),
+    atlas_slot_(slot),
+    atlas_x_(slot.x() + TextureAtlas::PADDING),
+    atlas_y_(slot.y() + TextureAtlas::PADDING) {
+  reupload(surface, 0, 0, x, y, w, h, bytes_per_pixel, byte_order, byte_type);
+}
+
+// -----------------------------------------------------------------------
+
 Texture::~Texture() {
+  // Pending quads may still refer to this texture.
+  ScreenBatch().flush();
+
+  if (atlas_page_) {
+    // The page owns the GL texture; just give our slot back.
+    atlas_page_->release(atlas_slot_);
+    return;
+  }
+
   glDeleteTextures(1, &texture_id_);
 
   if (back_texture_id_)
@@ -217,46 +323,137 @@ char* Texture::uploadBuffer(unsigned int size) {
 
 // -----------------------------------------------------------------------
 
-void Texture::reupload(SDL_Surface* surface,
-                       int offset_x, int offset_y,
-                       int x, int y, int w, int h,
-                       unsigned int bytes_per_pixel, int byte_order,
-                       int byte_type) {
-  surface = SDL_DisplayFormatAlpha(surface);
-  glBindTexture(GL_TEXTURE_2D, texture_id_);
+static void CopyRows(char* dst, const char* src, int row_size, int pitch,
+                     int rows) {
+  for (int row = 0; row < rows; ++row) {
+    memcpy(dst, src, row_size);
+    dst += row_size;
+    src += pitch;
+  }
+}
 
-  if (w == total_width_ && h == total_height_) {
-    SDL_LockSurface(surface);
+// -----------------------------------------------------------------------
 
-    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, surface->w, surface->h,
-                    byte_order, byte_type, surface->pixels);
-    DebugShowGLErrors();
+void Texture::uploadPixels(int x, int y, int w, int h,
+                           int byte_order, int byte_type,
+                           const void* pixels, int pitch) {
+  const int row_size = w * 4;
+  const unsigned int size = row_size * h;
+  s_upload_stats.uploads++;
+  s_upload_stats.bytes += size;
 
-    SDL_UnlockSurface(surface);
+#ifndef ANDROID
+  if (GLEW_ARB_pixel_buffer_object) {
+    GLuint& buffer = s_pixel_buffers[s_next_pixel_buffer];
+    s_next_pixel_buffer = (s_next_pixel_buffer + 1) % PIXEL_BUFFER_COUNT;
+    if (!buffer)
+      glGenBuffersARB(1, &buffer);
+
+    glBindBufferARB(GL_PIXEL_UNPACK_BUFFER_ARB, buffer);
+    // Orphan the old storage instead of waiting for the card to be done
+    // with it.
+    glBufferDataARB(GL_PIXEL_UNPACK_BUFFER_ARB, size, NULL,
+                    GL_STREAM_DRAW_ARB);
+    char* dst = static_cast<char*>(
+        glMapBufferARB(GL_PIXEL_UNPACK_BUFFER_ARB, GL_WRITE_ONLY_ARB));
+    if (dst) {
+      CopyRows(dst, static_cast<const char*>(pixels), row_size, pitch, h);
+      glUnmapBufferARB(GL_PIXEL_UNPACK_BUFFER_ARB);
+
+      // The data argument is now an offset into the bound buffer, and the
+      // transfer happens whenever the driver gets to it.
+      glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, w, h, byte_order, byte_type,
+                      NULL);
+      glBindBufferARB(GL_PIXEL_UNPACK_BUFFER_ARB, 0);
+      DebugShowGLErrors();
+
+      s_upload_stats.streamed++;
+      return;
+    }
+
+    glBindBufferARB(GL_PIXEL_UNPACK_BUFFER_ARB, 0);
+  }
+#endif
+
+  if (pitch == row_size) {
+    glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, w, h, byte_order, byte_type,
+                    pixels);
   } else {
-    // Cut out the current piece
-    char* pixel_data = uploadBuffer(surface->format->BytesPerPixel * w * h);
-    char* cur_dst_ptr = pixel_data;
+    char* pixel_data = uploadBuffer(size);
+    CopyRows(pixel_data, static_cast<const char*>(pixels), row_size, pitch, h);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, w, h, byte_order, byte_type,
+                    pixel_data);
+  }
+  DebugShowGLErrors();
+}
 
-    SDL_LockSurface(surface); {
-      char* cur_src_ptr = (char*) surface->pixels;
-      cur_src_ptr += surface->pitch * y;
+// -----------------------------------------------------------------------
 
-      int row_start = surface->format->BytesPerPixel * x;
-      int subrow_size = surface->format->BytesPerPixel * w;
-      for (int current_row = 0; current_row < h; ++current_row) {
-        memcpy(cur_dst_ptr, cur_src_ptr + row_start, subrow_size);
-        cur_dst_ptr += subrow_size;
-        cur_src_ptr += surface->pitch;
-      }
+void Texture::ResetUploadBuffers() {
+#ifndef ANDROID
+  for (int i = 0; i < PIXEL_BUFFER_COUNT; ++i) {
+    if (s_pixel_buffers[i]) {
+      glDeleteBuffersARB(1, &s_pixel_buffers[i]);
+      s_pixel_buffers[i] = 0;
     }
+  }
+  s_next_pixel_buffer = 0;
+  DebugShowGLErrors();
+#endif
+}
+
+// -----------------------------------------------------------------------
+
+void Texture::reupload(SDL_Surface* surface,
+                       int offset_x, int offset_y,
+                       int x, int y, int w, int h,
+                       unsigned int bytes_per_pixel, int byte_order,
+                       int byte_type) {
+  if (w <= 0 || h <= 0)
+    return;
+
+  // Quads queued earlier this frame have to draw the old contents.
+  ScreenBatch().flush();
+
+  // Only convert the piece that changed. Converting the whole surface to the
+  // display format used to cost more than uploading a small dirty rectangle.
+  // The piece shares |surface|'s pixels, so it has to carry everything else
+  // SDL_DisplayFormatAlpha() reads from the format: the palette of 8bpp
+  // surfaces, the colour key and the per surface alpha.
+  SDL_LockSurface(surface);
+  SDL_PixelFormat* format = surface->format;
+  SDL_Surface* piece = SDL_CreateRGBSurfaceFrom(
+      static_cast<char*>(surface->pixels) + surface->pitch * y +
+          format->BytesPerPixel * x,
+      w, h, format->BitsPerPixel, surface->pitch,
+      format->Rmask, format->Gmask, format->Bmask, format->Amask);
+  if (!piece) {
     SDL_UnlockSurface(surface);
+    return;
+  }
 
-    glTexSubImage2D(GL_TEXTURE_2D, 0, offset_x, offset_y, w, h,
-                    byte_order, byte_type, pixel_data);
-    DebugShowGLErrors();
+  if (format->palette) {
+    SDL_SetPalette(piece, SDL_LOGPAL, format->palette->colors, 0,
+                   format->palette->ncolors);
   }
-  SDL_FreeSurface(surface);
+  if (surface->flags & SDL_SRCCOLORKEY)
+    SDL_SetColorKey(piece, SDL_SRCCOLORKEY, format->colorkey);
+  if (surface->flags & SDL_SRCALPHA)
+    SDL_SetAlpha(piece, SDL_SRCALPHA, format->alpha);
+  SDL_Surface* converted = SDL_DisplayFormatAlpha(piece);
+  SDL_FreeSurface(piece);
+  SDL_UnlockSurface(surface);
+  if (!converted)
+    return;
+
+  glBindTexture(GL_TEXTURE_2D, texture_id_);
+
+  SDL_LockSurface(converted);
+  uploadPixels(atlas_x_ + offset_x, atlas_y_ + offset_y, w, h,
+               byte_order, byte_type, converted->pixels, converted->pitch);
+  SDL_UnlockSurface(converted);
+
+  SDL_FreeSurface(converted);
 }
 
 // -----------------------------------------------------------------------
@@ -300,61 +497,11 @@ void Texture::renderToScreen(const Rect& src, const Rect& dst, int opacity) {
   if (!filterCoords(x1, y1, x2, y2, fdx1, fdy1, fdx2, fdy2))
     return;
 
-  glEnable(GL_TEXTURE_2D);
-
   // For the time being, we are dumb and assume that it's one texture
-
-  float thisx1 = float(x1) / texture_width_;
-  float thisy1 = float(y1) / texture_height_;
-  float thisx2 = float(x2) / texture_width_;
-  float thisy2 = float(y2) / texture_height_;
-
-  if (is_upside_down_) {
-    thisy1 = float(logical_height_ - y1) / texture_height_;
-    thisy2 = float(logical_height_ - y2) / texture_height_;
-  }
-
-  glBindTexture(GL_TEXTURE_2D, texture_id_);
-
-  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-#if 0
-  glBegin(GL_QUADS); {
-    glColor4ub(255, 255, 255, opacity);
-    glTexCoord2f(thisx1, thisy1);
-    glVertex2i(fdx1, fdy1);
-    glTexCoord2f(thisx2, thisy1);
-    glVertex2i(fdx2, fdy1);
-    glTexCoord2f(thisx2, thisy2);
-    glVertex2i(fdx2, fdy2);
-    glTexCoord2f(thisx1, thisy2);
-    glVertex2i(fdx1, fdy2);
-  }
-  glEnd();
-#else
-  glColor4ub(255, 255, 255, opacity);
-  GLfloat vtx1[] = {
-    fdx1, fdy1, 0,
-    fdx2, fdy1, 0,
-    fdx2, fdy2, 0,
-    fdx1, fdy2, 0
-  };
-  GLfloat tex1[] = {
-    thisx1,thisy1,
-    thisx2,thisy1,
-    thisx2,thisy2,
-    thisx1,thisy2
-  };
-  glEnableClientState(GL_VERTEX_ARRAY);
-  glEnableClientState(GL_TEXTURE_COORD_ARRAY);
-
-  glVertexPointer(3, GL_FLOAT, 0, vtx1);
-  glTexCoordPointer(2, GL_FLOAT, 0, tex1);
-  glDrawArrays(GL_TRIANGLE_FAN,0,4);
-
-  glDisableClientState(GL_VERTEX_ARRAY);
-  glDisableClientState(GL_TEXTURE_COORD_ARRAY);
-#endif
-  glBlendFunc(GL_ONE, GL_ZERO);
+  RGBAColour colour(255, 255, 255, opacity);
+  RGBAColour colours[4] = { colour, colour, colour, colour };
+  queueRect(QuadBatch::BLEND_ALPHA, x1, y1, x2, y2,
+            fdx1, fdy1, fdx2, fdy2, colours);
 }
 
 // -----------------------------------------------------------------------
@@ -495,65 +642,12 @@ void Texture::render_to_screen_as_colour_mask_subtractive_fallback(
   if (!filterCoords(x1, y1, x2, y2, fdx1, fdy1, fdx2, fdy2))
     return;
 
-  float thisx1 = float(x1) / texture_width_;
-  float thisy1 = float(y1) / texture_height_;
-  float thisx2 = float(x2) / texture_width_;
-  float thisy2 = float(y2) / texture_height_;
-
-  if (is_upside_down_) {
-    thisy1 = float(logical_height_ - y1) / texture_height_;
-    thisy2 = float(logical_height_ - y2) / texture_height_;
-  }
-
-  // First draw the mask
-  glBindTexture(GL_TEXTURE_2D, texture_id_);
-
   /// SERIOUS WTF: gl_blend_func_separate causes a segmentation fault
-  /// under the current i810 driver for linux.
-//  glBlendFuncSeparate(GL_SRC_ALPHA_SATURATE, GL_ONE_MINUS_SRC_ALPHA,
-//                      GL_SRC_COLOR, GL_ONE_MINUS_SRC_ALPHA);
-  glBlendFunc(GL_SRC_ALPHA_SATURATE, GL_ONE_MINUS_SRC_ALPHA);
-
-#if 0
-  glBegin(GL_QUADS); {
-    glColorRGBA(rgba);
-    glTexCoord2f(thisx1, thisy1);
-    glVertex2i(fdx1, fdy1);
-    glTexCoord2f(thisx2, thisy1);
-    glVertex2i(fdx2, fdy1);
-    glTexCoord2f(thisx2, thisy2);
-    glVertex2i(fdx2, fdy2);
-    glTexCoord2f(thisx1, thisy2);
-    glVertex2i(fdx1, fdy2);
-  }
-  glEnd();
-#else
-  glColor4ub(rgba.r(), rgba.g(), rgba.b(), rgba.a());
-  GLfloat vtx1[] = {
-    fdx1, fdy1, 0,
-    fdx2, fdy1, 0,
-    fdx2, fdy2, 0,
-    fdx1, fdy2, 0
-  };
-  GLfloat tex1[] = {
-    thisx1,thisy1,
-    thisx2,thisy1,
-    thisx2,thisy2,
-    thisx1,thisy2
-  };
-
-  glEnableClientState(GL_VERTEX_ARRAY);
-  glEnableClientState(GL_TEXTURE_COORD_ARRAY);
-
-  glVertexPointer(3, GL_FLOAT, 0, vtx1);
-  glTexCoordPointer(2, GL_FLOAT, 0, tex1);
-  glDrawArrays(GL_TRIANGLE_FAN,0,4);
-
-  glDisableClientState(GL_VERTEX_ARRAY);
-  glDisableClientState(GL_TEXTURE_COORD_ARRAY);
-#endif
-
-  glBlendFunc(GL_ONE, GL_ZERO);
+  /// under the current i810 driver for linux, so BLEND_SATURATE is
+  /// glBlendFunc(GL_SRC_ALPHA_SATURATE, GL_ONE_MINUS_SRC_ALPHA).
+  RGBAColour colours[4] = { rgba, rgba, rgba, rgba };
+  queueRect(QuadBatch::BLEND_SATURATE, x1, y1, x2, y2,
+            fdx1, fdy1, fdx2, fdy2, colours);
 }
 
 // -----------------------------------------------------------------------
@@ -565,106 +659,29 @@ void Texture::render_to_screen_as_colour_mask_additive(
   if (!filterCoords(x1, y1, x2, y2, fdx1, fdy1, fdx2, fdy2))
     return;
 
-  float thisx1 = float(x1) / texture_width_;
-  float thisy1 = float(y1) / texture_height_;
-  float thisx2 = float(x2) / texture_width_;
-  float thisy2 = float(y2) / texture_height_;
-
-  if (is_upside_down_) {
-    thisy1 = float(logical_height_ - y1) / texture_height_;
-    thisy2 = float(logical_height_ - y2) / texture_height_;
-  }
-
-  // First draw the mask
-  glBindTexture(GL_TEXTURE_2D, texture_id_);
-  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-
-#if 0
-  glBegin(GL_QUADS); {
-    glColorRGBA(rgba);
-    glTexCoord2i(thisx1, thisy1);
-    glVertex2f(fdx1, fdy1);
-    glTexCoord2i(thisx2, thisy1);
-    glVertex2f(fdx2, fdy1);
-    glTexCoord2i(thisx2, thisy2);
-    glVertex2f(fdx2, fdy2);
-    glTexCoord2i(thisx1, thisy2);
-    glVertex2f(fdx1, fdy2);
-  }
-  glEnd();
-#else
-  glColor4ub(rgba.r(), rgba.g(), rgba.b(), rgba.a());
-  GLfloat vtx1[] = {
-    fdx1, fdy1, 0,
-    fdx2, fdy1, 0,
-    fdx2, fdy2, 0,
-    fdx1, fdy2, 0
-  };
-  GLfloat tex1[] = {
-    thisx1,thisy1,
-    thisx2,thisy1,
-    thisx2,thisy2,
-    thisx1,thisy2
-  };
-
-  glEnableClientState(GL_VERTEX_ARRAY);
-  glEnableClientState(GL_TEXTURE_COORD_ARRAY);
-
-  glVertexPointer(3, GL_FLOAT, 0, vtx1);
-  glTexCoordPointer(2, GL_FLOAT, 0, tex1);
-  glDrawArrays(GL_TRIANGLE_FAN,0,4);
-
-  glDisableClientState(GL_VERTEX_ARRAY);
-  glDisableClientState(GL_TEXTURE_COORD_ARRAY);
-#endif
-
-  glBlendFunc(GL_ONE, GL_ZERO);
+  RGBAColour colours[4] = { rgba, rgba, rgba, rgba };
+  queueRect(QuadBatch::BLEND_ALPHA, x1, y1, x2, y2,
+            fdx1, fdy1, fdx2, fdy2, colours);
 }
 
 // -----------------------------------------------------------------------
 
 void Texture::renderToScreen(const Rect& src, const Rect& dst,
                              const int opacity[4]) {
-#if 0
-  // For the time being, we are dumb and assume that it's one texture
   int x1 = src.x(), y1 = src.y(), x2 = src.x2(), y2 = src.y2();
   int fdx1 = dst.x(), fdy1 = dst.y(), fdx2 = dst.x2(), fdy2 = dst.y2();
   if (!filterCoords(x1, y1, x2, y2, fdx1, fdy1, fdx2, fdy2))
     return;
 
-  float thisx1 = float(x1) / texture_width_;
-  float thisy1 = float(y1) / texture_height_;
-  float thisx2 = float(x2) / texture_width_;
-  float thisy2 = float(y2) / texture_height_;
-
-  glBindTexture(GL_TEXTURE_2D, texture_id_);
-
-  // Blend when we have less opacity
-  if (find_if(opacity, opacity + 4, [](int o) { return o < 255; }) !=
-      opacity + 4) {
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-  }
-
-  glBegin(GL_QUADS); {
-    glColor4ub(255, 255, 255, opacity[0]);
-    glTexCoord2f(thisx1, thisy1);
-    glVertex2i(fdx1, fdy1);
-    glColor4ub(255, 255, 255, opacity[1]);
-    glTexCoord2f(thisx2, thisy1);
-    glVertex2i(fdx2, fdy1);
-    glColor4ub(255, 255, 255, opacity[2]);
-    glTexCoord2f(thisx2, thisy2);
-    glVertex2i(fdx2, fdy2);
-    glColor4ub(255, 255, 255, opacity[3]);
-    glTexCoord2f(thisx1, thisy2);
-    glVertex2i(fdx1, fdy2);
-  }
-  glEnd();
-  glBlendFunc(GL_ONE, GL_ZERO);
-#else
-  // TODO
-  renderToScreen(src, dst, (opacity[0] + opacity[1] + opacity[2] + opacity[3]) / 4);
-#endif
+  // Each corner gets its own opacity now that colour is per vertex.
+  RGBAColour colours[4] = {
+    RGBAColour(255, 255, 255, opacity[0]),
+    RGBAColour(255, 255, 255, opacity[1]),
+    RGBAColour(255, 255, 255, opacity[2]),
+    RGBAColour(255, 255, 255, opacity[3])
+  };
+  queueRect(QuadBatch::BLEND_ALPHA, x1, y1, x2, y2,
+            fdx1, fdy1, fdx2, fdy2, colours);
 }
 
 // -----------------------------------------------------------------------
@@ -693,137 +710,106 @@ void Texture::renderToScreenAsObject(
   }
 
   // Convert the pixel coordinates into [0,1) texture coordinates
-  float thisx1 = float(xSrc1) / texture_width_;
-  float thisy1 = float(ySrc1) / texture_height_;
-  float thisx2 = float(xSrc2) / texture_width_;
-  float thisy2 = float(ySrc2) / texture_height_;
-
-  glBindTexture(GL_TEXTURE_2D, texture_id_);
-
-  glPushMatrix(); {
-    // Translate to where the object starts.
-    glTranslatef(fdx1, fdy1, 0);
-
-    int width = fdx2 - fdx1;
-    int height = fdy2 - fdy1;
-
-    // Rotate the texture around the point (origin + position + reporigin)
-    float x_rep = (width / 2.0f) + go.xRepOrigin();
-    float y_rep = (height / 2.0f) + go.yRepOrigin();
-
-    glTranslatef(x_rep, y_rep, 0);
-    glRotatef(float(go.rotation()) / 10, 0, 0, 1);
-    glTranslatef(-x_rep, -y_rep, 0);
+  float thisx1 = float(atlas_x_ + xSrc1) / texture_width_;
+  float thisy1 = float(atlas_y_ + ySrc1) / texture_height_;
+  float thisx2 = float(atlas_x_ + xSrc2) / texture_width_;
+  float thisy2 = float(atlas_y_ + ySrc2) / texture_height_;
+
+  int width = fdx2 - fdx1;
+  int height = fdy2 - fdy1;
+
+  // Rotate the quad around the point (origin + position + reporigin). This
+  // used to be done with the modelview matrix, which forced a draw call per
+  // object; doing it here lets objects share a batch.
+  float x_rep = (width / 2.0f) + go.xRepOrigin();
+  float y_rep = (height / 2.0f) + go.yRepOrigin();
+  float radians = (float(go.rotation()) / 10) * M_PI / 180.0f;
+  float cos_r = cos(radians);
+  float sin_r = sin(radians);
+
+  const float corner_x[4] = { 0, float(width), float(width), 0 };
+  const float corner_y[4] = { 0, 0, float(height), float(height) };
+  float dest_x[4], dest_y[4];
+  for (int i = 0; i < 4; ++i) {
+    float x = corner_x[i] - x_rep;
+    float y = corner_y[i] - y_rep;
+    dest_x[i] = fdx1 + x_rep + x * cos_r - y * sin_r;
+    dest_y[i] = fdy1 + y_rep + x * sin_r + y * cos_r;
+  }
 
-    // RealLive has its own complex shading/tinting system which we implement
-    // in a shader if available. It's costly enough that we make sure we need
-    // to use it.
-    bool using_shader = false;
-#if 0
-    if ((go.light() ||
-         go.tint() != RGBColour::Black() ||
-         go.colour() != RGBAColour::Clear() ||
-         go.mono() ||
-         go.invert()) &&
-        GLEW_ARB_fragment_shader && GLEW_ARB_multitexture) {
-      // Image
-      glActiveTexture(GL_TEXTURE0_ARB);
-      glEnable(GL_TEXTURE_2D);
-      glBindTexture(GL_TEXTURE_2D, texture_id_);
-      glUseProgramObjectARB(Shaders::getObjectProgram());
-      glUniform1iARB(Shaders::getObjectUniformImage(), 0);
-
-      // Colour/Tint/Etc.
-      Shaders::loadObjectUniformFromGraphicsObject(go);
-
-      // Alpha.
-      glUniform1fARB(Shaders::getObjectUniformAlpha(),
-                     alpha / 255.0f);
-
-      // Our final blending color has to be all white here.
-      using_shader = true;
-    } else
-#endif
-    {
-      // The shader takes care of the alpha for us, so we need to specify when
-      // not using it.
-      glColor4ub(255, 255, 255, alpha);
+  // RealLive has its own complex shading/tinting system which we'd implement
+  // in a shader. Until then, the alpha is the only thing we apply.
+  RGBAColour colour(255, 255, 255, alpha);
+  RGBAColour colours[4] = { colour, colour, colour, colour };
+
+  // Make this so that when we have composite 1, we're doing a pure
+  // additive blend, (ignoring the alpha channel?)
+  QuadBatch::BlendMode mode;
+  switch (go.compositeMode()) {
+    case 0:
+      mode = QuadBatch::BLEND_ALPHA;
+      break;
+    case 1:
+      mode = QuadBatch::BLEND_ADDITIVE;
+      break;
+    case 2: {
+      // TODO: This should be GL_FUNC_REVERSE_SUBTRACT.
+      mode = QuadBatch::BLEND_ADDITIVE;
+      break;
     }
-
-    // Make this so that when we have composite 1, we're doing a pure
-    // additive blend, (ignoring the alpha channel?)
-    switch (go.compositeMode()) {
-      case 0:
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-        break;
-      case 1:
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE);
-        break;
-      case 2: {
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE);
-#if 0
-        glBlendEquation(GL_FUNC_REVERSE_SUBTRACT);
-#endif
-        break;
-      }
-      default: {
-        ostringstream oss;
-        oss << "Invalid composite_mode in render: " << go.compositeMode();
-        throw SystemError(oss.str());
-      }
+    default: {
+      ostringstream oss;
+      oss << "Invalid composite_mode in render: " << go.compositeMode();
+      throw SystemError(oss.str());
     }
+  }
 
-#if 0
-    glBegin(GL_QUADS); {
-      glTexCoord2f(thisx1, thisy1);
-      glVertex2i(0, 0);
-      glTexCoord2f(thisx2, thisy1);
-      glVertex2i(width, 0);
-      glTexCoord2f(thisx2, thisy2);
-      glVertex2i(width, height);
-      glTexCoord2f(thisx1, thisy2);
-      glVertex2i(0, height);
-    }
-    glEnd();
-#else
-  GLfloat vtx1[] = {
-    0, 0, 0,
-    width, 0, 0,
-    width, height, 0,
-    0, height, 0
-  };
-  GLfloat tex1[] = {
-    thisx1,thisy1,
-    thisx2,thisy1,
-    thisx2,thisy2,
-    thisx1,thisy2
-  };
+  queueQuad(mode, thisx1, thisy1, thisx2, thisy2, dest_x, dest_y, colours);
+}
 
-  glEnableClientState(GL_VERTEX_ARRAY);
-  glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+// -----------------------------------------------------------------------
 
-  glVertexPointer(3, GL_FLOAT, 0, vtx1);
-  glTexCoordPointer(2, GL_FLOAT, 0, tex1);
-  glDrawArrays(GL_TRIANGLE_FAN,0,4);
+void Texture::queueRect(QuadBatch::BlendMode mode,
+                        int x1, int y1, int x2, int y2,
+                        int dx1, int dy1, int dx2, int dy2,
+                        const RGBAColour colours[4]) {
+  float thisx1 = float(atlas_x_ + x1) / texture_width_;
+  float thisy1 = float(atlas_y_ + y1) / texture_height_;
+  float thisx2 = float(atlas_x_ + x2) / texture_width_;
+  float thisy2 = float(atlas_y_ + y2) / texture_height_;
 
-  glDisableClientState(GL_VERTEX_ARRAY);
-  glDisableClientState(GL_TEXTURE_COORD_ARRAY);
-#endif
+  if (is_upside_down_) {
+    thisy1 = float(logical_height_ - y1) / texture_height_;
+    thisy2 = float(logical_height_ - y2) / texture_height_;
+  }
 
-#if 0
-    if (using_shader) {
-      glUseProgramObjectARB(0);
-    }
-#endif
+  const float dest_x[4] = { float(dx1), float(dx2), float(dx2), float(dx1) };
+  const float dest_y[4] = { float(dy1), float(dy1), float(dy2), float(dy2) };
+  queueQuad(mode, thisx1, thisy1, thisx2, thisy2, dest_x, dest_y, colours);
+}
 
-#if 0
-    glBlendEquation(GL_FUNC_ADD);
-#endif
-    glBlendFunc(GL_ONE, GL_ZERO);
+// -----------------------------------------------------------------------
+
+void Texture::queueQuad(QuadBatch::BlendMode mode,
+                        float u1, float v1, float u2, float v2,
+                        const float dest_x[4], const float dest_y[4],
+                        const RGBAColour colours[4]) {
+  const float u[4] = { u1, u2, u2, u1 };
+  const float v[4] = { v1, v1, v2, v2 };
+
+  QuadBatch::Vertex quad[4];
+  for (int i = 0; i < 4; ++i) {
+    quad[i].x = dest_x[i];
+    quad[i].y = dest_y[i];
+    quad[i].u = u[i];
+    quad[i].v = v[i];
+    quad[i].r = colours[i].r();
+    quad[i].g = colours[i].g();
+    quad[i].b = colours[i].b();
+    quad[i].a = colours[i].a();
   }
-  glPopMatrix();
 
-  DebugShowGLErrors();
+  ScreenBatch().addQuad(texture_id_, mode, quad);
 }
 
 // -----------------------------------------------------------------------
@@ -30,6 +30,9 @@
 
 #include <string>
 #include <boost/scoped_array.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include "Systems/Base/QuadBatch.hpp"
 
 #ifndef ANDROID
 #include <SDL/SDL_opengl.h>
@@ -38,6 +41,7 @@
 #endif
 
 struct SDL_Surface;
+class AtlasPage;
 class SDLSurface;
 class GraphicsObject;
 
@@ -57,10 +61,39 @@ class Texture {
 
   static int ScreenHeight();
 
+  // Every quad drawn to the screen goes through this batch, which
+  // SDLGraphicsSystem flushes at the end of the frame. Anything that draws
+  // or reads pixels with raw GL calls has to flush it first.
+  static QuadBatch& ScreenBatch();
+
+  // What reupload() has sent to the card since the last ResetUploadStats().
+  struct UploadStats {
+    UploadStats() : uploads(0), bytes(0), streamed(0) {}
+
+    unsigned long uploads;
+    unsigned long bytes;
+
+    // Uploads that went through a pixel buffer object.
+    unsigned long streamed;
+  };
+  static const UploadStats& GetUploadStats() { return s_upload_stats; }
+  static void ResetUploadStats() { s_upload_stats = UploadStats(); }
+
+  // Deletes the pixel buffer objects reupload() streams through. Called when
+  // the GL context is about to go away.
+  static void ResetUploadBuffers();
+
  public:
   Texture(SDL_Surface* surface, int x, int y, int w, int h,
           unsigned int bytes_per_pixel, int byte_order, int byte_type);
   Texture(render_to_texture, int screen_width, int screen_height);
+
+  // Uploads Rect(x, y, w, h) of |surface| into |slot| (which includes
+  // TextureAtlas::PADDING) of a shared |page| instead of a texture of our
+  // own. The slot is given back when we're destroyed.
+  Texture(SDL_Surface* surface, int x, int y, int w, int h,
+          unsigned int bytes_per_pixel, int byte_order, int byte_type,
+          const boost::shared_ptr<AtlasPage>& page, const Rect& slot);
   ~Texture();
 
   // Uploads Rect(x, y, w, h) offset by (offset_x, offset_y) onto our texture
@@ -97,6 +130,13 @@ class Texture {
   // large enough.
   static char* uploadBuffer(unsigned int size);
 
+  // Uploads |w| x |h| 32-bit |pixels|, whose rows are |pitch| bytes apart, to
+  // (x, y) of the bound texture. Streams through a pixel buffer object when
+  // the card supports them.
+  static void uploadPixels(int x, int y, int w, int h,
+                           int byte_order, int byte_type,
+                           const void* pixels, int pitch);
+
   void render_to_screen_as_colour_mask_subtractive_glsl(
     const Rect& src, const Rect& dst, const RGBAColour& rgba);
   void render_to_screen_as_colour_mask_subtractive_fallback(
@@ -107,6 +147,22 @@ class Texture {
   bool filterCoords(int& x1, int& y1, int& x2, int& y2,
                     int& dx1, int& dy1, int& dx2, int& dy2);
 
+  // Queues the source pixels (x1, y1)-(x2, y2) of this texture to the
+  // destination rectangle (dx1, dy1)-(dx2, dy2). Handles upside down
+  // textures.
+  void queueRect(QuadBatch::BlendMode mode,
+                 int x1, int y1, int x2, int y2,
+                 int dx1, int dy1, int dx2, int dy2,
+                 const RGBAColour colours[4]);
+
+  // Queues the texture coordinates (u1, v1)-(u2, v2) to an arbitrary
+  // quadrilateral, corners in top left, top right, bottom right, bottom
+  // left order.
+  void queueQuad(QuadBatch::BlendMode mode,
+                 float u1, float v1, float u2, float v2,
+                 const float dest_x[4], const float dest_y[4],
+                 const RGBAColour colours[4]);
+
   int x_offset_;
   int y_offset_;
 
@@ -126,6 +182,14 @@ class Texture {
   // Is this texture upside down? (Because it's a screenshot, et cetera.)
   bool is_upside_down_;
 
+  // When we live in an atlas page: the page, our slot in it, and where our
+  // pixels start inside the slot. |texture_id_| and |texture_width_| and
+  // |texture_height_| are then the page's.
+  boost::shared_ptr<AtlasPage> atlas_page_;
+  Rect atlas_slot_;
+  int atlas_x_;
+  int atlas_y_;
+
   // Size of the screen. Used during color mask calculations.
   static unsigned int s_screen_width;
   static unsigned int s_screen_height;
@@ -136,6 +200,8 @@ class Texture {
   // To prevent new-ing in a loop, save the dynamically allocated
   // buffer used to upload data into.
   static boost::scoped_array<char> s_upload_buffer;
+
+  static UploadStats s_upload_stats;
 };
 
 #endif  // SRC_SYSTEMS_SDL_TEXTURE_HPP_
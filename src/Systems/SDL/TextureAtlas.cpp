@@ -0,0 +1,110 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2013 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+// -----------------------------------------------------------------------
+
+
+#ifndef ANDROID
+#include "GL/glew.h"
+#endif
+
+#include "Systems/SDL/TextureAtlas.hpp"
+
+#include <vector>
+
+#include "Systems/SDL/SDLUtils.hpp"
+#include "Systems/SDL/Texture.hpp"
+
+// -----------------------------------------------------------------------
+// AtlasPage
+// -----------------------------------------------------------------------
+
+AtlasPage::AtlasPage(int size)
+    : texture_id_(0), packer_(Size(size, size)) {
+  glEnable(GL_TEXTURE_2D);
+  glGenTextures(1, &texture_id_);
+  glBindTexture(GL_TEXTURE_2D, texture_id_);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+  // Start out transparent so the padding between slots is.
+  std::vector<char> clear(size * size * 4, 0);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, size, size, 0,
+               GL_RGBA, GL_UNSIGNED_BYTE, &clear[0]);
+  DebugShowGLErrors();
+}
+
+AtlasPage::~AtlasPage() {
+  // Pending quads may still sample this page.
+  Texture::ScreenBatch().flush();
+  glDeleteTextures(1, &texture_id_);
+}
+
+// -----------------------------------------------------------------------
+// TextureAtlas
+// -----------------------------------------------------------------------
+
+TextureAtlas::TextureAtlas() {
+}
+
+TextureAtlas::~TextureAtlas() {
+}
+
+boost::shared_ptr<AtlasPage> TextureAtlas::allocate(const Size& size,
+                                                    Rect* slot) {
+  Size padded(size.width() + 2 * PADDING, size.height() + 2 * PADDING);
+  for (std::vector<boost::shared_ptr<AtlasPage> >::iterator it =
+           pages_.begin(); it != pages_.end(); ++it) {
+    if ((*it)->allocate(padded, slot))
+      return *it;
+  }
+
+  if (int(pages_.size()) >= MAX_PAGES || SafeSize(PAGE_SIZE) < PAGE_SIZE)
+    return boost::shared_ptr<AtlasPage>();
+
+  boost::shared_ptr<AtlasPage> page(new AtlasPage(PAGE_SIZE));
+  pages_.push_back(page);
+  if (!page->allocate(padded, slot))
+    return boost::shared_ptr<AtlasPage>();
+
+  return page;
+}
+
+void TextureAtlas::clear() {
+  pages_.clear();
+}
+
+TextureAtlas::Stats TextureAtlas::stats() const {
+  Stats stats;
+  for (std::vector<boost::shared_ptr<AtlasPage> >::const_iterator it =
+           pages_.begin(); it != pages_.end(); ++it) {
+    const AtlasPacker& packer = (*it)->packer();
+    stats.pages++;
+    stats.slots += packer.allocations();
+    stats.used_pixels += packer.usedArea();
+    stats.total_pixels +=
+        long(packer.size().width()) * packer.size().height();
+  }
+  return stats;
+}
@@ -0,0 +1,114 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2013 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+// -----------------------------------------------------------------------
+
+
+#ifndef SRC_SYSTEMS_SDL_TEXTUREATLAS_HPP_
+#define SRC_SYSTEMS_SDL_TEXTUREATLAS_HPP_
+
+#include <vector>
+#include <boost/shared_ptr.hpp>
+
+#ifndef ANDROID
+#include <SDL/SDL_opengl.h>
+#else
+#include <GLES/gl.h>
+#endif
+
+#include "Systems/Base/AtlasPacker.hpp"
+#include "Systems/Base/Rect.hpp"
+
+// One OpenGL texture shared by many small surfaces. Textures that live in a
+// page keep a reference to it, so a page outlives the atlas dropping it.
+class AtlasPage {
+ public:
+  explicit AtlasPage(int size);
+  ~AtlasPage();
+
+  GLuint textureId() const { return texture_id_; }
+  int size() const { return packer_.size().width(); }
+
+  bool allocate(const Size& size, Rect* out) {
+    return packer_.allocate(size, out);
+  }
+  void release(const Rect& slot) { packer_.release(slot); }
+
+  const AtlasPacker& packer() const { return packer_; }
+
+ private:
+  GLuint texture_id_;
+  AtlasPacker packer_;
+};
+
+// Packs surfaces that are small enough into shared AtlasPages, so that a menu
+// full of button graphics draws from a few textures instead of one each.
+// Owned by SDLGraphicsSystem.
+class TextureAtlas {
+ public:
+  struct Stats {
+    Stats() : pages(0), slots(0), used_pixels(0), total_pixels(0) {}
+
+    int pages;
+    int slots;
+    long used_pixels;
+    long total_pixels;
+  };
+
+  // Pages are this many pixels on a side.
+  static const int PAGE_SIZE = 1024;
+
+  // Surfaces larger than this in either direction get their own textures.
+  static const int MAX_ITEM_SIZE = 128;
+
+  // Empty pixels around each slot so linear filtering doesn't sample the
+  // neighbouring surface.
+  static const int PADDING = 1;
+
+  // Past this many pages, small surfaces get their own textures too.
+  static const int MAX_PAGES = 8;
+
+  TextureAtlas();
+  ~TextureAtlas();
+
+  bool canHold(const Size& size) const {
+    return size.width() <= MAX_ITEM_SIZE && size.height() <= MAX_ITEM_SIZE;
+  }
+
+  // Finds room for |size| (plus padding) on some page. On success, |slot| is
+  // the padded rectangle to give back to AtlasPage::release(). Returns an
+  // empty pointer if every page is full and we can't make another.
+  boost::shared_ptr<AtlasPage> allocate(const Size& size, Rect* slot);
+
+  // Forgets every page. Called when the GL context is about to go away;
+  // textures that still reference a page release into it harmlessly.
+  void clear();
+
+  Stats stats() const;
+
+ private:
+  std::vector<boost::shared_ptr<AtlasPage> > pages_;
+};  // class TextureAtlas
+
+#endif  // SRC_SYSTEMS_SDL_TEXTUREATLAS_HPP_
@@ -0,0 +1,227 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2013 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+// -----------------------------------------------------------------------
+
+#include "Utilities/AsyncFileWriter.hpp"
+
+#include <boost/filesystem/operations.hpp>
+#include <boost/iostreams/device/back_inserter.hpp>
+#include <boost/iostreams/filter/zlib.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+#include <cstdio>
+#include <exception>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <utility>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+#include "Utilities/Exception.hpp"
+
+using namespace std;
+namespace fs = boost::filesystem;
+
+// -----------------------------------------------------------------------
+// AsyncFileWriter
+// -----------------------------------------------------------------------
+AsyncFileWriter::AsyncFileWriter()
+    : busy_(false), quit_(false), failed_writes_(0) {
+}
+
+AsyncFileWriter::~AsyncFileWriter() {
+  {
+    boost::unique_lock<boost::mutex> lock(mutex_);
+    quit_ = true;
+  }
+  work_available_.notify_all();
+  if (thread_)
+    thread_->join();
+}
+
+// static
+AsyncFileWriter& AsyncFileWriter::Shared() {
+  static AsyncFileWriter writer;
+  return writer;
+}
+
+// static
+void AsyncFileWriter::ReplaceNow(const boost::filesystem::path& path,
+                                 const std::string& data) {
+  Job job;
+  job.mode = REPLACE;
+  job.path = path;
+  job.body = data;
+  performJob(job);
+}
+
+void AsyncFileWriter::write(const boost::filesystem::path& path,
+                            std::string header, std::string body,
+                            Callback done) {
+  enqueue(WRITE_COMPRESSED, path, std::move(header), std::move(body),
+          std::move(done));
+}
+
+void AsyncFileWriter::replace(const boost::filesystem::path& path,
+                              std::string data) {
+  enqueue(REPLACE, path, std::string(), std::move(data), Callback());
+}
+
+void AsyncFileWriter::append(const boost::filesystem::path& path,
+                             std::string data) {
+  enqueue(APPEND, path, std::string(), std::move(data), Callback());
+}
+
+void AsyncFileWriter::enqueue(Mode mode, const boost::filesystem::path& path,
+                              std::string header, std::string body,
+                              Callback done) {
+  {
+    boost::unique_lock<boost::mutex> lock(mutex_);
+    // Anything queued for |path| is about to be overwritten, unless we're
+    // adding to it.
+    if (mode != APPEND) {
+      for (std::deque<Job>::iterator it = jobs_.begin(); it != jobs_.end(); ) {
+        if (it->path == path && !it->done)
+          it = jobs_.erase(it);
+        else
+          ++it;
+      }
+    }
+
+    Job job;
+    job.mode = mode;
+    job.path = path;
+    job.header = std::move(header);
+    job.body = std::move(body);
+    job.done = std::move(done);
+    jobs_.push_back(std::move(job));
+
+    if (!thread_) {
+      thread_.reset(
+          new boost::thread(std::bind(&AsyncFileWriter::threadMain, this)));
+    }
+  }
+  work_available_.notify_one();
+}
+
+void AsyncFileWriter::flush() {
+  boost::unique_lock<boost::mutex> lock(mutex_);
+  while (!jobs_.empty() || busy_)
+    work_done_.wait(lock);
+}
+
+int AsyncFileWriter::failedWrites() {
+  boost::unique_lock<boost::mutex> lock(mutex_);
+  return failed_writes_;
+}
+
+void AsyncFileWriter::threadMain() {
+  boost::unique_lock<boost::mutex> lock(mutex_);
+  while (true) {
+    while (jobs_.empty() && !quit_)
+      work_available_.wait(lock);
+    // Drain the queue even when quitting; those are the user's saves.
+    if (jobs_.empty())
+      return;
+
+    Job job = std::move(jobs_.front());
+    jobs_.pop_front();
+    busy_ = true;
+    lock.unlock();
+
+    bool succeeded = true;
+    try {
+      performJob(job);
+    } catch (std::exception& e) {
+      cerr << "--- WARNING: ERROR DURING SAVING FILE: " << e.what() << " ---"
+           << endl;
+      succeeded = false;
+    }
+
+    if (job.done)
+      job.done(succeeded);
+
+    lock.lock();
+    busy_ = false;
+    if (!succeeded)
+      ++failed_writes_;
+    work_done_.notify_all();
+  }
+}
+
+// static
+void AsyncFileWriter::performJob(const Job& job) {
+  std::string compressed;
+  if (job.mode == WRITE_COMPRESSED) {
+    using namespace boost::iostreams;
+    filtering_stream<output> filtered_output;
+    filtered_output.push(zlib_compressor());
+    filtered_output.push(boost::iostreams::back_inserter(compressed));
+    filtered_output.write(job.body.data(), job.body.size());
+  }
+  const std::string& data =
+      job.mode == WRITE_COMPRESSED ? compressed : job.body;
+
+  // Appends go straight to the file; everything else is renamed into place.
+  fs::path tmp_path = job.path;
+  if (job.mode != APPEND)
+    tmp_path += ".tmp";
+
+  FILE* file = fopen(tmp_path.string().c_str(),
+                     job.mode == APPEND ? "ab" : "wb");
+  if (!file) {
+    ostringstream oss;
+    oss << "Could not open " << tmp_path << " for writing";
+    throw rlvm::Exception(oss.str());
+  }
+
+  bool ok =
+      fwrite(job.header.data(), 1, job.header.size(), file) ==
+          job.header.size() &&
+      fwrite(data.data(), 1, data.size(), file) == data.size() &&
+      fflush(file) == 0;
+#ifndef _WIN32
+  // Make sure the data is on disk before the rename makes it visible.
+  ok = ok && fsync(fileno(file)) == 0;
+#endif
+  ok = (fclose(file) == 0) && ok;
+
+  if (!ok) {
+    if (job.mode != APPEND) {
+      boost::system::error_code ec;
+      fs::remove(tmp_path, ec);
+    }
+
+    ostringstream oss;
+    oss << "Could not write " << job.path;
+    throw rlvm::Exception(oss.str());
+  }
+
+  if (job.mode != APPEND)
+    fs::rename(tmp_path, job.path);
+}
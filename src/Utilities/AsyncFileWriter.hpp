@@ -0,0 +1,130 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2013 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+// -----------------------------------------------------------------------
+
+#ifndef SRC_UTILITIES_ASYNCFILEWRITER_HPP_
+#define SRC_UTILITIES_ASYNCFILEWRITER_HPP_
+
+#include <boost/filesystem/path.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include <deque>
+#include <functional>
+#include <string>
+
+// Compresses and writes files on a background thread, so that saving the game
+// doesn't stall the game loop on zlib and the disk.
+//
+// Every file is written under a temporary name, synced, and then renamed over
+// the destination, so a crash or a full disk leaves either the old or the new
+// file in place, never a truncated one. The exception is append(), which can
+// leave a torn tail; its readers have to cope with that. Writes happen in the
+// order they were queued.
+class AsyncFileWriter {
+ public:
+  AsyncFileWriter();
+
+  // Finishes every queued write before returning.
+  ~AsyncFileWriter();
+
+  // Told whether a write succeeded. Called on the writer thread as soon as
+  // the write finishes, before the next queued write starts. Mustn't throw.
+  typedef std::function<void(bool)> Callback;
+
+  // The writer used for save games and global memory.
+  static AsyncFileWriter& Shared();
+
+  // Replaces |path| with |data| on the calling thread, the way replace() does
+  // on the writer thread. Lets a Callback write a file before the writes
+  // queued after its own.
+  //
+  // @exception Error Throws when the file can't be written.
+  static void ReplaceNow(const boost::filesystem::path& path,
+                         const std::string& data);
+
+  // Queues writing |header| followed by the zlib compressed |body| to |path|.
+  // A write to the same path that is still waiting in the queue is dropped,
+  // since it would be overwritten anyway, unless someone is waiting on its
+  // |done| callback.
+  void write(const boost::filesystem::path& path, std::string header,
+             std::string body, Callback done = Callback());
+
+  // Queues replacing |path| with the uncompressed |data|. Like write(), this
+  // drops any queued write to the same path.
+  void replace(const boost::filesystem::path& path, std::string data);
+
+  // Queues appending |data| to |path|, creating it if it doesn't exist.
+  void append(const boost::filesystem::path& path, std::string data);
+
+  // Blocks until every write queued so far is on disk (or has failed).
+  void flush();
+
+  // The number of writes that have failed so far. The reasons are printed
+  // to stderr, since there's nobody left to throw to.
+  int failedWrites();
+
+ private:
+  enum Mode {
+    WRITE_COMPRESSED,
+    REPLACE,
+    APPEND
+  };
+
+  struct Job {
+    Mode mode;
+    boost::filesystem::path path;
+    std::string header;
+    std::string body;
+    Callback done;
+  };
+
+  void enqueue(Mode mode, const boost::filesystem::path& path,
+               std::string header, std::string body, Callback done);
+
+  void threadMain();
+
+  // Compresses (if needed) and writes out |job|.
+  //
+  // @exception Error Throws when the file can't be written.
+  static void performJob(const Job& job);
+
+  boost::mutex mutex_;
+  boost::condition_variable work_available_;
+  boost::condition_variable work_done_;
+
+  // Guarded by |mutex_|.
+  std::deque<Job> jobs_;
+  bool busy_;
+  bool quit_;
+  int failed_writes_;
+
+  // Started with the first write.
+  boost::scoped_ptr<boost::thread> thread_;
+};  // class AsyncFileWriter
+
+#endif  // SRC_UTILITIES_ASYNCFILEWRITER_HPP_
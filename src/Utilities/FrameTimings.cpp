@@ -0,0 +1,213 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2013 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+// -----------------------------------------------------------------------
+
+#include "Utilities/FrameTimings.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <boost/filesystem/fstream.hpp>
+
+using std::endl;
+
+namespace {
+
+double milliseconds(FrameTimings::Clock::duration duration) {
+  return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+double microseconds(FrameTimings::Clock::duration duration) {
+  return std::chrono::duration<double, std::micro>(duration).count();
+}
+
+// Writes |str| as a JSON string.
+void writeJSONString(std::ostream& os, const char* str) {
+  os << '"';
+  for (; *str; ++str) {
+    if (*str == '"' || *str == '\\')
+      os << '\\';
+    os << *str;
+  }
+  os << '"';
+}
+
+}  // namespace
+
+// -----------------------------------------------------------------------
+// FrameTimings
+// -----------------------------------------------------------------------
+const size_t FrameTimings::kWindowSize;
+const size_t FrameTimings::kMaxTraceEvents;
+
+FrameTimings::FrameTimings()
+    : enabled_(false), epoch_(Clock::now()) {
+}
+
+FrameTimings::~FrameTimings() {}
+
+// static
+FrameTimings& FrameTimings::Shared() {
+  static FrameTimings timings;
+  return timings;
+}
+
+void FrameTimings::enable(const boost::filesystem::path& trace_path) {
+  boost::mutex::scoped_lock lock(mutex_);
+  trace_path_ = trace_path;
+  epoch_ = Clock::now();
+  enabled_ = true;
+}
+
+void FrameTimings::record(const char* name, Clock::time_point start,
+                          Clock::time_point end) {
+  boost::mutex::scoped_lock lock(mutex_);
+  if (!enabled_)
+    return;
+
+  Window& window = windows_[name];
+  if (window.durations.size() < kWindowSize) {
+    window.durations.push_back(end - start);
+  } else {
+    window.durations[window.next] = end - start;
+    window.next = (window.next + 1) % kWindowSize;
+  }
+
+  if (!trace_path_.empty() && events_.size() < kMaxTraceEvents) {
+    Event event = { name, start, end - start, threadNumber() };
+    events_.push_back(event);
+  }
+}
+
+FrameTimings::Percentiles FrameTimings::percentiles(const char* name) const {
+  Percentiles result;
+
+  std::vector<Clock::duration> durations;
+  {
+    boost::mutex::scoped_lock lock(mutex_);
+    std::map<const char*, Window, NameLess>::const_iterator it =
+        windows_.find(name);
+    if (it == windows_.end())
+      return result;
+    durations = it->second.durations;
+  }
+
+  if (durations.empty())
+    return result;
+
+  std::sort(durations.begin(), durations.end());
+  size_t last = durations.size() - 1;
+  result.samples = durations.size();
+  result.p50_ms = milliseconds(durations[last * 50 / 100]);
+  result.p90_ms = milliseconds(durations[last * 90 / 100]);
+  result.p99_ms = milliseconds(durations[last * 99 / 100]);
+  return result;
+}
+
+void FrameTimings::printSummary(std::ostream& os) const {
+  std::vector<const char*> names;
+  {
+    boost::mutex::scoped_lock lock(mutex_);
+    for (auto const& window : windows_)
+      names.push_back(window.first);
+  }
+
+  std::ios::fmtflags flags = os.flags();
+  std::streamsize precision = os.precision();
+
+  os << std::left << std::setw(24) << "Section" << std::right
+     << std::setw(10) << "p50 ms" << std::setw(10) << "p90 ms"
+     << std::setw(10) << "p99 ms" << endl;
+  os << std::fixed << std::setprecision(3);
+  for (const char* name : names) {
+    Percentiles p = percentiles(name);
+    os << std::left << std::setw(24) << name << std::right
+       << std::setw(10) << p.p50_ms << std::setw(10) << p.p90_ms
+       << std::setw(10) << p.p99_ms << endl;
+  }
+
+  os.flags(flags);
+  os.precision(precision);
+}
+
+void FrameTimings::writeTrace(std::ostream& os) const {
+  boost::mutex::scoped_lock lock(mutex_);
+
+  std::ios::fmtflags flags = os.flags();
+  std::streamsize precision = os.precision();
+  os << std::fixed << std::setprecision(3);
+
+  // Complete ("X") events, with timestamps in microseconds.
+  os << "{\"traceEvents\":[";
+  for (size_t i = 0; i < events_.size(); ++i) {
+    const Event& event = events_[i];
+    os << (i ? ",\n" : "\n") << "{\"name\":";
+    writeJSONString(os, event.name);
+    os << ",\"cat\":\"rlvm\",\"ph\":\"X\",\"ts\":"
+       << microseconds(event.start - epoch_)
+       << ",\"dur\":" << microseconds(event.duration)
+       << ",\"pid\":1,\"tid\":" << event.thread << "}";
+  }
+  os << "\n],\"displayTimeUnit\":\"ms\"}" << endl;
+
+  os.flags(flags);
+  os.precision(precision);
+}
+
+void FrameTimings::finish() {
+  if (!enabled_)
+    return;
+  enabled_ = false;
+
+  std::cerr << "Frame timings over the last " << kWindowSize
+            << " samples of each section:" << endl;
+  printSummary(std::cerr);
+
+  boost::filesystem::path trace_path;
+  {
+    boost::mutex::scoped_lock lock(mutex_);
+    trace_path = trace_path_;
+  }
+  if (trace_path.empty())
+    return;
+
+  boost::filesystem::ofstream file(trace_path);
+  if (!file) {
+    std::cerr << "Could not write trace file " << trace_path << endl;
+    return;
+  }
+  writeTrace(file);
+}
+
+int FrameTimings::threadNumber() {
+  std::map<boost::thread::id, int>::const_iterator it =
+      threads_.find(boost::this_thread::get_id());
+  if (it != threads_.end())
+    return it->second;
+
+  int number = threads_.size() + 1;
+  threads_[boost::this_thread::get_id()] = number;
+  return number;
+}
@@ -0,0 +1,160 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2013 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+// -----------------------------------------------------------------------
+
+#ifndef SRC_UTILITIES_FRAMETIMINGS_HPP_
+#define SRC_UTILITIES_FRAMETIMINGS_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iosfwd>
+#include <map>
+#include <string>
+#include <vector>
+#include <boost/filesystem/path.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
+// Collects how long the named sections of each frame take (running each
+// subsystem, drawing, decoding images, uploading textures). Every section
+// keeps a window of its most recent durations for percentiles, and can also
+// be kept as a list of events for a Chrome trace file (load it in
+// chrome://tracing).
+//
+// Recording is off until enable() is called, and while it is off a
+// ScopedTimer costs a single load. Sections may be recorded from any thread.
+class FrameTimings {
+ public:
+  typedef std::chrono::steady_clock Clock;
+
+  struct Percentiles {
+    Percentiles() : samples(0), p50_ms(0), p90_ms(0), p99_ms(0) {}
+
+    size_t samples;
+    double p50_ms;
+    double p90_ms;
+    double p99_ms;
+  };
+
+  FrameTimings();
+  ~FrameTimings();
+
+  // The instance ScopedTimers report to.
+  static FrameTimings& Shared();
+
+  // Starts recording. When |trace_path| isn't empty, every section is also
+  // kept as a trace event, and finish() writes them there.
+  void enable(const boost::filesystem::path& trace_path);
+  bool enabled() const { return enabled_; }
+
+  // Records that section |name| ran from |start| to |end|. |name| must
+  // outlive this object; it's meant to be a string literal.
+  void record(const char* name, Clock::time_point start,
+              Clock::time_point end);
+
+  // Percentiles over the last kWindowSize durations of |name|.
+  Percentiles percentiles(const char* name) const;
+
+  // Writes every section's percentiles, one per line.
+  void printSummary(std::ostream& os) const;
+
+  // Writes the recorded events as Chrome trace JSON.
+  void writeTrace(std::ostream& os) const;
+
+  // Stops recording, prints the summary to stderr and writes the trace file,
+  // if there is one.
+  void finish();
+
+  // The number of durations each section remembers.
+  static const size_t kWindowSize = 512;
+
+  // Trace events beyond this many are dropped, so that a long session
+  // doesn't grow without bound.
+  static const size_t kMaxTraceEvents = 2000000;
+
+ private:
+  struct NameLess {
+    bool operator()(const char* lhs, const char* rhs) const {
+      return strcmp(lhs, rhs) < 0;
+    }
+  };
+
+  // The most recent durations of one section, in a ring.
+  struct Window {
+    Window() : next(0) {}
+
+    std::vector<Clock::duration> durations;
+    size_t next;
+  };
+
+  struct Event {
+    const char* name;
+    Clock::time_point start;
+    Clock::duration duration;
+    int thread;
+  };
+
+  // Returns a small number for the calling thread. Must be called with
+  // |mutex_| held.
+  int threadNumber();
+
+  std::atomic<bool> enabled_;
+
+  mutable boost::mutex mutex_;
+
+  // Everything below is guarded by |mutex_|.
+  std::map<const char*, Window, NameLess> windows_;
+  boost::filesystem::path trace_path_;
+  std::vector<Event> events_;
+  std::map<boost::thread::id, int> threads_;
+  Clock::time_point epoch_;
+};  // class FrameTimings
+
+// Records the lifetime of the enclosing scope as section |name| of
+// FrameTimings::Shared().
+class ScopedTimer {
+ public:
+  explicit ScopedTimer(const char* name)
+      : name_(name),
+        enabled_(FrameTimings::Shared().enabled()) {
+    if (enabled_)
+      start_ = FrameTimings::Clock::now();
+  }
+
+  ~ScopedTimer() {
+    if (enabled_) {
+      FrameTimings::Shared().record(name_, start_,
+                                    FrameTimings::Clock::now());
+    }
+  }
+
+ private:
+  const char* name_;
+  bool enabled_;
+  FrameTimings::Clock::time_point start_;
+};  // class ScopedTimer
+
+#endif  // SRC_UTILITIES_FRAMETIMINGS_HPP_
@@ -0,0 +1,101 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2013 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+// -----------------------------------------------------------------------
+
+#ifndef SRC_UTILITIES_SPSCQUEUE_HPP_
+#define SRC_UTILITIES_SPSCQUEUE_HPP_
+
+#include <atomic>
+#include <cstddef>
+
+// A fixed size, lock-free ring buffer for passing values from exactly one
+// producer thread to exactly one consumer thread. Neither side ever blocks;
+// push() fails when the ring is full and pop() fails when it is empty.
+//
+// One slot is always left empty to tell a full ring from an empty one, so the
+// ring holds |Capacity| - 1 items. |Capacity| must be a power of two.
+template<typename T, size_t Capacity>
+class SPSCQueue {
+ public:
+  SPSCQueue() : head_(0), tail_(0) {}
+
+  // Producer side. Copies |item| into the ring, returning false if full.
+  bool push(const T& item) {
+    size_t head = head_.load(std::memory_order_relaxed);
+    size_t next = (head + 1) & MASK;
+    if (next == tail_.load(std::memory_order_acquire))
+      return false;
+
+    slots_[head] = item;
+    head_.store(next, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer side. Moves the oldest item into |out|, returning false if the
+  // ring is empty. The slot is reset so the ring doesn't keep a reference to
+  // anything it has handed out.
+  bool pop(T* out) {
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail == head_.load(std::memory_order_acquire))
+      return false;
+
+    *out = slots_[tail];
+    slots_[tail] = T();
+    tail_.store((tail + 1) & MASK, std::memory_order_release);
+    return true;
+  }
+
+  // Either side may call these, though the answer can be stale by the time
+  // the caller acts on it.
+  bool empty() const {
+    return head_.load(std::memory_order_acquire) ==
+        tail_.load(std::memory_order_acquire);
+  }
+
+  // Free slots from the producer's point of view.
+  size_t freeSlots() const {
+    size_t used = (head_.load(std::memory_order_acquire) -
+                   tail_.load(std::memory_order_acquire)) & MASK;
+    return Capacity - 1 - used;
+  }
+
+  static size_t capacity() { return Capacity - 1; }
+
+ private:
+  static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+                "SPSCQueue capacity must be a power of two");
+  static const size_t MASK = Capacity - 1;
+
+  T slots_[Capacity];
+
+  // Index of the next slot to write; only the producer stores to it. The two
+  // indexes live on separate cache lines so the threads don't false share.
+  alignas(64) std::atomic<size_t> head_;
+
+  // Index of the next slot to read; only the consumer stores to it.
+  alignas(64) std::atomic<size_t> tail_;
+};  // class SPSCQueue
+
+#endif  // SRC_UTILITIES_SPSCQUEUE_HPP_
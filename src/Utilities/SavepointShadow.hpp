@@ -0,0 +1,102 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2013 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+// -----------------------------------------------------------------------
+
+#ifndef SRC_UTILITIES_SAVEPOINTSHADOW_HPP_
+#define SRC_UTILITIES_SAVEPOINTSHADOW_HPP_
+
+#include <map>
+#include <utility>
+
+// Remembers what the elements of some container looked like at the last
+// savepoint, without copying the container when the savepoint is marked.
+//
+// Instead, the owner calls recordOriginal() before it changes an element, and
+// the first such call after a savepoint copies the old value. Marking a
+// savepoint only bumps a generation number; originals from earlier
+// generations are stale and get overwritten the next time their element
+// changes. The state at the savepoint is the current state with every
+// original from forEachOriginal() put back.
+template<typename Key, typename Value>
+class SavepointShadow {
+ public:
+  SavepointShadow() : generation_(0) {}
+
+  // Starts a new savepoint at the current state. O(1).
+  void mark() { ++generation_; }
+
+  // Forgets everything, as if nothing had changed since the savepoint.
+  void clear() { entries_.clear(); }
+
+  // Whether |key| has changed since the savepoint.
+  bool hasOriginal(const Key& key) const {
+    typename EntryMap::const_iterator it = entries_.find(key);
+    return it != entries_.end() && it->second.first == generation_;
+  }
+
+  // Remembers |value| as |key|'s value at the savepoint, unless |key| has
+  // already changed since then. Call right before changing |key|.
+  void recordOriginal(const Key& key, const Value& value) {
+    typename EntryMap::iterator it = entries_.lower_bound(key);
+    if (it != entries_.end() && it->first == key) {
+      if (it->second.first != generation_)
+        it->second = std::make_pair(generation_, value);
+    } else {
+      entries_.insert(it, std::make_pair(key,
+                                         std::make_pair(generation_, value)));
+    }
+  }
+
+  // Calls |function| with each key that changed since the savepoint and its
+  // value back then.
+  template<typename Function>
+  void forEachOriginal(Function function) const {
+    for (typename EntryMap::const_iterator it = entries_.begin();
+         it != entries_.end(); ++it) {
+      if (it->second.first == generation_)
+        function(it->first, it->second.second);
+    }
+  }
+
+  // Calls |function| with every value held, including stale originals from
+  // earlier savepoints that haven't been overwritten yet. Used to count the
+  // memory the shadow keeps alive.
+  template<typename Function>
+  void forEachStoredValue(Function function) const {
+    for (typename EntryMap::const_iterator it = entries_.begin();
+         it != entries_.end(); ++it)
+      function(it->second.second);
+  }
+
+ private:
+  // Maps a key to the generation it was recorded in, and its original value.
+  typedef std::map<Key, std::pair<unsigned int, Value> > EntryMap;
+  EntryMap entries_;
+
+  unsigned int generation_;
+};  // class SavepointShadow
+
+#endif  // SRC_UTILITIES_SAVEPOINTSHADOW_HPP_
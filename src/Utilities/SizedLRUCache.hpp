@@ -0,0 +1,147 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2013 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+// -----------------------------------------------------------------------
+
+#ifndef SRC_UTILITIES_SIZEDLRUCACHE_HPP_
+#define SRC_UTILITIES_SIZEDLRUCACHE_HPP_
+
+#include <cstddef>
+#include <list>
+#include <map>
+#include <utility>
+
+// An LRU cache like the one in vendor/lru_cache.hpp, except that it is
+// bounded by the sum of the byte sizes its callers report on insertion instead
+// of by a count of entries. Keeps hit/miss/eviction counters so callers can
+// report how well the cache is doing.
+//
+// The most recently inserted entry is never evicted, even if it alone is
+// larger than the ceiling; otherwise a single huge item would thrash.
+template<typename Key, typename Data>
+class SizedLRUCache {
+ public:
+  struct Stats {
+    Stats() : hits(0), misses(0), insertions(0), evictions(0) {}
+
+    unsigned long hits;
+    unsigned long misses;
+    unsigned long insertions;
+    unsigned long evictions;
+  };
+
+  explicit SizedLRUCache(size_t max_bytes)
+      : max_bytes_(max_bytes), current_bytes_(0) {}
+
+  // Returns the item at |key| and marks it as most recently used, or returns
+  // a default constructed Data if we don't have it.
+  Data fetch(const Key& key) {
+    typename Map::iterator it = index_.find(key);
+    if (it == index_.end()) {
+      stats_.misses++;
+      return Data();
+    }
+
+    stats_.hits++;
+    list_.splice(list_.begin(), list_, it->second);
+    return it->second->data;
+  }
+
+  bool exists(const Key& key) const {
+    return index_.find(key) != index_.end();
+  }
+
+  // Inserts |data| which is accounted as taking |bytes|, replacing anything
+  // already at |key|, and then evicts the least recently used entries until
+  // we're back under the ceiling.
+  void insert(const Key& key, const Data& data, size_t bytes) {
+    remove(key);
+
+    list_.push_front(Node(key, data, bytes));
+    index_.insert(std::make_pair(key, list_.begin()));
+    current_bytes_ += bytes;
+    stats_.insertions++;
+
+    trim();
+  }
+
+  void remove(const Key& key) {
+    typename Map::iterator it = index_.find(key);
+    if (it != index_.end())
+      erase(it);
+  }
+
+  void clear() {
+    list_.clear();
+    index_.clear();
+    current_bytes_ = 0;
+  }
+
+  // Changes the ceiling, evicting entries if we're now over it.
+  void set_max_bytes(size_t max_bytes) {
+    max_bytes_ = max_bytes;
+    trim();
+  }
+
+  size_t max_bytes() const { return max_bytes_; }
+  size_t current_bytes() const { return current_bytes_; }
+  size_t size() const { return list_.size(); }
+  const Stats& stats() const { return stats_; }
+
+ private:
+  struct Node {
+    Node(const Key& in_key, const Data& in_data, size_t in_bytes)
+        : key(in_key), data(in_data), bytes(in_bytes) {}
+
+    Key key;
+    Data data;
+    size_t bytes;
+  };
+
+  typedef std::list<Node> List;
+  typedef std::map<Key, typename List::iterator> Map;
+
+  void erase(typename Map::iterator it) {
+    current_bytes_ -= it->second->bytes;
+    list_.erase(it->second);
+    index_.erase(it);
+  }
+
+  void trim() {
+    while (current_bytes_ > max_bytes_ && list_.size() > 1) {
+      erase(index_.find(list_.back().key));
+      stats_.evictions++;
+    }
+  }
+
+  size_t max_bytes_;
+  size_t current_bytes_;
+
+  List list_;
+  Map index_;
+
+  Stats stats_;
+};  // class SizedLRUCache
+
+#endif  // SRC_UTILITIES_SIZEDLRUCACHE_HPP_
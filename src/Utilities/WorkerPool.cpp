@@ -0,0 +1,150 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2013 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+// -----------------------------------------------------------------------
+
+#include "Utilities/WorkerPool.hpp"
+
+#include <algorithm>
+
+namespace {
+
+// Whether this thread is running a job for any WorkerPool: it's a worker, or
+// a caller inside parallelFor(). Nested parallelFor() calls run inline.
+thread_local bool s_inside_pool = false;
+
+class ScopedInsidePool {
+ public:
+  ScopedInsidePool() : was_inside_(s_inside_pool) { s_inside_pool = true; }
+  ~ScopedInsidePool() { s_inside_pool = was_inside_; }
+
+ private:
+  bool was_inside_;
+};
+
+}  // namespace
+
+// -----------------------------------------------------------------------
+// WorkerPool
+// -----------------------------------------------------------------------
+WorkerPool::WorkerPool(int threads)
+    : thread_count_(threads), job_(NULL), next_index_(0), job_size_(0),
+      remaining_(0), generation_(0), quit_(false) {
+  for (int i = 0; i < threads; ++i)
+    threads_.create_thread(std::bind(&WorkerPool::workerLoop, this));
+}
+
+WorkerPool::~WorkerPool() {
+  {
+    boost::unique_lock<boost::mutex> lock(mutex_);
+    quit_ = true;
+  }
+  work_available_.notify_all();
+  threads_.join_all();
+}
+
+// static
+WorkerPool& WorkerPool::Shared() {
+  static WorkerPool pool(
+      std::max(0, static_cast<int>(boost::thread::hardware_concurrency()) - 1));
+  return pool;
+}
+
+void WorkerPool::parallelFor(int count, const std::function<void(int)>& fn) {
+  if (count <= 0)
+    return;
+
+  if (thread_count_ == 0 || count == 1 || s_inside_pool) {
+    for (int i = 0; i < count; ++i)
+      fn(i);
+    return;
+  }
+
+  ScopedInsidePool inside_pool;
+  boost::unique_lock<boost::mutex> call_lock(call_mutex_);
+  boost::unique_lock<boost::mutex> lock(mutex_);
+  job_ = &fn;
+  next_index_ = 0;
+  job_size_ = count;
+  remaining_ = count;
+  exception_ = std::exception_ptr();
+  generation_++;
+  work_available_.notify_all();
+
+  runIndices(lock);
+  while (remaining_ > 0)
+    work_done_.wait(lock);
+
+  job_ = NULL;
+  if (exception_) {
+    std::exception_ptr exception = exception_;
+    exception_ = std::exception_ptr();
+    std::rethrow_exception(exception);
+  }
+}
+
+void WorkerPool::workerLoop() {
+  ScopedInsidePool inside_pool;
+  unsigned int seen_generation = 0;
+  boost::unique_lock<boost::mutex> lock(mutex_);
+  while (true) {
+    while (!quit_ && generation_ == seen_generation)
+      work_available_.wait(lock);
+    if (quit_)
+      return;
+
+    seen_generation = generation_;
+    runIndices(lock);
+  }
+}
+
+void WorkerPool::runIndices(boost::unique_lock<boost::mutex>& lock) {
+  while (next_index_ < job_size_) {
+    int index = next_index_++;
+    const std::function<void(int)>* job = job_;
+
+    // |job| stays alive until |remaining_| hits zero, which can't happen
+    // before we're done with |index|.
+    std::exception_ptr exception;
+    lock.unlock();
+    try {
+      (*job)(index);
+    } catch (...) {
+      exception = std::current_exception();
+    }
+    lock.lock();
+
+    if (exception) {
+      if (!exception_)
+        exception_ = exception;
+
+      // Give up on the indices nobody has started.
+      remaining_ -= job_size_ - next_index_;
+      next_index_ = job_size_;
+    }
+
+    if (--remaining_ == 0)
+      work_done_.notify_all();
+  }
+}
@@ -0,0 +1,91 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2013 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+// -----------------------------------------------------------------------
+
+#ifndef SRC_UTILITIES_WORKERPOOL_HPP_
+#define SRC_UTILITIES_WORKERPOOL_HPP_
+
+#include <exception>
+#include <functional>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
+// A fixed set of threads for splitting up CPU heavy loops. parallelFor()
+// runs a function once for every index and blocks until all of them are done;
+// the calling thread works through indices alongside the pool.
+class WorkerPool {
+ public:
+  // Starts |threads| workers. With zero, parallelFor() just runs everything
+  // on the caller.
+  explicit WorkerPool(int threads);
+  ~WorkerPool();
+
+  // The pool shared by everything in the process, with one worker for every
+  // core but the caller's.
+  static WorkerPool& Shared();
+
+  int threadCount() const { return thread_count_; }
+
+  // Calls |fn| with every index in [0, count). Only one parallelFor() runs
+  // at a time; other callers wait their turn.
+  //
+  // A parallelFor() made from inside |fn| (on the caller or on a worker) runs
+  // all its indices inline on that thread, since waiting for the pool there
+  // would deadlock.
+  //
+  // If |fn| throws, indices that haven't started yet are skipped, the call
+  // waits for the ones already running, and then rethrows the first
+  // exception on the caller.
+  void parallelFor(int count, const std::function<void(int)>& fn);
+
+ private:
+  void workerLoop();
+
+  // Runs indices of the current job until there are none left. Must be
+  // called with |mutex_| held through |lock|.
+  void runIndices(boost::unique_lock<boost::mutex>& lock);
+
+  boost::thread_group threads_;
+  int thread_count_;
+
+  // Serializes parallelFor() callers.
+  boost::mutex call_mutex_;
+
+  boost::mutex mutex_;
+  boost::condition_variable work_available_;
+  boost::condition_variable work_done_;
+
+  // The current job. Guarded by |mutex_|.
+  const std::function<void(int)>* job_;
+  int next_index_;
+  int job_size_;
+  int remaining_;
+  std::exception_ptr exception_;
+  unsigned int generation_;
+  bool quit_;
+};  // class WorkerPool
+
+#endif  // SRC_UTILITIES_WORKERPOOL_HPP_
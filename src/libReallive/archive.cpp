@@ -142,6 +142,27 @@ int Archive::getProbableEncodingType() const {
   return 0;
 }
 
+size_t
+Archive::mappedBytes() const {
+  size_t bytes = info.size();
+  for (boost::ptr_vector<Mapping>::const_iterator it = maps_to_delete_.begin();
+       it != maps_to_delete_.end(); ++it)
+    bytes += it->size();
+  return bytes;
+}
+
+size_t
+Archive::parsedScenarioBytes() const {
+  size_t bytes = 0;
+  for (accessed_t::const_iterator it = accessed.begin(); it != accessed.end();
+       ++it) {
+    for (Scenario::const_iterator elt = it->second->begin();
+         elt != it->second->end(); ++elt)
+      bytes += elt->length();
+  }
+  return bytes;
+}
+
 void
 Archive::reset() {
 	for (accessed_t::iterator it = accessed.begin(); it != accessed.end(); ++it) delete it->second;
@@ -104,6 +104,12 @@ public:
   int getProbableEncodingType() const;
 
   void reset();
+
+  // Memory accounting. The bytes of SEEN.TXT and any override files mapped
+  // into memory, and the number and bytecode size of scenarios parsed so far.
+  size_t mappedBytes() const;
+  int parsedScenarioCount() const { return accessed.size(); }
+  size_t parsedScenarioBytes() const;
 };
 
 }
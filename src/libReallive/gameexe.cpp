@@ -113,12 +113,28 @@ public:
 
 // -----------------------------------------------------------------------
 
-Gameexe::Gameexe() {}
+GameexeKey::GameexeKey()
+  : gameexe_(NULL), generation_(0) {}
+
+// -----------------------------------------------------------------------
+
+GameexeKey::GameexeKey(const std::string& key)
+  : key_(key), gameexe_(NULL), generation_(0) {}
+
+// -----------------------------------------------------------------------
+
+GameexeKey::~GameexeKey() {}
+
+// -----------------------------------------------------------------------
+// Gameexe
+// -----------------------------------------------------------------------
+
+Gameexe::Gameexe() : generation_(1) {}
 
 // -----------------------------------------------------------------------
 
 Gameexe::Gameexe(const fs::path& gameexefile)
-  : data_(), cdata_() {
+  : data_(), cdata_(), generation_(1) {
   fs::ifstream ifs(gameexefile);
   if (!ifs) {
     ostringstream oss;
@@ -132,6 +148,25 @@ Gameexe::Gameexe(const fs::path& gameexefile)
   }
 }
 
+Gameexe::Gameexe(const Gameexe& other)
+  : data_(other.data_), cdata_(other.cdata_), generation_(1) {
+  rebuildIndex();
+}
+
+// -----------------------------------------------------------------------
+
+Gameexe& Gameexe::operator=(const Gameexe& other) {
+  if (this != &other) {
+    data_ = other.data_;
+    cdata_ = other.cdata_;
+    rebuildIndex();
+    generation_++;
+  }
+  return *this;
+}
+
+// -----------------------------------------------------------------------
+
 Gameexe::~Gameexe() {
 }
 
@@ -170,7 +205,9 @@ void Gameexe::parseLine(const std::string& line) {
         }
       }
     }
-    data_.insert(make_pair(key, vec));
+    GameexeData_t::iterator it = data_.insert(make_pair(key, vec));
+    if (index_.insert(make_pair(key, it)).second)
+      generation_++;
   }
 }
 
@@ -197,7 +234,13 @@ int Gameexe::getIntAt(GameexeData_t::const_iterator key, int index) {
 // -----------------------------------------------------------------------
 
 bool Gameexe::exists(const std::string& key) {
-  return data_.find(key) != data_.end();
+  return index_.find(key) != index_.end();
+}
+
+// -----------------------------------------------------------------------
+
+bool Gameexe::exists(const GameexeKey& key) {
+  return resolve(key) != data_.end();
 }
 
 // -----------------------------------------------------------------------
@@ -213,8 +256,7 @@ void Gameexe::setStringAt(const std::string& key, const std::string& value) {
   Gameexe_vec_type toStore;
   cdata_.push_back(value);
   toStore.push_back(cdata_.size() - 1);
-  data_.erase(key);
-  data_.insert(make_pair(key, toStore));
+  setValue(key, toStore);
 }
 
 // -----------------------------------------------------------------------
@@ -222,14 +264,66 @@ void Gameexe::setStringAt(const std::string& key, const std::string& value) {
 void Gameexe::setIntAt(const std::string& key, const int value) {
   Gameexe_vec_type toStore;
   toStore.push_back(value);
-  data_.erase(key);
-  data_.insert(make_pair(key, toStore));
+  setValue(key, toStore);
+}
+
+// -----------------------------------------------------------------------
+
+GameexeInterpretObject Gameexe::operator()(const GameexeKey& key) {
+  return GameexeInterpretObject(key.key_, resolve(key), *this);
 }
 
 // -----------------------------------------------------------------------
 
 GameexeData_t::const_iterator Gameexe::find(const std::string& key) {
-  return data_.find(key);
+  GameexeIndex_t::const_iterator it = index_.find(key);
+  if (it == index_.end())
+    return data_.end();
+
+  return it->second;
+}
+
+// -----------------------------------------------------------------------
+
+GameexeData_t::const_iterator Gameexe::resolve(const GameexeKey& key) {
+  if (key.gameexe_ != this || key.generation_ != generation_) {
+    key.iterator_ = find(key.key_);
+    key.gameexe_ = this;
+    key.generation_ = generation_;
+  }
+
+  return key.iterator_;
+}
+
+// -----------------------------------------------------------------------
+
+void Gameexe::setValue(const std::string& key, const Gameexe_vec_type& value) {
+  GameexeIndex_t::iterator it = index_.find(key);
+  if (it == index_.end()) {
+    index_.insert(make_pair(key, data_.insert(make_pair(key, value))));
+    generation_++;
+    return;
+  }
+
+  // Overwrite the first row and drop any duplicates.
+  GameexeData_t::iterator first = it->second;
+  first->second = value;
+  std::pair<GameexeData_t::iterator, GameexeData_t::iterator> range =
+      data_.equal_range(key);
+  for (GameexeData_t::iterator row = range.first; row != range.second; ) {
+    if (row == first)
+      ++row;
+    else
+      data_.erase(row++);
+  }
+}
+
+// -----------------------------------------------------------------------
+
+void Gameexe::rebuildIndex() {
+  index_.clear();
+  for (GameexeData_t::iterator it = data_.begin(); it != data_.end(); ++it)
+    index_.insert(make_pair(it->first, it));
 }
 
 // -----------------------------------------------------------------------
@@ -42,6 +42,7 @@
 #include <boost/filesystem/path.hpp>
 
 #include <map>
+#include <unordered_map>
 
 class Gameexe;
 class GameexeFilteringIterator;
@@ -49,10 +50,49 @@ class GameexeFilteringIterator;
 // -----------------------------------------------------------------------
 
 /**
- * Storage backend for the Gameexe
+ * Storage backend for the Gameexe. Keys are kept in order for
+ * GameexeFilteringIterator, and indexed by a hash table for lookup.
  */
 typedef std::vector<int> Gameexe_vec_type;
 typedef std::multimap<std::string, Gameexe_vec_type> GameexeData_t;
+typedef std::unordered_map<std::string, GameexeData_t::iterator>
+    GameexeIndex_t;
+
+// -----------------------------------------------------------------------
+
+/**
+ * A key into the Gameexe that has been formatted and looked up ahead of
+ * time. Subsystems build these with Gameexe::key() when they are
+ * constructed and pass them to Gameexe::operator() on hot paths, which
+ * skips formatting the key and, unless a key has been added to the
+ * Gameexe since, looking it up.
+ *
+ * @code
+ * GameexeKey message_key = gameexe.key("SAVEPOINT_MESSAGE");
+ * ...
+ * int value = gameexe(message_key).to_int(1);
+ * @endcode
+ */
+class GameexeKey {
+ public:
+  GameexeKey();
+  ~GameexeKey();
+
+  const std::string& key() const { return key_; }
+
+ private:
+  friend class Gameexe;
+
+  explicit GameexeKey(const std::string& key);
+
+  std::string key_;
+
+  // The result of the last lookup of |key_|, which is valid as long as it
+  // was done on |gameexe_| at its current generation.
+  mutable const Gameexe* gameexe_;
+  mutable unsigned int generation_;
+  mutable GameexeData_t::const_iterator iterator_;
+};
 
 // -----------------------------------------------------------------------
 
@@ -214,6 +254,9 @@ class Gameexe {
    */
   Gameexe(const boost::filesystem::path& filename);
 
+  Gameexe(const Gameexe& other);
+  Gameexe& operator=(const Gameexe& other);
+
   /**
    * Destructor
    */
@@ -248,6 +291,26 @@ class Gameexe {
   GameexeInterpretObject operator()(const A& firstKey, const B& secondKey,
                                     const C& thirdKey);
 
+  /**
+   * Access a precompiled key.
+   */
+  GameexeInterpretObject operator()(const GameexeKey& key);
+
+  /**
+   * @name Precompiled keys
+   *
+   * Format a key the same way operator() does, for later use with
+   * operator()(const GameexeKey&).
+   */
+  template<typename A>
+  GameexeKey key(const A& firstKey);
+
+  template<typename A, typename B>
+  GameexeKey key(const A& firstKey, const B& secondKey);
+
+  template<typename A, typename B, typename C>
+  GameexeKey key(const A& firstKey, const B& secondKey, const C& thirdKey);
+
   /**
    * @name Iterated interface for keys
    *
@@ -277,6 +340,7 @@ class Gameexe {
    * Returns whether key exists in the stored data
    */
   bool exists(const std::string& key);
+  bool exists(const GameexeKey& key);
 
   /**
    * Returns the number of keys in the Gameexe.ini file.
@@ -301,6 +365,20 @@ class Gameexe {
    */
   GameexeData_t::const_iterator find(const std::string& key);
 
+  /**
+   * Returns the iterator for a precompiled key, looking it up again only
+   * if keys have been added since it was last resolved.
+   */
+  GameexeData_t::const_iterator resolve(const GameexeKey& key);
+
+  /**
+   * Gives |key| exactly one row, |value|. Rows that already exist are
+   * updated in place so that resolved keys stay valid.
+   */
+  void setValue(const std::string& key, const Gameexe_vec_type& value);
+
+  void rebuildIndex();
+
   /**
    * Regrettable artifact of hack to get all integers in streams to
    * have setw(3).
@@ -330,6 +408,13 @@ class Gameexe {
    */
   GameexeData_t data_;
   std::vector<std::string> cdata_;
+
+  // The first row for each key in |data_|.
+  GameexeIndex_t index_;
+
+  // Incremented whenever a key is added, which is the only change that can
+  // alter the result of looking up a key.
+  unsigned int generation_;
 };
 
 // -----------------------------------------------------------------------
@@ -380,6 +465,31 @@ GameexeInterpretObject Gameexe::operator()(
 
 // -----------------------------------------------------------------------
 
+template<typename A>
+GameexeKey Gameexe::key(const A& firstKey)
+{
+  return GameexeKey((*this)(firstKey).key());
+}
+
+// -----------------------------------------------------------------------
+
+template<typename A, typename B>
+GameexeKey Gameexe::key(const A& firstKey, const B& secondKey)
+{
+  return GameexeKey((*this)(firstKey, secondKey).key());
+}
+
+// -----------------------------------------------------------------------
+
+template<typename A, typename B, typename C>
+GameexeKey Gameexe::key(const A& firstKey, const B& secondKey,
+                        const C& thirdKey)
+{
+  return GameexeKey((*this)(firstKey, secondKey, thirdKey).key());
+}
+
+// -----------------------------------------------------------------------
+
 class GameexeFilteringIterator
   : public boost::iterator_facade<
   GameexeFilteringIterator,
@@ -78,6 +78,16 @@ bool TestTextWindow::character(const std::string& current,
   return ret;
 }
 
+void TestTextWindow::drawPlacedGlyphs(const std::vector<PlacedGlyph>& glyphs) {
+  TextWindow::drawPlacedGlyphs(glyphs);
+  for (std::vector<PlacedGlyph>::const_iterator it = glyphs.begin();
+       it != glyphs.end(); ++it) {
+    if (it->starts_line)
+      current_contents_ += "\n";
+    current_contents_ += it->text;
+  }
+}
+
 void TestTextWindow::setName(const std::string& utf8name,
                              const std::string& next_char) {
   TextWindow::setName(utf8name, next_char);
@@ -51,6 +51,9 @@ class TestTextWindow : public TextWindow {
 
   virtual void hardBrake();
 
+  // Mirrors character() so replayed pages show up in currentContents().
+  virtual void drawPlacedGlyphs(const std::vector<PlacedGlyph>& glyphs);
+
   // To implement for real, instead of just recording in the mocklog.
   virtual void resetIndentation();
   virtual void markRubyBegin();
@@ -0,0 +1,66 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2013 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+// -----------------------------------------------------------------------
+
+#include "allocation_counter.hpp"
+
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+thread_local bool s_counting = false;
+thread_local long s_allocations = 0;
+
+}  // namespace
+
+void* operator new(size_t size) {
+  if (s_counting)
+    ++s_allocations;
+  void* p = malloc(size ? size : 1);
+  if (!p)
+    throw std::bad_alloc();
+  return p;
+}
+
+void operator delete(void* p) noexcept {
+  free(p);
+}
+
+// -----------------------------------------------------------------------
+// ScopedAllocationCounter
+// -----------------------------------------------------------------------
+ScopedAllocationCounter::ScopedAllocationCounter()
+    : was_counting_(s_counting), start_(s_allocations) {
+  s_counting = true;
+}
+
+ScopedAllocationCounter::~ScopedAllocationCounter() {
+  s_counting = was_counting_;
+}
+
+long ScopedAllocationCounter::count() const {
+  return s_allocations - start_;
+}
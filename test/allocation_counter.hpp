@@ -0,0 +1,49 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2013 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+// -----------------------------------------------------------------------
+
+#ifndef TEST_ALLOCATION_COUNTER_HPP_
+#define TEST_ALLOCATION_COUNTER_HPP_
+
+// Counts the heap allocations the current thread makes while it's alive.
+// Counters nest, and allocations on other threads are never counted.
+//
+// This only works in programs that link test/allocation_counter.cpp, which
+// replaces the global operator new. Keep it out of rlvmTests so the rest of
+// the tests run on the normal allocator.
+class ScopedAllocationCounter {
+ public:
+  ScopedAllocationCounter();
+  ~ScopedAllocationCounter();
+
+  // Allocations made by this thread since construction.
+  long count() const;
+
+ private:
+  bool was_counting_;
+  long start_;
+};
+
+#endif  // TEST_ALLOCATION_COUNTER_HPP_
@@ -0,0 +1,187 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2013 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+// -----------------------------------------------------------------------
+
+#include "gtest/gtest.h"
+
+#include <boost/filesystem/fstream.hpp>
+#include <boost/filesystem/operations.hpp>
+#include <boost/iostreams/filter/zlib.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "Utilities/AsyncFileWriter.hpp"
+
+namespace fs = boost::filesystem;
+
+class AsyncFileWriterTest : public ::testing::Test {
+ protected:
+  virtual void SetUp() {
+    dir_ = fs::temp_directory_path() / fs::unique_path("rlvm-%%%%-%%%%");
+    fs::create_directories(dir_);
+  }
+
+  virtual void TearDown() {
+    fs::remove_all(dir_);
+  }
+
+  // Reads back a file written by AsyncFileWriter, whose header is
+  // |header_size| bytes long.
+  std::pair<std::string, std::string> readFile(const fs::path& path,
+                                               size_t header_size) {
+    fs::ifstream file(path, std::ios::binary);
+    std::string header(header_size, '\0');
+    file.read(&header[0], header_size);
+
+    using namespace boost::iostreams;
+    filtering_stream<input> filtered_input;
+    filtered_input.push(zlib_decompressor());
+    filtered_input.push(file);
+    std::string body((std::istreambuf_iterator<char>(filtered_input)),
+                     std::istreambuf_iterator<char>());
+    return std::make_pair(header, body);
+  }
+
+  // Reads back a file written uncompressed.
+  std::string readRawFile(const fs::path& path) {
+    fs::ifstream file(path, std::ios::binary);
+    return std::string((std::istreambuf_iterator<char>(file)),
+                       std::istreambuf_iterator<char>());
+  }
+
+  fs::path dir_;
+};
+
+TEST_F(AsyncFileWriterTest, WritesCompressedBodyAfterHeader) {
+  fs::path path = dir_ / "save001.sav.gz";
+  std::string body(100000, 'x');
+  {
+    AsyncFileWriter writer;
+    writer.write(path, "HEAD", body);
+    writer.flush();
+    EXPECT_EQ(0, writer.failedWrites());
+  }
+
+  ASSERT_TRUE(fs::exists(path));
+  EXPECT_LT(fs::file_size(path), body.size());
+  EXPECT_FALSE(fs::exists(dir_ / "save001.sav.gz.tmp"));
+
+  std::pair<std::string, std::string> contents = readFile(path, 4);
+  EXPECT_EQ("HEAD", contents.first);
+  EXPECT_EQ(body, contents.second);
+}
+
+TEST_F(AsyncFileWriterTest, LastWriteToAPathWins) {
+  fs::path path = dir_ / "global.sav.gz";
+  AsyncFileWriter writer;
+  for (int i = 0; i < 20; ++i)
+    writer.write(path, "", "version " + std::to_string(i));
+  writer.flush();
+
+  EXPECT_EQ("version 19", readFile(path, 0).second);
+}
+
+TEST_F(AsyncFileWriterTest, DestructorFinishesQueuedWrites) {
+  {
+    AsyncFileWriter writer;
+    for (int i = 0; i < 5; ++i) {
+      writer.write(dir_ / ("file" + std::to_string(i)), "",
+                   std::string(5000, 'a' + i));
+    }
+  }
+
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_EQ(std::string(5000, 'a' + i),
+              readFile(dir_ / ("file" + std::to_string(i)), 0).second);
+  }
+}
+
+TEST_F(AsyncFileWriterTest, FailedWriteKeepsOldFile) {
+  fs::path path = dir_ / "save002.sav.gz";
+  AsyncFileWriter writer;
+  writer.write(path, "OLD", "old body");
+  writer.flush();
+
+  // Writing into a directory that doesn't exist fails, and mustn't touch the
+  // existing file.
+  writer.write(dir_ / "missing" / "save002.sav.gz", "NEW", "new body");
+  writer.flush();
+  EXPECT_EQ(1, writer.failedWrites());
+
+  std::pair<std::string, std::string> contents = readFile(path, 3);
+  EXPECT_EQ("OLD", contents.first);
+  EXPECT_EQ("old body", contents.second);
+}
+
+TEST_F(AsyncFileWriterTest, AppendsAfterReplace) {
+  fs::path path = dir_ / "global.journal";
+  AsyncFileWriter writer;
+  writer.replace(path, "header;");
+  writer.append(path, "one;");
+  writer.append(path, "two;");
+  writer.flush();
+  EXPECT_EQ("header;one;two;", readRawFile(path));
+
+  // Replacing starts the file over and drops appends still in the queue.
+  writer.append(path, "three;");
+  writer.replace(path, "new;");
+  writer.flush();
+  EXPECT_EQ("new;", readRawFile(path));
+  EXPECT_EQ(0, writer.failedWrites());
+}
+
+TEST_F(AsyncFileWriterTest, CallsBackBeforeLaterWrites) {
+  fs::path base = dir_ / "global.sav.gz";
+  fs::path journal = dir_ / "global.journal";
+  std::vector<bool> outcomes;
+  AsyncFileWriter writer;
+
+  // The callback restarts the journal only when the base made it to disk;
+  // the append queued after the base lands after whatever it wrote.
+  AsyncFileWriter::Callback restart_journal = [&](bool succeeded) {
+    outcomes.push_back(succeeded);
+    if (succeeded)
+      AsyncFileWriter::ReplaceNow(journal, "new;");
+  };
+
+  writer.replace(journal, "old;");
+  writer.write(base, "", "base", restart_journal);
+  writer.append(journal, "one;");
+  writer.flush();
+  EXPECT_EQ("new;one;", readRawFile(journal));
+
+  writer.write(dir_ / "missing" / "global.sav.gz", "", "base",
+               restart_journal);
+  writer.append(journal, "two;");
+  writer.flush();
+  EXPECT_EQ("new;one;two;", readRawFile(journal));
+
+  ASSERT_EQ(2u, outcomes.size());
+  EXPECT_TRUE(outcomes[0]);
+  EXPECT_FALSE(outcomes[1]);
+}
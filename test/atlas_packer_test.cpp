@@ -0,0 +1,97 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2013 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+// -----------------------------------------------------------------------
+
+#include "gtest/gtest.h"
+
+#include <vector>
+
+#include "Systems/Base/AtlasPacker.hpp"
+
+namespace {
+
+bool Overlaps(const Rect& a, const Rect& b) {
+  return a.x() < b.x2() && b.x() < a.x2() && a.y() < b.y2() && b.y() < a.y2();
+}
+
+}  // namespace
+
+TEST(AtlasPackerTest, PacksWithoutOverlap) {
+  AtlasPacker packer(Size(256, 256));
+
+  // Sixteen 64x64 buttons exactly fill the page.
+  std::vector<Rect> rects;
+  for (int i = 0; i < 16; ++i) {
+    Rect r;
+    ASSERT_TRUE(packer.allocate(Size(64, 64), &r)) << "Button " << i;
+    rects.push_back(r);
+  }
+
+  Rect r;
+  EXPECT_FALSE(packer.allocate(Size(1, 1), &r));
+  EXPECT_EQ(256 * 256, packer.usedArea());
+
+  for (size_t i = 0; i < rects.size(); ++i) {
+    EXPECT_LE(0, rects[i].x());
+    EXPECT_LE(rects[i].x2(), 256);
+    EXPECT_LE(rects[i].y2(), 256);
+    for (size_t j = i + 1; j < rects.size(); ++j)
+      EXPECT_FALSE(Overlaps(rects[i], rects[j])) << i << " and " << j;
+  }
+}
+
+TEST(AtlasPackerTest, ReleasedSpaceIsReused) {
+  AtlasPacker packer(Size(128, 128));
+
+  Rect a, b, c;
+  ASSERT_TRUE(packer.allocate(Size(128, 64), &a));
+  ASSERT_TRUE(packer.allocate(Size(64, 64), &b));
+  ASSERT_TRUE(packer.allocate(Size(64, 64), &c));
+  EXPECT_FALSE(packer.allocate(Size(64, 64), &c));
+
+  // Releasing both halves of the bottom row makes room for a full width
+  // strip again.
+  packer.release(b);
+  packer.release(c);
+  Rect strip;
+  EXPECT_TRUE(packer.allocate(Size(128, 64), &strip));
+  EXPECT_FALSE(Overlaps(a, strip));
+}
+
+TEST(AtlasPackerTest, EmptyPageResets) {
+  AtlasPacker packer(Size(64, 64));
+
+  Rect a, b;
+  ASSERT_TRUE(packer.allocate(Size(10, 30), &a));
+  ASSERT_TRUE(packer.allocate(Size(30, 10), &b));
+  packer.release(a);
+  packer.release(b);
+  EXPECT_EQ(0, packer.allocations());
+  EXPECT_EQ(0, packer.usedArea());
+
+  Rect whole;
+  EXPECT_TRUE(packer.allocate(Size(64, 64), &whole));
+}
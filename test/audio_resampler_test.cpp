@@ -0,0 +1,122 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2013 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+// -----------------------------------------------------------------------
+
+#include "gtest/gtest.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+#include "Systems/Base/AudioResampler.hpp"
+
+namespace {
+
+std::vector<int16_t> Resample(const std::vector<int16_t>& in, int channels,
+                              int in_rate, int out_rate) {
+  std::vector<int16_t> out;
+  AudioResampler::resampleBuffer(&in[0], in.size() / channels, channels,
+                                 in_rate, out_rate, out);
+  return out;
+}
+
+}  // namespace
+
+TEST(AudioResamplerTest, SameRateIsPassthrough) {
+  std::vector<int16_t> in;
+  for (int i = 0; i < 100; ++i)
+    in.push_back(i * 37 - 1000);
+
+  EXPECT_EQ(in, Resample(in, 2, 44100, 44100));
+}
+
+TEST(AudioResamplerTest, OutputLengthFollowsRatio) {
+  std::vector<int16_t> in(22050 * 2, 0);
+  EXPECT_EQ(44100u * 2, Resample(in, 2, 22050, 44100).size());
+  EXPECT_EQ(22050u, Resample(in, 1, 44100, 22050).size());
+
+  // 44100 -> 48000 doesn't reduce to a small ratio.
+  std::vector<int16_t> out = Resample(in, 1, 44100, 48000);
+  EXPECT_NEAR(48000 * 1.0, out.size(), 2);
+}
+
+TEST(AudioResamplerTest, PreservesConstantSignal) {
+  std::vector<int16_t> in(4000, 10000);
+  std::vector<int16_t> out = Resample(in, 1, 22050, 48000);
+
+  // Ignore the edges where the filter sees the zero padding.
+  for (size_t i = 40; i < out.size() - 40; ++i)
+    ASSERT_NEAR(10000, out[i], 2) << "at " << i;
+}
+
+TEST(AudioResamplerTest, KeepsChannelsSeparate) {
+  std::vector<int16_t> in;
+  for (int i = 0; i < 2000; ++i) {
+    in.push_back(8000);
+    in.push_back(-8000);
+  }
+
+  std::vector<int16_t> out = Resample(in, 2, 44100, 32000);
+  for (size_t i = 40; i < out.size() / 2 - 40; ++i) {
+    ASSERT_NEAR(8000, out[i * 2], 2);
+    ASSERT_NEAR(-8000, out[i * 2 + 1], 2);
+  }
+}
+
+TEST(AudioResamplerTest, StreamingMatchesWholeBuffer) {
+  std::vector<int16_t> in;
+  srand(42);
+  for (int i = 0; i < 5000; ++i)
+    in.push_back(static_cast<int16_t>(rand() % 20000 - 10000));
+
+  std::vector<int16_t> whole = Resample(in, 1, 22050, 44100);
+
+  AudioResampler resampler(22050, 44100, 1);
+  std::vector<int16_t> streamed;
+  for (size_t i = 0; i < in.size(); i += 333) {
+    int frames = std::min<int>(333, in.size() - i);
+    resampler.process(&in[i], frames, streamed);
+  }
+  resampler.flush(streamed);
+
+  EXPECT_EQ(whole, streamed);
+}
+
+TEST(AudioResamplerTest, AttenuatesAliasesWhenDownsampling) {
+  // A tone at 20kHz can't be represented at 22050Hz and should mostly vanish
+  // rather than fold back down to 2050Hz.
+  std::vector<int16_t> in;
+  for (int i = 0; i < 44100; ++i)
+    in.push_back(static_cast<int16_t>(
+        10000 * std::sin(2 * M_PI * 20000.0 * i / 44100)));
+
+  std::vector<int16_t> out = Resample(in, 1, 44100, 22050);
+  double energy = 0;
+  for (size_t i = 100; i < out.size() - 100; ++i)
+    energy += double(out[i]) * out[i];
+  double rms = std::sqrt(energy / (out.size() - 200));
+  EXPECT_LT(rms, 1000);
+}
@@ -0,0 +1,129 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2013 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+// -----------------------------------------------------------------------
+
+// Standalone benchmark for replaying text pages out of the backlog. Fills the
+// backlog with full pages of text on the test system, then flips back through
+// all of them and forward again, and prints how many page flips per second
+// we get on the first pass (which lays every page out) and on later passes
+// (which redraw the cached layout).
+//
+// Usage: backlogBenchmark [--passes N]
+
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+
+#include "Systems/Base/TextPage.hpp"
+#include "Systems/Base/TextSystem.hpp"
+#include "Systems/Base/TextWindow.hpp"
+#include "TestSystem/TestMachine.hpp"
+#include "TestSystem/TestSystem.hpp"
+#include "libReallive/archive.h"
+#include "testUtils.hpp"
+
+using boost::posix_time::microsec_clock;
+using boost::posix_time::ptime;
+
+namespace {
+
+// The text system only keeps this many pages of history.
+const int kPages = 100;
+
+const char kLine[] =
+    "The quick brown fox jumps over the lazy dog, again and again. ";
+
+void WritePage(TextSystem& text, int lines) {
+  TextPage& page = text.currentPage();
+  for (int i = 0; i < lines; ++i) {
+    std::string line(kLine);
+    for (size_t j = 0; j < line.size(); ++j)
+      page.character(line.substr(j, 1), line.substr(j + 1));
+    page.hardBrake();
+  }
+}
+
+// Flips back to the oldest page and forward to the current one, returning the
+// number of flips per second.
+double FlipThroughBacklog(TextSystem& text) {
+  ptime start = microsec_clock::universal_time();
+  for (int i = 0; i < kPages; ++i)
+    text.backPage();
+  for (int i = 0; i < kPages; ++i)
+    text.forwardPage();
+  ptime end = microsec_clock::universal_time();
+
+  double seconds = (end - start).total_microseconds() / 1000000.0;
+  return (2 * kPages) / seconds;
+}
+
+void PrintResult(const std::string& name, double flips_per_second) {
+  std::cout << "  " << std::left << std::setw(16) << name
+            << std::right << std::setw(12) << std::fixed
+            << std::setprecision(1) << flips_per_second
+            << " flips/s" << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  int passes = 10;
+  if (argc > 2 && strcmp(argv[1], "--passes") == 0)
+    passes = atoi(argv[2]);
+
+  if (passes <= 0) {
+    std::cerr << "Usage: " << argv[0] << " [--passes N]" << std::endl;
+    return 1;
+  }
+
+  libReallive::Archive arc(locateTestCase("Module_Str_SEEN/strcpy_0.TXT"));
+  TestSystem system(locateTestCase("Gameexe_data/Gameexe.ini"));
+  TestMachine rlmachine(system, arc);
+
+  TextSystem& text = system.text();
+  text.setActiveWindow(0);
+  for (int i = 0; i < kPages; ++i) {
+    WritePage(text, 3);
+    text.snapshot();
+    text.textWindow(0)->clearWin();
+    text.newPageOnWindow(0);
+  }
+  WritePage(text, 3);
+
+  std::cout << kPages << " backlog pages" << std::endl;
+  PrintResult("first pass", FlipThroughBacklog(text));
+
+  double total = 0;
+  for (int i = 0; i < passes; ++i)
+    total += FlipThroughBacklog(text);
+  PrintResult("cached", total / passes);
+
+  text.stopReadingBacklog();
+  return 0;
+}
@@ -0,0 +1,86 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2013 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+// -----------------------------------------------------------------------
+
+#include "gtest/gtest.h"
+
+#include "Systems/Base/DirtyRegion.hpp"
+
+TEST(DirtyRegionTest, SeparateWritesStaySeparate) {
+  DirtyRegion region;
+  region.add(Rect::REC(0, 0, 10, 10));
+  region.add(Rect::REC(600, 400, 10, 10));
+
+  // A bounding box would have been 610x410.
+  ASSERT_EQ(2u, region.rects().size());
+  EXPECT_EQ(200, region.area());
+}
+
+TEST(DirtyRegionTest, OverlappingWritesMerge) {
+  DirtyRegion region;
+  region.add(Rect::REC(0, 0, 10, 10));
+  region.add(Rect::REC(5, 0, 10, 10));
+  region.add(Rect::REC(2, 2, 3, 3));
+
+  ASSERT_EQ(1u, region.rects().size());
+  EXPECT_EQ(Rect::REC(0, 0, 15, 10), region.rects()[0]);
+
+  // Typing a line of characters one at a time is one upload.
+  DirtyRegion line;
+  for (int i = 0; i < 20; ++i)
+    line.add(Rect::REC(i * 24, 100, 24, 24));
+  ASSERT_EQ(1u, line.rects().size());
+  EXPECT_EQ(Rect::REC(0, 100, 480, 24), line.rects()[0]);
+}
+
+TEST(DirtyRegionTest, CapsNumberOfRects) {
+  DirtyRegion region;
+  for (int i = 0; i < 20; ++i)
+    region.add(Rect::REC(i * 30, (i % 2) * 300, 10, 10));
+
+  EXPECT_LE(region.rects().size(), DirtyRegion::MAX_RECTS);
+
+  // Everything written is still covered.
+  for (int i = 0; i < 20; ++i) {
+    Rect written = Rect::REC(i * 30, (i % 2) * 300, 10, 10);
+    bool covered = false;
+    for (size_t j = 0; j < region.rects().size(); ++j) {
+      if (region.rects()[j].intersection(written) == written)
+        covered = true;
+    }
+    EXPECT_TRUE(covered) << "Lost " << written;
+  }
+}
+
+TEST(DirtyRegionTest, IgnoresEmptyRects) {
+  DirtyRegion region;
+  region.add(Rect());
+  region.add(Rect::REC(5, 5, 0, 10));
+  EXPECT_TRUE(region.empty());
+
+  region.add(Rect::REC(5, 5, 1, 1));
+  region.clear();
+  EXPECT_TRUE(region.empty());
+}
@@ -0,0 +1,93 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2013 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+// -----------------------------------------------------------------------
+#include "gtest/gtest.h"
+
+#include <chrono>
+#include <sstream>
+#include <string>
+
+#include "Utilities/FrameTimings.hpp"
+
+namespace {
+
+FrameTimings::Clock::time_point at(int milliseconds) {
+  return FrameTimings::Clock::time_point(
+      std::chrono::milliseconds(milliseconds));
+}
+
+}  // namespace
+
+TEST(FrameTimingsTest, DoesNothingUntilEnabled) {
+  FrameTimings timings;
+  timings.record("frame", at(0), at(5));
+  EXPECT_EQ(0, timings.percentiles("frame").samples);
+}
+
+TEST(FrameTimingsTest, Percentiles) {
+  FrameTimings timings;
+  timings.enable("");
+  for (int i = 1; i <= 100; ++i)
+    timings.record("frame", at(0), at(i));
+
+  FrameTimings::Percentiles p = timings.percentiles("frame");
+  EXPECT_EQ(100, p.samples);
+  EXPECT_DOUBLE_EQ(50, p.p50_ms);
+  EXPECT_DOUBLE_EQ(90, p.p90_ms);
+  EXPECT_DOUBLE_EQ(99, p.p99_ms);
+
+  // Sections are told apart by name, not by pointer.
+  std::string name = "frame";
+  EXPECT_EQ(100, timings.percentiles(name.c_str()).samples);
+  EXPECT_EQ(0, timings.percentiles("drawFrame").samples);
+}
+
+TEST(FrameTimingsTest, OnlyKeepsRecentSamples) {
+  FrameTimings timings;
+  timings.enable("");
+  for (size_t i = 0; i < FrameTimings::kWindowSize; ++i)
+    timings.record("frame", at(0), at(100));
+  for (size_t i = 0; i < FrameTimings::kWindowSize; ++i)
+    timings.record("frame", at(0), at(1));
+
+  FrameTimings::Percentiles p = timings.percentiles("frame");
+  EXPECT_EQ(FrameTimings::kWindowSize, p.samples);
+  EXPECT_DOUBLE_EQ(1, p.p99_ms);
+}
+
+TEST(FrameTimingsTest, WritesChromeTraceEvents) {
+  FrameTimings timings;
+  timings.enable("unused.json");
+  FrameTimings::Clock::time_point now = FrameTimings::Clock::now();
+  timings.record("drawFrame", now, now + std::chrono::microseconds(1500));
+
+  std::ostringstream oss;
+  timings.writeTrace(oss);
+  std::string trace = oss.str();
+  EXPECT_EQ(0, trace.find("{\"traceEvents\":["));
+  EXPECT_NE(std::string::npos, trace.find("\"name\":\"drawFrame\""));
+  EXPECT_NE(std::string::npos, trace.find("\"ph\":\"X\""));
+  EXPECT_NE(std::string::npos, trace.find("\"dur\":1500.000"));
+}
@@ -0,0 +1,133 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2013 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+// -----------------------------------------------------------------------
+
+// Standalone benchmark for Gameexe lookups. Every key in a Gameexe.ini file
+// is looked up over and over: through a plain std::multimap (how Gameexe
+// used to store its data), by string, by formatting the key from its parts
+// the way most callers do, and through precompiled GameexeKeys.
+//
+// Usage: gameexeBenchmark [--gameexe PATH] [--passes N]
+
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+
+#include "libReallive/gameexe.h"
+
+using boost::posix_time::microsec_clock;
+using boost::posix_time::ptime;
+
+namespace {
+
+// Keeps the compiler from optimizing the lookups away.
+volatile int sink = 0;
+
+void PrintResult(const std::string& name, const ptime& start, int lookups) {
+  ptime end = microsec_clock::universal_time();
+  double nanoseconds = (end - start).total_microseconds() * 1000.0;
+  std::cout << "  " << std::left << std::setw(16) << name
+            << std::right << std::setw(10) << std::fixed
+            << std::setprecision(1) << nanoseconds / lookups
+            << " ns/lookup" << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  std::string path = "test/Gameexe_data/Gameexe.ini";
+  int passes = 100000;
+  for (int i = 1; i + 1 < argc; i += 2) {
+    if (strcmp(argv[i], "--gameexe") == 0)
+      path = argv[i + 1];
+    else if (strcmp(argv[i], "--passes") == 0)
+      passes = atoi(argv[i + 1]);
+  }
+
+  if (passes <= 0) {
+    std::cerr << "Usage: " << argv[0]
+              << " [--gameexe PATH] [--passes N]" << std::endl;
+    return 1;
+  }
+
+  Gameexe gameexe(path);
+  std::vector<std::string> keys;
+  std::vector<GameexeKey> compiled;
+  GameexeData_t ordered;
+  for (GameexeFilteringIterator it = gameexe.filtering_begin("");
+       it != gameexe.filtering_end(); ++it) {
+    keys.push_back(it->key());
+    compiled.push_back(gameexe.key(it->key()));
+    ordered.insert(std::make_pair(it->key(), Gameexe_vec_type()));
+  }
+
+  if (keys.empty()) {
+    std::cerr << "No keys in " << path << std::endl;
+    return 1;
+  }
+
+  int lookups = passes * keys.size();
+  std::cout << keys.size() << " keys, " << passes << " passes" << std::endl;
+
+  ptime start = microsec_clock::universal_time();
+  for (int pass = 0; pass < passes; ++pass) {
+    for (size_t i = 0; i < keys.size(); ++i)
+      sink += ordered.find(keys[i]) != ordered.end();
+  }
+  PrintResult("std::multimap", start, lookups);
+
+  start = microsec_clock::universal_time();
+  for (int pass = 0; pass < passes; ++pass) {
+    for (size_t i = 0; i < keys.size(); ++i)
+      sink += gameexe.exists(keys[i]);
+  }
+  PrintResult("string", start, lookups);
+
+  start = microsec_clock::universal_time();
+  for (int pass = 0; pass < passes; ++pass) {
+    for (size_t i = 0; i < compiled.size(); ++i)
+      sink += gameexe.exists(compiled[i]);
+  }
+  PrintResult("compiled", start, lookups);
+
+  // The typical call site: formatting a numbered key and reading its value.
+  start = microsec_clock::universal_time();
+  for (int pass = 0; pass < passes; ++pass)
+    sink += gameexe("WINDOW", 0, "MOJI_SIZE").to_int(0);
+  PrintResult("formatted value", start, passes);
+
+  GameexeKey moji_size = gameexe.key("WINDOW", 0, "MOJI_SIZE");
+  start = microsec_clock::universal_time();
+  for (int pass = 0; pass < passes; ++pass)
+    sink += gameexe(moji_size).to_int(0);
+  PrintResult("compiled value", start, passes);
+
+  return 0;
+}
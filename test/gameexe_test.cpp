@@ -137,3 +137,55 @@ TEST(GameexeUnit, DstrackRegression) {
   EXPECT_EQ("dcbgm000", dc.getStringAt(3));
   EXPECT_EQ("dcbgm000", dc.getStringAt(4));
 }
+
+// Precompiled keys find the same rows as formatting the key each time.
+TEST(GameexeUnit, CompiledKeys) {
+  Gameexe ini(locateTestCase("Gameexe_data/Gameexe.ini"));
+  GameexeKey moji_size = ini.key("WINDOW", 0, "MOJI_SIZE");
+  EXPECT_EQ("WINDOW.000.MOJI_SIZE", moji_size.key());
+  EXPECT_TRUE(ini.exists(moji_size));
+  EXPECT_EQ(25, ini(moji_size).to_int());
+  EXPECT_EQ(25, ini(moji_size).to_int());
+
+  GameexeKey imagine = ini.key("IMAGINE");
+  EXPECT_EQ(2, ini(imagine)("TWO"));
+
+  GameexeKey missing = ini.key("RANDOM_KEY");
+  EXPECT_FALSE(ini.exists(missing));
+  EXPECT_EQ(7, ini(missing).to_int(7));
+}
+
+// Precompiled keys see keys added and values changed after they were made.
+TEST(GameexeUnit, CompiledKeysSeeChanges) {
+  Gameexe ini(locateTestCase("Gameexe_data/Gameexe.ini"));
+  GameexeKey seen_start = ini.key("SEEN_START");
+  GameexeKey added = ini.key("ADDED_LATER");
+  EXPECT_EQ(1, ini(seen_start).to_int());
+  EXPECT_FALSE(ini.exists(added));
+
+  ini("SEEN_START") = 5;
+  ini("ADDED_LATER") = "value";
+  EXPECT_EQ(5, ini(seen_start).to_int());
+  EXPECT_TRUE(ini.exists(added));
+  EXPECT_EQ("value", ini(added).to_string());
+  EXPECT_EQ(27, ini.size());
+
+  // A key resolved against one Gameexe can be used on a copy of it.
+  Gameexe copy(ini);
+  copy("SEEN_START") = 6;
+  EXPECT_EQ(6, copy(seen_start).to_int());
+  EXPECT_EQ(5, ini(seen_start).to_int());
+}
+
+// Assigning to a key that appears more than once leaves exactly one row.
+TEST(GameexeUnit, AssignmentReplacesDuplicateKeys) {
+  Gameexe ini;
+  ini.parseLine("#DUPLICATE=1");
+  ini.parseLine("#DUPLICATE=2");
+  EXPECT_EQ(2, ini.size());
+  EXPECT_EQ(1, ini("DUPLICATE").to_int());
+
+  ini("DUPLICATE") = 3;
+  EXPECT_EQ(1, ini.size());
+  EXPECT_EQ(3, ini("DUPLICATE").to_int());
+}
@@ -0,0 +1,162 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2013 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+// -----------------------------------------------------------------------
+
+#include "gtest/gtest.h"
+
+#include <string>
+
+#include "MachineBase/GlobalMemoryJournal.hpp"
+#include "MachineBase/Memory.hpp"
+
+namespace {
+
+const int VERSION = 4;
+
+// A journal for generation 7 holding everything marked in |memory|.
+std::string JournalOf(const GlobalMemory& memory) {
+  std::string journal = GlobalMemoryJournal::Header(VERSION, 7);
+  memory.journal.writeChangeRecords(memory, &journal);
+  return journal;
+}
+
+}  // namespace
+
+TEST(GlobalMemoryJournalTest, HeaderRoundTrips) {
+  std::string header = GlobalMemoryJournal::Header(VERSION, 7);
+  EXPECT_EQ(GlobalMemoryJournal::HEADER_SIZE, header.size());
+
+  int version;
+  unsigned int generation;
+  ASSERT_TRUE(GlobalMemoryJournal::ReadHeader(header, &version, &generation));
+  EXPECT_EQ(VERSION, version);
+  EXPECT_EQ(7u, generation);
+
+  EXPECT_FALSE(GlobalMemoryJournal::ReadHeader("", &version, &generation));
+  EXPECT_FALSE(GlobalMemoryJournal::ReadHeader(
+      std::string(GlobalMemoryJournal::HEADER_SIZE, 'x'), &version,
+      &generation));
+}
+
+TEST(GlobalMemoryJournalTest, ReplaysChangedEntries) {
+  GlobalMemory written;
+  written.intG[5] = 42;
+  written.journal.markIntG(5);
+  written.intZ[1999] = -3;
+  written.journal.markIntZ(1999);
+  written.strM[10] = "Some string";
+  written.journal.markStrM(10);
+  written.global_names[2] = "Name";
+  written.journal.markName(2);
+  written.kidoku_data[9032].resize(100);
+  written.kidoku_data[9032][99] = true;
+  written.journal.markKidoku(9032, 99);
+  EXPECT_TRUE(written.journal.hasChanges());
+
+  std::string journal = JournalOf(written);
+
+  GlobalMemory read;
+  std::string system_globals;
+  EXPECT_EQ(journal.size(),
+            GlobalMemoryJournal::ApplyRecords(journal, &read, &system_globals));
+  EXPECT_EQ(42, read.intG[5]);
+  EXPECT_EQ(-3, read.intZ[1999]);
+  EXPECT_EQ("Some string", read.strM[10]);
+  EXPECT_EQ("Name", read.global_names[2]);
+  ASSERT_EQ(100u, read.kidoku_data[9032].size());
+  EXPECT_TRUE(read.kidoku_data[9032][99]);
+  EXPECT_EQ("", system_globals);
+
+  written.journal.clearChanges();
+  EXPECT_FALSE(written.journal.hasChanges());
+}
+
+TEST(GlobalMemoryJournalTest, LaterRecordsWin) {
+  GlobalMemory written;
+  written.intG[0] = 1;
+  written.journal.markIntG(0);
+  std::string journal = JournalOf(written);
+
+  written.journal.clearChanges();
+  written.intG[0] = 2;
+  written.journal.markIntG(0);
+  written.journal.writeChangeRecords(written, &journal);
+
+  GlobalMemory read;
+  std::string system_globals;
+  GlobalMemoryJournal::ApplyRecords(journal, &read, &system_globals);
+  EXPECT_EQ(2, read.intG[0]);
+}
+
+TEST(GlobalMemoryJournalTest, StopsAtTornRecord) {
+  GlobalMemory written;
+  written.intG[0] = 1;
+  written.journal.markIntG(0);
+  std::string journal = JournalOf(written);
+  size_t first_batch = journal.size();
+
+  written.journal.clearChanges();
+  written.intG[1] = 2;
+  written.journal.markIntG(1);
+  written.journal.writeChangeRecords(written, &journal);
+
+  // A crash in the middle of appending the second batch.
+  journal.resize(journal.size() - 1);
+
+  GlobalMemory read;
+  std::string system_globals;
+  EXPECT_EQ(first_batch,
+            GlobalMemoryJournal::ApplyRecords(journal, &read, &system_globals));
+  EXPECT_EQ(1, read.intG[0]);
+  EXPECT_EQ(0, read.intG[1]);
+}
+
+TEST(GlobalMemoryJournalTest, StopsAtCorruptRecord) {
+  GlobalMemory written;
+  written.strM[0] = "abcdef";
+  written.journal.markStrM(0);
+  std::string journal = JournalOf(written);
+  journal[journal.size() - 6] ^= 0x20;
+
+  GlobalMemory read;
+  std::string system_globals;
+  EXPECT_EQ(GlobalMemoryJournal::HEADER_SIZE,
+            GlobalMemoryJournal::ApplyRecords(journal, &read, &system_globals));
+  EXPECT_EQ("", read.strM[0]);
+}
+
+TEST(GlobalMemoryJournalTest, KeepsLastSystemGlobals) {
+  std::string journal = GlobalMemoryJournal::Header(VERSION, 7);
+  GlobalMemoryJournal::WriteSystemGlobalsRecord("first", &journal);
+  GlobalMemoryJournal::WriteSystemGlobalsRecord(std::string("sec\0nd", 6),
+                                                &journal);
+
+  GlobalMemory read;
+  std::string system_globals;
+  EXPECT_EQ(journal.size(),
+            GlobalMemoryJournal::ApplyRecords(journal, &read, &system_globals));
+  EXPECT_EQ(std::string("sec\0nd", 6), system_globals);
+}
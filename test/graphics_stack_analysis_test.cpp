@@ -0,0 +1,124 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2013 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+// -----------------------------------------------------------------------
+
+#include "gtest/gtest.h"
+
+#include <string>
+#include <vector>
+
+#include "Systems/Base/GraphicsStackAnalysis.hpp"
+
+namespace {
+
+// grpLoad(file, dc) into a scratch DC, which reallocates it.
+GraphicsStackEffect Load(const std::string& file, int dc) {
+  GraphicsStackEffect effect;
+  effect.understood = true;
+  effect.writes.push_back(dc);
+  effect.replaces.push_back(dc);
+  effect.reallocates = true;
+  effect.image = file;
+  return effect;
+}
+
+// grpCopy(src, dst), which may grow |dst|.
+GraphicsStackEffect Copy(int src, int dst) {
+  GraphicsStackEffect effect;
+  effect.understood = true;
+  effect.writes.push_back(dst);
+  effect.reads.push_back(src);
+  effect.resizes.push_back(dst);
+  return effect;
+}
+
+// wipe(dc, ...), which keeps the DC's size.
+GraphicsStackEffect Wipe(int dc) {
+  GraphicsStackEffect effect;
+  effect.understood = true;
+  effect.writes.push_back(dc);
+  effect.replaces.push_back(dc);
+  return effect;
+}
+
+GraphicsStackEffect Unknown() {
+  return GraphicsStackEffect();
+}
+
+}  // namespace
+
+TEST(GraphicsStackAnalysisTest, DropsLoadsThatAreLoadedOver) {
+  std::vector<GraphicsStackEffect> stack;
+  stack.push_back(Load("BG001", 2));
+  stack.push_back(Load("BG002", 2));
+  stack.push_back(Load("BG003", 2));
+  stack.push_back(Load("CHR01", 3));
+
+  std::vector<bool> overwritten = FindOverwrittenStackCommands(stack);
+  ASSERT_EQ(4u, overwritten.size());
+  EXPECT_TRUE(overwritten[0]);
+  EXPECT_TRUE(overwritten[1]);
+  EXPECT_FALSE(overwritten[2]);
+  EXPECT_FALSE(overwritten[3]);
+}
+
+TEST(GraphicsStackAnalysisTest, KeepsWhatIsReadBeforeBeingReplaced) {
+  std::vector<GraphicsStackEffect> stack;
+  stack.push_back(Load("BG001", 2));
+  stack.push_back(Copy(2, 1));
+  stack.push_back(Load("BG002", 2));
+
+  std::vector<bool> overwritten = FindOverwrittenStackCommands(stack);
+  EXPECT_FALSE(overwritten[0]) << "DC 2 is copied to DC 1 first";
+  EXPECT_FALSE(overwritten[1]);
+  EXPECT_FALSE(overwritten[2]);
+}
+
+TEST(GraphicsStackAnalysisTest, UnknownCommandsAreBarriers) {
+  std::vector<GraphicsStackEffect> stack;
+  stack.push_back(Load("BG001", 2));
+  stack.push_back(Unknown());
+  stack.push_back(Load("BG002", 2));
+
+  std::vector<bool> overwritten = FindOverwrittenStackCommands(stack);
+  EXPECT_FALSE(overwritten[0]);
+  EXPECT_FALSE(overwritten[1]);
+  EXPECT_FALSE(overwritten[2]);
+}
+
+TEST(GraphicsStackAnalysisTest, SizeChangesSurviveWipes) {
+  // A wipe replaces the pixels but keeps the size a copy grew the DC to.
+  std::vector<GraphicsStackEffect> stack;
+  stack.push_back(Copy(1, 3));
+  stack.push_back(Wipe(3));
+  std::vector<bool> overwritten = FindOverwrittenStackCommands(stack);
+  EXPECT_FALSE(overwritten[0]);
+
+  // Reallocating it makes the copy pointless.
+  stack[1] = Load("BG001", 3);
+  overwritten = FindOverwrittenStackCommands(stack);
+  EXPECT_TRUE(overwritten[0]);
+  EXPECT_FALSE(overwritten[1]);
+}
@@ -0,0 +1,372 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2013 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+// -----------------------------------------------------------------------
+
+// Standalone benchmark for the bytecode interpreter. Runs the SEEN files from
+// the large tests, a recursive fibonacci and a handful of synthetic
+// expressions on the test system, and reports for each of them:
+//
+//   - instructions (or expression evaluations) per second,
+//   - the 50th, 90th and 99th percentile time of a single dispatch,
+//   - heap allocations per instruction.
+//
+// Usage: interpreterBenchmark [--passes N] [--fib N] [--csv]
+//
+// --csv prints one comma separated row per benchmark instead of a table, so
+// the output of two builds can be diffed or loaded into a spreadsheet.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "MachineBase/RLMachine.hpp"
+#include "Modules/Modules.hpp"
+#include "TestSystem/TestSystem.hpp"
+#include "libReallive/archive.h"
+#include "libReallive/expression.h"
+#include "libReallive/intmemref.h"
+#include "allocation_counter.hpp"
+#include "testUtils.hpp"
+
+namespace {
+
+// boost's microsec_clock (which the other benchmarks use) is too coarse to
+// time a single dispatch.
+typedef std::chrono::steady_clock Clock;
+
+// Guards against a script that never halts on the test system.
+const long kMaxInstructions = 10000000;
+
+// Number of times each synthetic expression is evaluated per pass.
+const int kEvaluations = 1000000;
+
+// Keeps the compiler from optimizing the evaluations away.
+volatile int sink = 0;
+
+struct Corpus {
+  const char* name;
+  std::vector<std::string> files;
+};
+
+const Corpus kCorpora[] = {
+  { "expressions", {
+      "ExpressionTest_SEEN/basicOperators.TXT",
+      "ExpressionTest_SEEN/comparisonOperators.TXT",
+      "ExpressionTest_SEEN/logicalOperators.TXT",
+      "ExpressionTest_SEEN/previousErrors.TXT" } },
+  { "jmp", {
+      "Module_Jmp_SEEN/farcallTest_0.TXT",
+      "Module_Jmp_SEEN/farcall_withTest.TXT",
+      "Module_Jmp_SEEN/gosub_0.TXT",
+      "Module_Jmp_SEEN/gosub_case_0.TXT",
+      "Module_Jmp_SEEN/gosub_if_0.TXT",
+      "Module_Jmp_SEEN/gosub_unless_0.TXT",
+      "Module_Jmp_SEEN/gosub_with_0.TXT",
+      "Module_Jmp_SEEN/goto_0.TXT",
+      "Module_Jmp_SEEN/goto_case_0.TXT",
+      "Module_Jmp_SEEN/goto_if_0.TXT",
+      "Module_Jmp_SEEN/goto_on_0.TXT",
+      "Module_Jmp_SEEN/goto_unless_0.TXT",
+      "Module_Jmp_SEEN/jumpTest.TXT",
+      "Module_Jmp_SEEN/jump_0.TXT",
+      "Module_Jmp_SEEN/pushStringValueUp.TXT" } },
+  { "mem", {
+      "Module_Mem_SEEN/cpyrng_0.TXT",
+      "Module_Mem_SEEN/cpyvars_0.TXT",
+      "Module_Mem_SEEN/setarray_0.TXT",
+      "Module_Mem_SEEN/setarray_stepped_0.TXT",
+      "Module_Mem_SEEN/setrng_0.TXT",
+      "Module_Mem_SEEN/setrng_1.TXT",
+      "Module_Mem_SEEN/setrng_stepped_0.TXT",
+      "Module_Mem_SEEN/setrng_stepped_1.TXT",
+      "Module_Mem_SEEN/sum_0.TXT" } },
+  { "str", {
+      "Module_Str_SEEN/atoi_0.TXT",
+      "Module_Str_SEEN/digits_0.TXT",
+      "Module_Str_SEEN/hantozen_0.TXT",
+      "Module_Str_SEEN/hantozen_1.TXT",
+      "Module_Str_SEEN/itoa_0.TXT",
+      "Module_Str_SEEN/itoa_s_0.TXT",
+      "Module_Str_SEEN/itoa_w_0.TXT",
+      "Module_Str_SEEN/itoa_ws_0.TXT",
+      "Module_Str_SEEN/lowercase_0.TXT",
+      "Module_Str_SEEN/lowercase_1.TXT",
+      "Module_Str_SEEN/strcat_0.TXT",
+      "Module_Str_SEEN/strcharlen_0.TXT",
+      "Module_Str_SEEN/strcharlen_1.TXT",
+      "Module_Str_SEEN/strclear_0.TXT",
+      "Module_Str_SEEN/strclear_1.TXT",
+      "Module_Str_SEEN/strcmp_0.TXT",
+      "Module_Str_SEEN/strcpy_0.TXT",
+      "Module_Str_SEEN/strcpy_1.TXT",
+      "Module_Str_SEEN/strlen_0.TXT",
+      "Module_Str_SEEN/strlpos_0.TXT",
+      "Module_Str_SEEN/strpos_0.TXT",
+      "Module_Str_SEEN/strrsub_0.TXT",
+      "Module_Str_SEEN/strrsub_1.TXT",
+      "Module_Str_SEEN/strsub_0.TXT",
+      "Module_Str_SEEN/strsub_1.TXT",
+      "Module_Str_SEEN/strsub_2.TXT",
+      "Module_Str_SEEN/strsub_3.TXT",
+      "Module_Str_SEEN/strtrunc_0.TXT",
+      "Module_Str_SEEN/strtrunc_1.TXT",
+      "Module_Str_SEEN/strused_0.TXT",
+      "Module_Str_SEEN/uppercase_0.TXT",
+      "Module_Str_SEEN/uppercase_1.TXT",
+      "Module_Str_SEEN/zentohan_0.TXT",
+      "Module_Str_SEEN/zentohan_1.TXT" } },
+  { "sys", {
+      "Module_Sys_SEEN/SceneNum.TXT",
+      "Module_Sys_SEEN/builtins.TXT" } }
+};
+
+// Synthetic expressions, written the way printableToParsableString() wants
+// them.
+struct SyntheticExpression {
+  const char* name;
+  bool assignment;
+  const char* printable;
+};
+
+const SyntheticExpression kExpressions[] = {
+  // intA[0] += 1
+  { "expr:increment", true,
+    "$ 00 [ $ FF 00 00 00 00 ] 5c 14 $ FF 01 00 00 00" },
+  // intB[intC[0]] = intC[1] - 1
+  { "expr:indexed", true,
+    "$ 01 [ $ 02 [ $ FF 00 00 00 00 ] ] 5c 1e "
+    "$ 02 [ $ FF 01 00 00 00 ] 5c 01 $ FF 01 00 00 00" },
+  // intC[0] * 3 + intC[1] / 2
+  { "expr:arithmetic", false,
+    "$ 02 [ $ FF 00 00 00 00 ] 5c 02 $ FF 03 00 00 00 5c 00 "
+    "$ 02 [ $ FF 01 00 00 00 ] 5c 03 $ FF 02 00 00 00" },
+  // intC[0] == 5 && intC[1] < 3
+  { "expr:logical", false,
+    "$ 02 [ $ FF 00 00 00 00 ] 5c 28 $ FF 05 00 00 00 5c 3c "
+    "$ 02 [ $ FF 01 00 00 00 ] 5c 2b $ FF 03 00 00 00" }
+};
+
+struct Result {
+  Result() : operations(0), seconds(0), allocations(0) {}
+
+  std::string name;
+  long operations;
+  double seconds;
+  long allocations;
+
+  // Time of each dispatch in the sampling pass, in nanoseconds.
+  std::vector<double> latencies;
+};
+
+double Nanoseconds(const Clock::time_point& start,
+                   const Clock::time_point& end) {
+  return std::chrono::duration<double, std::nano>(end - start).count();
+}
+
+// Runs |file| to completion and adds the instructions executed, the time they
+// took and the allocations they made to |result|. When |sample| is set, every
+// dispatch is timed individually instead.
+void RunScenario(const std::string& file, int fib_argument, bool sample,
+                 Result& result) {
+  libReallive::Archive arc(locateTestCase(file));
+  TestSystem system;
+  RLMachine machine(system, arc);
+  addAllModules(machine);
+  machine.setPrintUndefinedOpcodes(false);
+  if (fib_argument >= 0)
+    machine.setIntValue(libReallive::IntMemRef('D', 0), fib_argument);
+
+  long instructions = 0;
+  if (sample) {
+    while (!machine.halted() && instructions < kMaxInstructions) {
+      Clock::time_point before = Clock::now();
+      machine.executeNextInstruction();
+      result.latencies.push_back(Nanoseconds(before, Clock::now()));
+      ++instructions;
+    }
+  } else {
+    ScopedAllocationCounter counter;
+    Clock::time_point start = Clock::now();
+    while (!machine.halted() && instructions < kMaxInstructions) {
+      machine.executeNextInstruction();
+      ++instructions;
+    }
+    result.seconds += Nanoseconds(start, Clock::now()) / 1e9;
+    result.operations += instructions;
+    result.allocations += counter.count();
+  }
+}
+
+Result RunCorpus(const std::string& name,
+                 const std::vector<std::string>& files,
+                 int fib_argument, int passes) {
+  Result result;
+  result.name = name;
+  for (int pass = 0; pass < passes; ++pass) {
+    for (const std::string& file : files)
+      RunScenario(file, fib_argument, false, result);
+  }
+  for (const std::string& file : files)
+    RunScenario(file, fib_argument, true, result);
+  return result;
+}
+
+Result RunExpression(const SyntheticExpression& expression, int passes) {
+  Result result;
+  result.name = expression.name;
+
+  libReallive::Archive arc(locateTestCase("Module_Str_SEEN/strcpy_0.TXT"));
+  TestSystem system;
+  RLMachine machine(system, arc);
+  machine.setIntValue(libReallive::IntMemRef('C', 0), 5);
+  machine.setIntValue(libReallive::IntMemRef('C', 1), 2);
+
+  std::string parsable =
+      libReallive::printableToParsableString(expression.printable);
+  const char* src = parsable.c_str();
+  std::unique_ptr<libReallive::ExpressionPiece> piece(
+      expression.assignment ? libReallive::get_assignment(src) :
+                              libReallive::get_expression(src));
+
+  for (int pass = 0; pass < passes; ++pass) {
+    ScopedAllocationCounter counter;
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < kEvaluations; ++i)
+      sink += piece->integerValue(machine);
+    result.seconds += Nanoseconds(start, Clock::now()) / 1e9;
+    result.operations += kEvaluations;
+    result.allocations += counter.count();
+  }
+
+  // Individual evaluations are close to the resolution of the clock, so the
+  // samples are only good for spotting outliers.
+  result.latencies.reserve(kEvaluations);
+  for (int i = 0; i < kEvaluations; ++i) {
+    Clock::time_point before = Clock::now();
+    sink += piece->integerValue(machine);
+    result.latencies.push_back(Nanoseconds(before, Clock::now()));
+  }
+
+  return result;
+}
+
+double Percentile(std::vector<double>& samples, double fraction) {
+  if (samples.empty())
+    return 0;
+  std::vector<double>::iterator nth =
+      samples.begin() + static_cast<size_t>(fraction * (samples.size() - 1));
+  std::nth_element(samples.begin(), nth, samples.end());
+  return *nth;
+}
+
+void PrintHeader(bool csv) {
+  if (csv) {
+    std::cout << "benchmark,operations,seconds,operations_per_second,"
+              << "p50_ns,p90_ns,p99_ns,allocations_per_operation"
+              << std::endl;
+  } else {
+    std::cout << std::left << std::setw(18) << "benchmark"
+              << std::right << std::setw(14) << "ops/s"
+              << std::setw(10) << "p50 ns"
+              << std::setw(10) << "p90 ns"
+              << std::setw(10) << "p99 ns"
+              << std::setw(12) << "allocs/op" << std::endl;
+  }
+}
+
+void PrintResult(Result& result, bool csv) {
+  double per_second =
+      result.seconds > 0 ? result.operations / result.seconds : 0;
+  double allocations_per_operation =
+      result.operations ? double(result.allocations) / result.operations : 0;
+  double p50 = Percentile(result.latencies, 0.50);
+  double p90 = Percentile(result.latencies, 0.90);
+  double p99 = Percentile(result.latencies, 0.99);
+
+  if (csv) {
+    std::cout << result.name << "," << result.operations << ","
+              << std::fixed << std::setprecision(6) << result.seconds << ","
+              << std::setprecision(1) << per_second << "," << p50 << ","
+              << p90 << "," << p99 << "," << std::setprecision(3)
+              << allocations_per_operation << std::endl;
+  } else {
+    std::cout << std::left << std::setw(18) << result.name
+              << std::right << std::fixed << std::setprecision(0)
+              << std::setw(14) << per_second
+              << std::setw(10) << p50
+              << std::setw(10) << p90
+              << std::setw(10) << p99
+              << std::setprecision(2) << std::setw(12)
+              << allocations_per_operation << std::endl;
+  }
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  int passes = 10;
+  int fib_argument = 15;
+  bool csv = false;
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "--csv") == 0)
+      csv = true;
+    else if (strcmp(argv[i], "--passes") == 0 && i + 1 < argc)
+      passes = atoi(argv[++i]);
+    else if (strcmp(argv[i], "--fib") == 0 && i + 1 < argc)
+      fib_argument = atoi(argv[++i]);
+    else
+      passes = 0;
+  }
+
+  if (passes <= 0 || fib_argument < 0) {
+    std::cerr << "Usage: " << argv[0] << " [--passes N] [--fib N] [--csv]"
+              << std::endl;
+    return 1;
+  }
+
+  PrintHeader(csv);
+
+  for (const Corpus& corpus : kCorpora) {
+    Result result = RunCorpus(corpus.name, corpus.files, -1, passes);
+    PrintResult(result, csv);
+  }
+
+  Result fibonacci = RunCorpus(
+      "fibonacci", { "Module_Jmp_SEEN/fibonacci.TXT" }, fib_argument, passes);
+  PrintResult(fibonacci, csv);
+
+  for (const SyntheticExpression& expression : kExpressions) {
+    Result result = RunExpression(expression, passes);
+    PrintResult(result, csv);
+  }
+
+  return 0;
+}
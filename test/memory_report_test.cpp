@@ -0,0 +1,81 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2013 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+// -----------------------------------------------------------------------
+
+#include "gtest/gtest.h"
+
+#include <sstream>
+#include <string>
+
+#include "Systems/Base/MemoryReport.hpp"
+#include "Utilities/SavepointShadow.hpp"
+
+TEST(MemoryReportTest, Lines) {
+  MemoryReport report;
+  report.add("Surfaces", 4096, 2);
+  report.add("Text pages", 300, 5);
+
+  ASSERT_EQ(2, report.lines().size());
+  EXPECT_EQ("Surfaces", report.lines()[0].name);
+  EXPECT_EQ(4096, report.lines()[0].bytes);
+  EXPECT_EQ(2, report.lines()[0].items);
+  EXPECT_EQ(300, report.bytes("Text pages"));
+  EXPECT_EQ(0, report.bytes("Voice archives"));
+}
+
+TEST(MemoryReportTest, FormatBytes) {
+  EXPECT_EQ("0 B", formatBytes(0));
+  EXPECT_EQ("1023 B", formatBytes(1023));
+  EXPECT_EQ("1.5 KB", formatBytes(1536));
+  EXPECT_EQ("3.0 MB", formatBytes(3 * 1024 * 1024));
+}
+
+TEST(MemoryReportTest, Summary) {
+  MemoryReport report;
+  report.add("Surfaces", 2048, 1);
+  report.add("Text pages", 10, 1);
+  EXPECT_EQ("Surfaces 2.0 KB, Text pages 10 B", report.summary());
+
+  std::ostringstream oss;
+  oss << report;
+  EXPECT_NE(std::string::npos, oss.str().find("Surfaces"));
+  EXPECT_NE(std::string::npos, oss.str().find("2.0 KB"));
+}
+
+// Stale originals still hold memory until they're overwritten, so the memory
+// report has to see them.
+TEST(MemoryReportTest, ShadowCountsStaleOriginals) {
+  SavepointShadow<int, int> shadow;
+  shadow.recordOriginal(1, 10);
+  shadow.mark();
+  shadow.recordOriginal(2, 20);
+
+  int originals = 0;
+  shadow.forEachOriginal([&](int key, int value) { originals++; });
+  int stored = 0;
+  shadow.forEachStoredValue([&](int value) { stored++; });
+  EXPECT_EQ(1, originals);
+  EXPECT_EQ(2, stored);
+}
@@ -0,0 +1,135 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2013 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+// -----------------------------------------------------------------------
+
+// Standalone benchmark for the NWA decoders in vendor/xclannad/nwatowav.cc.
+// Decodes each NWA file given on the command line with jagarl's reference
+// decoder, the fast decoder on one thread and the fast decoder on all cores,
+// checks that all three produce identical PCM, and prints the throughput of
+// each in megabytes of PCM per second.
+//
+// Usage: nwaBenchmark [--iterations N] file.nwa [file.nwa...]
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+
+#include "xclannad/wavfile.h"
+
+using boost::posix_time::microsec_clock;
+using boost::posix_time::ptime;
+
+namespace {
+
+struct DecodeResult {
+  DecodeResult() : data(NULL), size(0), seconds(0) {}
+
+  char* data;
+  int size;
+  double seconds;
+};
+
+// Decodes |file| |iterations| times, keeping the output of the last run.
+DecodeResult RunDecoder(FILE* file, NWADecoder decoder, int threads,
+                        int iterations) {
+  DecodeResult result;
+  ptime start = microsec_clock::universal_time();
+  for (int i = 0; i < iterations; ++i) {
+    delete [] result.data;
+    fseek(file, 0, SEEK_SET);
+    result.data = NWAFILE::ReadAll(file, result.size, decoder, threads);
+  }
+  ptime end = microsec_clock::universal_time();
+  result.seconds = (end - start).total_microseconds() / 1000000.0;
+  return result;
+}
+
+void PrintResult(const std::string& name, const DecodeResult& result,
+                 int iterations) {
+  double megabytes = double(result.size) * iterations / (1024 * 1024);
+  std::cout << "  " << std::left << std::setw(16) << name
+            << std::right << std::setw(10) << std::fixed
+            << std::setprecision(2) << megabytes / result.seconds
+            << " MB/s" << std::endl;
+}
+
+bool SameOutput(const DecodeResult& lhs, const DecodeResult& rhs) {
+  return lhs.data && rhs.data && lhs.size == rhs.size &&
+      memcmp(lhs.data, rhs.data, lhs.size) == 0;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  int iterations = 10;
+  int first_file = 1;
+  if (argc > 2 && strcmp(argv[1], "--iterations") == 0) {
+    iterations = atoi(argv[2]);
+    first_file = 3;
+  }
+
+  if (first_file >= argc || iterations <= 0) {
+    std::cerr << "Usage: " << argv[0]
+              << " [--iterations N] file.nwa [file.nwa...]" << std::endl;
+    return 1;
+  }
+
+  int mismatches = 0;
+  for (int i = first_file; i < argc; ++i) {
+    FILE* file = fopen(argv[i], "rb");
+    if (!file) {
+      std::cerr << "Could not open " << argv[i] << std::endl;
+      return 1;
+    }
+
+    DecodeResult reference =
+        RunDecoder(file, NWA_DECODER_REFERENCE, 1, iterations);
+    DecodeResult fast = RunDecoder(file, NWA_DECODER_FAST, 1, iterations);
+    DecodeResult parallel = RunDecoder(file, NWA_DECODER_FAST, 0, iterations);
+    fclose(file);
+
+    std::cout << argv[i] << " (" << reference.size << " bytes of PCM)"
+              << std::endl;
+    PrintResult("reference", reference, iterations);
+    PrintResult("fast", fast, iterations);
+    PrintResult("fast, threaded", parallel, iterations);
+
+    if (!SameOutput(reference, fast) || !SameOutput(reference, parallel)) {
+      std::cout << "  MISMATCH: decoders produced different PCM!" << std::endl;
+      mismatches++;
+    }
+
+    delete [] reference.data;
+    delete [] fast.data;
+    delete [] parallel.data;
+  }
+
+  return mismatches ? 1 : 0;
+}
@@ -0,0 +1,107 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2013 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+// -----------------------------------------------------------------------
+#include "gtest/gtest.h"
+
+#include "MachineBase/OpcodeProfiler.hpp"
+#include "MachineBase/RLMachine.hpp"
+#include "Modules/Module_Jmp.hpp"
+#include "Modules/Module_Sys.hpp"
+#include "TestSystem/TestSystem.hpp"
+#include "libReallive/archive.h"
+
+#include "testUtils.hpp"
+
+#include <string>
+
+namespace {
+
+const OpcodeProfiler::Entry* findOpcode(const OpcodeProfiler& profiler,
+                                        const std::string& prefix) {
+  for (auto const& entry : profiler.opcodes()) {
+    if (entry.second.name.compare(0, prefix.size(), prefix) == 0)
+      return &entry.second;
+  }
+  return NULL;
+}
+
+}  // namespace
+
+// SceneNum.TXT calls SceneNum() once in each of its three scenarios.
+TEST(OpcodeProfilerTest, CountsDispatches) {
+  libReallive::Archive arc(locateTestCase("Module_Sys_SEEN/SceneNum.TXT"));
+  TestSystem system;
+  RLMachine rlmachine(system, arc);
+  rlmachine.attachModule(new SysModule);
+  rlmachine.attachModule(new JmpModule);
+  rlmachine.profileOpcodes();
+  rlmachine.executeUntilHalted();
+
+  const OpcodeProfiler* profiler = rlmachine.opcodeProfiler();
+  ASSERT_TRUE(profiler);
+  const OpcodeProfiler::Entry* scene_num = findOpcode(*profiler,
+                                                      "Sys.SceneNum");
+  ASSERT_TRUE(scene_num);
+  EXPECT_EQ(3, scene_num->count);
+
+  // Every dispatch is also charged to the line it came from.
+  long opcode_count = 0;
+  for (auto const& entry : profiler->opcodes())
+    opcode_count += entry.second.count;
+  long line_count = 0;
+  for (auto const& entry : profiler->lines())
+    line_count += entry.second.count;
+  EXPECT_EQ(opcode_count, line_count);
+}
+
+// LongOperations pushed outside of any opcode (like textout) are charged to
+// the line they were pushed from, and forgotten once they finish.
+TEST(OpcodeProfilerTest, ChargesLongOperationsToTheirLine) {
+  OpcodeProfiler profiler;
+  const LongOperation* long_operation =
+      reinterpret_cast<const LongOperation*>(&profiler);
+  profiler.attributeLongOperation(long_operation, 42, 7);
+  profiler.beginLongOperation(long_operation);
+  profiler.endLongOperation(false);
+  profiler.beginLongOperation(long_operation);
+  profiler.endLongOperation(true);
+
+  const OpcodeProfiler::Entry* no_opcode = findOpcode(profiler, "(no opcode)");
+  ASSERT_TRUE(no_opcode);
+  EXPECT_EQ(0, no_opcode->count);
+
+  OpcodeProfiler::LineStorage::const_iterator line =
+      profiler.lines().find(OpcodeProfiler::LineKey(42, 7));
+  ASSERT_TRUE(line != profiler.lines().end());
+  EXPECT_EQ(no_opcode->long_operation_time.count(),
+            line->second.long_operation_time.count());
+
+  // Running it again after it finished no longer reaches the line.
+  OpcodeProfiler::Clock::duration line_time = line->second.long_operation_time;
+  profiler.beginLongOperation(long_operation);
+  profiler.endLongOperation(true);
+  EXPECT_EQ(line_time.count(), line->second.long_operation_time.count());
+}
@@ -0,0 +1,103 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2013 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+// -----------------------------------------------------------------------
+
+
+#include "gtest/gtest.h"
+
+#include "MachineBase/Memory.hpp"
+#include "MachineBase/ParameterPreparser.hpp"
+#include "MachineBase/RLMachine.hpp"
+#include "Modules/Module_Str.hpp"
+#include "libReallive/bytecode.h"
+#include "libReallive/intmemref.h"
+#include "libReallive/scenario.h"
+
+#include "testUtils.hpp"
+
+#include <string>
+
+using libReallive::CommandElement;
+using libReallive::STRS_LOCATION;
+using libReallive::Scenario;
+
+class ParameterPreparserTest : public FullSystemTest {
+ protected:
+  ParameterPreparserTest() {
+    rlmachine.attachModule(new StrModule);
+  }
+
+  // Counts the commands in |scenario| that have an operation, and how many
+  // of those already have their parameters parsed.
+  void countCommands(const Scenario& scenario, int* known, int* parsed) {
+    *known = 0;
+    *parsed = 0;
+    for (Scenario::const_iterator it = scenario.begin(); it != scenario.end();
+         ++it) {
+      const CommandElement* command =
+          dynamic_cast<const CommandElement*>(&*it);
+      if (command && rlmachine.findOperation(*command)) {
+        ++*known;
+        if (command->areParametersParsed())
+          ++*parsed;
+      }
+    }
+  }
+};
+
+TEST_F(ParameterPreparserTest, ParsesKnownCommands) {
+  const Scenario& scenario = rlmachine.scenario();
+  int known, parsed;
+  countCommands(scenario, &known, &parsed);
+  ASSERT_LT(0, known);
+  EXPECT_EQ(0, parsed);
+
+  ParameterPreparser preparser(rlmachine);
+  preparser.queueScenario(&scenario);
+  preparser.flush();
+
+  // Nothing is handed to the bytecode until the interpreter thread asks.
+  countCommands(scenario, &known, &parsed);
+  EXPECT_EQ(0, parsed);
+
+  preparser.installParsedParameters();
+  countCommands(scenario, &known, &parsed);
+  EXPECT_EQ(known, parsed);
+
+  // Queueing the scenario again has nothing left to do.
+  preparser.queueScenario(&scenario);
+  preparser.flush();
+  preparser.installParsedParameters();
+  countCommands(scenario, &known, &parsed);
+  EXPECT_EQ(known, parsed);
+}
+
+TEST_F(ParameterPreparserTest, ExecutesTheSame) {
+  rlmachine.preparseParameters();
+  rlmachine.executeUntilHalted();
+
+  EXPECT_EQ("valid", rlmachine.getStringValue(STRS_LOCATION, 0));
+}
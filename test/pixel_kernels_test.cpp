@@ -0,0 +1,156 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2013 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+// -----------------------------------------------------------------------
+
+#include "gtest/gtest.h"
+
+#include <cstdlib>
+#include <vector>
+
+#include "Systems/Base/PixelKernels.hpp"
+
+namespace {
+
+// The layout of the surfaces buildNewSurface() makes.
+const PixelLayout kLayout(16, 8, 0, 24);
+
+std::vector<uint32_t> RandomPixels(int count, unsigned int seed) {
+  std::vector<uint32_t> pixels(count);
+  srand(seed);
+  for (int i = 0; i < count; ++i) {
+    pixels[i] = (rand() & 0xffff) | ((rand() & 0xffff) << 16);
+    // Make sure the special cases of blending come up.
+    if (i % 7 == 0)
+      pixels[i] |= 0xff000000;
+    else if (i % 11 == 0)
+      pixels[i] &= 0x00ffffff;
+  }
+  return pixels;
+}
+
+uint8_t Channel(uint32_t pixel, int shift) {
+  return (pixel >> shift) & 0xff;
+}
+
+}  // namespace
+
+// Odd widths make sure the vector loops hand the leftovers to the scalar
+// ones, and the large size goes through the worker pool.
+class PixelKernelsTest : public ::testing::TestWithParam<int> {
+ protected:
+  int width() const { return GetParam(); }
+  int height() const { return GetParam() > 500 ? 600 : 3; }
+};
+
+TEST_P(PixelKernelsTest, AlphaBlendMatchesPerPixelBlend) {
+  int count = width() * height();
+  std::vector<uint32_t> src = RandomPixels(count, 1);
+  std::vector<uint32_t> dst = RandomPixels(count, 2);
+  std::vector<uint32_t> original = dst;
+
+  AlphaBlendPixels(PixelRect(&src[0], width() * 4, width(), height()),
+                   PixelRect(&dst[0], width() * 4, width(), height()),
+                   kLayout);
+
+  for (int i = 0; i < count; ++i) {
+    int a = Channel(src[i], 24);
+    ASSERT_EQ(Channel(original[i], 24), Channel(dst[i], 24)) << i;
+    for (int shift = 0; shift < 24; shift += 8) {
+      int s = Channel(src[i], shift), d = Channel(original[i], shift);
+      int expected = a == 255 ? s : d + (((s - d) * a) >> 8);
+      ASSERT_EQ(expected, Channel(dst[i], shift))
+          << "Pixel " << i << " shift " << shift;
+    }
+  }
+}
+
+TEST_P(PixelKernelsTest, MonoMatchesFloatingPoint) {
+  int count = width() * height();
+  std::vector<uint32_t> pixels = RandomPixels(count, 3);
+  std::vector<uint32_t> original = pixels;
+
+  MonoPixels(PixelRect(&pixels[0], width() * 4, width(), height()), kLayout);
+
+  for (int i = 0; i < count; ++i) {
+    float grey = 0.3 * Channel(original[i], 16) +
+                 0.59 * Channel(original[i], 8) +
+                 0.11 * Channel(original[i], 0);
+    uint8_t expected = grey > 255 ? 255 : static_cast<uint8_t>(grey);
+    ASSERT_EQ(expected, Channel(pixels[i], 16)) << i;
+    ASSERT_EQ(expected, Channel(pixels[i], 8)) << i;
+    ASSERT_EQ(expected, Channel(pixels[i], 0)) << i;
+    ASSERT_EQ(Channel(original[i], 24), Channel(pixels[i], 24)) << i;
+  }
+}
+
+TEST_P(PixelKernelsTest, InvertAndMapLeaveAlphaAlone) {
+  int count = width() * height();
+  std::vector<uint32_t> pixels = RandomPixels(count, 4);
+  std::vector<uint32_t> original = pixels;
+  PixelRect rect(&pixels[0], width() * 4, width(), height());
+
+  InvertPixels(rect, kLayout);
+  for (int i = 0; i < count; ++i)
+    ASSERT_EQ(original[i] ^ 0x00ffffff, pixels[i]) << i;
+
+  ChannelMap r, g, b;
+  for (int i = 0; i < 256; ++i) {
+    r[i] = 255 - i;
+    g[i] = i / 2;
+    b[i] = 7;
+  }
+  MapPixelChannels(rect, kLayout, r, g, b);
+  for (int i = 0; i < count; ++i) {
+    uint32_t inverted = original[i] ^ 0x00ffffff;
+    uint32_t expected = (inverted & 0xff000000) |
+                        (r[Channel(inverted, 16)] << 16) |
+                        (g[Channel(inverted, 8)] << 8) | 7;
+    ASSERT_EQ(expected, pixels[i]) << i;
+  }
+}
+
+TEST_P(PixelKernelsTest, FillAndCopyStayInsideTheRect) {
+  // A rectangle inside a larger buffer, so the pitch is wider than a row.
+  int pitch_pixels = width() + 5;
+  std::vector<uint32_t> pixels(pitch_pixels * height(), 0x12345678);
+  PixelRect rect(&pixels[2], pitch_pixels * 4, width(), height());
+
+  FillPixels(rect, 0xdeadbeef);
+  for (int y = 0; y < height(); ++y) {
+    for (int x = 0; x < pitch_pixels; ++x) {
+      bool inside = x >= 2 && x < 2 + width();
+      ASSERT_EQ(inside ? 0xdeadbeef : 0x12345678,
+                pixels[y * pitch_pixels + x]) << x << ", " << y;
+    }
+  }
+
+  std::vector<uint32_t> copy(width() * height(), 0);
+  CopyPixels(rect, PixelRect(&copy[0], width() * 4, width(), height()));
+  for (size_t i = 0; i < copy.size(); ++i)
+    ASSERT_EQ(0xdeadbeef, copy[i]) << i;
+}
+
+INSTANTIATE_TEST_CASE_P(Widths, PixelKernelsTest,
+                        ::testing::Values(1, 7, 64, 801));
@@ -0,0 +1,131 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2013 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+// -----------------------------------------------------------------------
+
+#include "gtest/gtest.h"
+
+#include <vector>
+
+#include "Systems/Base/QuadBatch.hpp"
+
+namespace {
+
+struct Submission {
+  unsigned int texture;
+  QuadBatch::BlendMode mode;
+  std::vector<QuadBatch::Vertex> vertices;
+};
+
+// Records every batch instead of drawing it.
+class RecordingSubmitter {
+ public:
+  explicit RecordingSubmitter(std::vector<Submission>* out) : out_(out) {}
+
+  void operator()(unsigned int texture, QuadBatch::BlendMode mode,
+                  const QuadBatch::Vertex* vertices, int quads) {
+    Submission submission;
+    submission.texture = texture;
+    submission.mode = mode;
+    submission.vertices.assign(vertices, vertices + quads * 4);
+    out_->push_back(submission);
+  }
+
+ private:
+  std::vector<Submission>* out_;
+};
+
+void AddQuad(QuadBatch& batch, unsigned int texture, QuadBatch::BlendMode mode,
+             float x) {
+  QuadBatch::Vertex quad[4] = {
+    { x, 0, 0, 0, 255, 255, 255, 255 },
+    { x + 1, 0, 1, 0, 255, 255, 255, 255 },
+    { x + 1, 1, 1, 1, 255, 255, 255, 255 },
+    { x, 1, 0, 1, 255, 255, 255, 255 }
+  };
+  batch.addQuad(texture, mode, quad);
+}
+
+}  // namespace
+
+TEST(QuadBatchTest, SameStateIsOneDrawCall) {
+  std::vector<Submission> submissions;
+  QuadBatch batch((RecordingSubmitter(&submissions)));
+
+  // Like a DriftGraphicsObject: many particles from one texture.
+  for (int i = 0; i < 100; ++i)
+    AddQuad(batch, 7, QuadBatch::BLEND_ALPHA, i);
+  EXPECT_TRUE(submissions.empty()) << "Nothing is drawn until a flush.";
+
+  batch.flush();
+  ASSERT_EQ(1u, submissions.size());
+  EXPECT_EQ(7u, submissions[0].texture);
+  EXPECT_EQ(400u, submissions[0].vertices.size());
+  EXPECT_EQ(42, submissions[0].vertices[42 * 4].x);
+  EXPECT_EQ(1u, batch.stats().draw_calls);
+  EXPECT_EQ(100u, batch.stats().quads);
+  EXPECT_EQ(0, batch.pendingQuads());
+}
+
+TEST(QuadBatchTest, StateChangesSplitBatches) {
+  std::vector<Submission> submissions;
+  QuadBatch batch((RecordingSubmitter(&submissions)));
+
+  AddQuad(batch, 1, QuadBatch::BLEND_ALPHA, 0);
+  AddQuad(batch, 1, QuadBatch::BLEND_ALPHA, 1);
+  AddQuad(batch, 2, QuadBatch::BLEND_ALPHA, 2);
+  AddQuad(batch, 2, QuadBatch::BLEND_ADDITIVE, 3);
+  batch.flush();
+
+  ASSERT_EQ(3u, submissions.size());
+  EXPECT_EQ(8u, submissions[0].vertices.size());
+  EXPECT_EQ(2u, submissions[1].texture);
+  EXPECT_EQ(QuadBatch::BLEND_ADDITIVE, submissions[2].mode);
+  EXPECT_EQ(3u, batch.stats().draw_calls);
+  EXPECT_EQ(2u, batch.stats().texture_binds)
+      << "Changing only the blend mode doesn't need a new texture.";
+  EXPECT_EQ(2u, batch.stats().state_changes);
+}
+
+TEST(QuadBatchTest, FullBatchFlushes) {
+  std::vector<Submission> submissions;
+  QuadBatch batch((RecordingSubmitter(&submissions)));
+
+  for (int i = 0; i < QuadBatch::MAX_QUADS + 1; ++i)
+    AddQuad(batch, 1, QuadBatch::BLEND_ALPHA, i);
+  ASSERT_EQ(1u, submissions.size());
+  EXPECT_EQ(QuadBatch::MAX_QUADS * 4u, submissions[0].vertices.size());
+  EXPECT_EQ(1, batch.pendingQuads());
+  EXPECT_EQ(0u, batch.stats().state_changes);
+}
+
+TEST(QuadBatchTest, EmptyFlushDoesNothing) {
+  std::vector<Submission> submissions;
+  QuadBatch batch((RecordingSubmitter(&submissions)));
+
+  batch.flush();
+  EXPECT_TRUE(submissions.empty());
+  EXPECT_EQ(0u, batch.stats().draw_calls);
+}
@@ -27,6 +27,11 @@
 
 #include "gtest/gtest.h"
 
+#include <boost/archive/text_oarchive.hpp>
+#include <boost/date_time/posix_time/time_serialize.hpp>
+#include <boost/filesystem/operations.hpp>
+#include <boost/iostreams/filter/zlib.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
 #include <boost/lexical_cast.hpp>
 #include <iostream>
 #include <utility>
@@ -35,8 +40,13 @@
 
 #include "MachineBase/Memory.hpp"
 #include "MachineBase/RLMachine.hpp"
+#include "MachineBase/SaveGameHeader.hpp"
 #include "MachineBase/Serialization.hpp"
 #include "Modules/Module_Str.hpp"
+#include "Systems/Base/GraphicsObject.hpp"
+#include "Systems/Base/GraphicsSystem.hpp"
+#include "Systems/Base/ObjectMutator.hpp"
+#include "TestSystem/TestEventSystem.hpp"
 #include "Utilities/Exception.hpp"
 #include "libReallive/intmemref.h"
 #include "testUtils.hpp"
@@ -250,6 +260,49 @@ TEST_F(RLMachineTest, SerializationOfKidoku) {
   }
 }
 
+TEST_F(RLMachineTest, GlobalMemorySurvivesFailedBaseWrite) {
+  libReallive::Archive arc(locateTestCase("Module_Str_SEEN/strcpy_0.TXT"));
+  system.gameexe().setStringAt(
+      "REGNAME",
+      boost::filesystem::unique_path("rlvm-test-%%%%-%%%%").string());
+  boost::filesystem::path save_dir = system.gameSaveDirectory();
+
+  {
+    RLMachine saveMachine(system, arc);
+    saveMachine.setIntValue(IntMemRef('G', 0), 1);
+    Serialization::saveGlobalMemory(saveMachine);
+    Serialization::waitForPendingSaves();
+
+    // A directory in the way of the temporary file makes every later base
+    // write fail, while the journal can still be appended to.
+    boost::filesystem::create_directory(save_dir / "global.sav.gz.tmp");
+
+    // Grow the journal past the point where the next save writes a new base.
+    for (int i = 0; i < 300; ++i)
+      saveMachine.setStringValue(STRM_LOCATION, i, string(1000, 'a' + i % 26));
+    Serialization::saveGlobalMemory(saveMachine);
+    Serialization::waitForPendingSaves();
+
+    saveMachine.setIntValue(IntMemRef('G', 1), 2);
+    Serialization::saveGlobalMemory(saveMachine);
+    saveMachine.setIntValue(IntMemRef('G', 2), 3);
+    Serialization::saveGlobalMemory(saveMachine);
+    Serialization::waitForPendingSaves();
+  }
+
+  {
+    RLMachine loadMachine(system, arc);
+    Serialization::loadGlobalMemory(loadMachine);
+    EXPECT_EQ(1, loadMachine.getIntValue(IntMemRef('G', 0)));
+    EXPECT_EQ(2, loadMachine.getIntValue(IntMemRef('G', 1)));
+    EXPECT_EQ(3, loadMachine.getIntValue(IntMemRef('G', 2)));
+    EXPECT_EQ(string(1000, 'a' + 299 % 26),
+              loadMachine.getStringValue(STRM_LOCATION, 299));
+  }
+
+  boost::filesystem::remove_all(save_dir);
+}
+
 TEST_F(RLMachineTest, SerializationOfSavepointValues) {
   stringstream ss;
   libReallive::Archive arc(locateTestCase("Module_Str_SEEN/strcpy_0.TXT"));
@@ -284,3 +337,156 @@ TEST_F(RLMachineTest, SerializationOfSavepointValues) {
     verifyStrMemoryCountingFrom(loadMachine, STRS_LOCATION, 0);
   }
 }
+
+TEST_F(RLMachineTest, SerializationOfLatestSavepoint) {
+  stringstream ss;
+  libReallive::Archive arc(locateTestCase("Module_Str_SEEN/strcpy_0.TXT"));
+  {
+    RLMachine saveMachine(system, arc);
+    setIntMemoryCountingFrom(saveMachine, LOCAL_INTEGER_BANKS, 0);
+    setStrMemoryCountingFrom(saveMachine, STRS_LOCATION, 0);
+    saveMachine.markSavepoint();
+
+    // Changes before the latest savepoint are committed...
+    setIntMemoryCountingFrom(saveMachine, LOCAL_INTEGER_BANKS, 5);
+    setStrMemoryCountingFrom(saveMachine, STRS_LOCATION, 5);
+    saveMachine.markSavepoint();
+
+    // ...and changes after it aren't.
+    setIntMemoryCountingFrom(saveMachine, LOCAL_INTEGER_BANKS, 10);
+    setStrMemoryCountingFrom(saveMachine, STRS_LOCATION, 10);
+
+    Serialization::saveGameTo(ss, saveMachine);
+  }
+
+  {
+    RLMachine loadMachine(system, arc);
+    Serialization::loadGameFrom(ss, loadMachine);
+    verifyIntMemoryCountingFrom(loadMachine, LOCAL_INTEGER_BANKS, 5);
+    verifyStrMemoryCountingFrom(loadMachine, STRS_LOCATION, 5);
+  }
+}
+
+TEST_F(RLMachineTest, SerializationOfSavepointObjects) {
+  stringstream ss;
+  libReallive::Archive arc(locateTestCase("Module_Str_SEEN/strcpy_0.TXT"));
+  {
+    RLMachine saveMachine(system, arc);
+    GraphicsSystem& graphics = system.graphics();
+    graphics.getObject(OBJ_FG, 3).setX(10);
+    saveMachine.markSavepoint();
+
+    // Neither of these happened as far as the savepoint is concerned.
+    graphics.getObject(OBJ_FG, 3).setX(20);
+    graphics.getObject(OBJ_FG, 4).setX(5);
+    EXPECT_EQ(20, graphics.getObject(OBJ_FG, 3).x());
+
+    Serialization::saveGameTo(ss, saveMachine);
+  }
+
+  {
+    RLMachine loadMachine(system, arc);
+    Serialization::loadGameFrom(ss, loadMachine);
+    GraphicsSystem& graphics = system.graphics();
+    EXPECT_EQ(10, graphics.getObject(OBJ_FG, 3).x());
+    EXPECT_FALSE(graphics.foregroundObjects().exists(4));
+  }
+}
+
+// A clock that is always well past the end of any mutator started at 0.
+class LateTickCounter : public EventSystemMockHandler {
+ public:
+  virtual unsigned int getTicks() const { return 1000; }
+};
+
+TEST_F(RLMachineTest, SerializationOfObjectsMutatedAfterSavepoint) {
+  stringstream ss;
+  libReallive::Archive arc(locateTestCase("Module_Str_SEEN/strcpy_0.TXT"));
+  {
+    RLMachine saveMachine(system, arc);
+    GraphicsSystem& graphics = system.graphics();
+    GraphicsObject& object = graphics.getObject(OBJ_FG, 3);
+    object.setX(10);
+    object.AddObjectMutator(new OneIntObjectMutator(
+        "objEveX", 0, 100, 0, 0, 10, 110, &GraphicsObject::setX));
+    saveMachine.markSavepoint();
+
+    // The mutator finishes in a frame after the savepoint, which the save
+    // shouldn't see.
+    dynamic_cast<TestEventSystem&>(system.event()).setMockHandler(
+        boost::shared_ptr<EventSystemMockHandler>(new LateTickCounter));
+    graphics.executeGraphicsSystem(saveMachine);
+    EXPECT_EQ(110, graphics.foregroundObjects()[3].x());
+
+    Serialization::saveGameTo(ss, saveMachine);
+  }
+
+  {
+    RLMachine loadMachine(system, arc);
+    Serialization::loadGameFrom(ss, loadMachine);
+    EXPECT_EQ(10, system.graphics().getObject(OBJ_FG, 3).x());
+  }
+}
+
+TEST_F(RLMachineTest, SaveGameHeaderReadableOnItsOwn) {
+  stringstream ss;
+  libReallive::Archive arc(locateTestCase("Module_Str_SEEN/strcpy_0.TXT"));
+  {
+    RLMachine saveMachine(system, arc);
+    Serialization::saveGameTo(ss, saveMachine);
+  }
+
+  // Truncate the compressed body; the header mustn't depend on it.
+  std::string data = ss.str();
+  ASSERT_GT(data.size(), 256u);
+  stringstream header_only(data.substr(0, 256));
+  SaveGameHeader header = Serialization::loadHeaderFrom(header_only);
+  EXPECT_FALSE(header.save_time.is_not_a_date_time());
+}
+
+TEST_F(RLMachineTest, SaveGameHeaderRoundTripsWithoutTheBody) {
+  stringstream ss;
+  libReallive::Archive arc(locateTestCase("Module_Str_SEEN/strcpy_0.TXT"));
+  {
+    RLMachine saveMachine(system, arc);
+    system.graphics().setWindowSubtitle("Header only", 0);
+    Serialization::saveGameTo(ss, saveMachine);
+  }
+
+  std::string data = ss.str();
+  stringstream full(data);
+  SaveGameHeader written = Serialization::loadHeaderFrom(full);
+  EXPECT_EQ("Header only", written.title);
+
+  // Integers in the header are stored with their length, not at the width of
+  // this build: the archive signature's length is one byte long.
+  const std::string signature = "serialization::archive";
+  ASSERT_GT(data.size(), 10 + signature.size());
+  EXPECT_EQ(1, data[8]);
+  EXPECT_EQ(signature.size(), static_cast<size_t>(data[9]));
+  EXPECT_EQ(signature, data.substr(10, signature.size()));
+
+  stringstream header_only(data.substr(0, 256));
+  SaveGameHeader header = Serialization::loadHeaderFrom(header_only);
+  EXPECT_EQ(written.title, header.title);
+  EXPECT_EQ(written.save_time, header.save_time);
+}
+
+TEST_F(RLMachineTest, ReadsHeadersOfTextSaveGames) {
+  // Save games written before the binary format are zlib compressed text
+  // archives.
+  stringstream ss;
+  SaveGameHeader written("Old save");
+  {
+    boost::iostreams::filtering_stream<boost::iostreams::output> output;
+    output.push(boost::iostreams::zlib_compressor());
+    output.push(ss);
+    boost::archive::text_oarchive oa(output);
+    int version = 2;
+    oa << version << written;
+  }
+
+  SaveGameHeader header = Serialization::loadHeaderFrom(ss);
+  EXPECT_EQ("Old save", header.title);
+  EXPECT_EQ(written.save_time, header.save_time);
+}
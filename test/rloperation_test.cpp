@@ -144,8 +144,8 @@ struct StringcStringcCapturer
       : one_(one), two_(two) {
   }
 
-  virtual void operator()(RLMachine& machine, std::string in_one,
-                          std::string in_two) {
+  virtual void operator()(RLMachine& machine, const std::string& in_one,
+                          const std::string& in_two) {
     one_ = in_one;
     two_ = in_two;
   }
@@ -0,0 +1,113 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2013 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+// -----------------------------------------------------------------------
+
+#include "gtest/gtest.h"
+
+#include <boost/filesystem/fstream.hpp>
+#include <boost/filesystem/operations.hpp>
+#include <string>
+
+#include "MachineBase/SaveGameHeader.hpp"
+#include "MachineBase/SaveGameIndex.hpp"
+
+namespace fs = boost::filesystem;
+
+class SaveGameIndexTest : public ::testing::Test {
+ protected:
+  virtual void SetUp() {
+    dir_ = fs::temp_directory_path() / fs::unique_path("rlvm-%%%%-%%%%");
+    fs::create_directories(dir_);
+    index_file_ = dir_ / "saveindex.dat";
+  }
+
+  virtual void TearDown() {
+    fs::remove_all(dir_);
+  }
+
+  fs::path writeSave(int slot, const std::string& contents) {
+    fs::path path = dir_ / ("save" + std::to_string(slot) + ".sav.gz");
+    fs::ofstream file(path, std::ios::binary);
+    file << contents;
+    return path;
+  }
+
+  fs::path dir_;
+  fs::path index_file_;
+};
+
+TEST_F(SaveGameIndexTest, EmptyIndexHasNothing) {
+  fs::path save = writeSave(1, "contents");
+  SaveGameIndex index(index_file_);
+  SaveGameHeader header;
+  EXPECT_FALSE(index.lookup(1, save, &header));
+}
+
+TEST_F(SaveGameIndexTest, RemembersHeadersAcrossInstances) {
+  fs::path save = writeSave(4, "contents");
+  SaveGameHeader written("Chapter 4");
+  {
+    SaveGameIndex index(index_file_);
+    index.update(4, save, written);
+  }
+
+  SaveGameIndex index(index_file_);
+  SaveGameHeader header;
+  ASSERT_TRUE(index.lookup(4, save, &header));
+  EXPECT_EQ("Chapter 4", header.title);
+  EXPECT_EQ(written.save_time, header.save_time);
+  EXPECT_FALSE(index.lookup(5, save, &header));
+}
+
+TEST_F(SaveGameIndexTest, IgnoresChangedSaveGames) {
+  fs::path save = writeSave(2, "contents");
+  SaveGameIndex index(index_file_);
+  index.update(2, save, SaveGameHeader("Old"));
+
+  writeSave(2, "different contents");
+  SaveGameHeader header;
+  EXPECT_FALSE(index.lookup(2, save, &header));
+
+  fs::remove(save);
+  EXPECT_FALSE(index.lookup(2, save, &header));
+}
+
+TEST_F(SaveGameIndexTest, IgnoresCorruptIndex) {
+  {
+    fs::ofstream file(index_file_, std::ios::binary);
+    file << "garbage";
+  }
+
+  fs::path save = writeSave(3, "contents");
+  SaveGameIndex index(index_file_);
+  SaveGameHeader header;
+  EXPECT_FALSE(index.lookup(3, save, &header));
+
+  index.update(3, save, SaveGameHeader("Recovered"));
+  SaveGameIndex reread(index_file_);
+  ASSERT_TRUE(reread.lookup(3, save, &header));
+  EXPECT_EQ("Recovered", header.title);
+}
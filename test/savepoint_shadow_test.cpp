@@ -0,0 +1,84 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2013 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+// -----------------------------------------------------------------------
+
+#include "gtest/gtest.h"
+
+#include <map>
+#include <string>
+
+#include "Utilities/SavepointShadow.hpp"
+
+namespace {
+
+std::map<int, std::string> Originals(
+    const SavepointShadow<int, std::string>& shadow) {
+  std::map<int, std::string> originals;
+  shadow.forEachOriginal([&](int key, const std::string& value) {
+    originals[key] = value;
+  });
+  return originals;
+}
+
+}  // namespace
+
+TEST(SavepointShadowTest, KeepsFirstValueAfterSavepoint) {
+  SavepointShadow<int, std::string> shadow;
+  shadow.mark();
+  EXPECT_FALSE(shadow.hasOriginal(3));
+
+  shadow.recordOriginal(3, "before");
+  shadow.recordOriginal(3, "in between");
+  EXPECT_TRUE(shadow.hasOriginal(3));
+
+  std::map<int, std::string> originals = Originals(shadow);
+  ASSERT_EQ(1u, originals.size());
+  EXPECT_EQ("before", originals[3]);
+}
+
+TEST(SavepointShadowTest, MarkForgetsEarlierGenerations) {
+  SavepointShadow<int, std::string> shadow;
+  shadow.recordOriginal(1, "one");
+  shadow.recordOriginal(2, "two");
+
+  shadow.mark();
+  EXPECT_FALSE(shadow.hasOriginal(1));
+  EXPECT_TRUE(Originals(shadow).empty());
+
+  // A stale original is replaced by the value at the new savepoint.
+  shadow.recordOriginal(2, "two again");
+  std::map<int, std::string> originals = Originals(shadow);
+  ASSERT_EQ(1u, originals.size());
+  EXPECT_EQ("two again", originals[2]);
+}
+
+TEST(SavepointShadowTest, ClearForgetsEverything) {
+  SavepointShadow<int, std::string> shadow;
+  shadow.recordOriginal(1, "one");
+  shadow.clear();
+  EXPECT_FALSE(shadow.hasOriginal(1));
+  EXPECT_TRUE(Originals(shadow).empty());
+}
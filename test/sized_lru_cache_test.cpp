@@ -0,0 +1,91 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2013 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+// -----------------------------------------------------------------------
+
+#include "gtest/gtest.h"
+
+#include <string>
+
+#include "Utilities/SizedLRUCache.hpp"
+
+typedef SizedLRUCache<int, std::string> StringCache;
+
+TEST(SizedLRUCacheTest, EvictsLeastRecentlyUsedByBytes) {
+  StringCache cache(100);
+  cache.insert(1, "one", 40);
+  cache.insert(2, "two", 40);
+
+  // Touching 1 makes 2 the eviction candidate.
+  EXPECT_EQ("one", cache.fetch(1));
+  cache.insert(3, "three", 40);
+
+  EXPECT_TRUE(cache.exists(1));
+  EXPECT_FALSE(cache.exists(2));
+  EXPECT_TRUE(cache.exists(3));
+  EXPECT_EQ(80u, cache.current_bytes());
+  EXPECT_EQ(1u, cache.stats().evictions);
+}
+
+TEST(SizedLRUCacheTest, KeepsOversizedNewestEntry) {
+  StringCache cache(100);
+  cache.insert(1, "one", 10);
+  cache.insert(2, "huge", 500);
+
+  EXPECT_FALSE(cache.exists(1));
+  EXPECT_TRUE(cache.exists(2));
+  EXPECT_EQ(500u, cache.current_bytes());
+}
+
+TEST(SizedLRUCacheTest, ReplacingKeyUpdatesAccounting) {
+  StringCache cache(100);
+  cache.insert(1, "one", 10);
+  cache.insert(1, "uno", 30);
+
+  EXPECT_EQ(1u, cache.size());
+  EXPECT_EQ(30u, cache.current_bytes());
+  EXPECT_EQ("uno", cache.fetch(1));
+}
+
+TEST(SizedLRUCacheTest, CountsHitsAndMisses) {
+  StringCache cache(100);
+  cache.insert(1, "one", 10);
+
+  EXPECT_EQ("one", cache.fetch(1));
+  EXPECT_EQ("", cache.fetch(2));
+  EXPECT_EQ(1u, cache.stats().hits);
+  EXPECT_EQ(1u, cache.stats().misses);
+}
+
+TEST(SizedLRUCacheTest, ShrinkingCeilingEvicts) {
+  StringCache cache(100);
+  cache.insert(1, "one", 30);
+  cache.insert(2, "two", 30);
+  cache.insert(3, "three", 30);
+
+  cache.set_max_bytes(50);
+  EXPECT_EQ(1u, cache.size());
+  EXPECT_TRUE(cache.exists(3));
+}
@@ -0,0 +1,112 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2013 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+// -----------------------------------------------------------------------
+
+#include "gtest/gtest.h"
+
+#include <boost/bind.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/thread.hpp>
+#include <vector>
+
+#include "Utilities/SPSCQueue.hpp"
+
+TEST(SPSCQueueTest, FirstInFirstOut) {
+  SPSCQueue<int, 8> queue;
+  EXPECT_TRUE(queue.empty());
+  EXPECT_TRUE(queue.push(1));
+  EXPECT_TRUE(queue.push(2));
+
+  int out = 0;
+  EXPECT_TRUE(queue.pop(&out));
+  EXPECT_EQ(1, out);
+  EXPECT_TRUE(queue.pop(&out));
+  EXPECT_EQ(2, out);
+  EXPECT_FALSE(queue.pop(&out));
+  EXPECT_TRUE(queue.empty());
+}
+
+TEST(SPSCQueueTest, RejectsPushWhenFull) {
+  SPSCQueue<int, 4> queue;
+  EXPECT_EQ(3u, queue.freeSlots());
+  EXPECT_TRUE(queue.push(1));
+  EXPECT_TRUE(queue.push(2));
+  EXPECT_TRUE(queue.push(3));
+  EXPECT_EQ(0u, queue.freeSlots());
+  EXPECT_FALSE(queue.push(4));
+
+  // Wrapping around works once there's room again.
+  int out = 0;
+  EXPECT_TRUE(queue.pop(&out));
+  EXPECT_TRUE(queue.push(4));
+  for (int expected = 2; expected <= 4; ++expected) {
+    EXPECT_TRUE(queue.pop(&out));
+    EXPECT_EQ(expected, out);
+  }
+}
+
+TEST(SPSCQueueTest, ReleasesPoppedSlots) {
+  SPSCQueue<boost::shared_ptr<int>, 4> queue;
+  boost::shared_ptr<int> value(new int(5));
+  queue.push(value);
+  EXPECT_EQ(2, value.use_count());
+
+  boost::shared_ptr<int> out;
+  queue.pop(&out);
+  out.reset();
+  EXPECT_EQ(1, value.use_count());
+}
+
+namespace {
+
+void produce(SPSCQueue<int, 64>* queue, int count) {
+  for (int i = 0; i < count; ++i) {
+    while (!queue->push(i))
+      boost::this_thread::yield();
+  }
+}
+
+}  // namespace
+
+TEST(SPSCQueueTest, PassesEverythingBetweenThreads) {
+  const int COUNT = 100000;
+  SPSCQueue<int, 64> queue;
+  boost::thread producer(boost::bind(&produce, &queue, COUNT));
+
+  int next = 0;
+  while (next < COUNT) {
+    int out;
+    if (queue.pop(&out)) {
+      ASSERT_EQ(next, out);
+      next++;
+    } else {
+      boost::this_thread::yield();
+    }
+  }
+
+  producer.join();
+  EXPECT_TRUE(queue.empty());
+}
@@ -0,0 +1,110 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2013 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+// -----------------------------------------------------------------------
+
+#include "gtest/gtest.h"
+
+#include "Modules/Module_Str.hpp"
+#include "libReallive/archive.h"
+#include "libReallive/expression.h"
+#include "libReallive/intmemref.h"
+
+#include "MachineBase/RLMachine.hpp"
+#include "MachineBase/RLModule.hpp"
+#include "MachineBase/RLOperation.hpp"
+
+#include "TestSystem/TestSystem.hpp"
+
+#include "allocation_counter.hpp"
+#include "testUtils.hpp"
+
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace libReallive;
+
+namespace {
+
+RLOperation* findOperation(RLModule& module, const string& name) {
+  for (RLModule::OpcodeMap::iterator it = module.begin(); it != module.end();
+       ++it) {
+    if (name == it->second->name())
+      return it->second;
+  }
+  return NULL;
+}
+
+}  // namespace
+
+// Tests that string constants are handed to operations as references into
+// string memory: executing strlen and strcmp on long strings must not
+// allocate.
+//
+//   intA[0] = strlen(strS[0])
+//   intA[0] = strcmp(strS[0], strS[1])
+//
+TEST(StringParameterAllocationTest, StrConstantParametersDontAllocate) {
+  libReallive::Archive arc(locateTestCase("Module_Str_SEEN/strlen_0.TXT"));
+  TestSystem system;
+  RLMachine rlmachine(system, arc);
+  StrModule* module = new StrModule;
+  rlmachine.attachModule(module);
+
+  // Long enough that a copy can't fit in a small string buffer.
+  rlmachine.setStringValue(STRS_LOCATION, 0, string(100, 'a'));
+  rlmachine.setStringValue(STRS_LOCATION, 1, string(100, 'b'));
+
+  RLOperation* strlen_op = findOperation(*module, "strlen");
+  ASSERT_TRUE(strlen_op);
+  vector<string> strlen_input = {
+    printableToParsableString("$ 12 [ $ FF 00 00 00 00 ]")
+  };
+  ExpressionPiecesVector strlen_parameters;
+  strlen_op->parseParameters(strlen_input, strlen_parameters);
+
+  {
+    ScopedAllocationCounter counter;
+    strlen_op->dispatch(rlmachine, strlen_parameters);
+    EXPECT_EQ(0, counter.count()) << "strlen copied its parameter";
+  }
+  EXPECT_EQ(100, rlmachine.getStoreRegisterValue());
+
+  RLOperation* strcmp_op = findOperation(*module, "strcmp");
+  ASSERT_TRUE(strcmp_op);
+  vector<string> strcmp_input = {
+    printableToParsableString("$ 12 [ $ FF 00 00 00 00 ]"),
+    printableToParsableString("$ 12 [ $ FF 01 00 00 00 ]")
+  };
+  ExpressionPiecesVector strcmp_parameters;
+  strcmp_op->parseParameters(strcmp_input, strcmp_parameters);
+
+  {
+    ScopedAllocationCounter counter;
+    strcmp_op->dispatch(rlmachine, strcmp_parameters);
+    EXPECT_EQ(0, counter.count()) << "strcmp copied its parameters";
+  }
+  EXPECT_GT(0, rlmachine.getStoreRegisterValue());
+}
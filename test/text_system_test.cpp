@@ -57,6 +57,17 @@ class IncrementingTickCounter : public EventSystemMockHandler {
   mutable unsigned int ticks;
 };
 
+// Returns whatever time the test sets.
+class SettableTickCounter : public EventSystemMockHandler {
+ public:
+  SettableTickCounter() : ticks(0) {}
+  void setTicks(unsigned int in) { ticks = in; }
+  virtual unsigned int getTicks() const { return ticks; }
+
+ private:
+  unsigned int ticks;
+};
+
 class TextSystemTest : public FullSystemTest {
  protected:
   TextSystemTest() {
@@ -167,6 +178,32 @@ TEST_F(TextSystemTest, BackLogFunctionality) {
       << "We're no longer reading the backlog.";
 }
 
+// Replaying a backlog page a second time should redraw the glyphs it laid out
+// the first time instead of running them back through character().
+TEST_F(TextSystemTest, BackLogReplayUsesCachedLayout) {
+  TextSystem& text = rlmachine.system().text();
+  TestTextSystem& sys = getTextSystem();
+
+  writeString("Page one.", true);
+  snapshotAndClear();
+  writeString("Page two.", true);
+
+  text.backPage();
+  std::vector<std::tuple<std::string, int, int> > first(
+      sys.glyphs().end() - 9, sys.glyphs().end());
+  text.forwardPage();
+
+  EXPECT_CALL(getTextWindow(0), character(_, _)).Times(0);
+  size_t before = sys.glyphs().size();
+  text.backPage();
+  EXPECT_EQ("Page one.", getTextWindow(0).currentContents());
+  ASSERT_EQ(before + 9, sys.glyphs().size());
+
+  std::vector<std::tuple<std::string, int, int> > second(
+      sys.glyphs().end() - 9, sys.glyphs().end());
+  EXPECT_TRUE(first == second);
+}
+
 // -----------------------------------------------------------------------
 
 // Tests that the TextPage::name construct repeats correctly.
@@ -310,6 +347,27 @@ TEST_F(TextSystemTest, RenderGlyphOntoTwoLines) {
   }
 }
 
+// Identical object text should be rendered once and then shared.
+TEST_F(TextSystemTest, RenderTextIsCached) {
+  TestTextSystem& sys = getTextSystem();
+  boost::shared_ptr<Surface> first =
+      sys.renderText("Score", 20, 0, 0, RGBColour::White(), NULL, -1);
+  ASSERT_EQ(5, sys.glyphs().size());
+
+  boost::shared_ptr<Surface> second =
+      sys.renderText("Score", 20, 0, 0, RGBColour::White(), NULL, -1);
+  EXPECT_EQ(first, second);
+  EXPECT_EQ(5, sys.glyphs().size());
+  EXPECT_EQ(1, sys.textSurfaceCacheStats().hits);
+
+  // Changing any parameter is a different surface.
+  RGBColour shadow = RGBColour::Black();
+  boost::shared_ptr<Surface> shadowed =
+      sys.renderText("Score", 20, 0, 0, RGBColour::White(), &shadow, -1);
+  EXPECT_NE(first, shadowed);
+  EXPECT_EQ(10, sys.glyphs().size());
+}
+
 TEST_F(TextSystemTest, DontCrashWithNoEmojiFile) {
   TestTextSystem& sys = getTextSystem();
   boost::shared_ptr<Surface> text_surface =
@@ -367,3 +425,32 @@ TEST_F(TextSystemTest, TestEmptyString) {
   EXPECT_GT(text_surface->size().width(), 0);
   EXPECT_GT(text_surface->size().height(), 0);
 }
+
+// Textout reveals as many characters per pass as the message speed says are
+// due, instead of one character per pass.
+TEST_F(TextSystemTest, RevealsCharactersByElapsedTime) {
+  boost::shared_ptr<SettableTickCounter> clock(new SettableTickCounter);
+  dynamic_cast<TestEventSystem&>(system.event()).setMockHandler(clock);
+  system.text().setMessageSpeed(10);
+
+  TextoutLongOperation textout(rlmachine, "ABCDEFGHIJKLMNOPQRSTUVWXYZ");
+  clock->setTicks(10000);
+  EXPECT_FALSE(textout(rlmachine));
+  size_t shown = getTextWindow(0).currentContents().size();
+
+  // Long waits are only partially made up for: the character that was due
+  // 50ms ago and the five since.
+  clock->setTicks(20000);
+  EXPECT_FALSE(textout(rlmachine));
+  EXPECT_EQ(shown + 6, getTextWindow(0).currentContents().size());
+  shown += 6;
+
+  // Nothing more is due until time passes.
+  EXPECT_FALSE(textout(rlmachine));
+  EXPECT_EQ(shown, getTextWindow(0).currentContents().size());
+
+  // After that, every pass shows everything that came due since the last.
+  clock->setTicks(20030);
+  EXPECT_FALSE(textout(rlmachine));
+  EXPECT_EQ(shown + 3, getTextWindow(0).currentContents().size());
+}
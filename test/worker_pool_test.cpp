@@ -0,0 +1,99 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2013 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+// -----------------------------------------------------------------------
+
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+#include <boost/thread/mutex.hpp>
+
+#include "Utilities/WorkerPool.hpp"
+
+TEST(WorkerPoolTest, RunsEveryIndexOnce) {
+  WorkerPool pool(3);
+  std::vector<int> counts(1000, 0);
+  for (int pass = 0; pass < 20; ++pass) {
+    pool.parallelFor(counts.size(), [&](int i) { counts[i]++; });
+  }
+
+  for (size_t i = 0; i < counts.size(); ++i)
+    EXPECT_EQ(20, counts[i]) << "Index " << i;
+}
+
+TEST(WorkerPoolTest, WorksWithoutThreads) {
+  WorkerPool pool(0);
+  int sum = 0;
+  pool.parallelFor(10, [&](int i) { sum += i; });
+  EXPECT_EQ(45, sum);
+}
+
+TEST(WorkerPoolTest, ConcurrentCallersTakeTurns) {
+  WorkerPool pool(2);
+  boost::mutex mutex;
+  int total = 0;
+
+  boost::thread other([&]() {
+      for (int pass = 0; pass < 50; ++pass) {
+        pool.parallelFor(8, [&](int i) {
+            boost::mutex::scoped_lock lock(mutex);
+            total++;
+          });
+      }
+    });
+  for (int pass = 0; pass < 50; ++pass) {
+    pool.parallelFor(8, [&](int i) {
+        boost::mutex::scoped_lock lock(mutex);
+        total++;
+      });
+  }
+  other.join();
+
+  EXPECT_EQ(800, total);
+}
+
+TEST(WorkerPoolTest, NestedCallsRunInline) {
+  WorkerPool pool(3);
+  std::atomic<int> total(0);
+  pool.parallelFor(8, [&](int i) {
+      pool.parallelFor(8, [&](int j) { total++; });
+    });
+
+  EXPECT_EQ(64, total);
+}
+
+TEST(WorkerPoolTest, RethrowsOnCallerAndStaysUsable) {
+  WorkerPool pool(3);
+  EXPECT_THROW(pool.parallelFor(100, [&](int i) {
+        if (i == 10)
+          throw std::runtime_error("index 10");
+      }), std::runtime_error);
+
+  std::vector<int> counts(100, 0);
+  pool.parallelFor(counts.size(), [&](int i) { counts[i]++; });
+  for (size_t i = 0; i < counts.size(); ++i)
+    EXPECT_EQ(1, counts[i]) << "Index " << i;
+}